@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <pfme/Compiled.hpp>
+#include <pfme/Session.hpp>
+#include <pfme/Small.hpp>
+#include <pfme/Visitor.hpp>
+#include <string>
+#include <vector>
+
+// Measures the latency of single short expressions in nanoseconds, from the string to the result.
+// Usage: Bench_Latency [iterations], the default is 200000 per input and path.
+
+namespace
+{
+constexpr int REPETITIONS = 5;
+
+// the fastest of several runs in nanoseconds per evaluation
+auto best_latency ( std::size_t iterations, const std::function<bool()>& run ) -> double
+{
+    double best = std::numeric_limits<double>::max();
+    for ( int i = 0; i < REPETITIONS; ++i )
+    {
+        std::size_t failed = 0;
+        const auto  start  = std::chrono::steady_clock::now();
+        for ( std::size_t j = 0; j < iterations; ++j ) { failed += run() ? 0U : 1U; }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        if ( failed > 0 ) { return std::numeric_limits<double>::quiet_NaN(); }
+        best = std::min ( best, elapsed.count() / static_cast<double> ( iterations ) );
+    }
+    return best;
+}
+
+auto long_input() -> std::string
+{
+    std::string input = "1";
+    for ( int i = 0; i < 50; ++i ) { input += " + 2 * 3"; }
+    return input;
+}
+} // namespace
+
+int main ( int argc, char** argv )
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const std::size_t              iterations = argc > 1 ? std::stoul ( argv[1] ) : 200000;
+    const std::vector<std::string> inputs { "1 + 2",
+                                            "2 * (3 + 4) - 5 / 2",
+                                            "1.5e3 * .5 - 2 ^ 10",
+                                            "((1 + 2) * (3 - 4) ^ 2) / (5 + 6 * 7 - 8)",
+                                            "sqrt(2) + 1",
+                                            long_input() };
+
+    pfme::Session session;
+    std::cout << std::format (
+        "{:<44} {:>8} {:>10} {:>10} {:>10} {:>10}\n", "input", "small", "fast ns", "small ns", "session ns", "visitor ns" );
+    for ( const auto& input : inputs )
+    {
+        const bool fast       = pfme::try_evaluate_small ( input ).has_value();
+        const auto fast_only  = best_latency ( iterations, [&] { return pfme::try_evaluate_small ( input ).has_value(); } );
+        const auto small      = best_latency ( iterations, [&] { return pfme::evaluate_small ( input ).has_value(); } );
+        const auto in_session = best_latency ( iterations, [&] { return session.evaluate ( input ).has_value(); } );
+        const auto visitor    =
+            best_latency ( iterations / 10, [&] { return pfme::Visitor::try_create ( input )->try_evaluate().has_value(); } );
+        const auto name       = input.size() > 40 ? input.substr ( 0, 37 ) + "..." : input;
+        std::cout << std::format ( "{:<44} {:>8} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}\n",
+                                   name,
+                                   fast ? "yes" : "no",
+                                   fast_only,
+                                   small,
+                                   in_session,
+                                   visitor );
+    }
+}
@@ -0,0 +1,98 @@
+#include <Workload.hpp>
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <pfme/Lexer.hpp>
+#include <pfme/Scan.hpp>
+#include <string>
+#include <vector>
+
+// Measures the throughput of the Lexer on multi megabyte inputs for every usable simd::SIMD_LEVEL.
+// Usage: Bench_Lexer [megabytes], the default is 8.
+
+namespace
+{
+constexpr int REPETITIONS = 5;
+
+struct Input
+{
+    std::string m_name;
+    std::string m_text;
+};
+
+auto repeat ( const std::string& part, std::size_t size ) -> std::string
+{
+    std::string text;
+    text.reserve ( size + part.size() );
+    while ( text.size() < size ) { text += part; }
+    return text + "1";
+}
+
+auto inputs ( std::size_t size ) -> std::vector<Input>
+{
+    pfme::workload::Options options;
+    options.m_operands = size / 8;
+
+    return {
+        { "long literals", repeat ( std::string ( 60, '7' ) + "." + std::string ( 40, '3' ) + " + ", size ) },
+        { "whitespace padding", repeat ( "1" + std::string ( 120, ' ' ) + "\t\n+" + std::string ( 60, ' ' ), size ) },
+        { "seperator padding", repeat ( "2____''''____'''' * ", size ) },
+        { "generated", pfme::workload::Generator ( options ).generate() },
+    };
+}
+
+// the fastest of several runs in seconds
+auto best_time ( const std::function<void()>& run ) -> double
+{
+    double best = std::numeric_limits<double>::max();
+    for ( int i = 0; i < REPETITIONS; ++i )
+    {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best                                        = std::min ( best, elapsed.count() );
+    }
+    return best;
+}
+
+auto lex ( const std::string& input ) -> std::size_t
+{
+    pfme::Lexer lexer ( input );
+    std::size_t count = 0;
+    while ( lexer.get_next_token()->get_type() != pfme::TOKEN_TYPE::TOKEN_EOF ) { ++count; }
+    return count;
+}
+} // namespace
+
+int main ( int argc, char** argv )
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const std::size_t megabytes = argc > 1 ? std::stoul ( argv[1] ) : 8;
+    std::vector<pfme::simd::SIMD_LEVEL> levels { pfme::simd::SIMD_LEVEL::SCALAR };
+    for ( const auto level : { pfme::simd::SIMD_LEVEL::SSE2, pfme::simd::SIMD_LEVEL::AVX2 } )
+    {
+        if ( level <= pfme::simd::supported_level() ) { levels.push_back ( level ); }
+    }
+
+    std::cout << std::format ( "{:<20} {:>10} {:>10} {:>12}\n", "input", "MB", "level", "MB/s" );
+    for ( const auto& input : inputs ( megabytes << 20U ) )
+    {
+        const double size = static_cast<double> ( input.m_text.size() ) / ( 1 << 20 );
+        std::size_t  tokens = 0;
+        for ( const auto level : levels )
+        {
+            pfme::simd::set_level ( level );
+            const auto seconds = best_time ( [&] { tokens = lex ( input.m_text ); } );
+            std::cout << std::format ( "{:<20} {:>10.1f} {:>10} {:>12.1f}\n",
+                                       input.m_name,
+                                       size,
+                                       pfme::simd::simd_level_to_string ( level ),
+                                       size / seconds );
+        }
+        std::cout << std::format ( "{:<20} {:>10} tokens\n", "", tokens );
+    }
+    pfme::simd::set_level ( pfme::simd::supported_level() );
+}
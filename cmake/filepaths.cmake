@@ -5,6 +5,24 @@ set(sources
     src/cpp/Token.cpp
     src/cpp/Visitor.cpp
 	src/cpp/Fraction.cpp
+	src/cpp/Serialization.cpp
+	src/cpp/Error.cpp
+	src/cpp/Format.cpp
+	src/cpp/Scan.cpp
+	src/cpp/Simd.cpp
+	src/cpp/Functions.cpp
+	src/cpp/Session.cpp
+	src/cpp/Compiled.cpp
+	src/cpp/Gradient.cpp
+	src/cpp/Trace.cpp
+	src/cpp/Columns.cpp
+	src/cpp/Small.cpp
+	src/cpp/ParallelParser.cpp
+	src/cpp/Decimal.cpp
+	src/cpp/Canonical.cpp
+	src/cpp/Supervisor.cpp
+	src/cpp/Reassociate.cpp
+	src/cpp/Range.cpp
 )
 
 set(absolute_sources ${sources})
@@ -27,6 +45,24 @@ set(headers
     include/pfme/Token.hpp
     include/pfme/Visitor.hpp
 	include/pfme/Fraction.hpp
+	include/pfme/Serialization.hpp
+	include/pfme/Error.hpp
+	include/pfme/Format.hpp
+	include/pfme/Scan.hpp
+	include/pfme/Simd.hpp
+	include/pfme/Functions.hpp
+	include/pfme/Session.hpp
+	include/pfme/Compiled.hpp
+	include/pfme/Gradient.hpp
+	include/pfme/Trace.hpp
+	include/pfme/Columns.hpp
+	include/pfme/Small.hpp
+	include/pfme/ParallelParser.hpp
+	include/pfme/Decimal.hpp
+	include/pfme/Canonical.hpp
+	include/pfme/Supervisor.hpp
+	include/pfme/Limits.hpp
+	include/pfme/Reassociate.hpp
 )
 
 set(absolute_headers ${headers})
@@ -40,7 +76,38 @@ set(test_sources
     src/Token.cpp
     src/Visitor.cpp
 	src/Fraction.cpp
+	src/Serialization.cpp
+	src/Scaling.cpp
+	src/Error.cpp
+	src/Format.cpp
+	src/Scan.cpp
+	src/Functions.cpp
+	src/Session.cpp
+	src/Compiled.cpp
+	src/Gradient.cpp
+	src/Trace.cpp
+	src/Columns.cpp
+	src/Small.cpp
+	src/ParallelParser.cpp
+	src/Decimal.cpp
+	src/Canonical.cpp
+	src/Supervisor.cpp
+	src/Limits.cpp
+	src/Reassociate.cpp
+	src/Range.cpp
+)
+
+set(bench_sources
+	src/Lexer.cpp
+	src/Latency.cpp
+)
+
+set(test_headers
+	test/include/Workload.hpp
 )
 
 set(source_test_sources ${test_sources})
 list(TRANSFORM source_test_sources PREPEND "test/")
+
+set(source_bench_sources ${bench_sources})
+list(TRANSFORM source_bench_sources PREPEND "bench/")
@@ -10,7 +10,7 @@ function(add_clang_format_target)
     if(${PROJECT_NAME}_CLANG_FORMAT_BINARY)
 		add_custom_target(clang-format
 				COMMAND ${${PROJECT_NAME}_CLANG_FORMAT_BINARY}
-				-i ${exe_sources} ${headers} ${source_test_sources}
+				-i ${exe_sources} ${headers} ${source_test_sources} ${test_headers} ${source_bench_sources}
 				WORKING_DIRECTORY ${CMAKE_CURRENT_LIST_DIR})
 		message(STATUS "Format the project using the `clang-format` target (i.e: cmake --build build --target clang-format)./n")
     endif()
@@ -19,7 +19,7 @@ endfunction()
 function(add_clang_tidy_target)
 	find_program(CLANGTIDY clang-tidy)
 	set(CMAKE_CXX_CLANG_TIDY 
-		"${CLANGTIDY};--extra-arg=-Wno-unknown-warning-option;--extra-arg=-Xclang;--extra-arg=-fcxx-exceptions;--extra-arg=-std=c++20;--extra-arg=-I${CMAKE_CURRENT_SOURCE_DIR}/include;--extra-arg=-DLIBCXX_ENABLE_INCOMPLETE_FEATURES=ON;--extra-arg=-stdlib=libc++;--extra-arg=-fexperimental-library")
+		"${CLANGTIDY};--extra-arg=-Wno-unknown-warning-option;--extra-arg=-Xclang;--extra-arg=-fcxx-exceptions;--extra-arg=-std=c++23;--extra-arg=-I${CMAKE_CURRENT_SOURCE_DIR}/include;--extra-arg=-DLIBCXX_ENABLE_INCOMPLETE_FEATURES=ON;--extra-arg=-stdlib=libc++;--extra-arg=-fexperimental-library")
 	add_custom_target(
         clang-tidy
         COMMAND ${CMAKE_CXX_CLANG_TIDY}
@@ -1,7 +1,12 @@
 #pragma once
 #include <cmath>
+#include <concepts>
+#include <cstdint>
 #include <iostream>
+#include <expected>
 #include <memory>
+#include <pfme/Decimal.hpp>
+#include <pfme/Error.hpp>
 #include <pfme/Fraction.hpp>
 #include <stdexcept>
 #include <string>
@@ -17,6 +22,27 @@ namespace pfme
 {
 using LD  = long double;
 using LLI = long long int;
+
+/**
+ * The value of a number with a choice of floating point type, integers, fractions and decimals are always exact.
+ * The AST stores long double (AST::num_t), basic_visitor can evaluate with float or double instead.
+ */
+template <std::floating_point Float>
+using basic_num_t = std::variant<LLI, Float, Fraction, Decimal>;
+
+/**
+ * Converts the float alternative of a number to another floating point type, the exact alternatives stay as they are.
+ * @param number is the number to convert
+ * @return The same number with To as float type
+ */
+template <std::floating_point To, std::floating_point From>
+auto convert_number ( const basic_num_t<From>& number ) -> basic_num_t<To>
+{
+    if ( const auto* floating = std::get_if<From> ( &number ) ) { return static_cast<To> ( *floating ); }
+    if ( const auto* integer = std::get_if<LLI> ( &number ) ) { return *integer; }
+    if ( const auto* decimal = std::get_if<Decimal> ( &number ) ) { return *decimal; }
+    return std::get<Fraction> ( number );
+}
 /**
  * Enum for the types of AST nodes.
  */
@@ -31,6 +57,20 @@ enum class AST_TYPE : int
     FLOAT,          /**< Float */
     EMPTY,          /**< Empty */
     FRACTION,
+    FUNCTION, /**< A function call, the first argument is lhand, the others follow in a chain of ARGUMENT nodes in rhand */
+    ARGUMENT, /**< One more argument of a function call, the argument is lhand, rhand is the next ARGUMENT or empty */
+    VARIABLE, /**< A name without a call, m_value is the name and the value is only known when it is evaluated */
+    DECIMAL,  /**< A scaled fixed point number, see Decimal */
+    LESS,          /**< Less than, the comparisons result in the integer 1 if they are true and 0 otherwise */
+    LESS_EQUAL,    /**< Less than or equal */
+    GREATER,       /**< Greater than */
+    GREATER_EQUAL, /**< Greater than or equal */
+    EQUAL,         /**< Equal */
+    NOT_EQUAL,     /**< Not equal */
+    AND,           /**< Logical and, the right operand is only evaluated if the left one is true (not 0) */
+    OR,            /**< Logical or, the right operand is only evaluated if the left one is false (0) */
+    CONDITION,     /**< A conditional expression (c ? a : b), lhand is the condition and rhand the ALTERNATIVE node */
+    ALTERNATIVE,   /**< The two results of a conditional expression, only the one the condition selects is evaluated */
 };
 
 /**
@@ -38,14 +78,35 @@ enum class AST_TYPE : int
  * There are two general types: 
  * - Operation nodes that have numbers or other operation nodes as children
  * - Number nodes that do not have children
+ *
+ * Function calls are operation nodes as well, max(1, 2, 3) is stored as:
+ *
+ *       max
+ *      /   \
+ *     1     ,
+ *          / \
+ *         2   ,
+ *            /
+ *           3
+ *
+ * A name that is not followed by '(' is a variable (e.g. x in 2 * x), it is a leaf like a number.
+ *
+ * A conditional expression is an operation node as well, x > 0 ? x : 0 is stored as:
+ *
+ *         ?
+ *       /   \
+ *      >     :
+ *     / \   / \
+ *    x   0 x   0
  */
 struct AST
 {
-    using num_t                  = std::variant<LLI, LD, Fraction>;
+    using num_t                  = basic_num_t<LD>;
     AST_TYPE             m_type  = AST_TYPE::EMPTY; /**< The type of the node, set to empty. */
-    std::string          m_value = "0"; /**< The Value of the node, generally either the number as a string or the operation. */
+    std::string          m_value = "0"; /**< The operation or number as written, empty for calculated numbers */
     num_t                m_number          = 0LL;
     int                  m_operation_level = 0; /**< The operation level, used to determine how the nodes are ordered. */
+    std::uint32_t        m_function        = 0; /**< The id in the FunctionRegistry, only used by function nodes */
     std::shared_ptr<AST> lhand =
         nullptr; /**< The left child node, will typically never be empty unless the node is a number. */
     std::shared_ptr<AST> rhand = nullptr; /**< The right child node. */
@@ -54,7 +115,11 @@ struct AST
     AST()              = default;
     AST ( const AST& ) = default;
     AST ( AST&& )      = default;
-    ~AST()             = default;
+    /**
+     * Releases the children without recursion and without allocating, so even a tree with millions of levels can not
+     * overflow the stack. Children that are still shared with another owner are left alone.
+     */
+    ~AST();
 
     AST& operator= ( const AST& ) = default;
     AST& operator= ( AST&& )      = default;
@@ -73,31 +138,45 @@ struct AST
     }
     /**
      * Helper constructor, sets the node as type integer.
+     * The number is not turned into a string, see to_string().
      * @param number is the integer number the node will be set to
      */
     explicit AST ( LLI number )
         : m_type ( AST_TYPE::INTEGER )
-        , m_value ( std::to_string ( number ) )
+        , m_value {}
         , m_number ( number )
     {
     }
     /**
      * Helper constructor, sets the node as type float without losing precision.
+     * The number is not turned into a string, see to_string().
      * @param number is the float number the node will be set to
      */
     explicit AST ( LD number )
         : m_type ( AST_TYPE::FLOAT )
-        , m_value ( std::to_string ( number ) )
+        , m_value {}
         , m_number ( number )
     {
     }
     /**
      * Helper constructor, sets the node as type fraction.
+     * The number is not turned into a string, see to_string().
      * @param number is the fraction number the node will be set to
      */
     explicit AST ( Fraction number )
         : m_type ( AST_TYPE::FRACTION )
-        , m_value ( number.to_string() )
+        , m_value {}
+        , m_number ( number )
+    {
+    }
+    /**
+     * Helper constructor, sets the node as type decimal.
+     * The number is not turned into a string, see to_string().
+     * @param number is the decimal number the node will be set to
+     */
+    explicit AST ( Decimal number )
+        : m_type ( AST_TYPE::DECIMAL )
+        , m_value {}
         , m_number ( number )
     {
     }
@@ -125,12 +204,32 @@ struct AST
         case AST_TYPE::EXPONENTIATION: return "Exponentiation";
         case AST_TYPE::INTEGER: [[fallthrough]];
         case AST_TYPE::FRACTION: [[fallthrough]];
-        case AST_TYPE::FLOAT: return m_value;
+        case AST_TYPE::DECIMAL: [[fallthrough]];
+        case AST_TYPE::FLOAT: return to_string();
         case AST_TYPE::EMPTY: return "Empty";
+        case AST_TYPE::FUNCTION: return m_value;
+        case AST_TYPE::ARGUMENT: return "Argument";
+        case AST_TYPE::VARIABLE: return m_value;
+        case AST_TYPE::LESS: return "Less";
+        case AST_TYPE::LESS_EQUAL: return "Less or equal";
+        case AST_TYPE::GREATER: return "Greater";
+        case AST_TYPE::GREATER_EQUAL: return "Greater or equal";
+        case AST_TYPE::EQUAL: return "Equal";
+        case AST_TYPE::NOT_EQUAL: return "Not equal";
+        case AST_TYPE::AND: return "And";
+        case AST_TYPE::OR: return "Or";
+        case AST_TYPE::CONDITION: return "Condition";
+        case AST_TYPE::ALTERNATIVE: return "Alternative";
         default: return "";
         }
     }
 
+    /**
+     * Get the value of the node as a string, numbers are only formatted when this is called.
+     * @return m_value if it is set, otherwise the number in the format of std::to_string (see pfme::format_number)
+     */
+    [[nodiscard]] auto to_string() const -> std::string;
+
     /**
 	 * Tells you wether or not the node is a number.
 	 * @return true for integer, floats or empty, false for all others
@@ -138,7 +237,21 @@ struct AST
     auto is_num() const -> bool
     {
         return ( m_type == AST_TYPE::INTEGER || m_type == AST_TYPE::FLOAT || m_type == AST_TYPE::EMPTY ||
-                 m_type == AST_TYPE::FRACTION );
+                 m_type == AST_TYPE::FRACTION || m_type == AST_TYPE::DECIMAL );
+    }
+
+    /**
+     * Calls a function for every argument of a function node, from the first to the last one.
+     * @param function is called with a pointer to each argument
+     */
+    template <typename F>
+    auto for_each_argument ( F&& function ) const -> void
+    {
+        function ( lhand.get() );
+        for ( const AST* argument = rhand.get(); argument != nullptr; argument = argument->rhand.get() )
+        {
+            function ( argument->lhand.get() );
+        }
     }
 
     friend auto operator+ ( const AST& lhs, const AST& rhs ) -> AST;
@@ -148,4 +261,48 @@ struct AST
     friend auto operator^ ( const AST& lhs, const AST& rhs ) -> AST;
     friend auto operator<< ( std::ostream& stream, const AST& obj ) -> std::ostream&;
 };
+
+/**
+ * The truth of a number as a condition, like in C every number except 0 is true (NaN as well).
+ * @param number is the number
+ * @return false for 0 of every type, true otherwise
+ */
+template <std::floating_point Float>
+auto is_true ( const basic_num_t<Float>& number ) -> bool
+{
+    return std::visit ( [] ( auto value ) { return !( value == decltype ( value ) { 0 } ); }, number );
+}
+
+/**
+ * Applies an operation to two number nodes without throwing.
+ * Unlike the operators a division by zero (including 0 to the power of a negative number) is returned as an error.
+ * @param operation is the type of the operation node, e.g. AST_TYPE::ADDITION
+ * @param lhs is the left hand number
+ * @param rhs is the right hand number
+ * @return A number node with the result or the ERROR_CODE of what went wrong
+ */
+auto apply ( AST_TYPE operation, const AST& lhs, const AST& rhs ) -> std::expected<AST, ERROR_CODE>;
+
+/**
+ * Applies an operation to two numbers in the precision of Float, the AST operators and apply() use it with long double.
+ * Integers stay integers (a division that is not clean becomes a Fraction), as soon as a float is involved the result
+ * is a float. An integer, fraction or decimal result that does not fit into 64 bits is ERROR_CODE::NUMBER_OUT_OF_RANGE,
+ * only powers that do not fit are calculated in Float instead. A decimal with an integer or a decimal stays a decimal,
+ * + - * are exact and a division is rounded as the context says, a decimal with a fraction becomes a fraction. It is
+ * instantiated for float, double and long double.
+ * Comparisons and the logical operations result in the integer 1 or 0. Exact numbers are compared exactly, as soon as
+ * a float is involved both are compared as Float and NaN is neither less, greater nor equal to anything.
+ * AND and OR use both operands, the evaluators skip the right one when the left one decides (see Shortcut).
+ * CONDITION and ALTERNATIVE are not operations on two numbers and return ERROR_CODE::INVALID_OPERATOR.
+ * @param operation is the type of the operation node, e.g. AST_TYPE::ADDITION
+ * @param lhs is the left hand number
+ * @param rhs is the right hand number
+ * @param context is the scale and the rounding of decimal quotients
+ * @return The result or the ERROR_CODE of what went wrong
+ */
+template <std::floating_point Float>
+auto apply_operation ( AST_TYPE                  operation,
+                       const basic_num_t<Float>& lhs,
+                       const basic_num_t<Float>& rhs,
+                       const DecimalContext&     context = {} ) -> std::expected<basic_num_t<Float>, ERROR_CODE>;
 } // namespace pfme
\ No newline at end of file
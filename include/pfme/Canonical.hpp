@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <pfme/AST.hpp>
+#include <pfme/Error.hpp>
+#include <pfme/Lexer.hpp>
+#include <string>
+#include <string_view>
+
+namespace pfme
+{
+/**
+ * Enum for how far canonicalize() goes to make different ways of writing an expression equal.
+ */
+enum class CANONICAL : std::uint8_t
+{
+    EXACT,       /**< Only changes that keep every result the same: the two operands of + * == and != are ordered */
+    ASSOCIATIVE, /**< Also flattens chains of + and *, e.g. a + (b + c), and orders their operands, floats may round */
+};
+
+/**
+ * @brief A 128 bit hash of an expression, m_low alone is a good 64 bit hash.
+ *
+ * The hash only depends on the structure, the numbers, the names of the variables and the names of the functions, so it
+ * is the same in every process and on every platform with the same long double.
+ */
+struct Hash128
+{
+    std::uint64_t m_low  = 0;
+    std::uint64_t m_high = 0;
+
+    /**
+     * Writes the hash as 32 hexadecimal digits, m_high first.
+     * @return The hash as text, e.g. for the key of a cache on disk
+     */
+    [[nodiscard]] auto to_string() const -> std::string;
+
+    friend auto operator== ( const Hash128& lhs, const Hash128& rhs ) -> bool = default;
+};
+
+/**
+ * Builds the canonical form of a tree, every way of writing the same expression results in the same tree.
+ * Whitespace, seperators, parenthesis and the way numbers are written (e.g. 1'000, 1_000 and 0x3E8) are already gone
+ * after parsing, the canonical tree also orders the operands of commutative operations by their hash and with
+ * CANONICAL::ASSOCIATIVE rebuilds every chain of + or * as a left leaning chain of its ordered operands.
+ * Numbers lose the text they were written as (see AST::to_string()). The tree is walked without recursion.
+ * @param root is the root of a completely parsed tree, e.g. the return value of Parser::parse()
+ * @param mode is how far the tree is normalized
+ * @return The root of the new canonical tree, the input is not changed
+ */
+auto canonicalize ( const AST* root, CANONICAL mode = CANONICAL::EXACT ) -> std::shared_ptr<AST>;
+
+/**
+ * Hashes a tree as it is, trees with the same structure, numbers and names have the same hash.
+ * @see canonical_hash for a hash that ignores the order of commutative operands
+ * @param root is the root of a completely parsed tree
+ * @return The stable hash of the tree
+ */
+auto structural_hash ( const AST* root ) -> Hash128;
+
+/**
+ * Parses an expression and hashes its canonical form, e.g. to group identical jobs or as the key of a cache.
+ * @param input is the expression
+ * @param config is the number format of the input
+ * @param mode is how far the tree is normalized before it is hashed
+ * @return The hash of the canonical tree or the first error in the input
+ */
+auto canonical_hash ( std::string_view   input,
+                      const LexerConfig& config = LexerConfig::standard(),
+                      CANONICAL          mode = CANONICAL::EXACT ) -> Result<Hash128>;
+} // namespace pfme
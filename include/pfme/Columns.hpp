@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <pfme/Compiled.hpp>
+#include <span>
+#include <string>
+
+namespace pfme
+{
+/**
+ * @brief How evaluate_csv() and evaluate_binary() read and write their columns.
+ */
+struct ColumnOptions
+{
+    char        m_seperator    = ',';                      /**< Seperates the fields of a CSV row, e.g. ';' for german files */
+    char        m_point_symbol = '.';                      /**< The decimal point of the numbers, e.g. ',' for german files */
+    std::size_t m_block_rows   = std::size_t { 1 } << 16U; /**< Rows read, evaluated and written at once, bounds the memory */
+    std::string m_output_name  = "result";                 /**< The header of the written CSV column */
+};
+
+/**
+ * Evaluates an expression for every row of a CSV file and writes the results as a CSV column.
+ * The first row holds the names of the columns, every variable of the expression is read from the column with its
+ * name, other columns are skipped. The input is streamed in blocks of ColumnOptions::m_block_rows rows, so the memory
+ * does not grow with the size of the file. Numbers are parsed in place with std::from_chars and every row is computed
+ * in double (see CompiledExpression::evaluate_batch()). Numbers are read and written with ColumnOptions::m_point_symbol
+ * as decimal point (a '.' is not a number then), empty lines are skipped and quoted numbers are not supported.
+ * Throws a runtime error if a variable has no column, a row has too few fields or a field is not a number.
+ * @param expression is the expression
+ * @param input is the CSV file
+ * @param output receives a header row with ColumnOptions::m_output_name and one row per result
+ * @param options are the seperator, the decimal point and the block size
+ * @return The number of evaluated rows
+ */
+auto evaluate_csv ( const CompiledExpression& expression,
+                    std::istream&             input,
+                    std::ostream&             output,
+                    const ColumnOptions&      options = {} ) -> std::size_t;
+
+/**
+ * Evaluates an expression for every row of a raw binary file and writes the results as a raw binary column.
+ * A row is one little-endian 64 bit IEEE double for every column, without any header. The input is streamed in blocks
+ * like in evaluate_csv(), the results are written as little-endian doubles.
+ * Throws a runtime error if a variable is not one of the columns or the file ends in the middle of a row.
+ * @param expression is the expression
+ * @param input is the binary file, opened in binary mode
+ * @param columns are the names of the columns in the order they are stored in every row
+ * @param output receives one double per row, opened in binary mode
+ * @param options are the block size
+ * @return The number of evaluated rows
+ */
+auto evaluate_binary ( const CompiledExpression&    expression,
+                       std::istream&                input,
+                       std::span<const std::string> columns,
+                       std::ostream&                output,
+                       const ColumnOptions&         options = {} ) -> std::size_t;
+} // namespace pfme
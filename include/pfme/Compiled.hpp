@@ -0,0 +1,215 @@
+#pragma once
+#include <concepts>
+#include <memory>
+#include <optional>
+#include <pfme/AST.hpp>
+#include <pfme/Error.hpp>
+#include <pfme/Lexer.hpp>
+#include <pfme/Serialization.hpp>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pfme
+{
+class CompiledExpression;
+
+/**
+ * @brief The scratch space of CompiledExpression::evaluate().
+ *
+ * A context is used by one thread at a time, local() gives every thread its own one. The buffers grow to the size of
+ * the largest expression evaluated with the context and are kept afterwards.
+ * @tparam Float is the floating point type of the evaluation, see basic_visitor
+ */
+template <std::floating_point Float = LD>
+class basic_evaluation_context
+{
+public:
+    /**
+     * The context of the calling thread.
+     * @return A context that lives as long as the thread
+     */
+    static auto local() -> basic_evaluation_context&;
+
+private:
+    friend class CompiledExpression;
+
+    std::vector<basic_num_t<Float>>     m_values;    /**< The value of every node */
+    std::vector<AST::num_t>             m_arguments; /**< The arguments of a function call */
+    std::vector<Float>                  m_block;     /**< The values of every node for a block of rows, see evaluate_batch() */
+    std::vector<std::span<const Float>> m_columns;   /**< The argument columns of a batched function call */
+};
+
+using EvaluationContext = basic_evaluation_context<>; /**< The context for evaluations in long double */
+
+/**
+ * @brief The value of a variable that stays the same for many evaluations, see CompiledExpression::specialize().
+ */
+struct Binding
+{
+    std::string m_name;  /**< The name of the variable */
+    AST::num_t  m_value; /**< The value of the variable */
+};
+
+/**
+ * @brief A parsed expression that can be evaluated by many threads at the same time.
+ *
+ * The expression is stored in the flat form of the serialization (see BinaryNode) and never changes after it is
+ * compiled, evaluating it only writes into the context. Copies are handles that share the nodes, so an expression
+ * that is compiled once at startup can be handed to every thread without locks or copying the nodes.
+ * Variables are numbered in the order they first appear (see get_variables()), their values are passed to evaluate()
+ * in that order.
+ */
+class CompiledExpression
+{
+public:
+    /**
+     * Parses and compiles an expression without throwing.
+     * @param input is the expression
+     * @param config is the number format of the input
+     * @return The compiled expression or the first error in the input, ERROR_CODE::UNSUPPORTED_RANGE for sum and prod
+     */
+    static auto compile ( std::string_view input, const LexerConfig& config = LexerConfig::standard() )
+        -> Result<CompiledExpression>;
+    /**
+     * Compiles a parsed tree, throws a runtime error if the tree is incomplete or contains sum or prod.
+     * @param root is the root of a completely parsed tree, e.g. the return value of Parser::parse()
+     */
+    explicit CompiledExpression ( const AST* root );
+    /**
+     * Compiles serialized nodes, e.g. of a MappedExpression, the nodes are copied.
+     * @param nodes are nodes in post order that passed validate(), a runtime error is thrown if they contain sum or prod
+     */
+    explicit CompiledExpression ( std::span<const BinaryNode> nodes );
+
+    /**
+     * Evaluates the expression, only the context is written to.
+     * Every operation is computed in Float like in basic_visitor<Float>. Only the branch a condition selects is
+     * evaluated, see Shortcut.
+     * @param context is the scratch space, it can not be used by another thread at the same time
+     * @param variables are the values of the variables, ERROR_CODE::UNBOUND_VARIABLE is returned if there are too few
+     * @return The result or the error that stopped the evaluation
+     */
+    template <std::floating_point Float>
+    auto evaluate ( basic_evaluation_context<Float>& context, std::span<const basic_num_t<Float>> variables = {} ) const
+        -> Result<basic_num_t<Float>>
+    {
+        return evaluate ( context, variables, DecimalContext {} );
+    }
+    /**
+     * Evaluates the expression with the scale and rounding of a Session, e.g. the term of a sum or prod.
+     * @see evaluate(basic_evaluation_context<Float>&, std::span<const basic_num_t<Float>>)
+     * @param context is the scratch space, it can not be used by another thread at the same time
+     * @param variables are the values of the variables
+     * @param decimal_context rounds the quotients of decimals
+     * @return The result or the error that stopped the evaluation
+     */
+    template <std::floating_point Float>
+    auto evaluate ( basic_evaluation_context<Float>&    context,
+                    std::span<const basic_num_t<Float>> variables,
+                    const DecimalContext&               decimal_context ) const -> Result<basic_num_t<Float>>;
+    /**
+     * Evaluates the expression with the context of the calling thread.
+     * @see evaluate(basic_evaluation_context<Float>&, std::span<const basic_num_t<Float>>)
+     * @param variables are the values of the variables
+     * @return The result or the error that stopped the evaluation
+     */
+    template <std::floating_point Float = LD>
+    auto evaluate ( std::span<const basic_num_t<Float>> variables = {} ) const -> Result<basic_num_t<Float>>
+    {
+        return evaluate ( basic_evaluation_context<Float>::local(), variables );
+    }
+    /**
+     * Evaluates the expression for many rows of variables, e.g. the columns of a data file.
+     * The rows are processed in blocks, every node is evaluated for the whole block at once, so the loops over the rows
+     * vectorize and functions use their batched implementation (see Function::batch_t). Every row is computed in Float,
+     * rows outside of the domain result in NaN or infinity instead of an error. Comparisons result in 1 or 0, both
+     * results of a condition are computed for the whole block and every row selects one of them without a branch.
+     * Throws a runtime error if a variable has no column or a column has the wrong size.
+     * @param context is the scratch space, it can not be used by another thread at the same time
+     * @param variables has a column for every variable, variables[i][row] is the value of variable i in the row
+     * @param results receives the value of every row, its size is the number of rows
+     */
+    template <std::floating_point Float>
+    auto evaluate_batch ( basic_evaluation_context<Float>&        context,
+                          std::span<const std::span<const Float>> variables,
+                          std::span<Float>                        results ) const -> void;
+    /**
+     * Evaluates the expression for many rows with the context of the calling thread.
+     * @see evaluate_batch(basic_evaluation_context<Float>&, std::span<const std::span<const Float>>, std::span<Float>)
+     * @param variables has a column for every variable
+     * @param results receives the value of every row
+     */
+    template <std::floating_point Float = double>
+    auto evaluate_batch ( std::span<const std::span<const Float>> variables, std::span<Float> results ) const -> void
+    {
+        evaluate_batch ( basic_evaluation_context<Float>::local(), variables, results );
+    }
+    /**
+     * Partially evaluates the expression for some of its variables, e.g. parameters that are fixed for a whole job
+     * while the other variables change with every row.
+     * Every subtree that only depends on numbers and bound variables is folded into a single number with the arithmetic
+     * of the Visitor (exact for integers, fractions and decimals, long double for floats). A condition, && or || whose
+     * left hand is known keeps only the part it still needs. A subtree that fails to fold (e.g. a division by zero) is
+     * kept as it is, so evaluating the result reports the error where the original expression would.
+     * The remaining variables are numbered again in the order they first appear, names that are not variables of the
+     * expression are ignored.
+     * @param bindings are the values of the bound variables
+     * @param context rounds the quotients of decimals
+     * @return The smaller expression, evaluating it gives the result of this one with the bound values
+     */
+    [[nodiscard]] auto specialize ( std::span<const Binding> bindings, const DecimalContext& context = {} ) const
+        -> CompiledExpression;
+    /**
+     * Getter for the variables.
+     * @return The names of the variables, the index of a name is the number of the variable
+     */
+    [[nodiscard]] auto get_variables() const -> std::span<const std::string> { return m_program->m_variables; }
+    /**
+     * Looks up the number of a variable.
+     * @param name is the name of the variable
+     * @return The index of the value of the variable or nothing if the expression does not contain it
+     */
+    [[nodiscard]] auto find_variable ( std::string_view name ) const -> std::optional<std::size_t>;
+    /**
+     * Getter for the nodes.
+     * @return The nodes in post order, they live as long as any handle to the expression
+     */
+    [[nodiscard]] auto get_nodes() const -> std::span<const BinaryNode> { return m_program->m_nodes; }
+    /**
+     * Getter for the shortcuts of the branches.
+     * @return A Shortcut for every node or nothing if the expression has no branches
+     */
+    [[nodiscard]] auto get_shortcuts() const -> std::span<const Shortcut> { return m_program->m_shortcuts; }
+    /**
+     * Rebuilds the tree of the expression.
+     * @see pfme::to_ast
+     */
+    [[nodiscard]] auto to_ast() const -> std::shared_ptr<AST>
+    {
+        return pfme::to_ast ( m_program->m_nodes, m_program->m_variables );
+    }
+
+private:
+    struct Program
+    {
+        std::vector<BinaryNode>  m_nodes;     /**< The expression in post order */
+        std::vector<std::string> m_variables; /**< The name of every variable number */
+        std::vector<Shortcut>    m_shortcuts; /**< Where evaluate() jumps over the branches not taken */
+    };
+
+    /**
+     * Takes the nodes and the names of their variables.
+     * @param nodes are the nodes in post order
+     * @param variables are the names of the variable numbers, they do not have to fit into a node
+     */
+    CompiledExpression ( std::vector<BinaryNode>&& nodes, std::vector<std::string>&& variables );
+
+    std::shared_ptr<const Program> m_program; /**< Shared by all handles, never changed */
+};
+
+extern template class basic_evaluation_context<float>;
+extern template class basic_evaluation_context<double>;
+extern template class basic_evaluation_context<LD>;
+} // namespace pfme
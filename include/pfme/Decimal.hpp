@@ -0,0 +1,131 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <pfme/Fraction.hpp>
+#include <string>
+#include <string_view>
+
+namespace pfme
+{
+using LD  = long double;
+using LLI = long long int;
+
+/**
+ * Enum for the ways the result of a decimal division is rounded to the scale of its DecimalContext.
+ */
+enum class ROUNDING : std::uint8_t
+{
+    HALF_EVEN, /**< To the nearest, ties to the even neighbour (banker's rounding) */
+    HALF_UP,   /**< To the nearest, ties away from zero (commercial rounding) */
+    HALF_DOWN, /**< To the nearest, ties towards zero */
+    DOWN,      /**< Towards zero (truncation) */
+    UP,        /**< Away from zero */
+    FLOOR,     /**< Towards negative infinity */
+    CEILING,   /**< Towards positive infinity */
+};
+
+/**
+ * @brief How a division of decimals that does not end is rounded.
+ */
+struct DecimalContext
+{
+    std::uint8_t m_scale    = 9;                   /**< The digits after the point of a quotient, at most Decimal::MAX_SCALE */
+    ROUNDING     m_rounding = ROUNDING::HALF_EVEN; /**< How the last digit is rounded */
+};
+
+/**
+ * @brief A scaled fixed point number, the value is mantissa / 10^scale.
+ *
+ * Every decimal literal with at most MAX_SCALE digits after the point is stored exactly (e.g. 0.1 is 1 / 10^1), so
+ * sums of prices do not pick up the error of a binary float. Addition, subtraction and multiplication only use 64 bit
+ * integer arithmetic and are exact, an operation whose exact result does not fit returns nothing instead and the
+ * caller decides what to fall back to. The results never have the smallest LLI as mantissa, so they can always be
+ * negated. Decimals are kept normalized (no trailing zeros in the mantissa), so two decimals of the same value are
+ * always equal.
+ */
+class Decimal
+{
+public:
+    static constexpr std::uint8_t MAX_SCALE = 18; /**< 10^18 is the largest power of ten in a LLI */
+
+    Decimal()                             = default;
+    Decimal ( const Decimal& )            = default;
+    Decimal ( Decimal&& )                 = default;
+    ~Decimal()                            = default;
+    Decimal& operator= ( const Decimal& ) = default;
+    Decimal& operator= ( Decimal&& )      = default;
+
+    /**
+     * Creates a whole decimal.
+     * @param integer is the value
+     */
+    explicit Decimal ( LLI integer );
+    /**
+     * Creates a decimal from its parts, throws a runtime error if the scale is larger than MAX_SCALE.
+     * @param mantissa is the value times 10^scale
+     * @param scale is the number of digits after the point
+     */
+    Decimal ( LLI mantissa, std::uint8_t scale );
+
+    /**
+     * Reads a decimal from a number as the Lexer normalized it (digits, an optional '.' and an optional exponent).
+     * @param text is the number, e.g. "12.50" or "1.5e-3"
+     * @return The exact value or nothing if the text is not a number or the value has no exact decimal of 64 bits
+     */
+    static auto from_chars ( std::string_view text ) -> std::optional<Decimal>;
+
+    auto mantissa() const -> LLI { return m_mantissa; }
+    auto scale() const -> std::uint8_t { return m_scale; }
+    auto is_whole() const -> bool { return m_scale == 0; }
+    auto to_string() const -> std::string;
+    /**
+     * Writes the decimal without allocating, like std::to_chars.
+     * @param first is the start of the buffer
+     * @param last is the end of the buffer
+     * @return The end of the written text or std::errc::value_too_large
+     */
+    auto to_chars ( char* first, char* last ) const -> std::to_chars_result;
+    /**
+     * The exact value as a fraction, 10^scale always fits into the denominator.
+     * @return mantissa / 10^scale reduced
+     */
+    auto to_fraction() const -> Fraction;
+    explicit operator LD() const;
+
+    /**
+     * Exact operations, nothing is returned if the result needs more than 64 bits or more than MAX_SCALE digits.
+     * @param other is the right hand operand
+     * @return The exact result or nothing
+     */
+    auto add ( const Decimal& other ) const -> std::optional<Decimal>;
+    auto subtract ( const Decimal& other ) const -> std::optional<Decimal>; /**< @see add() */
+    auto multiply ( const Decimal& other ) const -> std::optional<Decimal>; /**< @see add() */
+    /**
+     * Divides and rounds the quotient to the scale of the context, an exact quotient with fewer digits stays exact.
+     * The divisor must not be zero.
+     * @param other is the divisor
+     * @param context is the scale and the rounding of the quotient
+     * @return The rounded quotient or nothing if it does not fit into 64 bits
+     */
+    auto divide ( const Decimal& other, const DecimalContext& context ) const -> std::optional<Decimal>;
+
+    auto        operator-() const -> Decimal { return Decimal { -m_mantissa, m_scale }; }
+    friend auto operator== ( const Decimal& lhs, const Decimal& rhs ) -> bool = default;
+    /**
+     * The exact operations for code that works on the alternatives of a number directly.
+     * They throw a runtime error where add(), subtract() and multiply() return nothing.
+     */
+    friend auto operator+ ( const Decimal& lhs, const Decimal& rhs ) -> Decimal;
+    friend auto operator- ( const Decimal& lhs, const Decimal& rhs ) -> Decimal; /**< @see operator+ */
+    friend auto operator* ( const Decimal& lhs, const Decimal& rhs ) -> Decimal; /**< @see operator+ */
+    friend auto operator<< ( std::ostream& stream, const Decimal& obj ) -> std::ostream&;
+
+private:
+    LLI          m_mantissa = 0;
+    std::uint8_t m_scale    = 0;
+
+    auto normalize() -> void;
+};
+} // namespace pfme
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <expected>
+#include <limits>
+#include <pfme/Token.hpp>
+#include <string>
+#include <string_view>
+
+namespace pfme
+{
+/**
+ * Enum for everything that can go wrong while lexing, parsing or evaluating an expression.
+ */
+enum class ERROR_CODE : std::uint8_t
+{
+    CHARACTER_TOO_LARGE, /**< A character outside of ASCII was found */
+    TWO_POINTS,          /**< A number contains two decimal points */
+    UNEXPECTED_TOKEN,    /**< The Parser expected a specific token and found another one */
+    INVALID_TOKEN,       /**< The Parser expected a number or a parenthesis */
+    INVALID_OPERATOR,    /**< The Parser expected an operator */
+    INVALID_NUMBER,      /**< A number without any digits */
+    NUMBER_OUT_OF_RANGE, /**< A number does not fit into its type */
+    EMPTY_EXPRESSION,    /**< The input does not contain an expression */
+    DIVISION_BY_ZERO,    /**< Division by zero during the evaluation */
+    UNKNOWN_FUNCTION,    /**< A name that is not in the FunctionRegistry */
+    ARGUMENT_COUNT,      /**< A function was called with too few or too many arguments */
+    DOMAIN_ERROR,        /**< A function was called with an argument it is not defined for, e.g. sqrt(-1) */
+    UNBOUND_VARIABLE,    /**< A variable was evaluated without a value */
+    NOT_DIFFERENTIABLE,  /**< A derivative was needed of a function that does not have one */
+    WORKER_FAILED,       /**< The worker process evaluating the expression crashed or did not answer in time, see Supervisor */
+    INPUT_TOO_LONG,      /**< The expression does not fit into a request of the Supervisor */
+    LIMIT_EXCEEDED,      /**< The expression needs more than one of its Limits allow, e.g. too many tokens or steps */
+    UNSUPPORTED_RANGE,   /**< sum or prod outside of the Visitor, e.g. in a CompiledExpression or inside another range */
+};
+
+/**
+ * Get a short description for each ERROR_CODE.
+ * @param code is the ERROR_CODE for which you want the description
+ * @return Is a description of the error without any details (e.g. "Division by Zero")
+ */
+auto error_code_to_string ( ERROR_CODE code ) -> std::string_view;
+
+/**
+ * @brief A compact description of an error, it only becomes a message if one is needed.
+ * @see message()
+ */
+struct Error
+{
+    static constexpr std::uint32_t NO_POSITION = std::numeric_limits<std::uint32_t>::max();
+
+    ERROR_CODE    m_code;                                 /**< What went wrong */
+    std::uint32_t m_position = NO_POSITION;               /**< The index in the input where it went wrong */
+    TOKEN_TYPE    m_found    = TOKEN_TYPE::TOKEN_UNKNOWN; /**< The token that was found, only for parser errors */
+    TOKEN_TYPE    m_expected = TOKEN_TYPE::TOKEN_UNKNOWN; /**< The token that was expected, only for UNEXPECTED_TOKEN */
+
+    /**
+     * Formats the error the same way the exceptions of the Lexer, Parser and Visitor do.
+     * @param input is the input that caused the error, used to point at the position
+     * @return A multi line error message, see Lexer::error_string()
+     */
+    [[nodiscard]] auto message ( std::string_view input ) const -> std::string;
+};
+
+/**
+ * The return type of all functions that report errors without throwing.
+ */
+template <typename T>
+using Result = std::expected<T, Error>;
+
+/**
+ * Helper function for generating error messages.
+ * @see Lexer::error_string
+ * @param msg will be the beginning of the string
+ * @param input is the input that caused the error
+ * @param position is the index in the input the error points to
+ * @return A formatted error string
+ */
+auto format_error ( std::string_view msg, std::string_view input, std::size_t position ) -> std::string;
+} // namespace pfme
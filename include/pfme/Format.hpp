@@ -0,0 +1,57 @@
+#pragma once
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <pfme/AST.hpp>
+#include <string>
+
+namespace pfme
+{
+/**
+ * Enum for the ways a float can be written.
+ */
+enum class NUMBER_FORMAT : std::uint8_t
+{
+    SHORTEST,  /**< The shortest text that reads back to exactly the same value */
+    FIXED,     /**< A fixed number of digits after the point, like %f (std::to_string uses 6) */
+    PRECISION, /**< A fixed number of significant digits, like %g */
+};
+
+/**
+ * @brief Describes how numbers are written.
+ * Integers and decimals are always written completely and fractions as "numerator / denominator", the format only
+ * affects floats.
+ */
+struct NumberFormat
+{
+    NUMBER_FORMAT m_format    = NUMBER_FORMAT::SHORTEST; /**< How floats are written */
+    int           m_precision = 6;                       /**< The digits for FIXED and PRECISION, ignored by SHORTEST */
+};
+
+/**
+ * The format of std::to_string, used wherever a number is turned into a std::string without a format.
+ */
+constexpr NumberFormat TO_STRING_FORMAT { NUMBER_FORMAT::FIXED, 6 };
+
+/**
+ * Writes a number into a caller provided buffer without allocating, instantiated for float, double and long double.
+ * @param first is the start of the buffer
+ * @param last is the end of the buffer
+ * @param number is the number that is written
+ * @param format describes how floats are written
+ * @return Like std::to_chars: the end of the written text or std::errc::value_too_large if the buffer is too small
+ */
+template <std::floating_point Float>
+auto format_number ( char* first, char* last, const basic_num_t<Float>& number, NumberFormat format = {} )
+    -> std::to_chars_result;
+
+/**
+ * Writes a number into a string.
+ * @see format_number(char*, char*, const basic_num_t<Float>&, NumberFormat)
+ * @param number is the number that is written
+ * @param format describes how floats are written
+ * @return The number as a string
+ */
+template <std::floating_point Float>
+auto format_number ( const basic_num_t<Float>& number, NumberFormat format = {} ) -> std::string;
+} // namespace pfme
@@ -25,6 +25,8 @@ public:
     auto        to_string() const -> std::string;
     auto        is_whole() const -> bool;
     auto        inverse() const -> Fraction;
+    auto        numerator() const -> LLI { return m_numerator; }
+    auto        denominator() const -> LLI { return m_denominator; }
     explicit            operator LLI() const;
     explicit            operator LD() const;
 
@@ -0,0 +1,144 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <pfme/AST.hpp>
+#include <pfme/Error.hpp>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace pfme
+{
+/**
+ * Enum for the built-in functions, the value is the id of the function in the FunctionRegistry.
+ */
+enum class FUNCTION : std::uint32_t
+{
+    SQRT, /**< Square root, exact for square integers and fractions */
+    EXP,  /**< Exponential function */
+    LOG,  /**< Natural logarithm */
+    SIN,  /**< Sine */
+    COS,  /**< Cosine */
+    MIN,  /**< Smallest of one or more arguments */
+    MAX,  /**< Largest of one or more arguments */
+    ABS,  /**< Absolute value, keeps the type of the argument */
+    KSUM, /**< Sum of one or more arguments, exact or compensated (Kahan-Babuska) once a float is involved */
+    SUM,  /**< sum(i, first, last, term), the term for every integer i from first to last added up, evaluated by the Visitor */
+    PROD, /**< prod(i, first, last, term), like SUM but multiplied */
+};
+
+/**
+ * @brief A function that can be called in an expression, e.g. sqrt(2) or max(1, 2, 3).
+ *
+ * Every function has a scalar implementation that works on the numbers of the AST and a batched implementation that
+ * evaluates whole columns of doubles at once, e.g. for the values of a variable in many rows.
+ */
+struct Function
+{
+    static constexpr std::size_t VARIADIC = std::numeric_limits<std::size_t>::max(); /**< No upper limit for m_max_arguments */
+
+    /**
+     * Evaluates the function for one set of arguments.
+     * The number of arguments is already checked against m_min_arguments and m_max_arguments.
+     */
+    using scalar_t = auto ( * ) ( std::span<const AST::num_t> arguments ) -> std::expected<AST::num_t, ERROR_CODE>;
+    /**
+     * Evaluates the function for every row, arguments[i][row] is the i-th argument of the row.
+     * All columns have the size of results, results may be the same memory as one of the arguments.
+     * Rows outside of the domain of the function result in NaN instead of an error.
+     */
+    using batch_t = auto ( * ) ( std::span<const std::span<const double>> arguments, std::span<double> results ) -> void;
+    /**
+     * Writes the partial derivative with respect to every argument at the point of the arguments, partials has the
+     * size of arguments. Used by the automatic differentiation, see gradient().
+     */
+    using derivative_t = auto ( * ) ( std::span<const LD> arguments, std::span<LD> partials ) -> void;
+
+    std::string  m_name;              /**< The name used in expressions */
+    std::size_t  m_min_arguments = 1; /**< The least number of arguments */
+    std::size_t  m_max_arguments = 1; /**< The most number of arguments, VARIADIC for no limit */
+    scalar_t     m_scalar        = nullptr; /**< Only nullptr for the ranges sum and prod */
+    batch_t      m_batch         = nullptr; /**< Only nullptr for the ranges sum and prod */
+    derivative_t m_derivative    = nullptr; /**< Optional, calls of the function can not be differentiated without it */
+};
+
+/**
+ * @brief All functions that can be called in expressions.
+ *
+ * The registry starts with the built-in functions (see FUNCTION), more can be added at any time. Functions are only
+ * ever added, so an id stays valid and can be looked up without locking while other threads add functions.
+ * Ids of added functions depend on the order they were added in, so serialized expressions store the names of the
+ * functions they call and the reader looks them up by name (see BinaryNode::get_function()).
+ */
+class FunctionRegistry
+{
+public:
+    static constexpr std::size_t MAX_FUNCTIONS = 256; /**< The capacity of the registry, including the built-ins */
+
+    /**
+     * The registry used by the Parser, the Visitor and the serialization.
+     * @return The registry with the built-in functions and all added ones
+     */
+    static auto global() -> FunctionRegistry&;
+
+    /**
+     * Adds a function, throws a runtime error if the name is not a valid name, already taken or the registry is full.
+     * @param function is the function to add, both implementations have to be set
+     * @return The id of the new function
+     */
+    auto add ( Function function ) -> std::uint32_t;
+    /**
+     * Looks up a function by its name.
+     * @param name is the name as written in the expression
+     * @return The id of the function or nothing if there is no function with that name
+     */
+    [[nodiscard]] auto find ( std::string_view name ) const -> std::optional<std::uint32_t>;
+    /**
+     * Looks up a function by its id, the id has to be smaller than size().
+     * @param id is the id of the function
+     * @return The function
+     */
+    [[nodiscard]] auto get ( std::uint32_t id ) const -> const Function& { return m_functions[id]; }
+    /**
+     * The number of functions.
+     * @return One more than the largest valid id
+     */
+    [[nodiscard]] auto size() const -> std::uint32_t { return m_size.load ( std::memory_order_acquire ); }
+
+private:
+    FunctionRegistry();
+
+    std::array<Function, MAX_FUNCTIONS> m_functions {};
+    std::atomic<std::uint32_t>          m_size { 0 };
+    std::mutex                          m_add_mutex; /**< Only adding functions is serialized */
+};
+
+/**
+ * Calls a function of the global registry with numbers of the AST.
+ * @param function is the id of the function
+ * @param arguments are the arguments of the call
+ * @return The result or the ERROR_CODE of what went wrong, e.g. ERROR_CODE::DOMAIN_ERROR for sqrt(-1) and
+ * ERROR_CODE::UNSUPPORTED_RANGE for sum and prod
+ */
+auto call ( std::uint32_t function, std::span<const AST::num_t> arguments ) -> std::expected<AST::num_t, ERROR_CODE>;
+
+/**
+ * Calls a function of the global registry for whole columns, throws a runtime error for sum and prod and if the number
+ * of arguments or the size of a column does not fit.
+ * The built-in functions use the vector units on x86-64 (see simd::get_level()), sqrt, abs, min and max return exactly
+ * the results of the scalar code, exp, log, sin and cos stay within a few units in the last place of them.
+ * @see Function::batch_t
+ * @param function is the id of the function
+ * @param arguments are the columns of the arguments
+ * @param results is the column the results are written to
+ */
+auto call_batch ( std::uint32_t                            function,
+                  std::span<const std::span<const double>> arguments,
+                  std::span<double>                        results ) -> void;
+} // namespace pfme
@@ -0,0 +1,90 @@
+#pragma once
+#include <concepts>
+#include <cstdint>
+#include <pfme/Compiled.hpp>
+#include <span>
+#include <vector>
+
+namespace pfme
+{
+/**
+ * Enum for the ways derivatives are computed.
+ */
+enum class AD_MODE : std::uint8_t
+{
+    FORWARD, /**< Dual numbers, every node carries its derivatives with respect to all variables */
+    REVERSE, /**< The nodes are evaluated once and the derivative of the result is propagated back through them */
+};
+
+/**
+ * @brief The scratch space of gradient() and gradient_batch().
+ *
+ * Like basic_evaluation_context a context is used by one thread at a time, local() gives every thread its own one.
+ * @tparam Float is the floating point type of the derivatives
+ */
+template <std::floating_point Float = double>
+struct basic_gradient_context
+{
+    /**
+     * The context of the calling thread.
+     * @return A context that lives as long as the thread
+     */
+    static auto local() -> basic_gradient_context&;
+
+    std::vector<basic_num_t<Float>>     m_numbers;     /**< The exact value of every node */
+    std::vector<Float>                  m_values;      /**< The value of every node, a block of rows per node for batches */
+    std::vector<Float>                  m_derivatives; /**< Tangents (forward) or adjoints (reverse) of every node */
+    std::vector<std::uint8_t>           m_dependent;   /**< 1 for every node that depends on a variable */
+    std::vector<std::uint32_t>          m_children;    /**< The argument nodes of a function call */
+    std::vector<AST::num_t>             m_arguments;   /**< The arguments of a function call */
+    std::vector<LD>                     m_points;      /**< The arguments of a derivative */
+    std::vector<LD>                     m_partials;    /**< The partial derivatives of a function */
+    std::vector<std::span<const Float>> m_columns;     /**< The argument columns of a batched function call */
+};
+
+using GradientContext = basic_gradient_context<>; /**< The context for derivatives in double */
+
+/**
+ * Evaluates an expression and computes its partial derivative with respect to every variable in one pass.
+ * The value is computed like CompiledExpression::evaluate(), the derivatives in Float. The derivative of x ^ y with
+ * respect to y only exists for a positive x and is NaN otherwise. Functions need a Function::m_derivative.
+ * Both modes and gradient_batch() skip every term of the chain rule whose partial or incoming derivative is 0, so they
+ * give the same derivatives, e.g. 0 for 0 * sqrt(x) at x = 0 instead of 0 * infinity.
+ * Throws a runtime error if partials does not have one entry for every variable of the expression.
+ * @param expression is the expression, its variables are numbered like in CompiledExpression::get_variables()
+ * @param variables are the values of the variables
+ * @param partials receives the partial derivatives, in the order of the variables
+ * @param mode decides how the derivatives are computed, REVERSE is faster for more than a few variables
+ * @param context is the scratch space
+ * @return The value of the expression or the error that stopped the evaluation, e.g. ERROR_CODE::NOT_DIFFERENTIABLE
+ */
+template <std::floating_point Float>
+auto gradient ( const CompiledExpression&      expression,
+                std::span<const Float>         variables,
+                std::span<Float>               partials,
+                AD_MODE                        mode    = AD_MODE::REVERSE,
+                basic_gradient_context<Float>& context = basic_gradient_context<Float>::local() ) -> Result<Float>;
+
+/**
+ * Computes the value and the partial derivatives for many rows of variables with the reverse mode.
+ * The rows are processed in blocks, every node is evaluated for the whole block at once, so the loops over the rows
+ * vectorize and functions use their batched implementation (see Function::batch_t). Every row is computed in Float,
+ * rows outside of the domain result in NaN or infinity instead of an error.
+ * Throws a runtime error if a column has the wrong size, a variable has no column or a function has no derivative.
+ * @param expression is the expression
+ * @param variables has a column of values for every variable, variables[i][row] is the value of variable i in the row
+ * @param values receives the value of every row, its size is the number of rows
+ * @param partials has a column for every variable, partials[i][row] receives the derivative with respect to variable i
+ * @param context is the scratch space
+ */
+template <std::floating_point Float>
+auto gradient_batch ( const CompiledExpression&               expression,
+                      std::span<const std::span<const Float>> variables,
+                      std::span<Float>                        values,
+                      std::span<const std::span<Float>>       partials,
+                      basic_gradient_context<Float>&          context = basic_gradient_context<Float>::local() ) -> void;
+
+extern template struct basic_gradient_context<float>;
+extern template struct basic_gradient_context<double>;
+extern template struct basic_gradient_context<LD>;
+} // namespace pfme
@@ -1,16 +1,145 @@
 #pragma once
+#include <array>
 #include <format>
 #include <memory>
+#include <pfme/Error.hpp>
+#include <pfme/Limits.hpp>
 #include <pfme/Token.hpp>
 #include <string>
 #include <string_view>
 #include <vector>
 namespace pfme
 {
+/**
+ * Enum for the classes a character can belong to, a character can be in more than one class.
+ */
+enum class CHAR_CLASS : std::uint8_t
+{
+    DIGIT      = 1U << 0U, /**< 0-9 */
+    HEX_DIGIT  = 1U << 1U, /**< 0-9, a-f and A-F */
+    POINT      = 1U << 2U, /**< The decimal point */
+    SEPERATOR  = 1U << 3U, /**< A digit seperator */
+    WHITESPACE = 1U << 4U, /**< Space, tab and line end */
+    OPERATOR   = 1U << 5U, /**< A character that is a Token on its own, e.g. + or ( */
+    EXPONENT   = 1U << 6U, /**< e and E, the start of the exponent in scientific notation */
+    LETTER     = 1U << 7U, /**< a-z and A-Z, the characters of function names */
+};
+
+/**
+ * @brief The number format of a Lexer.
+ *
+ * The configuration is validated and turned into a table with the CHAR_CLASS of every character when it is created,
+ * the Lexer only looks up characters in that table. A configuration can be reused for any number of Lexers.
+ */
+class LexerConfig
+{
+public:
+    /**
+     * Creates the default configuration, '.' as point and ', ',' and '_' as seperators.
+     */
+    LexerConfig();
+    /**
+     * Creates a configuration and validates it, throws a runtime error if the configuration is ambiguous.
+     * The point and the seperators can not be digits, letters, operators or control characters and the point can not
+     * be a seperator or whitespace. A space as seperator allows grouping with spaces (e.g. 1 000 000).
+     * The argument seperator may also be a digit seperator, inside the parentheses of a function call it always
+     * seperates arguments (e.g. max(1,000) has two arguments).
+     * @param point_symbol is the decimal point
+     * @param seperators are the characters allowed between digits
+     * @param argument_seperator seperates the arguments of function calls, '\0' picks ',' or ';' if ',' is the point
+     */
+    LexerConfig ( char point_symbol, std::vector<char> seperators, char argument_seperator = '\0' );
+
+    /**
+     * The default configuration.
+     * @return '.' as point with ', ',' and '_' as seperators
+     */
+    static auto standard() -> const LexerConfig&;
+    /**
+     * The configuration of the -ger mode.
+     * @return ',' as point with '.', ' and '_' as seperators and ';' between function arguments
+     */
+    static auto german() -> const LexerConfig&;
+    /**
+     * The Swiss configuration.
+     * @return '.' as point with ' as seperator (e.g. 1'000.5)
+     */
+    static auto swiss() -> const LexerConfig&;
+    /**
+     * A configuration that groups digits with spaces.
+     * @return '.' as point with ' ' and '_' as seperators (e.g. 1 000.5)
+     */
+    static auto space_grouping() -> const LexerConfig&;
+
+    /**
+     * Looks up the class of a character.
+     * @param character is the character to check
+     * @param type is the class to check for
+     * @return true if the character belongs to the class
+     */
+    [[nodiscard]] auto is ( char character, CHAR_CLASS type ) const -> bool
+    {
+        return ( m_classes[static_cast<unsigned char> ( character )] & static_cast<std::uint8_t> ( type ) ) != 0;
+    }
+    /**
+     * Checks if a character is skipped between tokens.
+     * @param character is the character to check
+     * @return true for whitespace and seperators
+     */
+    [[nodiscard]] auto is_skipped ( char character ) const -> bool
+    {
+        constexpr auto SKIPPED =
+            static_cast<std::uint8_t> ( CHAR_CLASS::WHITESPACE ) | static_cast<std::uint8_t> ( CHAR_CLASS::SEPERATOR );
+        return ( m_classes[static_cast<unsigned char> ( character )] & SKIPPED ) != 0;
+    }
+    /**
+     * Getter for the point symbol.
+     * @return The decimal point
+     */
+    [[nodiscard]] auto get_point_symbol() const -> char { return m_point_symbol; }
+    /**
+     * Getter for the argument seperator.
+     * @return The character between the arguments of a function call
+     */
+    [[nodiscard]] auto get_argument_seperator() const -> char { return m_argument_seperator; }
+    /**
+     * Getter for the characters that are skipped between tokens, used by the vectorized scanning.
+     * @return The whitespace and seperator characters, empty if there are more than MAX_SKIPPED of them
+     */
+    [[nodiscard]] auto get_skipped() const -> std::string_view { return { m_skipped.data(), m_skipped_count }; }
+    /**
+     * Getter for decimal literals.
+     * @return true if numbers with a point or an exponent become a Decimal
+     */
+    [[nodiscard]] auto get_decimals() const -> bool { return m_decimals; }
+    /**
+     * Makes numbers with a point or an exponent a Decimal instead of a long double, e.g. for exact currency math.
+     * Numbers that have no exact Decimal (more than Decimal::MAX_SCALE digits after the point or more than 64 bits)
+     * stay long double.
+     * @param decimals is true for decimals and false for long double
+     */
+    auto set_decimals ( bool decimals ) -> void { m_decimals = decimals; }
+
+    static constexpr std::size_t MAX_SKIPPED = 8; /**< Each skipped character costs a comparison per vector */
+
+private:
+    std::array<std::uint8_t, 256> m_classes {}; /**< The CHAR_CLASS bits of every character */
+    std::array<char, MAX_SKIPPED> m_skipped {}; /**< The characters with the WHITESPACE or SEPERATOR class */
+    std::size_t                   m_skipped_count      = 0;
+    char                          m_point_symbol       = '.';
+    char                          m_argument_seperator = ',';
+    bool                          m_decimals           = false;
+};
 
 /**
  * @brief The Lexer class.
  * It's job is iterating over the input string, find tokens, and collect numbers.
+ *
+ * Numbers are converted with std::from_chars while they are collected, independent of the locale.
+ * Besides plain integers and floats (e.g. 42 or 4.2) it accepts scientific notation (e.g. 1.5e-9, always a float)
+ * and hexadecimal integers (e.g. 0x1F). Seperators are allowed between the digits of the mantissa.
+ * A letter followed by letters and digits is the name of a function (e.g. sqrt). The Lexer remembers which open
+ * parentheses belong to a function call, directly inside of them the argument seperator is a Token of its own.
  */
 class Lexer
 {
@@ -27,13 +156,59 @@ public:
     Lexer& operator= ( const Lexer& ) = default;
     Lexer& operator= ( Lexer&& )      = default;
 
+    /**
+     * Initialises the Lexer with an input string and a number format.
+     * @param data is the input string for the Lexer
+     * @param point_sym is the decimal point
+     * @param seperators are the characters allowed between digits
+     * @see LexerConfig
+     */
     Lexer ( std::string_view data, char point_sym, std::vector<char>&& seperators );
     /**
-	 * Collects the next token.
+     * Initialises the Lexer with an input string and a number format that is already validated.
+     * @param data is the input string for the Lexer
+     * @param config is the number format, it is copied
+     */
+    Lexer ( std::string_view data, const LexerConfig& config );
+    /**
+	 * Collects the next token, throws a runtime error with a formatted message if the input is invalid.
 	 * @return The found token as an unique_ptr
 	 * @see Token
 	 */
     auto get_next_token() -> std::unique_ptr<Token>;
+    /**
+	 * Collects the next token without throwing.
+	 * @return The found token as an unique_ptr or the Error if the input is invalid
+	 * @see get_next_token()
+	 */
+    auto try_next_token() -> Result<std::unique_ptr<Token>>;
+    /**
+     * Collects the next token into an existing one without throwing, the storage of the token is reused.
+     * @see try_next_token()
+     * @param token is overwritten with the found token
+     * @return Nothing or the Error if the input is invalid, the token is unspecified then
+     */
+    auto try_next_token ( Token& token ) -> Result<void>;
+    /**
+     * Starts over with a new input, the configuration and the capacity of all buffers are kept.
+     * @param data is the new input string
+     */
+    auto reset ( std::string_view data ) -> void;
+    /**
+     * Setter for the limits of the input, its tokens and its numbers, checked from the next token on.
+     * @param limits are the budgets of every input, the Parser and the Visitor read theirs from the Lexer as well
+     */
+    auto set_limits ( const Limits& limits ) -> void { m_limits = limits; }
+    /**
+     * Getter for the limits.
+     * @return The budgets of every input, unlimited by default
+     */
+    [[nodiscard]] auto get_limits() const -> const Limits& { return m_limits; }
+    /**
+     * Getter for the position.
+     * @return The index of the current character in the content
+     */
+    [[nodiscard]] auto get_position() const -> std::uint32_t { return m_index; }
     /**
      * Getter for the content.
      * @return The content of the Lexer as a string
@@ -55,32 +230,75 @@ public:
     auto error_string ( std::string_view msg, int index_modifier = 0 ) -> std::string;
 
 private:
-    unsigned int      m_index = 0;    /**< The index, the position of the Lexer in the string */
+    std::uint32_t     m_index = 0;    /**< The index, the position of the Lexer in the string */
     std::string       m_contents;     /**< The content of the Lexer */
     char              m_current_char; /**< The current character, will be the same as m_contents[m_index] */
-    char              m_point_symbol = '.';
-    std::vector<char> m_seperators { '\'', ',', '_' };
+    LexerConfig       m_config;       /**< The number format, decides the class of every character */
+    std::string       m_buffer {};    /**< Reused for numbers that contain seperators or a point other than '.' */
+    std::vector<bool> m_calls {};     /**< One entry for each open parenthesis, true if it belongs to a function call */
+    bool              m_after_name = false; /**< The last Token was a function name, so the next '(' starts a call */
+    Limits            m_limits {};          /**< The budgets of the input */
+    std::size_t       m_tokens = 0;         /**< The tokens collected since the last reset */
 
     /**
 	 * Advances the Lexer by one character, changes m_index and m_current_char.
 	 */
     auto advance() -> void;
 
+    /**
+     * Moves the Lexer to an index that was found by scanning ahead, changes m_index and m_current_char.
+     * @param index is the new index, at most the length of the content
+     */
+    auto jump_to ( std::size_t index ) -> void;
+
     /**
 	 * Will advance the Lexer until m_current_char is not a space, a line end, or a tab.
+	 * Inside of a function call it also stops at the argument seperator.
 	 */
     auto skip_whitespace() -> void;
 
     /**
-	 * Collects a number and will also check wether the number has two points (it throws a runtime error if it does).
-	 * @return Either a integer or float Token with the value set to the collected number
-	 */
-    auto collect_number() -> std::unique_ptr<Token>;
+     * Checks if the innermost open parenthesis belongs to a function call.
+     * @return true if the argument seperator is a Token at the current position
+     */
+    [[nodiscard]] auto in_call() const -> bool { return !m_calls.empty() && m_calls.back(); }
+
+    /**
+     * Collects the name of a function or variable, m_current_char has to be a letter. Letters, digits and a '_'
+     * followed by one of them are part of the name.
+     * @param token becomes an identifier Token with the name as value
+     */
+    auto collect_identifier ( Token& token ) -> void;
 
     /**
-	 * Helper function.
-	 * @return m_current_char as a string
+     * Collects a comparison or a logical operator, they can have two characters (e.g. <=).
+     * A single '=', '!', '&' or '|' is not an operator and becomes an unknown Token.
+     * @param token becomes the operator Token
+     * @return false if m_current_char can not start such an operator
+     */
+    auto collect_operator ( Token& token ) -> bool;
+
+    /**
+	 * Collects a number and will also check wether the number has two points (it fails if it does).
+	 * @param token becomes either a integer or float Token with the converted number, the value is the number as written
+	 * @return Nothing or an Error if the number is invalid
 	 */
-    [[nodiscard]] auto get_current_char_as_string() const -> std::string;
+    auto collect_number ( Token& token ) -> Result<void>;
+
+    /**
+     * Collects the digits of a hexadecimal integer, m_current_char has to be the first digit after the "0x".
+     * @param token becomes an integer Token
+     * @param start is the index of the leading '0'
+     * @return Nothing or an Error if there are no digits or the number is too large
+     */
+    auto collect_hex_number ( Token& token, std::uint32_t start ) -> Result<void>;
+
+    /**
+     * Removes the seperators and whitespace from a number and replaces the point symbol with '.'.
+     * @param start is the index of the first character of the number
+     * @param end is the index after the last character of the number
+     * @return The cleaned up number, points into m_buffer
+     */
+    auto normalize_number ( std::uint32_t start, std::uint32_t end ) -> std::string_view;
 };
 } // namespace pfme
\ No newline at end of file
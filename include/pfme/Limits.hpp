@@ -0,0 +1,47 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace pfme
+{
+/**
+ * @brief Budgets for a single expression, e.g. to bound the latency of expressions from untrusted sources.
+ *
+ * Every limit is checked where the work is done, the Lexer checks the input, its tokens and its numbers, the Parser the
+ * nesting and the Visitor the exponents, the steps and the time of the evaluation. An expression that exceeds a limit
+ * results in ERROR_CODE::LIMIT_EXCEEDED, with the position of the part that exceeded it where there is one.
+ * The default has no limits, see untrusted() for a configuration meant for hostile input.
+ */
+struct Limits
+{
+    static constexpr std::size_t UNLIMITED      = std::numeric_limits<std::size_t>::max();
+    static constexpr std::size_t CLOCK_INTERVAL = 256; /**< The Visitor looks at the clock once per this many steps */
+
+    std::size_t              m_input_length   = UNLIMITED; /**< Characters of the whole input */
+    std::size_t              m_tokens         = UNLIMITED; /**< Tokens of the input, without the end */
+    std::size_t              m_literal_length = UNLIMITED; /**< Characters of a single number, including its seperators */
+    std::size_t              m_depth          = UNLIMITED; /**< Operations on the right spine, open parentheses and calls */
+    std::uint64_t            m_exponent       = UNLIMITED; /**< Magnitude of an exact (integer or whole decimal) exponent */
+    std::size_t              m_steps          = UNLIMITED; /**< Operations and function calls of one evaluation */
+    std::chrono::nanoseconds m_time = std::chrono::nanoseconds::max(); /**< Wall time of one evaluation, see CLOCK_INTERVAL */
+
+    /**
+     * Limits for expressions typed by people or sent by clients that can not be trusted.
+     * @return Limits that keep the evaluation of every accepted expression far below a millisecond
+     */
+    static constexpr auto untrusted() -> Limits
+    {
+        Limits limits;
+        limits.m_input_length   = 16'384;
+        limits.m_tokens         = 4'096;
+        limits.m_literal_length = 64;
+        limits.m_depth          = 256;
+        limits.m_exponent       = 1'024;
+        limits.m_steps          = 10'000;
+        limits.m_time           = std::chrono::milliseconds { 10 };
+        return limits;
+    }
+};
+} // namespace pfme
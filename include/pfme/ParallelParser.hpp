@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <pfme/AST.hpp>
+#include <pfme/Error.hpp>
+#include <pfme/Lexer.hpp>
+#include <string_view>
+
+namespace pfme
+{
+/**
+ * @brief How parse_parallel() splits its input.
+ */
+struct ParallelOptions
+{
+    std::size_t m_threads    = 0;                        /**< The most chunks parsed at once, 0 uses one per core */
+    std::size_t m_chunk_size = std::size_t { 1 } << 20U; /**< The smallest chunk in bytes, smaller inputs use one Parser */
+};
+
+/**
+ * Parses one huge expression with several threads, the tree is the same one the Parser builds.
+ * The input is split into chunks in front of operator characters, where no number, name or run of seperators can
+ * be cut in two. Every chunk is lexed and parsed into a partial tree by its own thread, the operation levels of a
+ * chunk are shifted by the parenthesis it is nested in once all chunks are done. The partial trees are then zipped
+ * together along the right edge of one and the left edge of the next, like the Parser orders operations by level.
+ * Expressions with function calls and inputs with an error are parsed again by a single Parser, so the errors and
+ * their positions are the same as the ones of Parser::try_parse().
+ * @param input is the expression
+ * @param config is the number format
+ * @param options are the number of threads and the chunk size
+ * @return The root of the tree or the first error in the input
+ */
+auto parse_parallel ( std::string_view       input,
+                      const LexerConfig&     config = LexerConfig::standard(),
+                      const ParallelOptions& options = {} ) -> Result<std::shared_ptr<AST>>;
+} // namespace pfme
@@ -3,13 +3,44 @@
 #include <format>
 #include <iostream>
 #include <memory>
+#include <memory_resource>
 #include <optional>
 #include <pfme/AST.hpp>
+#include <pfme/Error.hpp>
 #include <pfme/Lexer.hpp>
 #include <pfme/Token.hpp>
+#include <string_view>
+#include <vector>
 
 namespace pfme
 {
+/**
+ * Enum for the precedence of the operations, the lower the level the higher up in the tree the operation ends up.
+ */
+enum class OPERATION_LEVEL : int
+{
+    CONDITIONAL,    /**< ? and :, both at the same level so conditions chain to the right */
+    OR,             /**< || */
+    AND,            /**< && */
+    EQUALITY,       /**< == and !=, they chain to the left like in C */
+    RELATIONAL,     /**< <, <=, > and >=, they chain to the left like in C */
+    ADDITIVE,       /**< + and - */
+    MULTIPLICATIVE, /**< * and / */
+    EXPONENTIAL,    /**< ^ */
+    COUNT,          /**< The number of levels, every pair of parentheses raises the levels inside it by this */
+};
+
+/**
+ * The level of an operation node.
+ * @param level is the precedence of the operation
+ * @param parenthesis_level is the number of open parentheses around the operation
+ * @return The value of AST::m_operation_level
+ */
+constexpr auto operation_level ( OPERATION_LEVEL level, int parenthesis_level ) -> int
+{
+    return ( parenthesis_level * static_cast<int> ( OPERATION_LEVEL::COUNT ) ) + static_cast<int> ( level );
+}
+
 /**
  * @brief The Parser class.
  * 
@@ -40,6 +71,14 @@ namespace pfme
  *       +   2
  *      / \
  *     4   3
+ *
+ * Every argument of a function call (e.g. max(1, 2 + 3)) is parsed like an expression of its own, the call is then
+ * used like a number (see AST for how the arguments are stored). Calls nest without recursion.
+ * A name without parentheses is a variable and used like a number as well.
+ *
+ * Comparisons and the logical operators bind weaker than the arithmetic ones, like in C (see OPERATION_LEVEL).
+ * In a conditional expression c ? a : b the '?' opens a parenthesis that the ':' closes, so a can be any expression
+ * and the ':' always belongs to the innermost open '?'.
  */
 class Parser
 {
@@ -56,6 +95,14 @@ public:
      * @param input is the input string with which the Lexer will be initialised
      */
     explicit Parser ( const std::string& input );
+    /**
+     * Initialises the Parser with a Lexer and a storage for the nodes of the tree.
+     * A pool resource (e.g. std::pmr::unsynchronized_pool_resource) gets the nodes of the last tree back when the next
+     * one is parsed, so reparsing short expressions does not allocate once the pool is warm.
+     * @param lexer is the Lexer that the Parser will use
+     * @param nodes is where the nodes are allocated, it has to outlive every node of the trees
+     */
+    Parser ( std::unique_ptr<Lexer>&& lexer, std::pmr::memory_resource* nodes );
     Parser ( const Parser& )            = default;
     Parser ( Parser&& )                 = default;
     ~Parser()                           = default;
@@ -74,6 +121,30 @@ public:
 	 * @return Is a shared pointer to the root of the constructed binary tree
 	 */
     auto parse() -> std::shared_ptr<AST>;
+    /**
+     * @brief Parses the input string without throwing.
+     * Errors of the Lexer and the Parser are returned instead of thrown, the tree is the same as the one of parse().
+     * @see parse()
+     * @return Is a shared pointer to the root of the constructed binary tree or the first error that occurred
+     */
+    auto try_parse() -> Result<std::shared_ptr<AST>>;
+    /**
+     * Releases the tree and starts over with a new input, the Lexer, the buffers and the node storage are kept.
+     * Call parse() or try_parse() afterwards.
+     * @param input is the new input string
+     */
+    auto reset ( std::string_view input ) -> void;
+    /**
+     * Setter for the limits, they are kept by the Lexer and checked from the next input on.
+     * @see Lexer::set_limits
+     * @param limits are the budgets of every input, the Parser checks the depth
+     */
+    auto set_limits ( const Limits& limits ) -> void { m_lexer->set_limits ( limits ); }
+    /**
+     * Getter for the limits.
+     * @return The budgets of every input, unlimited by default
+     */
+    [[nodiscard]] auto get_limits() const -> const Limits& { return m_lexer->get_limits(); }
     /**
      * @brief Helper function to print the binary tree.
      * 
@@ -86,6 +157,14 @@ public:
      * @param node is a pointer to the root node from which the tree is printed
      */
     static auto print_binary_tree ( const AST* node ) -> void;
+    /**
+     * Prints the binary tree into a stream, without the empty line at the end.
+     * The tree is walked without recursion, the depth of the tree is only limited by memory.
+     * @see print_binary_tree(const AST*)
+     * @param node is a pointer to the root node from which the tree is printed
+     * @param stream is the stream the tree is printed into
+     */
+    static auto print_binary_tree ( const AST* node, std::ostream& stream ) -> void;
     /**
      * Getter for the root.
      * @return A shared pointer to the root node
@@ -93,18 +172,100 @@ public:
     [[nodiscard]] auto get_root() const -> std::shared_ptr<AST> { return m_root; }
 
 private:
-    std::unique_ptr<Lexer> m_lexer             = nullptr;
-    std::unique_ptr<Token> m_current_token     = nullptr;
-    std::shared_ptr<AST>   m_root              = nullptr;
-    int                    m_parenthesis_level = 0;
-    bool                   m_negative_sign     = false;
+    /**
+     * The state of the expression around a function call, restored once the call is complete.
+     */
+    struct Call
+    {
+        std::shared_ptr<AST> m_root;
+        std::size_t          m_spine_start; /**< The start of the spine of the expression around the call */
+        std::size_t          m_condition_start; /**< The start of the conditions of the expression around the call */
+        int                  m_parenthesis_level;
+        bool                 m_negative_sign;
+        std::shared_ptr<AST> m_function;      /**< The function node, its arguments are added while they are parsed */
+        AST*                 m_last_argument; /**< The end of the argument chain */
+        std::size_t          m_argument_count;
+    };
 
-    auto                      parse_expression() -> void;
-    auto                      eat ( TOKEN_TYPE token ) -> void;
-    auto                      add_operation ( const std::shared_ptr<AST>& operation ) -> void;
-    static auto               print_binary_tree ( const std::string& prefix, const AST* node, bool isLeft ) -> void;
-    [[nodiscard]] static auto find_bottom ( std::shared_ptr<AST> start ) -> std::shared_ptr<AST>;
-    [[nodiscard]] static auto find_parent ( std::shared_ptr<AST> start, const std::shared_ptr<AST>& bottom )
-        -> std::shared_ptr<AST>;
+    std::unique_ptr<Lexer>     m_lexer             = nullptr;
+    std::unique_ptr<Token>     m_current_token     = std::make_unique<Token>(); /**< Overwritten by every next_token() */
+    std::shared_ptr<AST>       m_root              = nullptr;
+    std::vector<AST*>          m_spine             = {}; /**< The right spine, from the root to the last operation */
+    std::size_t                m_spine_start       = 0;  /**< The spines of the expressions around open calls come first */
+    std::vector<int>           m_conditions        = {}; /**< The parenthesis level inside every '?' that has no ':' yet */
+    std::size_t                m_condition_start   = 0;  /**< The conditions of the expressions around open calls come first */
+    int                        m_parenthesis_level = 0;
+    bool                       m_negative_sign     = false;
+    std::optional<Error>       m_error             = std::nullopt; /**< The error of the Lexer, reported by try_parse() */
+    std::vector<Call>          m_calls             = {}; /**< The open function calls, the innermost one is last */
+    std::pmr::memory_resource* m_nodes             = nullptr; /**< Where the nodes live, nullptr for std::make_shared */
+
+    /**
+     * Creates a node in the node storage.
+     * @param args are the arguments of the AST constructor
+     * @return The new node
+     */
+    template <typename... Args>
+    auto make_node ( Args&&... args ) const -> std::shared_ptr<AST>;
+
+    auto parse_expression() -> Result<void>;
+    /**
+     * Handles everything after an operand: closing parentheses, the end of an argument and the next operation.
+     * @param operand is a number or a complete function call
+     */
+    auto parse_operation ( std::shared_ptr<AST> operand ) -> Result<void>;
+    /**
+     * Parses a name, it is a function call if a '(' follows and a variable otherwise.
+     */
+    auto parse_name() -> Result<void>;
+    /**
+     * Starts a function call, the current token has to be the '(' after the name of the function.
+     * @param function is the function node, the arguments are added to it
+     */
+    auto open_call ( std::shared_ptr<AST> function ) -> Result<void>;
+    /**
+     * Negates an operand that is not a number.
+     * @param operand is a variable or a function call
+     * @return The operand multiplied with -1
+     */
+    [[nodiscard]] auto negate ( std::shared_ptr<AST> operand ) const -> std::shared_ptr<AST>;
+    /**
+     * Completes the argument that is parsed right now and adds it to the innermost function call.
+     */
+    auto add_argument() -> Result<void>;
+    /**
+     * Completes the innermost function call and restores the expression around it.
+     * @return The function node, negated if there was a '-' in front of the name
+     */
+    auto close_call() -> Result<std::shared_ptr<AST>>;
+    /**
+     * Puts an operand into the last empty slot of the tree.
+     * @param operand is a number or a function call
+     */
+    auto attach ( std::shared_ptr<AST> operand ) -> void;
+    auto eat ( TOKEN_TYPE token ) -> Result<void>;
+    auto next_token() -> Result<void>;
+    [[nodiscard]] auto error ( ERROR_CODE code, TOKEN_TYPE expected = TOKEN_TYPE::TOKEN_UNKNOWN ) const
+        -> std::unexpected<Error>;
+    auto add_operation ( const std::shared_ptr<AST>& operation ) -> void;
+    /**
+     * Checks the nesting against Limits::m_depth, the operations on the spine and the open parentheses and calls are
+     * a cheap bound for the depth of the tree that is built.
+     * @return Nothing or ERROR_CODE::LIMIT_EXCEEDED at the current token
+     */
+    [[nodiscard]] auto check_depth() const -> Result<void>;
+    /**
+     * Checks if the innermost '?' of the expression that is parsed right now is still waiting for its ':'.
+     * @return true if the ':' would close the current parenthesis level
+     */
+    [[nodiscard]] auto condition_open() const -> bool
+    {
+        return m_conditions.size() > m_condition_start && m_conditions.back() == m_parenthesis_level;
+    }
+    /**
+     * Checks if the expression that is parsed right now has no operation yet.
+     * @return true if the spine of the innermost expression is empty
+     */
+    [[nodiscard]] auto spine_empty() const -> bool { return m_spine.size() == m_spine_start; }
 };
 } // namespace pfme
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <pfme/AST.hpp>
+
+namespace pfme
+{
+/**
+ * Enum for which chains reassociate() rebalances and how floats are added.
+ * With KAHAN a chain of + with floats becomes calls of ksum with at most 32 arguments each, nested log n deep.
+ */
+enum class REASSOCIATE : std::uint8_t
+{
+    EXACT,    /**< Only chains of exact operands that can not overflow, every result stays the same */
+    PAIRWISE, /**< Every chain of + and *, floats are added in pairs, the rounding error grows with log n instead of n */
+    KAHAN,    /**< Like PAIRWISE, but float sums are compensated by ksum */
+};
+
+/**
+ * Rebalances the chains of + and * of a tree, e.g. a sum of 100'000 terms is a chain 100'000 nodes deep after parsing.
+ * The operands of a chain keep their order and are combined in pairs, a + b + c + d becomes (a + b) + (c + d), so the
+ * chain is only log n deep and its halves do not depend on each other. Which operands are always exact is known from
+ * the tree alone: integer and fraction numbers, comparisons, && and || and + - * / of exact operands. Variables and
+ * function calls may be floats, so chains with them are only rebalanced if the mode allows it. An exact chain is only
+ * rebalanced if the bounds of its operands show that no partial result can leave 64 bits, otherwise another grouping
+ * could turn a result into ERROR_CODE::NUMBER_OUT_OF_RANGE, e.g. 9223372036854775807 + 1 + -1 stays as it is.
+ * The tree is walked without recursion.
+ * @param root is the root of a completely parsed tree
+ * @param mode decides which chains are rebalanced
+ * @return The root of the new tree, the input is not changed
+ */
+auto reassociate ( const AST* root, REASSOCIATE mode = REASSOCIATE::EXACT ) -> std::shared_ptr<AST>;
+} // namespace pfme
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <pfme/Simd.hpp>
+#include <string_view>
+
+namespace pfme
+{
+class LexerConfig;
+
+/**
+ * @brief Functions that find the end of a run of characters of the same class.
+ *
+ * On x86-64 the runs are classified 16 (SSE2) or 32 (AVX2) bytes at a time, everywhere else and for the last bytes
+ * of the input a scalar loop is used. All levels return exactly the same results.
+ * @see simd::get_level()
+ */
+namespace scan
+{
+/**
+ * Finds the end of a run of decimal digits.
+ * @param input is the text that is scanned
+ * @param from is the index the run starts at
+ * @return The index of the first character at or after from that is not a digit, input.size() if there is none
+ */
+auto digit_run_end ( std::string_view input, std::size_t from ) -> std::size_t;
+
+/**
+ * Finds the end of a run of whitespace and seperators.
+ * @param input is the text that is scanned
+ * @param from is the index the run starts at
+ * @param config decides which characters are seperators
+ * @return The index of the first character at or after from that is not skipped, input.size() if there is none
+ */
+auto skip_run_end ( std::string_view input, std::size_t from, const LexerConfig& config ) -> std::size_t;
+} // namespace scan
+} // namespace pfme
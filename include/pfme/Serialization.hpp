@@ -0,0 +1,257 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <pfme/AST.hpp>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pfme
+{
+/**
+ * @brief The header at the start of every serialized expression.
+ *
+ * All fields are fixed width, a file is only accepted if the magic, the version, the node and float sizes,
+ * the byte order and the checksum of the node block match.
+ */
+struct BinaryHeader
+{
+    static constexpr std::array<char, 4> MAGIC       = { 'P', 'F', 'M', 'E' };
+    static constexpr std::uint16_t       VERSION     = 7;
+    static constexpr std::uint16_t       ENDIAN_MARK = 0x0102;
+
+    std::array<char, 4> m_magic      = MAGIC;       /**< Always "PFME" */
+    std::uint16_t       m_version    = VERSION;     /**< The version of the format */
+    std::uint16_t       m_node_size  = 0;           /**< sizeof(BinaryNode) of the writer */
+    std::uint16_t       m_float_size = 0;           /**< sizeof(LD) of the writer, floats are stored in their native layout */
+    std::uint16_t       m_byte_order = ENDIAN_MARK; /**< Reads as 0x0201 if the writer had a different endianness */
+    std::uint32_t       m_node_count = 0;           /**< The number of nodes following the header */
+    std::uint32_t       m_flags      = 0;           /**< Reserved, always 0 */
+    std::uint32_t       m_reserved   = 0;           /**< Reserved, always 0 */
+    std::uint64_t       m_checksum   = 0;           /**< FNV-1a hash of the node block */
+};
+
+/**
+ * @brief A single node of a serialized expression.
+ *
+ * The nodes are stored in post order, so the children of a node always have a smaller index than the node itself
+ * and the root is the last node. Children are referenced by their index, which makes the format position independent.
+ * Number nodes store their value in the payload: integers in the first 8 bytes, fractions as numerator and denominator
+ * decimals as mantissa followed by a byte with the scale and floats in the native layout of LD.
+ * Function nodes store the name of the function in the payload and its id in the writer in m_extra, the reader looks
+ * the function up by its name (see get_function()), the last node of an argument chain has NO_CHILD as right child.
+ * Version 2 added function calls, version 7 their names, before only the id was stored, which depends on the order
+ * the functions were added to the FunctionRegistry in.
+ * Variable nodes store their name in the payload and a number in m_extra, variables are numbered in the order they
+ * first appear and every node of the same variable has the same number. Version 3 added variables, version 4 decimals.
+ * Version 5 added comparisons, logical operators and conditions. Every node has to be in the exact post order flatten()
+ * writes, the right child directly in front of the node and the left one directly in front of that subtree, because
+ * the branches jump over whole subtrees.
+ * Version 6 added the built-in functions ksum, sum and prod, which moved the ids of every function added at runtime.
+ */
+struct alignas ( 16 ) BinaryNode
+{
+    static constexpr std::uint32_t NO_CHILD = 0xFFFF'FFFF; /**< The right child of a function call without more arguments */
+    static constexpr std::size_t   MAX_NAME = 16; /**< The longest name of a variable that fits into the payload */
+
+    std::uint32_t             m_type  = 0; /**< The AST_TYPE of the node */
+    std::uint32_t             m_lhand = 0; /**< The index of the left child, only valid for operations */
+    std::uint32_t             m_rhand = 0; /**< The index of the right child, only valid for operations */
+    std::uint32_t             m_extra = 0; /**< The function id or the variable number, otherwise 0 */
+    std::array<std::byte, 16> m_payload {}; /**< The value of number nodes, the name of variable and function nodes */
+
+    /**
+     * Creates a number node from the value of a number.
+     * @param number is the value that will be stored in the payload
+     * @return A node of the type corresponding to the active alternative of the number
+     */
+    static auto from_number ( const AST::num_t& number ) -> BinaryNode;
+    /**
+     * Reads the payload back into a number.
+     * @return The value of the node, the alternative is selected through m_type
+     */
+    [[nodiscard]] auto to_number() const -> AST::num_t;
+    /**
+     * Creates a variable node, the name is only stored if it is not longer than MAX_NAME, serialize() rejects the node
+     * otherwise, in memory the number is enough. Throws a runtime error if the name is empty.
+     * @param name is the name of the variable
+     * @param index is the number of the variable
+     * @return A node of type AST_TYPE::VARIABLE
+     */
+    static auto from_variable ( std::string_view name, std::uint32_t index ) -> BinaryNode;
+    /**
+     * Creates a function node, the name is only stored if it is not longer than MAX_NAME, serialize() rejects the node
+     * otherwise, in memory the id is enough.
+     * @param id is the id of the function in the global FunctionRegistry
+     * @return A node of type AST_TYPE::FUNCTION without children
+     */
+    static auto from_function ( std::uint32_t id ) -> BinaryNode;
+    /**
+     * Reads the name of a variable or function node.
+     * @return The name stored in the payload
+     */
+    [[nodiscard]] auto get_name() const -> std::string_view;
+    /**
+     * Looks up the function of a function node in the global FunctionRegistry by its name, so a reader that added its
+     * functions in another order calls the same function. m_extra is only used if it already has the name, or if the
+     * node has no name because it was never written to a file.
+     * @return The id of the function, nothing if no function has the name
+     */
+    [[nodiscard]] auto get_function() const -> std::optional<std::uint32_t>;
+    /**
+     * Getter for the type.
+     * @return m_type as an AST_TYPE
+     */
+    [[nodiscard]] auto get_type() const -> AST_TYPE { return static_cast<AST_TYPE> ( m_type ); }
+};
+
+static_assert ( sizeof ( BinaryHeader ) == 32, "the header layout is part of the file format" );
+static_assert ( sizeof ( BinaryNode ) == 32, "the node layout is part of the file format" );
+
+/**
+ * @brief Where the evaluation of nodes in post order continues after the left operand of a branch.
+ *
+ * The nodes of a subtree are next to each other, so the part of a branch that is not needed is skipped by jumping
+ * over it: the second result of a condition (?:) if it is true, the first one if it is false, the right operand of &&
+ * if the left one is false and the right operand of || if the left one is true. Errors in the skipped nodes (e.g.
+ * the division in x != 0 ? 1 / x : 0) do not stop the evaluation.
+ */
+struct Shortcut
+{
+    static constexpr std::uint32_t NONE = 0xFFFF'FFFF; /**< The node does not decide a branch */
+
+    std::uint32_t m_target = NONE;            /**< The node that is evaluated next if the evaluation jumps */
+    AST_TYPE      m_branch = AST_TYPE::EMPTY; /**< The CONDITION, ALTERNATIVE, AND or OR the node is the left operand of */
+
+    /**
+     * Decides if the evaluation jumps after the node, the first result of a condition always jumps over the second.
+     * @param value is the truth of the node, see pfme::is_true
+     * @return true if the evaluation continues at m_target
+     */
+    [[nodiscard]] auto jumps ( bool value ) const -> bool
+    {
+        return m_branch == AST_TYPE::ALTERNATIVE || ( m_branch == AST_TYPE::OR ) == value;
+    }
+};
+
+/**
+ * Finds the nodes that decide a branch.
+ * @param nodes are the nodes in post order that passed validate()
+ * @return A Shortcut for every node, nothing if the expression has no branches
+ */
+auto find_shortcuts ( std::span<const BinaryNode> nodes ) -> std::vector<Shortcut>;
+
+/**
+ * Flattens a tree into its serialized form (without the header).
+ * @param root is the root of a completely parsed tree, e.g. the return value of Parser::parse()
+ * @return The nodes of the tree in post order
+ */
+auto flatten ( const AST* root ) -> std::vector<BinaryNode>;
+
+/**
+ * Flattens a tree like flatten(const AST*) and collects the full names of its variables, which are only stored in the
+ * nodes if they are not longer than BinaryNode::MAX_NAME.
+ * @param root is the root of a completely parsed tree
+ * @param variables is overwritten with the name of every variable number
+ * @return The nodes of the tree in post order
+ */
+auto flatten ( const AST* root, std::vector<std::string>& variables ) -> std::vector<BinaryNode>;
+
+/**
+ * Serializes a tree into a buffer consisting of a BinaryHeader followed by the nodes.
+ * Throws a runtime error if the name of a function or a variable is longer than BinaryNode::MAX_NAME or if the tree
+ * contains sum or prod, which only the Visitor can evaluate.
+ * @param root is the root of a completely parsed tree
+ * @return The serialized expression, can be written to disk as is
+ */
+auto serialize ( const AST* root ) -> std::vector<std::byte>;
+
+/**
+ * Serializes a tree and writes it to a file, an existing file will be overwritten.
+ * @param root is the root of a completely parsed tree
+ * @param path is the path of the file
+ */
+auto save_expression ( const AST* root, const std::filesystem::path& path ) -> void;
+
+/**
+ * Checks a buffer for a valid header, checksum and node structure. The nodes have to form a tree, every node except
+ * the root is the child of exactly one node and every subtree is stored in one piece in front of its parent, fractions
+ * can not have a denominator of 0, every function has to be known by its name and every variable number from 0 to the
+ * last one belongs to exactly one name.
+ * Throws a runtime error describing the first problem found.
+ * @param data is the serialized expression
+ * @return The nodes inside of the buffer, they point into data
+ */
+auto validate ( std::span<const std::byte> data ) -> std::span<const BinaryNode>;
+
+/**
+ * Evaluates serialized nodes directly, without rebuilding a tree, throws a runtime error if they contain a variable.
+ * @see CompiledExpression for expressions with variables
+ * @param nodes are the nodes in post order, e.g. from validate()
+ * @return A number node with the result of the calculation
+ */
+auto evaluate ( std::span<const BinaryNode> nodes ) -> AST;
+
+/**
+ * Rebuilds a tree from serialized nodes, the result can be used like the return value of Parser::parse().
+ * @param nodes are the nodes in post order
+ * @param variables are the names of the variable numbers, the names in the nodes are used if it is empty
+ * @return A shared pointer to the root of the rebuilt tree
+ */
+auto to_ast ( std::span<const BinaryNode> nodes, std::span<const std::string> variables = {} ) -> std::shared_ptr<AST>;
+
+/**
+ * @brief A serialized expression that is memory mapped from a file.
+ *
+ * The file is validated once when it is opened, afterwards the nodes are used in place.
+ */
+class MappedExpression
+{
+public:
+    /**
+     * Maps the file read only and validates it, throws a runtime error if the file can not be mapped or is invalid.
+     * @param path is the path of a file written by save_expression()
+     */
+    explicit MappedExpression ( const std::filesystem::path& path );
+    MappedExpression ( const MappedExpression& ) = delete;
+    MappedExpression ( MappedExpression&& other ) noexcept;
+    ~MappedExpression();
+
+    MappedExpression& operator= ( const MappedExpression& ) = delete;
+    MappedExpression& operator= ( MappedExpression&& other ) noexcept;
+
+    /**
+     * Getter for the nodes.
+     * @return The nodes of the expression, valid as long as the MappedExpression lives
+     */
+    [[nodiscard]] auto get_nodes() const -> std::span<const BinaryNode> { return m_nodes; }
+    /**
+     * Evaluates the mapped expression.
+     * @see pfme::evaluate
+     */
+    [[nodiscard]] auto evaluate() const -> AST { return pfme::evaluate ( m_nodes ); }
+    /**
+     * Rebuilds the tree of the mapped expression.
+     * @see pfme::to_ast
+     */
+    [[nodiscard]] auto to_ast() const -> std::shared_ptr<AST> { return pfme::to_ast ( m_nodes ); }
+
+private:
+    const std::byte*            m_data = nullptr;
+    std::size_t                 m_size = 0;
+    std::span<const BinaryNode> m_nodes {};
+#ifdef _WIN32
+    void* m_file    = nullptr;
+    void* m_mapping = nullptr;
+#else
+    int m_file = -1;
+#endif
+
+    auto unmap() noexcept -> void;
+};
+} // namespace pfme
@@ -0,0 +1,88 @@
+#pragma once
+#include <concepts>
+#include <memory_resource>
+#include <pfme/Lexer.hpp>
+#include <pfme/Visitor.hpp>
+#include <string_view>
+
+namespace pfme
+{
+/**
+ * @brief Evaluates one expression after the other with the same Lexer, Parser and Visitor.
+ *
+ * A Visitor is built for a single expression, a Session is reset for every new one instead. The Token, the spine of
+ * the Parser, the scratch space of the Visitor and the nodes of the tree are all kept, the nodes go back into a pool
+ * whenever the next expression is parsed. Once the Session has seen an expression of a similar size, evaluating
+ * another one allocates nothing.
+ * With a LexerConfig that has decimals turned on the Session does exact currency math, e.g. 0.1 + 0.2 is exactly 0.3.
+ * Like the Visitor a Session is meant to be used by one thread at a time.
+ * @tparam Float is the floating point type of the evaluation, see basic_visitor
+ */
+template <std::floating_point Float = LD>
+class basic_session
+{
+public:
+    using number_t = typename basic_visitor<Float>::number_t; /**< The result of an evaluation */
+
+    /**
+     * Creates a Session that reads every expression with the same configuration.
+     * @param config is the number format, it is copied
+     */
+    explicit basic_session ( const LexerConfig& config = LexerConfig::standard() );
+    basic_session ( const basic_session& )            = delete;
+    basic_session ( basic_session&& )                 = delete;
+    ~basic_session()                                  = default;
+    basic_session& operator= ( const basic_session& ) = delete;
+    basic_session& operator= ( basic_session&& )      = delete;
+
+    /**
+     * Parses and evaluates an expression, the tree of the last expression is released.
+     * @param input is the expression
+     * @return The result or the first error of the Lexer, the Parser or the evaluation
+     */
+    auto evaluate ( std::string_view input ) -> Result<number_t>;
+    /**
+     * Parses an expression without evaluating it, e.g. to look at the tree before it is evaluated.
+     * @param input is the expression
+     * @return Nothing or the first error in the input
+     */
+    auto parse ( std::string_view input ) -> Result<void> { return m_visitor.try_reset ( input ); }
+    /**
+     * Evaluates the expression of the last successful parse().
+     * @return The result or the error that stopped the evaluation
+     */
+    auto evaluate() -> Result<number_t> { return m_visitor.try_evaluate(); }
+    /**
+     * Prints the tree of the last expression.
+     * @see Parser::print_binary_tree
+     */
+    auto print_tree() const -> void { m_visitor.print_tree(); }
+    /**
+     * Setter for debug mode.
+     * @param debug is the value of debug mode, true for on and false for off
+     */
+    auto set_debug_mode ( bool debug ) -> void { m_visitor.set_debug_mode ( debug ); }
+    /**
+     * Setter for the rounding of decimal divisions, decimals are turned on through the LexerConfig.
+     * @see LexerConfig::set_decimals
+     * @param context is the scale and the rounding of decimal quotients
+     */
+    auto set_decimal_context ( const DecimalContext& context ) -> void { m_visitor.set_decimal_context ( context ); }
+    /**
+     * Setter for the limits of every following expression, e.g. Limits::untrusted() for input from clients.
+     * @see Limits
+     * @param limits are the budgets of every expression
+     */
+    auto set_limits ( const Limits& limits ) -> void { m_visitor.set_limits ( limits ); }
+
+private:
+    std::pmr::unsynchronized_pool_resource m_nodes;   /**< Declared first, so it outlives every node */
+    basic_visitor<Float>                   m_visitor; /**< Owns the Parser and the Lexer */
+};
+
+using Session = basic_session<>; /**< The Session that evaluates in long double */
+
+extern template class basic_session<float>;
+extern template class basic_session<double>;
+extern template class basic_session<LD>;
+} // namespace pfme
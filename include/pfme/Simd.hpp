@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+namespace pfme
+{
+/**
+ * @brief The instruction sets the vectorized code paths can use.
+ *
+ * The level is detected once at runtime, all code paths of a level return exactly the same results as the scalar
+ * code. The vector code can be disabled at compile time by defining PFME_NO_SIMD (the CMake option PFME_SIMD).
+ */
+namespace simd
+{
+/**
+ * Enum for the instruction sets the vectorized code can use.
+ */
+enum class SIMD_LEVEL : std::uint8_t
+{
+    SCALAR, /**< One element at a time */
+    SSE2,   /**< 128 bit vectors */
+    AVX2,   /**< 256 bit vectors */
+};
+
+/**
+ * Get a string for each SIMD_LEVEL.
+ * @param level is the SIMD_LEVEL for which you want the string
+ * @return The name of the instruction set, e.g. "AVX2"
+ */
+auto simd_level_to_string ( SIMD_LEVEL level ) -> std::string_view;
+
+/**
+ * The best level the compiler and the CPU support, detected once.
+ * @return The highest usable SIMD_LEVEL
+ */
+auto supported_level() -> SIMD_LEVEL;
+
+/**
+ * The level used by the Lexer and the function kernels, starts as supported_level().
+ * @return The active SIMD_LEVEL
+ */
+auto get_level() -> SIMD_LEVEL;
+
+/**
+ * Changes the active level for all threads, e.g. to compare the levels in tests and benchmarks.
+ * @param level is the requested level, it is lowered to supported_level() if the CPU can not use it
+ * @return The level that is active now
+ */
+auto set_level ( SIMD_LEVEL level ) -> SIMD_LEVEL;
+} // namespace simd
+} // namespace pfme
@@ -0,0 +1,51 @@
+#pragma once
+#include <concepts>
+#include <cstddef>
+#include <optional>
+#include <pfme/AST.hpp>
+#include <pfme/Error.hpp>
+#include <pfme/Lexer.hpp>
+#include <string_view>
+
+namespace pfme
+{
+constexpr std::size_t SMALL_TOKEN_LIMIT = 64; /**< The most tokens an expression of the fast path can have */
+
+/**
+ * Evaluates a small expression without touching the heap, the tokens and the nodes live in fixed-size arrays on the
+ * stack. The fast path only knows numbers, + - * / ^ and parentheses and builds the same tree as the Parser, so
+ * it gets the same results (e.g. 2^3^2 is 512 and -2^2 is 4).
+ * It gives up on anything else: more than SMALL_TOKEN_LIMIT tokens, names, digit seperators, hexadecimal numbers,
+ * configurations with decimals and every error of the Lexer or the Parser, the general path then reports the error
+ * with its position.
+ * Errors of the evaluation (e.g. a division by zero) are the same as the ones of the Visitor.
+ * @tparam Float is the floating point type of the evaluation, see basic_visitor
+ * @param input is the expression
+ * @param config is the number format
+ * @return The result or the error of the evaluation, nothing if the expression needs the general path
+ */
+template <std::floating_point Float = LD>
+auto try_evaluate_small ( std::string_view input, const LexerConfig& config = LexerConfig::standard() )
+    -> std::optional<Result<basic_num_t<Float>>>;
+
+/**
+ * Evaluates an expression with try_evaluate_small() and falls back to a basic_visitor if it is not small.
+ * Both paths get the same results and errors, only expressions on the fast path are evaluated without allocating.
+ * @tparam Float is the floating point type of the evaluation, see basic_visitor
+ * @param input is the expression
+ * @param config is the number format
+ * @return The result or the first error of the Lexer, the Parser or the evaluation
+ */
+template <std::floating_point Float = LD>
+auto evaluate_small ( std::string_view input, const LexerConfig& config = LexerConfig::standard() )
+    -> Result<basic_num_t<Float>>;
+
+extern template auto try_evaluate_small<float> ( std::string_view, const LexerConfig& )
+    -> std::optional<Result<basic_num_t<float>>>;
+extern template auto try_evaluate_small<double> ( std::string_view, const LexerConfig& )
+    -> std::optional<Result<basic_num_t<double>>>;
+extern template auto try_evaluate_small<LD> ( std::string_view, const LexerConfig& ) -> std::optional<Result<basic_num_t<LD>>>;
+extern template auto evaluate_small<float> ( std::string_view, const LexerConfig& ) -> Result<basic_num_t<float>>;
+extern template auto evaluate_small<double> ( std::string_view, const LexerConfig& ) -> Result<basic_num_t<double>>;
+extern template auto evaluate_small<LD> ( std::string_view, const LexerConfig& ) -> Result<basic_num_t<LD>>;
+} // namespace pfme
@@ -0,0 +1,89 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <pfme/AST.hpp>
+#include <pfme/Decimal.hpp>
+#include <pfme/Error.hpp>
+#include <pfme/Lexer.hpp>
+#include <pfme/Limits.hpp>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace pfme
+{
+/**
+ * @brief How many worker processes a Supervisor runs and how long it waits for them.
+ */
+struct SupervisorOptions
+{
+    std::size_t               m_workers = 0;                          /**< The worker processes, 0 uses one per core */
+    std::chrono::milliseconds m_timeout = std::chrono::seconds { 5 }; /**< A worker stuck longer on one expression restarts */
+    LexerConfig               m_config  = LexerConfig::standard();    /**< The number format of the expressions */
+    DecimalContext            m_decimal_context {};                   /**< Rounds the quotients of decimals */
+    Limits                    m_limits {};                            /**< The budgets of every expression */
+};
+
+/**
+ * @brief Evaluates expressions in separate worker processes, so a crash only loses the expression that caused it.
+ *
+ * The workers are forked when the Supervisor is created and talk to it through shared memory, every worker has a ring
+ * of requests and a ring of responses with a single producer and a single consumer each, so neither side takes a
+ * lock or makes a system call for an expression. A worker that dies (e.g. through a crashing function) or works on
+ * one expression for longer than the timeout is killed and forked again, the expression it was working on results in
+ * ERROR_CODE::WORKER_FAILED and the expressions queued behind it are evaluated by the new worker.
+ * Workers evaluate like a Session, with the functions that were registered before the Supervisor was created. A
+ * Supervisor is meant to be created before other threads are started and used by one thread at a time, the workers
+ * exit on their own when the process that created them is gone.
+ * Only available where processes can be forked, the constructor throws a runtime error everywhere else.
+ */
+class Supervisor
+{
+public:
+    static constexpr std::size_t MAX_LENGTH = 4064; /**< The longest expression in bytes that fits into a request */
+
+    /**
+     * Forks the workers, throws a runtime error if the shared memory or a worker can not be created.
+     * @param options are the number of workers, the timeout and the number format
+     */
+    explicit Supervisor ( const SupervisorOptions& options = {} );
+    Supervisor ( const Supervisor& ) = delete;
+    Supervisor ( Supervisor&& )      = delete;
+    /**
+     * Stops the workers and waits for them.
+     */
+    ~Supervisor();
+    Supervisor& operator= ( const Supervisor& ) = delete;
+    Supervisor& operator= ( Supervisor&& )      = delete;
+
+    /**
+     * Evaluates expressions in the workers, the requests are spread over all of them and answered in any order.
+     * @param expressions are the expressions, they are copied into the requests
+     * @return The result or the error of every expression in the order of the input
+     */
+    auto evaluate ( std::span<const std::string_view> expressions ) -> std::vector<Result<AST::num_t>>;
+    /**
+     * Evaluates a single expression in a worker.
+     * @see evaluate(std::span<const std::string_view>)
+     * @param expression is the expression
+     * @return The result or the error of the expression
+     */
+    auto evaluate ( std::string_view expression ) -> Result<AST::num_t>;
+
+    /**
+     * Getter for the number of workers.
+     * @return The number of worker processes, always the same
+     */
+    [[nodiscard]] auto get_workers() const -> std::size_t;
+    /**
+     * Getter for the restarts.
+     * @return How often a worker was forked again since the Supervisor was created
+     */
+    [[nodiscard]] auto get_restarts() const -> std::size_t;
+
+private:
+    struct State;
+    std::unique_ptr<State> m_state; /**< The shared memory and the processes, only known to Supervisor.cpp */
+};
+} // namespace pfme
@@ -1,6 +1,10 @@
 #pragma once
+#include <cstdint>
 #include <iostream>
+#include <pfme/Decimal.hpp>
 #include <string>
+#include <string_view>
+#include <variant>
 namespace pfme
 {
 /**
@@ -17,8 +21,20 @@ enum class TOKEN_TYPE : char
     TOKEN_EXPONENTIATION = '^', /**< Exponentiation, represented by ^ */
     TOKEN_INTEGER        = '0', /**< Integer, represented by 0 */
     TOKEN_FLOAT          = '.', /**< Float, represented by . */
+    TOKEN_IDENTIFIER     = 'a', /**< The name of a function, represented by a */
+    TOKEN_COMMA          = ',', /**< Seperates the arguments of a function call, represented by , */
+    TOKEN_LESS           = '<', /**< Less than, represented by < */
+    TOKEN_LESS_EQUAL     = 'L', /**< Less than or equal, represented by <= */
+    TOKEN_GREATER        = '>', /**< Greater than, represented by > */
+    TOKEN_GREATER_EQUAL  = 'G', /**< Greater than or equal, represented by >= */
+    TOKEN_EQUAL          = '=', /**< Equal, represented by == */
+    TOKEN_NOT_EQUAL      = '!', /**< Not equal, represented by != */
+    TOKEN_AND            = '&', /**< Logical and, represented by && */
+    TOKEN_OR             = '|', /**< Logical or, represented by || */
+    TOKEN_CONDITION      = '?', /**< The end of the condition of a conditional expression, represented by ? */
+    TOKEN_ALTERNATIVE    = ':', /**< Seperates the two results of a conditional expression, represented by : */
     TOKEN_EOF            = '#', /**< End of File, represented by # */
-    TOKEN_UNKNOWN        = '?', /**< Unknown, represented by ? */
+    TOKEN_UNKNOWN        = '~', /**< Unknown, represented by ~ */
 };
 
 /**
@@ -35,6 +51,13 @@ auto token_type_to_string ( TOKEN_TYPE type ) -> std::string;
 class Token
 {
 public:
+    /**
+     * The binary value of a number Token.
+     * Integers are stored as their magnitude, the sign is a Token of its own and applied by the Parser.
+     * Floats are a Decimal instead of a long double if the LexerConfig asks for decimals and the number has one.
+     */
+    using number_t = std::variant<std::uint64_t, long double, Decimal>;
+
     Token()                           = default;
     Token ( const Token& )            = default;
     Token ( Token&& )                 = default;
@@ -64,6 +87,32 @@ public:
     {
     }
 
+    /**
+     * Initialises a number Token, the value is already converted by the Lexer.
+     * @param type is either TOKEN_TYPE::TOKEN_INTEGER or TOKEN_TYPE::TOKEN_FLOAT
+     * @param value is the number as it was written in the input
+     * @param number is the converted value of the number
+     */
+    Token ( TOKEN_TYPE type, std::string value, number_t number )
+        : m_type ( type )
+        , m_value ( std::move ( value ) )
+        , m_number ( number )
+    {
+    }
+
+    /**
+     * Overwrites the Token, the storage of the value is reused.
+     * @param type is the new type
+     * @param value is the new value
+     * @param number is the converted value of a number Token
+     */
+    auto assign ( TOKEN_TYPE type, std::string_view value, const number_t& number = {} ) -> void
+    {
+        m_type = type;
+        m_value.assign ( value );
+        m_number = number;
+    }
+
     /**
 	 * Getter for the type.
 	 * @return The TOKEN_TYPE of the Token
@@ -74,9 +123,15 @@ public:
 	 * @return The value of the Token
 	 */
     auto get_value() const -> std::string { return m_value; }
+    /**
+     * Getter for the number.
+     * @return The converted value of a number Token, 0 for all other Tokens
+     */
+    auto get_number() const -> const number_t& { return m_number; }
 
 private:
     TOKEN_TYPE  m_type { TOKEN_TYPE::TOKEN_UNKNOWN };
     std::string m_value {};
+    number_t    m_number {};
 };
 } // namespace pfme
\ No newline at end of file
@@ -0,0 +1,150 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string_view>
+
+namespace pfme
+{
+/**
+ * @brief A trace of where the time of parsing and evaluating goes, for the expressions that are slower than expected.
+ *
+ * Every thread records into its own ring buffer of CAPACITY events, allocated on its first event, so recording takes
+ * no lock and never allocates afterwards. When a buffer is full the oldest events are overwritten. The buffer of a
+ * finished thread keeps its events and is reused by the next thread that starts recording, so there are only as many
+ * buffers as threads recorded at the same time, and a thread of the trace may show several threads one after another.
+ * Tracing is off until set_level() turns it on, an untraced stage costs one relaxed atomic load.
+ * The events are exported in the Chrome trace format, which chrome://tracing and https://ui.perfetto.dev can open.
+ */
+namespace trace
+{
+/**
+ * Enum for how much is recorded.
+ */
+enum class TRACE_LEVEL : std::uint8_t
+{
+    OFF,    /**< Nothing */
+    STAGES, /**< Parsing, compiling and evaluating whole expressions */
+    NODES,  /**< The stages and every evaluated operation and function call */
+};
+
+/**
+ * Enum for the recorded steps.
+ */
+enum class STAGE : std::uint8_t
+{
+    PARSE,    /**< Lexing and parsing an expression */
+    COMPILE,  /**< Turning an expression into a CompiledExpression */
+    EVALUATE, /**< Evaluating a whole expression */
+    GRADIENT, /**< Computing the derivatives of an expression */
+    NODE,     /**< Evaluating one operation or function call */
+};
+
+/**
+ * @brief One recorded step.
+ */
+struct Event
+{
+    std::uint64_t m_start    = 0;            /**< Nanoseconds of the steady clock */
+    std::uint64_t m_duration = 0;            /**< Nanoseconds */
+    std::uint32_t m_detail   = 0;            /**< The id of a called function, else the index in a CompiledExpression */
+    STAGE         m_stage    = STAGE::PARSE; /**< What was recorded */
+    std::uint8_t  m_type     = 0;            /**< For nodes the AST_TYPE */
+};
+
+constexpr std::size_t CAPACITY = std::size_t { 1 } << 15U; /**< The number of events every thread keeps */
+
+namespace detail
+{
+inline std::atomic<TRACE_LEVEL> active_level { TRACE_LEVEL::OFF }; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+} // namespace detail
+
+/**
+ * The current level, cheap enough to check for every node.
+ * @return What is recorded
+ */
+inline auto get_level() -> TRACE_LEVEL { return detail::active_level.load ( std::memory_order_relaxed ); }
+
+/**
+ * Changes what is recorded for all threads.
+ * @param level is the new level, OFF stops recording but keeps the recorded events
+ */
+inline auto set_level ( TRACE_LEVEL level ) -> void { detail::active_level.store ( level, std::memory_order_relaxed ); }
+
+/**
+ * The clock of the events.
+ * @return The nanoseconds of the steady clock
+ */
+inline auto now() -> std::uint64_t
+{
+    return static_cast<std::uint64_t> (
+        std::chrono::duration_cast<std::chrono::nanoseconds> ( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+}
+
+/**
+ * Records an event that started at start and ends now into the buffer of the calling thread.
+ * @param stage is what is recorded
+ * @param start is the result of now() at the beginning of the step
+ * @param detail is the index of a node or the id of a function
+ * @param type is the AST_TYPE of a node
+ */
+auto record ( STAGE stage, std::uint64_t start, std::uint32_t detail = 0, std::uint8_t type = 0 ) -> void;
+
+/**
+ * Writes the events of all threads as a Chrome trace, the oldest event starts at 0.
+ * Threads that still record while the events are written may overwrite events that are being written, so this
+ * should be called after the traced work is done. The events of finished threads are kept until their buffer is reused.
+ * @param output is the stream the JSON is written to
+ */
+auto write_chrome_trace ( std::ostream& output ) -> void;
+/**
+ * Writes the events of all threads as a Chrome trace into a file, throws a runtime error if the file can not be written.
+ * @param path is the path of the file, usually ending with .json
+ */
+auto save_chrome_trace ( const std::filesystem::path& path ) -> void;
+
+/**
+ * Drops the events of all threads, like write_chrome_trace() this should not run while threads record.
+ */
+auto clear() -> void;
+
+/**
+ * Get a string for each STAGE.
+ * @param stage is the STAGE for which you want the string
+ * @return The name of the stage, e.g. "parse"
+ */
+auto stage_to_string ( STAGE stage ) -> std::string_view;
+
+/**
+ * @brief Records a stage from its construction to its destruction.
+ */
+class Scope
+{
+public:
+    /**
+     * Starts the stage, nothing is recorded if the level is OFF.
+     * @param stage is the recorded stage
+     */
+    explicit Scope ( STAGE stage )
+        : m_start ( get_level() != TRACE_LEVEL::OFF ? now() : 0 )
+        , m_stage ( stage )
+    {
+    }
+    ~Scope()
+    {
+        if ( m_start != 0 ) { record ( m_stage, m_start ); }
+    }
+    Scope ( const Scope& )            = delete;
+    Scope ( Scope&& )                 = delete;
+    Scope& operator= ( const Scope& ) = delete;
+    Scope& operator= ( Scope&& )      = delete;
+
+private:
+    std::uint64_t m_start;
+    STAGE         m_stage;
+};
+} // namespace trace
+} // namespace pfme
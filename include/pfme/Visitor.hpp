@@ -1,38 +1,68 @@
 #pragma once
+#include <concepts>
 #include <functional>
 #include <memory>
 #include <pfme/Parser.hpp>
+#include <string_view>
+#include <utility>
+#include <vector>
 namespace pfme
 {
 /**
  * @brief The Visitor class.
  * Will visit each node in the binary tree that the Parser constructed starting from the deepest node or the first node with two children.
+ *
+ * Every operation is computed in Float, floats are rounded to it before the operation and the result is stored back
+ * into the tree exactly, so a basic_visitor<double> gets the same results as a program that uses double throughout.
+ * Integers and fractions stay exact in every instantiation. Functions are evaluated in long double and their result
+ * is rounded to Float. basic_visitor is instantiated for float, double and long double, Visitor is the long double one.
+ *
+ * Conditions, && and || only evaluate their left hand first and then only the side that is needed, so a branch that
+ * is not taken (e.g. the 1 / x of x != 0 ? 1 / x : 0) can not fail the evaluation.
+ * @tparam Float is the floating point type of the evaluation
  */
-class Visitor
+template <std::floating_point Float = LD>
+class basic_visitor
 {
 public:
+    using number_t = basic_num_t<Float>; /**< The result of the evaluation */
+
     /**
      * Initialises the Visitor with a parser and will use parse().
      * @param parser is the parser that should be used
      */
-    explicit Visitor ( std::unique_ptr<Parser>&& parser );
+    explicit basic_visitor ( std::unique_ptr<Parser>&& parser );
 
     /**
      * Initialises the Visitor with a parser through an input string.
      * @param input is the input string used
      */
-    explicit Visitor ( const std::string& input );
+    explicit basic_visitor ( const std::string& input );
 
     /**
      * Initialises the Visitor with a parser through a Lexer.
      * @param lexer is the input Lexer
      */
-    explicit Visitor ( std::unique_ptr<Lexer>&& lexer );
+    explicit basic_visitor ( std::unique_ptr<Lexer>&& lexer );
+
+    /**
+     * Creates a Visitor without throwing, errors of the Lexer and the Parser are returned instead.
+     * @param input is the input string used
+     * @return A Visitor with a parsed tree or the first error in the input
+     */
+    static auto try_create ( const std::string& input ) -> Result<basic_visitor>;
+    /**
+     * Creates a Visitor from a Lexer without throwing.
+     * @see try_create(const std::string&)
+     * @param lexer is the input Lexer
+     * @return A Visitor with a parsed tree or the first error in the input
+     */
+    static auto try_create ( std::unique_ptr<Lexer>&& lexer ) -> Result<basic_visitor>;
 
     /**
 	 * @brief Will visit all nodes of the binary tree constructed by the parser.
-	 * It will loop over the tree until the root node is a number, to do that it:
-	 * - recursively looks for an operation node with two numbers as children
+	 * It will walk the tree until the root node is a number, to do that it:
+	 * - goes down (left before right) until it finds an operation node with two numbers as children
 	 * - performs the operation
 	 * - sets the operation node to a number node with the result:
 	 * 
@@ -45,6 +75,25 @@ public:
 	 * @return Is a variant with the result of the calculation
 	 */
     auto visit() -> std::string;
+    /**
+     * Visits all nodes like visit() but returns errors (e.g. a division by zero) instead of throwing them.
+     * @see visit()
+     * @return Is the result of the calculation or the error that stopped it
+     */
+    auto try_visit() -> Result<std::string>;
+    /**
+     * Visits all nodes like try_visit() but returns the number itself, so the caller decides how it is written.
+     * @see format_number
+     * @return Is the result of the calculation or the error that stopped it
+     */
+    auto try_evaluate() -> Result<number_t>;
+    /**
+     * Parses a new input with the same Parser, the buffers of the Lexer, the Parser and the Visitor are kept.
+     * @see Parser::reset
+     * @param input is the new input string
+     * @return Nothing or the first error in the input
+     */
+    auto try_reset ( std::string_view input ) -> Result<void>;
     /**
      * Helper function to print the tree.
      * @see Parser::print_binary_tree
@@ -55,11 +104,35 @@ public:
      * @param debug is the value of debug mode, true for on and false for off
      */
     auto set_debug_mode ( bool debug ) -> void { m_debug_mode = debug; }
+    /**
+     * Setter for the rounding of decimal divisions, see LexerConfig::set_decimals() for decimal literals.
+     * @param context is the scale and the rounding of decimal quotients
+     */
+    auto set_decimal_context ( const DecimalContext& context ) -> void { m_decimal_context = context; }
+    /**
+     * Setter for the limits, the Lexer and the Parser check theirs from the next input on, the Visitor checks the
+     * exponents, the steps and the time of every evaluation.
+     * @see Limits
+     * @param limits are the budgets of every expression
+     */
+    auto set_limits ( const Limits& limits ) -> void { m_parser->set_limits ( limits ); }
 
 private:
-    std::unique_ptr<Parser> m_parser     = nullptr;
-    bool                    m_debug_mode = false;
+    template <std::floating_point>
+    friend class basic_session;
+
+    basic_visitor() = default;
 
-    static auto traverse_tree ( std::shared_ptr<AST>& node ) -> std::shared_ptr<AST>&;
+    std::unique_ptr<Parser>            m_parser     = nullptr;
+    bool                               m_debug_mode = false;
+    DecimalContext                     m_decimal_context {};
+    std::vector<std::pair<AST*, bool>> m_worklist   = {}; /**< Scratch space of try_evaluate(), kept between evaluations */
+    std::vector<AST::num_t>            m_arguments  = {}; /**< The arguments of a function call */
 };
+
+using Visitor = basic_visitor<>; /**< The Visitor that evaluates in long double */
+
+extern template class basic_visitor<float>;
+extern template class basic_visitor<double>;
+extern template class basic_visitor<LD>;
 } // namespace pfme
\ No newline at end of file
@@ -1,73 +1,472 @@
+#include <compare>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <optional>
 #include <pfme/AST.hpp>
+#include <pfme/Format.hpp>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 namespace pfme
 {
-auto operator+ ( const AST& lhs, const AST& rhs ) -> AST
+namespace
 {
-    AST node;
-    std::visit ( [&] ( auto add1, auto add2 ) { node = AST { add1 + add2 }; }, lhs.m_number, rhs.m_number );
-    return node;
+// releases a tree without recursion and without memory of its own, so nothing is allocated while a tree is released
+auto release ( std::shared_ptr<AST> node ) -> void
+{
+    // children that are still shared with another owner are only let go of
+    if ( node.use_count() != 1 ) { return; }
+    while ( node != nullptr )
+    {
+        if ( node->lhand != nullptr && node->lhand.use_count() == 1 )
+        {
+            // rotate the left child up, the node becomes its right child until it has no left child anymore
+            auto left   = std::move ( node->lhand );
+            node->lhand = std::move ( left->rhand );
+            left->rhand = std::move ( node );
+            node        = std::move ( left );
+            continue;
+        }
+        node->lhand = nullptr;
+        auto right  = std::move ( node->rhand );
+        if ( right != nullptr && right.use_count() == 1 ) { node = std::move ( right ); }
+        else { node = nullptr; }
+    }
+}
+} // namespace
+
+AST::~AST()
+{
+    if ( lhand == nullptr && rhand == nullptr ) { return; }
+    release ( std::move ( lhand ) );
+    release ( std::move ( rhand ) );
+}
+
+auto AST::to_string() const -> std::string
+{
+    if ( !m_value.empty() || !is_num() ) { return m_value; }
+    return format_number ( m_number, TO_STRING_FORMAT );
+}
+
+namespace
+{
+template <std::floating_point Float, typename T>
+auto to_float ( T value ) -> Float
+{
+    if constexpr ( std::is_same_v<T, Fraction> )
+    {
+        return static_cast<Float> ( value.numerator() ) / static_cast<Float> ( value.denominator() );
+    }
+    else if constexpr ( std::is_same_v<T, Decimal> ) { return static_cast<Float> ( static_cast<LD> ( value ) ); }
+    else { return static_cast<Float> ( value ); }
+}
+
+template <typename T>
+auto to_fraction ( T value ) -> Fraction
+{
+    if constexpr ( std::is_same_v<T, Decimal> ) { return value.to_fraction(); }
+    else { return Fraction { value }; }
+}
+
+template <typename T>
+auto to_decimal ( T value ) -> Decimal
+{
+    return Decimal { value };
+}
+
+constexpr std::uint64_t LIMIT = std::numeric_limits<LLI>::max(); // the largest magnitude of an exact result
+
+auto magnitude ( LLI value ) -> std::uint64_t
+{
+    return value < 0 ? 0 - static_cast<std::uint64_t> ( value ) : static_cast<std::uint64_t> ( value );
+}
+
+auto checked_multiply ( std::uint64_t lhs, std::uint64_t rhs ) -> std::optional<std::uint64_t>
+{
+    if ( lhs != 0 && rhs > std::numeric_limits<std::uint64_t>::max() / lhs ) { return std::nullopt; }
+    return lhs * rhs;
+}
+
+// by squaring, the time grows with the bits of the exponent, nothing if the power is larger than LIMIT
+auto checked_power ( std::uint64_t base, std::uint64_t exponent ) -> std::optional<std::uint64_t>
+{
+    std::optional<std::uint64_t> product = 1, factor = base;
+    for ( ; product && factor && exponent > 0; exponent >>= 1U )
+    {
+        if ( ( exponent & 1U ) != 0 ) { product = checked_multiply ( *product, *factor ); }
+        if ( exponent > 1 ) { factor = checked_multiply ( *factor, *factor ); }
+    }
+    if ( !factor || !product || *product > LIMIT ) { return std::nullopt; }
+    return product;
+}
+
+// the smallest LLI is left out of fractions, so every numerator and denominator can be negated
+auto fits ( LLI value ) -> bool { return value != std::numeric_limits<LLI>::min(); }
+
+auto checked_sum ( LLI lhs, LLI rhs ) -> std::optional<LLI>
+{
+    if ( rhs > 0 ? lhs > std::numeric_limits<LLI>::max() - rhs : lhs < std::numeric_limits<LLI>::min() - rhs )
+    {
+        return std::nullopt;
+    }
+    return lhs + rhs;
+}
+
+auto checked_difference ( LLI lhs, LLI rhs ) -> std::optional<LLI>
+{
+    if ( rhs < 0 ? lhs > std::numeric_limits<LLI>::max() + rhs : lhs < std::numeric_limits<LLI>::min() + rhs )
+    {
+        return std::nullopt;
+    }
+    return lhs - rhs;
+}
+
+auto checked_product ( LLI lhs, LLI rhs ) -> std::optional<LLI>
+{
+    const bool negative = ( lhs < 0 ) != ( rhs < 0 );
+    const auto product  = checked_multiply ( magnitude ( lhs ), magnitude ( rhs ) );
+    if ( !product || *product > LIMIT + ( negative ? 1 : 0 ) ) { return std::nullopt; }
+    return negative ? static_cast<LLI> ( 0 - *product ) : static_cast<LLI> ( *product );
+}
+
+// + - * of two integers, nothing if the result does not fit
+auto integer_arithmetic ( AST_TYPE operation, LLI lhs, LLI rhs ) -> std::optional<LLI>
+{
+    switch ( operation )
+    {
+    case AST_TYPE::ADDITION: return checked_sum ( lhs, rhs );
+    case AST_TYPE::SUBTRACTION: return checked_difference ( lhs, rhs );
+    default: return checked_product ( lhs, rhs );
+    }
 }
 
-auto operator- ( const AST& lhs, const AST& rhs ) -> AST
+// + - * / of two fractions, the divisor is not 0, nothing if a numerator or a denominator does not fit
+auto fraction_arithmetic ( AST_TYPE operation, const Fraction& lhs, const Fraction& rhs ) -> std::optional<Fraction>
 {
-    AST node;
-    std::visit ( [&] ( auto minuend, auto subtrahend ) { node = AST { minuend - subtrahend }; }, lhs.m_number, rhs.m_number );
-    return node;
+    if ( !fits ( lhs.numerator() ) || !fits ( lhs.denominator() ) || !fits ( rhs.numerator() ) || !fits ( rhs.denominator() ) )
+    {
+        return std::nullopt;
+    }
+    const auto first = lhs.numerator(), first_denominator = lhs.denominator();
+    auto       second = rhs.numerator(), second_denominator = rhs.denominator();
+    if ( operation == AST_TYPE::SUBTRACTION ) { second = -second; }
+    if ( operation == AST_TYPE::DIVISION ) { std::swap ( second, second_denominator ); }
+
+    std::optional<LLI> numerator, denominator;
+    if ( operation == AST_TYPE::ADDITION || operation == AST_TYPE::SUBTRACTION )
+    {
+        // over the least common multiple of the denominators, so the products stay as small as possible
+        const auto common = static_cast<LLI> ( std::gcd ( magnitude ( first_denominator ), magnitude ( second_denominator ) ) );
+        const auto left   = checked_product ( first, second_denominator / common );
+        const auto right  = checked_product ( second, first_denominator / common );
+        numerator         = left && right ? checked_sum ( *left, *right ) : std::nullopt;
+        denominator       = checked_product ( first_denominator, second_denominator / common );
+    }
+    else
+    {
+        // cancelled crosswise before multiplying, a / b * c / d = (a / g * c / h) / (b / h * d / g)
+        const auto left  = static_cast<LLI> ( std::gcd ( magnitude ( first ), magnitude ( second_denominator ) ) );
+        const auto right = static_cast<LLI> ( std::gcd ( magnitude ( second ), magnitude ( first_denominator ) ) );
+        numerator        = checked_product ( first / left, second / right );
+        denominator      = checked_product ( first_denominator / right, second_denominator / left );
+    }
+    if ( !numerator || !denominator || !fits ( *numerator ) || !fits ( *denominator ) ) { return std::nullopt; }
+    return Fraction { *numerator, *denominator };
 }
 
-auto operator* ( const AST& lhs, const AST& rhs ) -> AST
+template <typename T>
+constexpr bool IS_DECIMAL = std::is_same_v<T, Decimal>;
+
+// integers and fractions are checked, a result that does not fit into 64 bits is ERROR_CODE::NUMBER_OUT_OF_RANGE
+// as soon as a float is involved both sides are turned into Float
+// a decimal stays a decimal with integers and decimals, like an integer it is ERROR_CODE::NUMBER_OUT_OF_RANGE if the
+// exact result does not fit
+template <std::floating_point Float, typename Operation, typename Exact>
+auto arithmetic ( AST_TYPE                  type,
+                  const basic_num_t<Float>& lhs,
+                  const basic_num_t<Float>& rhs,
+                  Operation                 operation,
+                  Exact                     exact ) -> std::expected<basic_num_t<Float>, ERROR_CODE>
 {
-    AST node;
-    std::visit ( [&] ( auto factor1, auto factor2 ) { node = AST { factor1 * factor2 }; }, lhs.m_number, rhs.m_number );
-    return node;
+    return std::visit (
+        [&] ( auto left, auto right ) -> std::expected<basic_num_t<Float>, ERROR_CODE>
+        {
+            using Left  = decltype ( left );
+            using Right = decltype ( right );
+            if constexpr ( std::is_same_v<Left, Float> || std::is_same_v<Right, Float> )
+            {
+                return operation ( to_float<Float> ( left ), to_float<Float> ( right ) );
+            }
+            else if constexpr ( std::is_same_v<Left, LLI> && std::is_same_v<Right, LLI> )
+            {
+                if ( const auto result = integer_arithmetic ( type, left, right ) ) { return *result; }
+                return std::unexpected ( ERROR_CODE::NUMBER_OUT_OF_RANGE );
+            }
+            else if constexpr ( ( !IS_DECIMAL<Left> && !IS_DECIMAL<Right> ) || std::is_same_v<Left, Fraction> ||
+                                std::is_same_v<Right, Fraction> )
+            {
+                if ( const auto result = fraction_arithmetic ( type, to_fraction ( left ), to_fraction ( right ) ) )
+                {
+                    return *result;
+                }
+                return std::unexpected ( ERROR_CODE::NUMBER_OUT_OF_RANGE );
+            }
+            else
+            {
+                if ( const auto result = exact ( to_decimal ( left ), to_decimal ( right ) ) ) { return *result; }
+                return std::unexpected ( ERROR_CODE::NUMBER_OUT_OF_RANGE );
+            }
+        },
+        lhs,
+        rhs );
 }
 
-auto operator/ ( const AST& lhs, const AST& rhs ) -> AST
+template <std::floating_point Float>
+auto divide ( const basic_num_t<Float>& lhs, const basic_num_t<Float>& rhs, const DecimalContext& context )
+    -> std::expected<basic_num_t<Float>, ERROR_CODE>
 {
-    if ( ( rhs.m_type == AST_TYPE::INTEGER && std::get<LLI> ( rhs.m_number ) == 0 ) ||
-         ( rhs.m_type == AST_TYPE::FLOAT && std::get<LD> ( rhs.m_number ) == 0 ) )
+    const auto* dividend = std::get_if<LLI> ( &lhs );
+    const auto* divisor  = std::get_if<LLI> ( &rhs );
+    if ( dividend != nullptr && divisor != nullptr ) // preserve the type if there is a "clean" integer division
     {
-        throw std::runtime_error ( "Division by Zero" );
+        // the smallest LLI can be divided as a whole, only its negation does not fit
+        if ( *divisor == -1 && *dividend == std::numeric_limits<LLI>::min() )
+        {
+            return std::unexpected ( ERROR_CODE::NUMBER_OUT_OF_RANGE );
+        }
+        if ( *dividend % *divisor == 0 ) { return *dividend / *divisor; }
+        const auto temp = fraction_arithmetic ( AST_TYPE::DIVISION, Fraction { *dividend }, Fraction { *divisor } );
+        if ( !temp ) { return std::unexpected ( ERROR_CODE::NUMBER_OUT_OF_RANGE ); }
+        if ( temp->is_whole() ) { return static_cast<LLI> ( *temp ); }
+        return *temp;
     }
-    if ( lhs.m_type == AST_TYPE::INTEGER &&
-         rhs.m_type == AST_TYPE::INTEGER ) // preserve the type if there is a "clean" integer division
+    return arithmetic<Float> (
+        AST_TYPE::DIVISION,
+        lhs,
+        rhs,
+        [] ( auto div1, auto div2 ) { return div1 / div2; },
+        [&context] ( const Decimal& div1, const Decimal& div2 ) { return div1.divide ( div2, context ); } );
+}
+
+template <std::floating_point Float>
+auto power ( const basic_num_t<Float>& lhs, const basic_num_t<Float>& rhs, const DecimalContext& context ) -> basic_num_t<Float>
+{
+    // a whole decimal exponent is an integer exponent, so the result can stay exact
+    if ( const auto* decimal = std::get_if<Decimal> ( &rhs ); decimal != nullptr && decimal->is_whole() )
+    {
+        return power<Float> ( lhs, decimal->mantissa(), context );
+    }
+    const auto* base     = std::get_if<LLI> ( &lhs );
+    const auto* exponent = std::get_if<LLI> ( &rhs );
+    if ( const auto* floating = std::get_if<Float> ( &rhs );
+         ( exponent != nullptr && *exponent == 0 ) || ( floating != nullptr && *floating == 0 ) )
+    {
+        return 1LL;
+    }
+    const bool odd = exponent != nullptr && ( magnitude ( *exponent ) & 1U ) != 0;
+    if ( base != nullptr && exponent != nullptr ) // exponentiation while preserving the integer type
     {
-        const Fraction temp { std::get<LLI> ( lhs.m_number ), std::get<LLI> ( rhs.m_number ) };
-        if ( temp.is_whole() ) { return AST { static_cast<LLI> ( temp ) }; }
-        return AST { temp };
+        // a power that does not fit is calculated in Float below
+        if ( const auto product = checked_power ( magnitude ( *base ), magnitude ( *exponent ) ) )
+        {
+            const auto res = *base < 0 && odd ? -static_cast<LLI> ( *product ) : static_cast<LLI> ( *product );
+            // a negative exponent is the inverse, which stays exact as a fraction
+            if ( *exponent > 0 || *product == 1 ) { return res; }
+            return Fraction { 1, res };
+        }
     }
+    if ( const auto* fraction = std::get_if<Fraction> ( &lhs ); fraction != nullptr && exponent != nullptr )
+    {
+        const auto numerator   = checked_power ( magnitude ( fraction->numerator() ), magnitude ( *exponent ) );
+        const auto denominator = checked_power ( magnitude ( fraction->denominator() ), magnitude ( *exponent ) );
+        if ( numerator && denominator )
+        {
+            const bool negative = ( fraction->numerator() < 0 ) != ( fraction->denominator() < 0 ) && odd;
+            const auto top      = negative ? -static_cast<LLI> ( *numerator ) : static_cast<LLI> ( *numerator );
+            const auto bottom   = static_cast<LLI> ( *denominator );
+            // a negative exponent is the inverse, the result stays a fraction
+            if ( *exponent > 0 ) { return Fraction { top, bottom }; }
+            return Fraction { bottom, top };
+        }
+    }
+    if ( const auto* decimal = std::get_if<Decimal> ( &lhs ); decimal != nullptr && exponent != nullptr )
+    {
+        // by squaring, a decimal runs out of digits long before the exponent gets large
+        std::optional<Decimal> res = Decimal { 1 }, factor = *decimal;
+        const auto             magnitude = static_cast<std::uint64_t> ( *exponent );
+        auto                   bits      = *exponent < 0 ? 0 - magnitude : magnitude;
+        for ( ; res && factor && bits > 0; bits >>= 1U )
+        {
+            if ( ( bits & 1U ) != 0 ) { res = res->multiply ( *factor ); }
+            if ( bits > 1 ) { factor = factor->multiply ( *factor ); }
+        }
+        if ( !factor ) { res.reset(); }
+        if ( res && *exponent < 0 ) { res = Decimal { 1 }.divide ( *res, context ); }
+        if ( res ) { return *res; }
+    }
+    return std::visit (
+        [] ( auto base_value, auto exponent_value ) -> basic_num_t<Float>
+        {
+            // exact powers that fit are already done
+            return std::pow ( to_float<Float> ( base_value ), to_float<Float> ( exponent_value ) );
+        },
+        lhs,
+        rhs );
+}
 
-    AST node {};
-    std::visit ( [&] ( auto div1, auto div2 ) { node = AST { div1 / div2 }; }, lhs.m_number, rhs.m_number );
-    return AST { node };
+// the product of two 64 bit numbers as its high and its low half, without a 128 bit type
+auto wide_multiply ( std::uint64_t lhs, std::uint64_t rhs ) -> std::pair<std::uint64_t, std::uint64_t>
+{
+    constexpr std::uint64_t LOW       = 0xFFFFFFFFULL;
+    const std::uint64_t     low_low   = ( lhs & LOW ) * ( rhs & LOW );
+    const std::uint64_t     high_low  = ( lhs >> 32U ) * ( rhs & LOW );
+    const std::uint64_t     low_high  = ( lhs & LOW ) * ( rhs >> 32U );
+    const std::uint64_t     high_high = ( lhs >> 32U ) * ( rhs >> 32U );
+    const std::uint64_t     middle    = ( low_low >> 32U ) + ( high_low & LOW ) + low_high;
+    return { high_high + ( high_low >> 32U ) + ( middle >> 32U ), ( middle << 32U ) | ( low_low & LOW ) };
 }
 
-auto operator^ ( const AST& lhs, const AST& rhs ) -> AST
+// a / b and c / d are compared by their signs and then by |a| * |d| and |c| * |b|, which always fit into 128 bits
+auto compare_exact ( const Fraction& lhs, const Fraction& rhs ) -> std::strong_ordering
 {
-    if ( ( rhs.m_type == AST_TYPE::INTEGER && std::get<LLI> ( rhs.m_number ) == 0 ) ||
-         ( rhs.m_type == AST_TYPE::FLOAT && std::get<LD> ( rhs.m_number ) == 0 ) )
+    const auto sign = [] ( const Fraction& fraction )
+    { return ( ( fraction.numerator() > 0 ) - ( fraction.numerator() < 0 ) ) * ( fraction.denominator() < 0 ? -1 : 1 ); };
+    const int left  = sign ( lhs );
+    const int right = sign ( rhs );
+    if ( left != right || left == 0 ) { return left <=> right; }
+    const auto left_product  = wide_multiply ( magnitude ( lhs.numerator() ), magnitude ( rhs.denominator() ) );
+    const auto right_product = wide_multiply ( magnitude ( rhs.numerator() ), magnitude ( lhs.denominator() ) );
+    return left > 0 ? left_product <=> right_product : right_product <=> left_product;
+}
+
+// exact numbers are never rounded for a comparison, with a float both are compared as Float
+template <std::floating_point Float>
+auto compare ( const basic_num_t<Float>& lhs, const basic_num_t<Float>& rhs ) -> std::partial_ordering
+{
+    return std::visit (
+        [] ( auto left, auto right ) -> std::partial_ordering
+        {
+            using Left  = decltype ( left );
+            using Right = decltype ( right );
+            if constexpr ( std::is_same_v<Left, Float> || std::is_same_v<Right, Float> )
+            {
+                return to_float<Float> ( left ) <=> to_float<Float> ( right );
+            }
+            else if constexpr ( std::is_same_v<Left, LLI> && std::is_same_v<Right, LLI> ) { return left <=> right; }
+            else { return compare_exact ( to_fraction ( left ), to_fraction ( right ) ); }
+        },
+        lhs,
+        rhs );
+}
+
+// NaN is unordered, so it is only not equal
+auto holds ( AST_TYPE comparison, std::partial_ordering order ) -> bool
+{
+    switch ( comparison )
     {
-        return AST { 1LL };
+    case AST_TYPE::LESS: return order < 0;
+    case AST_TYPE::LESS_EQUAL: return order <= 0;
+    case AST_TYPE::GREATER: return order > 0;
+    case AST_TYPE::GREATER_EQUAL: return order >= 0;
+    case AST_TYPE::EQUAL: return order == 0;
+    default: return order != 0;
     }
-    if ( lhs.m_type == AST_TYPE::INTEGER &&
-         rhs.m_type == AST_TYPE::INTEGER ) // exponentiation while preserving the integer type
+}
+
+auto to_node ( const AST::num_t& number ) -> AST
+{
+    return std::visit ( [] ( auto value ) { return AST { value }; }, number );
+}
+
+// the operators throw the errors apply() returns
+auto checked ( AST_TYPE operation, const AST& lhs, const AST& rhs ) -> AST
+{
+    auto result = apply_operation<LD> ( operation, lhs.m_number, rhs.m_number );
+    if ( !result ) { throw std::runtime_error ( std::string ( error_code_to_string ( result.error() ) ) ); }
+    return to_node ( *result );
+}
+} // namespace
+
+auto operator+ ( const AST& lhs, const AST& rhs ) -> AST { return checked ( AST_TYPE::ADDITION, lhs, rhs ); }
+
+auto operator- ( const AST& lhs, const AST& rhs ) -> AST { return checked ( AST_TYPE::SUBTRACTION, lhs, rhs ); }
+
+auto operator* ( const AST& lhs, const AST& rhs ) -> AST { return checked ( AST_TYPE::MULTIPLICATION, lhs, rhs ); }
+
+auto operator/ ( const AST& lhs, const AST& rhs ) -> AST { return checked ( AST_TYPE::DIVISION, lhs, rhs ); }
+
+auto operator^ ( const AST& lhs, const AST& rhs ) -> AST { return checked ( AST_TYPE::EXPONENTIATION, lhs, rhs ); }
+
+template <std::floating_point Float>
+auto apply_operation ( AST_TYPE                  operation,
+                       const basic_num_t<Float>& lhs,
+                       const basic_num_t<Float>& rhs,
+                       const DecimalContext&     context ) -> std::expected<basic_num_t<Float>, ERROR_CODE>
+{
+    const auto is_zero = [] ( const basic_num_t<Float>& number )
+    { return std::visit ( [] ( auto value ) { return value == decltype ( value ) { 0 }; }, number ); };
+    const auto is_negative = [] ( const basic_num_t<Float>& number )
+    { return std::visit ( [] ( auto value ) { return to_float<Float> ( value ) < 0; }, number ); };
+
+    switch ( operation )
     {
-        LLI res = 1;
-        for ( LLI i = 0; i < std::get<LLI> ( rhs.m_number ); ++i ) { res *= std::get<LLI> ( lhs.m_number ); }
-        return AST { res };
+    case AST_TYPE::MULTIPLICATION:
+        return arithmetic<Float> ( operation,
+                                   lhs,
+                                   rhs,
+                                   [] ( auto factor1, auto factor2 ) { return factor1 * factor2; },
+                                   std::mem_fn ( &Decimal::multiply ) );
+    case AST_TYPE::DIVISION:
+        if ( is_zero ( rhs ) ) { return std::unexpected ( ERROR_CODE::DIVISION_BY_ZERO ); }
+        return divide<Float> ( lhs, rhs, context );
+    case AST_TYPE::ADDITION:
+        return arithmetic<Float> (
+            operation, lhs, rhs, [] ( auto add1, auto add2 ) { return add1 + add2; }, std::mem_fn ( &Decimal::add ) );
+    case AST_TYPE::SUBTRACTION:
+        return arithmetic<Float> ( operation,
+                                   lhs,
+                                   rhs,
+                                   [] ( auto minuend, auto subtrahend ) { return minuend - subtrahend; },
+                                   std::mem_fn ( &Decimal::subtract ) );
+    case AST_TYPE::EXPONENTIATION:
+        if ( is_zero ( lhs ) && is_negative ( rhs ) ) { return std::unexpected ( ERROR_CODE::DIVISION_BY_ZERO ); }
+        return power<Float> ( lhs, rhs, context );
+    case AST_TYPE::LESS: [[fallthrough]];
+    case AST_TYPE::LESS_EQUAL: [[fallthrough]];
+    case AST_TYPE::GREATER: [[fallthrough]];
+    case AST_TYPE::GREATER_EQUAL: [[fallthrough]];
+    case AST_TYPE::EQUAL: [[fallthrough]];
+    case AST_TYPE::NOT_EQUAL: return LLI { holds ( operation, compare<Float> ( lhs, rhs ) ) };
+    case AST_TYPE::AND: return LLI { is_true<Float> ( lhs ) && is_true<Float> ( rhs ) };
+    case AST_TYPE::OR: return LLI { is_true<Float> ( lhs ) || is_true<Float> ( rhs ) };
+    default: return std::unexpected ( ERROR_CODE::INVALID_OPERATOR );
     }
+}
+
+template auto apply_operation<float> ( AST_TYPE, const basic_num_t<float>&, const basic_num_t<float>&, const DecimalContext& )
+    -> std::expected<basic_num_t<float>, ERROR_CODE>;
+template auto apply_operation<double> ( AST_TYPE,
+                                        const basic_num_t<double>&,
+                                        const basic_num_t<double>&,
+                                        const DecimalContext& ) -> std::expected<basic_num_t<double>, ERROR_CODE>;
+template auto apply_operation<LD> ( AST_TYPE, const basic_num_t<LD>&, const basic_num_t<LD>&, const DecimalContext& )
+    -> std::expected<basic_num_t<LD>, ERROR_CODE>;
 
-    LD res {};
-    std::visit (
-        [&] ( auto base, auto exponent ) { res = std::powl ( static_cast<LD> ( base ), static_cast<LD> ( exponent ) ); },
-        lhs.m_number,
-        rhs.m_number );
-    return AST { res };
+auto apply ( AST_TYPE operation, const AST& lhs, const AST& rhs ) -> std::expected<AST, ERROR_CODE>
+{
+    auto result = apply_operation<LD> ( operation, lhs.m_number, rhs.m_number );
+    if ( !result ) { return std::unexpected ( result.error() ); }
+    return to_node ( *result );
 }
 
 auto operator<< ( std::ostream& stream, const AST& obj ) -> std::ostream&
 {
-    if ( obj.is_num() ) { stream << obj.m_value; }
+    if ( obj.is_num() ) { stream << obj.to_string(); }
+    else if ( obj.m_type == AST_TYPE::FUNCTION ) { stream << "Function: " << obj.m_value; }
+    else if ( obj.m_type == AST_TYPE::VARIABLE ) { stream << "Variable: " << obj.m_value; }
     else
     {
         stream << "Operation: " << obj.lhand->operation_to_string() << ' ' << obj.operation_to_string() << ' '
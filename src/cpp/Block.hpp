@@ -0,0 +1,161 @@
+#pragma once
+// The forward step of the batch evaluations of Compiled.cpp and Gradient.cpp, not part of the public headers.
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <pfme/AST.hpp>
+#include <pfme/Functions.hpp>
+#include <pfme/Serialization.hpp>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace pfme
+{
+template <std::floating_point Float>
+auto to_float ( const AST::num_t& number ) -> Float
+{
+    if ( const auto* fraction = std::get_if<Fraction> ( &number ) )
+    {
+        return static_cast<Float> ( fraction->numerator() ) / static_cast<Float> ( fraction->denominator() );
+    }
+    if ( const auto* integer = std::get_if<LLI> ( &number ) ) { return static_cast<Float> ( *integer ); }
+    if ( const auto* decimal = std::get_if<Decimal> ( &number ) )
+    {
+        return static_cast<Float> ( static_cast<LD> ( *decimal ) );
+    }
+    return static_cast<Float> ( std::get<LD> ( number ) );
+}
+
+// the comparisons of a block, every row is turned into 1 or 0 without a branch, so the loops become vector compares
+template <std::floating_point Float>
+auto compare_block ( AST_TYPE type, const Float* lhs, const Float* rhs, Float* out, std::size_t size ) -> void
+{
+    switch ( type )
+    {
+    case AST_TYPE::LESS:
+        for ( std::size_t row = 0; row < size; ++row ) { out[row] = static_cast<Float> ( lhs[row] < rhs[row] ); }
+        break;
+    case AST_TYPE::LESS_EQUAL:
+        for ( std::size_t row = 0; row < size; ++row ) { out[row] = static_cast<Float> ( lhs[row] <= rhs[row] ); }
+        break;
+    case AST_TYPE::GREATER:
+        for ( std::size_t row = 0; row < size; ++row ) { out[row] = static_cast<Float> ( lhs[row] > rhs[row] ); }
+        break;
+    case AST_TYPE::GREATER_EQUAL:
+        for ( std::size_t row = 0; row < size; ++row ) { out[row] = static_cast<Float> ( lhs[row] >= rhs[row] ); }
+        break;
+    case AST_TYPE::EQUAL:
+        for ( std::size_t row = 0; row < size; ++row ) { out[row] = static_cast<Float> ( lhs[row] == rhs[row] ); }
+        break;
+    case AST_TYPE::NOT_EQUAL:
+        for ( std::size_t row = 0; row < size; ++row ) { out[row] = static_cast<Float> ( lhs[row] != rhs[row] ); }
+        break;
+    case AST_TYPE::AND:
+        for ( std::size_t row = 0; row < size; ++row )
+        {
+            out[row] = static_cast<Float> ( ( lhs[row] != 0 ) & ( rhs[row] != 0 ) );
+        }
+        break;
+    default:
+        for ( std::size_t row = 0; row < size; ++row )
+        {
+            out[row] = static_cast<Float> ( ( lhs[row] != 0 ) | ( rhs[row] != 0 ) );
+        }
+        break;
+    }
+}
+
+// both results are complete for the block, so every row picks one with a blend instead of a jump
+template <std::floating_point Float>
+auto select_block ( const Float* condition, const Float* first, const Float* second, Float* out, std::size_t size ) -> void
+{
+    for ( std::size_t row = 0; row < size; ++row ) { out[row] = condition[row] != 0 ? first[row] : second[row]; }
+}
+
+// the value of node i for a block of rows, block[j * stride + row] is the value of node j in the row and the nodes in
+// front of i are already done, the first row of the block is row begin of the variable columns
+template <std::floating_point Float>
+auto evaluate_block ( std::span<const BinaryNode>             nodes,
+                      std::size_t                             i,
+                      Float*                                  block,
+                      std::size_t                             stride,
+                      std::span<const std::span<const Float>> variables,
+                      std::size_t                             begin,
+                      std::size_t                             size,
+                      std::vector<std::span<const Float>>&    columns,
+                      std::vector<AST::num_t>&                arguments ) -> void
+{
+    const auto& node = nodes[i];
+    auto*       out  = block + ( i * stride );
+    const auto* lhs  = block + ( std::size_t { node.m_lhand } * stride );
+    const auto* rhs  = block + ( std::size_t { node.m_rhand } * stride );
+    switch ( node.get_type() )
+    {
+    case AST_TYPE::ARGUMENT: break;
+    case AST_TYPE::INTEGER: [[fallthrough]];
+    case AST_TYPE::FLOAT: [[fallthrough]];
+    case AST_TYPE::FRACTION: [[fallthrough]];
+    case AST_TYPE::DECIMAL: std::fill ( out, out + size, to_float<Float> ( node.to_number() ) ); break;
+    case AST_TYPE::VARIABLE: std::copy_n ( variables[node.m_extra].data() + begin, size, out ); break;
+    case AST_TYPE::ADDITION:
+        for ( std::size_t row = 0; row < size; ++row ) { out[row] = lhs[row] + rhs[row]; }
+        break;
+    case AST_TYPE::SUBTRACTION:
+        for ( std::size_t row = 0; row < size; ++row ) { out[row] = lhs[row] - rhs[row]; }
+        break;
+    case AST_TYPE::MULTIPLICATION:
+        for ( std::size_t row = 0; row < size; ++row ) { out[row] = lhs[row] * rhs[row]; }
+        break;
+    case AST_TYPE::DIVISION:
+        for ( std::size_t row = 0; row < size; ++row ) { out[row] = lhs[row] / rhs[row]; }
+        break;
+    case AST_TYPE::EXPONENTIATION:
+        for ( std::size_t row = 0; row < size; ++row ) { out[row] = std::pow ( lhs[row], rhs[row] ); }
+        break;
+    case AST_TYPE::LESS: [[fallthrough]];
+    case AST_TYPE::LESS_EQUAL: [[fallthrough]];
+    case AST_TYPE::GREATER: [[fallthrough]];
+    case AST_TYPE::GREATER_EQUAL: [[fallthrough]];
+    case AST_TYPE::EQUAL: [[fallthrough]];
+    case AST_TYPE::NOT_EQUAL: [[fallthrough]];
+    case AST_TYPE::AND: [[fallthrough]];
+    case AST_TYPE::OR: compare_block ( node.get_type(), lhs, rhs, out, size ); break;
+    case AST_TYPE::ALTERNATIVE: break;
+    case AST_TYPE::CONDITION:
+    {
+        const auto& alternative = nodes[node.m_rhand];
+        select_block ( lhs,
+                       block + ( std::size_t { alternative.m_lhand } * stride ),
+                       block + ( std::size_t { alternative.m_rhand } * stride ),
+                       out,
+                       size );
+        break;
+    }
+    case AST_TYPE::FUNCTION:
+    {
+        columns.assign ( 1, { lhs, size } );
+        for ( auto next = node.m_rhand; next != BinaryNode::NO_CHILD; next = nodes[next].m_rhand )
+        {
+            columns.emplace_back ( block + ( std::size_t { nodes[next].m_lhand } * stride ), size );
+        }
+        if constexpr ( std::is_same_v<Float, double> ) { call_batch ( node.m_extra, columns, { out, size } ); }
+        else
+        {
+            for ( std::size_t row = 0; row < size; ++row )
+            {
+                arguments.clear();
+                for ( const auto column : columns ) { arguments.emplace_back ( static_cast<LD> ( column[row] ) ); }
+                const auto result = call ( node.m_extra, arguments );
+                out[row]          = result ? to_float<Float> ( *result ) : std::numeric_limits<Float>::quiet_NaN();
+            }
+        }
+        break;
+    }
+    default: break;
+    }
+}
+} // namespace pfme
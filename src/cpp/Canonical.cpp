@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <pfme/Canonical.hpp>
+#include <pfme/Parser.hpp>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace pfme
+{
+namespace
+{
+// the finalizer of splitmix64, every bit of the input changes about half of the output
+auto mix ( std::uint64_t value ) -> std::uint64_t
+{
+    value ^= value >> 30U;
+    value *= 0xBF58'476D'1CE4'E5B9ULL;
+    value ^= value >> 27U;
+    value *= 0x94D0'49BB'1331'11EBULL;
+    return value ^ ( value >> 31U );
+}
+
+/**
+ * @brief Hashes a sequence of words into two lanes, the bytes of a text are read as little endian words on every platform.
+ */
+class Hasher
+{
+public:
+    auto add ( std::uint64_t word ) -> void
+    {
+        m_low  = mix ( m_low ^ word );
+        m_high = mix ( m_high + word + std::rotl ( m_low, 29 ) );
+    }
+    auto add ( std::string_view text ) -> void
+    {
+        add ( std::uint64_t { text.size() } );
+        for ( std::size_t i = 0; i < text.size(); i += 8 )
+        {
+            std::uint64_t word = 0;
+            for ( std::size_t byte = i; byte < std::min ( i + 8, text.size() ); ++byte )
+            {
+                word |= std::uint64_t { static_cast<unsigned char> ( text[byte] ) } << ( 8 * ( byte - i ) );
+            }
+            add ( word );
+        }
+    }
+    auto add ( const Hash128& hash ) -> void
+    {
+        add ( hash.m_low );
+        add ( hash.m_high );
+    }
+    [[nodiscard]] auto get() const -> Hash128 { return { m_low, m_high }; }
+
+private:
+    std::uint64_t m_low  = 0x9E37'79B9'7F4A'7C15ULL;
+    std::uint64_t m_high = 0xC2B2'AE3D'27D4'EB4FULL;
+};
+
+auto hash_number ( const AST::num_t& number ) -> Hash128
+{
+    Hasher hasher;
+    hasher.add ( std::uint64_t { number.index() } );
+    std::visit (
+        [&hasher] ( const auto& value )
+        {
+            using T = std::decay_t<decltype ( value )>;
+            if constexpr ( std::is_same_v<T, LLI> ) { hasher.add ( static_cast<std::uint64_t> ( value ) ); }
+            else if constexpr ( std::is_same_v<T, Fraction> )
+            {
+                hasher.add ( static_cast<std::uint64_t> ( value.numerator() ) );
+                hasher.add ( static_cast<std::uint64_t> ( value.denominator() ) );
+            }
+            else if constexpr ( std::is_same_v<T, Decimal> )
+            {
+                hasher.add ( static_cast<std::uint64_t> ( value.mantissa() ) );
+                hasher.add ( std::uint64_t { value.scale() } );
+            }
+            else
+            {
+                // the shortest text that reads back to the same value does not depend on the padding of long double
+                std::array<char, 64> buffer {};
+                const auto           end = std::to_chars ( buffer.data(), buffer.data() + buffer.size(), value ).ptr;
+                hasher.add ( std::string_view ( buffer.data(), end ) );
+            }
+        },
+        number );
+    return hasher.get();
+}
+
+auto is_commutative ( AST_TYPE type ) -> bool
+{
+    return type == AST_TYPE::ADDITION || type == AST_TYPE::MULTIPLICATION || type == AST_TYPE::EQUAL ||
+           type == AST_TYPE::NOT_EQUAL;
+}
+
+auto is_call ( AST_TYPE type ) -> bool { return type == AST_TYPE::FUNCTION || type == AST_TYPE::ARGUMENT; }
+
+/**
+ * @brief A node of the walked tree, the node itself is only built if the tree is needed.
+ */
+struct Entry
+{
+    std::shared_ptr<AST> m_node;
+    Hash128              m_hash;
+};
+
+// an operation of the tree with its operands, which are already on the stack of results
+auto combine ( const AST& operation, std::span<Entry> operands, bool build ) -> Entry
+{
+    Hasher hasher;
+    hasher.add ( static_cast<std::uint64_t> ( operation.m_type ) );
+    if ( operation.m_type == AST_TYPE::FUNCTION ) { hasher.add ( operation.m_value ); }
+    hasher.add ( std::uint64_t { operands.size() } );
+    for ( const auto& operand : operands ) { hasher.add ( operand.m_hash ); }
+
+    Entry entry { nullptr, hasher.get() };
+    if ( build )
+    {
+        entry.m_node                    = std::make_shared<AST> ( std::move ( operands[0].m_node ) );
+        entry.m_node->m_type            = operation.m_type;
+        entry.m_node->m_value           = operation.m_value;
+        entry.m_node->m_function        = operation.m_function;
+        entry.m_node->m_operation_level = operation.m_operation_level;
+        if ( operands.size() > 1 ) { entry.m_node->rhand = std::move ( operands[1].m_node ); }
+    }
+    return entry;
+}
+
+/**
+ * Walks the tree in post order without recursion.
+ * @param root is the root of the tree
+ * @param reorder orders the operands of commutative operations, otherwise the tree is only hashed as it is
+ * @param mode decides if chains of + and * are flattened
+ * @param build builds the new tree, otherwise only the hash is computed
+ * @return The new root and its hash
+ */
+auto walk ( const AST* root, bool reorder, CANONICAL mode, bool build ) -> Entry
+{
+    struct Frame
+    {
+        const AST*  m_node;
+        std::size_t m_operands; /**< The number of results the node takes from the stack, once they are computed */
+        bool        m_done;
+    };
+
+    std::vector<Frame>      stack { { root, 0, false } };
+    std::vector<Entry>      results;
+    std::vector<const AST*> chain;
+    std::vector<const AST*> operands;
+    while ( !stack.empty() )
+    {
+        const auto [node, count, done] = stack.back();
+        stack.pop_back();
+        if ( node == nullptr ) { throw std::runtime_error ( "Can not canonicalize an incomplete tree" ); }
+        if ( node->is_num() )
+        {
+            // the new number has no text, 0x10 and 16 are the same node
+            auto number =
+                build ? std::visit ( [] ( auto value ) { return std::make_shared<AST> ( value ); }, node->m_number ) : nullptr;
+            results.push_back ( { std::move ( number ), hash_number ( node->m_number ) } );
+            continue;
+        }
+        if ( node->m_type == AST_TYPE::VARIABLE )
+        {
+            Hasher hasher;
+            hasher.add ( static_cast<std::uint64_t> ( node->m_type ) );
+            hasher.add ( node->m_value );
+            auto variable = build ? std::make_shared<AST> ( AST_TYPE::VARIABLE, node->m_value ) : nullptr;
+            results.push_back ( { std::move ( variable ), hasher.get() } );
+            continue;
+        }
+
+        if ( !done )
+        {
+            operands.clear();
+            if ( reorder && mode == CANONICAL::ASSOCIATIVE &&
+                 ( node->m_type == AST_TYPE::ADDITION || node->m_type == AST_TYPE::MULTIPLICATION ) )
+            {
+                // the operands of the whole chain in their order, a + (b + c) and (a + b) + c have the same ones
+                chain.assign ( 1, node );
+                while ( !chain.empty() )
+                {
+                    const auto* link = chain.back();
+                    chain.pop_back();
+                    if ( link != nullptr && link->m_type == node->m_type )
+                    {
+                        chain.push_back ( link->rhand.get() );
+                        chain.push_back ( link->lhand.get() );
+                    }
+                    else { operands.push_back ( link ); }
+                }
+            }
+            else
+            {
+                operands.push_back ( node->lhand.get() );
+                if ( node->rhand != nullptr || !is_call ( node->m_type ) ) { operands.push_back ( node->rhand.get() ); }
+            }
+            stack.push_back ( { node, operands.size(), true } );
+            for ( auto operand = operands.rbegin(); operand != operands.rend(); ++operand )
+            {
+                stack.push_back ( { *operand, 0, false } );
+            }
+            continue;
+        }
+
+        const auto      first = results.end() - static_cast<std::ptrdiff_t> ( count );
+        const std::span taken ( first, results.end() );
+        if ( reorder && is_commutative ( node->m_type ) )
+        {
+            std::ranges::sort ( taken,
+                                [] ( const Entry& lhs, const Entry& rhs )
+                                {
+                                    return std::pair { lhs.m_hash.m_high, lhs.m_hash.m_low } <
+                                           std::pair { rhs.m_hash.m_high, rhs.m_hash.m_low };
+                                } );
+        }
+        // a chain becomes left leaning, ((a + b) + c) + d
+        auto accumulated = std::move ( taken[0] );
+        if ( count == 1 )
+        {
+            std::array<Entry, 1> single { std::move ( accumulated ) };
+            accumulated = combine ( *node, single, build );
+        }
+        for ( std::size_t i = 1; i < count; ++i )
+        {
+            std::array<Entry, 2> pair { std::move ( accumulated ), std::move ( taken[i] ) };
+            accumulated = combine ( *node, pair, build );
+        }
+        results.erase ( first, results.end() );
+        results.push_back ( std::move ( accumulated ) );
+    }
+    return std::move ( results.back() );
+}
+} // namespace
+
+auto Hash128::to_string() const -> std::string
+{
+    std::string text ( 32, '0' );
+    for ( const auto& [offset, part] : { std::pair { std::size_t { 0 }, m_high }, std::pair { std::size_t { 16 }, m_low } } )
+    {
+        std::array<char, 16> digits {};
+        const auto           end  = std::to_chars ( digits.data(), digits.data() + digits.size(), part, 16 ).ptr;
+        const auto           size = static_cast<std::size_t> ( end - digits.data() );
+        std::copy ( digits.data(), end, text.begin() + static_cast<std::ptrdiff_t> ( offset + 16 - size ) );
+    }
+    return text;
+}
+
+auto canonicalize ( const AST* root, CANONICAL mode ) -> std::shared_ptr<AST> { return walk ( root, true, mode, true ).m_node; }
+
+auto structural_hash ( const AST* root ) -> Hash128 { return walk ( root, false, CANONICAL::EXACT, false ).m_hash; }
+
+auto canonical_hash ( std::string_view input, const LexerConfig& config, CANONICAL mode ) -> Result<Hash128>
+{
+    Parser parser ( std::make_unique<Lexer> ( input, config ) );
+    auto   root = parser.try_parse();
+    if ( !root ) { return std::unexpected ( root.error() ); }
+    return walk ( root->get(), true, mode, false ).m_hash;
+}
+} // namespace pfme
@@ -0,0 +1,302 @@
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <optional>
+#include <pfme/Columns.hpp>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pfme
+{
+namespace
+{
+constexpr std::size_t READ_SIZE     = std::size_t { 1 } << 20U;                  // bytes read from a CSV file at once
+constexpr std::size_t NO_VARIABLE   = std::numeric_limits<std::size_t>::max(); // a column that is not read
+constexpr std::size_t MAX_CHARACTER = 32;                                      // the longest to_chars() double and a newline
+
+/**
+ * @brief Hands out the lines of a stream without copying them into strings.
+ *
+ * The stream is read in chunks of READ_SIZE bytes, only a line that is longer than the buffer makes it grow.
+ */
+class LineReader
+{
+public:
+    explicit LineReader ( std::istream& input )
+        : m_input ( input )
+        , m_buffer ( READ_SIZE )
+    {
+    }
+
+    /**
+     * The next line without its line break.
+     * @return A view into the buffer that is valid until the next call, or nothing at the end of the stream
+     */
+    auto next() -> std::optional<std::string_view>
+    {
+        while ( true )
+        {
+            const char* begin = m_buffer.data() + m_begin;
+            if ( const auto* newline = static_cast<const char*> ( std::memchr ( begin, '\n', m_end - m_begin ) ) )
+            {
+                m_begin = static_cast<std::size_t> ( newline - m_buffer.data() ) + 1;
+                return std::string_view ( begin, newline );
+            }
+            if ( m_eof )
+            {
+                if ( m_begin == m_end ) { return std::nullopt; }
+                const std::string_view last ( begin, m_end - m_begin );
+                m_begin = m_end;
+                return last;
+            }
+            // the partial line moves to the front, the rest of the buffer is filled
+            std::memmove ( m_buffer.data(), begin, m_end - m_begin );
+            m_end -= m_begin;
+            m_begin = 0;
+            if ( m_end == m_buffer.size() ) { m_buffer.resize ( m_buffer.size() * 2 ); }
+            m_input.read ( m_buffer.data() + m_end, static_cast<std::streamsize> ( m_buffer.size() - m_end ) );
+            m_end += static_cast<std::size_t> ( m_input.gcount() );
+            m_eof = !m_input;
+        }
+    }
+
+private:
+    std::istream&     m_input;
+    std::vector<char> m_buffer;
+    std::size_t       m_begin = 0;
+    std::size_t       m_end   = 0;
+    bool              m_eof   = false;
+};
+
+auto trim ( std::string_view text ) -> std::string_view
+{
+    constexpr std::string_view BLANK = " \t\r";
+    const auto                 first = text.find_first_not_of ( BLANK );
+    if ( first == std::string_view::npos ) { return {}; }
+    return text.substr ( first, text.find_last_not_of ( BLANK ) - first + 1 );
+}
+
+auto unquote ( std::string_view name ) -> std::string_view
+{
+    if ( name.size() >= 2 && name.front() == '"' && name.back() == '"' ) { return name.substr ( 1, name.size() - 2 ); }
+    return name;
+}
+
+// std::from_chars only knows '.', so another point is replaced in a copy, scratch is reused for every field
+auto parse_number ( std::string_view field, std::size_t row, std::size_t column, char point, std::string& scratch ) -> double
+{
+    auto text = trim ( field );
+    if ( !text.empty() && text.front() == '+' ) { text.remove_prefix ( 1 ); }
+    if ( point != '.' )
+    {
+        const auto position = text.find ( point );
+        // a '.' would be read as the point, but it is not the point of this file
+        if ( text.find ( '.' ) != std::string_view::npos ) { text = {}; }
+        else if ( position != std::string_view::npos )
+        {
+            scratch.assign ( text );
+            scratch[position] = '.';
+            text              = scratch;
+        }
+    }
+    double     value = 0;
+    const auto end   = text.data() + text.size();
+    const auto read  = std::from_chars ( text.data(), end, value );
+    if ( text.empty() || read.ec != std::errc {} || read.ptr != end )
+    {
+        throw std::runtime_error (
+            std::format ( "Invalid number '{}' in row {}, column {}", trim ( field ), row, column + 1 ) );
+    }
+    return value;
+}
+
+/**
+ * @brief The columns of the variables for one block of rows and the results of the block.
+ */
+class Block
+{
+public:
+    Block ( const CompiledExpression& expression, std::size_t rows )
+        : m_expression ( expression )
+        , m_columns ( expression.get_variables().size(), std::vector<double> ( rows ) )
+        , m_spans ( m_columns.size() )
+        , m_results ( rows )
+    {
+    }
+
+    auto value ( std::size_t variable ) -> double& { return m_columns[variable][m_size]; }
+    auto column ( std::size_t variable ) -> double* { return m_columns[variable].data(); }
+    auto add_row() -> bool { return ++m_size == m_results.size(); }
+    auto set_size ( std::size_t size ) -> void { m_size = size; }
+    auto size() const -> std::size_t { return m_size; }
+
+    /**
+     * Evaluates the filled rows and starts a new block.
+     * @return The results of the rows
+     */
+    auto evaluate() -> std::span<const double>
+    {
+        for ( std::size_t i = 0; i < m_columns.size(); ++i ) { m_spans[i] = { m_columns[i].data(), m_size }; }
+        const std::span<double> results ( m_results.data(), m_size );
+        m_expression.evaluate_batch<double> ( m_spans, results );
+        m_size = 0;
+        return results;
+    }
+
+private:
+    const CompiledExpression&            m_expression;
+    std::vector<std::vector<double>>     m_columns;
+    std::vector<std::span<const double>> m_spans;
+    std::vector<double>                  m_results;
+    std::size_t                          m_size = 0;
+};
+
+auto write_text ( std::ostream& output, std::span<const double> results, std::vector<char>& text, char point ) -> void
+{
+    text.resize ( results.size() * MAX_CHARACTER );
+    char* position = text.data();
+    for ( const auto result : results )
+    {
+        auto* const start = position;
+        position          = std::to_chars ( position, position + MAX_CHARACTER - 1, result ).ptr;
+        if ( point != '.' ) { std::replace ( start, position, '.', point ); }
+        *position++ = '\n';
+    }
+    output.write ( text.data(), position - text.data() );
+}
+
+auto read_double ( const std::byte* data ) -> double
+{
+    std::uint64_t bits = 0;
+    std::memcpy ( &bits, data, sizeof ( bits ) );
+    if constexpr ( std::endian::native == std::endian::big ) { bits = std::byteswap ( bits ); }
+    return std::bit_cast<double> ( bits );
+}
+
+auto write_double ( std::byte* data, double value ) -> void
+{
+    auto bits = std::bit_cast<std::uint64_t> ( value );
+    if constexpr ( std::endian::native == std::endian::big ) { bits = std::byteswap ( bits ); }
+    std::memcpy ( data, &bits, sizeof ( bits ) );
+}
+} // namespace
+
+auto evaluate_csv ( const CompiledExpression& expression,
+                    std::istream&             input,
+                    std::ostream&             output,
+                    const ColumnOptions&      options ) -> std::size_t
+{
+    LineReader lines ( input );
+    const auto header = lines.next();
+    if ( !header ) { throw std::runtime_error ( "CSV file without a header" ); }
+
+    // targets[field] is the variable read from the field
+    const auto               variables = expression.get_variables();
+    std::vector<std::size_t> targets;
+    std::vector<bool>        found ( variables.size(), false );
+    for ( std::size_t begin = 0; begin <= header->size(); )
+    {
+        const auto end      = std::min ( header->find ( options.m_seperator, begin ), header->size() );
+        const auto variable = expression.find_variable ( unquote ( trim ( header->substr ( begin, end - begin ) ) ) );
+        targets.push_back ( variable && !found[*variable] ? *variable : NO_VARIABLE );
+        if ( variable ) { found[*variable] = true; }
+        begin = end + 1;
+    }
+    for ( std::size_t i = 0; i < variables.size(); ++i )
+    {
+        if ( !found[i] )
+        {
+            throw std::runtime_error ( std::format ( "Variable '{}' is not a column of the CSV file", variables[i] ) );
+        }
+    }
+    // fields after the last variable are not even split
+    while ( !targets.empty() && targets.back() == NO_VARIABLE ) { targets.pop_back(); }
+
+    Block             block ( expression, std::max<std::size_t> ( options.m_block_rows, 1 ) );
+    std::vector<char> text;
+    std::string       scratch;
+    std::size_t       rows = 0;
+    const auto        flush = [&]
+    {
+        rows += block.size();
+        write_text ( output, block.evaluate(), text, options.m_point_symbol );
+    };
+    output << options.m_output_name << '\n';
+    for ( std::size_t row = 2; const auto line = lines.next(); ++row )
+    {
+        if ( trim ( *line ).empty() ) { continue; }
+        std::size_t begin = 0;
+        for ( std::size_t field = 0; field < targets.size(); ++field )
+        {
+            if ( begin > line->size() ) { throw std::runtime_error ( std::format ( "Row {} has too few fields", row ) ); }
+            const auto end = std::min ( line->find ( options.m_seperator, begin ), line->size() );
+            if ( targets[field] != NO_VARIABLE )
+            {
+                block.value ( targets[field] ) =
+                    parse_number ( line->substr ( begin, end - begin ), row, field, options.m_point_symbol, scratch );
+            }
+            begin = end + 1;
+        }
+        if ( block.add_row() ) { flush(); }
+    }
+    if ( block.size() > 0 ) { flush(); }
+    return rows;
+}
+
+auto evaluate_binary ( const CompiledExpression&    expression,
+                       std::istream&                input,
+                       std::span<const std::string> columns,
+                       std::ostream&                output,
+                       const ColumnOptions&         options ) -> std::size_t
+{
+    if ( columns.empty() ) { throw std::runtime_error ( "Binary file without columns" ); }
+    const auto               variables = expression.get_variables();
+    std::vector<std::size_t> sources;
+    for ( const auto& variable : variables )
+    {
+        const auto column = std::ranges::find ( columns, variable );
+        if ( column == columns.end() )
+        {
+            throw std::runtime_error ( std::format ( "Variable '{}' is not a column of the binary file", variable ) );
+        }
+        sources.push_back ( static_cast<std::size_t> ( column - columns.begin() ) );
+    }
+
+    const auto             block_rows = std::max<std::size_t> ( options.m_block_rows, 1 );
+    const auto             row_size   = columns.size() * sizeof ( double );
+    Block                  block ( expression, block_rows );
+    std::vector<std::byte> raw ( block_rows * row_size );
+    std::vector<std::byte> written ( block_rows * sizeof ( double ) );
+    std::size_t            rows = 0;
+    while ( input )
+    {
+        input.read ( reinterpret_cast<char*> ( raw.data() ), static_cast<std::streamsize> ( raw.size() ) );
+        const auto bytes = static_cast<std::size_t> ( input.gcount() );
+        if ( bytes % row_size != 0 ) { throw std::runtime_error ( "Binary file ends in the middle of a row" ); }
+        const auto size = bytes / row_size;
+        if ( size == 0 ) { break; }
+
+        for ( std::size_t variable = 0; variable < sources.size(); ++variable )
+        {
+            auto*       column = block.column ( variable );
+            const auto* source = raw.data() + ( sources[variable] * sizeof ( double ) );
+            for ( std::size_t row = 0; row < size; ++row ) { column[row] = read_double ( source + ( row * row_size ) ); }
+        }
+        block.set_size ( size );
+        const auto results = block.evaluate();
+        for ( std::size_t row = 0; row < size; ++row )
+        {
+            write_double ( written.data() + ( row * sizeof ( double ) ), results[row] );
+        }
+        output.write ( reinterpret_cast<const char*> ( written.data() ),
+                       static_cast<std::streamsize> ( size * sizeof ( double ) ) );
+        rows += size;
+    }
+    return rows;
+}
+} // namespace pfme
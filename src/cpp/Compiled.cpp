@@ -0,0 +1,331 @@
+#include "Block.hpp"
+#include "Range.hpp"
+
+#include <algorithm>
+#include <format>
+#include <optional>
+#include <pfme/Compiled.hpp>
+#include <pfme/Functions.hpp>
+#include <pfme/Parser.hpp>
+#include <pfme/Trace.hpp>
+#include <stdexcept>
+
+namespace pfme
+{
+namespace
+{
+constexpr std::size_t BLOCK = 256; // rows per block of evaluate_batch, a block of every node stays in the cache
+
+// the names stored in the nodes, serialized nodes always have them
+auto variable_names ( std::span<const BinaryNode> nodes ) -> std::vector<std::string>
+{
+    std::vector<std::string> variables;
+    for ( const auto& node : nodes )
+    {
+        if ( node.get_type() != AST_TYPE::VARIABLE ) { continue; }
+        if ( node.m_extra >= variables.size() ) { variables.resize ( node.m_extra + 1 ); }
+        variables[node.m_extra] = node.get_name();
+    }
+    return variables;
+}
+} // namespace
+
+template <std::floating_point Float>
+auto basic_evaluation_context<Float>::local() -> basic_evaluation_context&
+{
+    thread_local basic_evaluation_context context;
+    return context;
+}
+
+auto CompiledExpression::compile ( std::string_view input, const LexerConfig& config ) -> Result<CompiledExpression>
+{
+    const trace::Scope scope ( trace::STAGE::COMPILE );
+    Parser             parser ( std::make_unique<Lexer> ( input, config ) );
+    auto               root = parser.try_parse();
+    if ( !root ) { return std::unexpected ( root.error() ); }
+    // the full names are kept next to the nodes, only serialize() needs them to fit into a node
+    std::vector<std::string> variables;
+    auto                     nodes = flatten ( root->get(), variables );
+    if ( contains_range ( nodes ) ) { return std::unexpected ( Error { ERROR_CODE::UNSUPPORTED_RANGE } ); }
+    return CompiledExpression ( std::move ( nodes ), std::move ( variables ) );
+}
+
+CompiledExpression::CompiledExpression ( const AST* root )
+{
+    std::vector<std::string> variables;
+    auto                     nodes = flatten ( root, variables );
+    *this                          = CompiledExpression ( std::move ( nodes ), std::move ( variables ) );
+}
+
+CompiledExpression::CompiledExpression ( std::span<const BinaryNode> nodes )
+    : CompiledExpression ( std::vector<BinaryNode> ( nodes.begin(), nodes.end() ), variable_names ( nodes ) )
+{
+}
+
+CompiledExpression::CompiledExpression ( std::vector<BinaryNode>&& nodes, std::vector<std::string>&& variables )
+{
+    // serialized nodes may come from a program that added its functions in another order
+    for ( auto& node : nodes )
+    {
+        if ( node.get_type() != AST_TYPE::FUNCTION ) { continue; }
+        const auto function = node.get_function();
+        if ( !function )
+        {
+            throw std::runtime_error ( std::format ( "Unknown function '{}' in compiled expression", node.get_name() ) );
+        }
+        node.m_extra = *function;
+    }
+    // the index of a range is bound by the range, compiled it would look like a free variable
+    if ( contains_range ( nodes ) )
+    {
+        throw std::runtime_error ( "sum and prod can not be compiled, evaluate them with the Visitor" );
+    }
+    Program program { std::move ( nodes ), std::move ( variables ), {} };
+    program.m_shortcuts = find_shortcuts ( program.m_nodes );
+    m_program = std::make_shared<const Program> ( std::move ( program ) );
+}
+
+auto CompiledExpression::find_variable ( std::string_view name ) const -> std::optional<std::size_t>
+{
+    const auto& variables = m_program->m_variables;
+    const auto  found     = std::ranges::find ( variables, name );
+    if ( found == variables.end() ) { return std::nullopt; }
+    return static_cast<std::size_t> ( found - variables.begin() );
+}
+
+auto CompiledExpression::specialize ( std::span<const Binding> bindings, const DecimalContext& context ) const
+    -> CompiledExpression
+{
+    const auto&                            nodes = m_program->m_nodes;
+    std::vector<std::optional<AST::num_t>> bound ( m_program->m_variables.size() );
+    for ( const auto& binding : bindings )
+    {
+        if ( const auto index = find_variable ( binding.m_name ) ) { bound[*index] = binding.m_value; }
+    }
+
+    // known[i] is the value of node i if it does not depend on an unbound variable,
+    // alias[i] is the node that replaces it (a decided condition is replaced by the branch it takes)
+    std::vector<std::optional<AST::num_t>> known ( nodes.size() );
+    std::vector<std::uint32_t>             alias ( nodes.size() );
+    std::vector<AST::num_t>                arguments;
+    for ( std::size_t i = 0; i < nodes.size(); ++i )
+    {
+        const auto& node = nodes[i];
+        const auto  type = node.get_type();
+        alias[i]         = static_cast<std::uint32_t> ( i );
+        switch ( type )
+        {
+        case AST_TYPE::ARGUMENT: break;
+        case AST_TYPE::ALTERNATIVE: break;
+        case AST_TYPE::INTEGER: [[fallthrough]];
+        case AST_TYPE::FLOAT: [[fallthrough]];
+        case AST_TYPE::FRACTION: [[fallthrough]];
+        case AST_TYPE::DECIMAL: known[i] = node.to_number(); break;
+        case AST_TYPE::VARIABLE: known[i] = bound[node.m_extra]; break;
+        case AST_TYPE::CONDITION:
+            if ( known[node.m_lhand] )
+            {
+                const auto& alternative = nodes[node.m_rhand];
+                const bool  condition   = is_true<LD> ( *known[node.m_lhand] );
+                alias[i]                = alias[condition ? alternative.m_lhand : alternative.m_rhand];
+                known[i]                = known[alias[i]];
+            }
+            break;
+        case AST_TYPE::FUNCTION:
+        {
+            arguments.clear();
+            for ( auto next = i; next != BinaryNode::NO_CHILD && known[nodes[next].m_lhand]; next = nodes[next].m_rhand )
+            {
+                arguments.push_back ( *known[nodes[next].m_lhand] );
+                if ( nodes[next].m_rhand != BinaryNode::NO_CHILD ) { continue; }
+                if ( auto result = call ( node.m_extra, arguments ) ) { known[i] = *result; }
+            }
+            break;
+        }
+        default:
+            if ( ( type == AST_TYPE::AND || type == AST_TYPE::OR ) && known[node.m_lhand] &&
+                 is_true<LD> ( *known[node.m_lhand] ) == ( type == AST_TYPE::OR ) )
+            {
+                known[i] = AST::num_t { LLI { type == AST_TYPE::OR } };
+            }
+            else if ( known[node.m_lhand] && known[node.m_rhand] )
+            {
+                if ( auto result = apply_operation<LD> ( type, *known[node.m_lhand], *known[node.m_rhand], context ) )
+                {
+                    known[i] = *result;
+                }
+            }
+        }
+    }
+
+    // only the nodes below an operation that is not folded are still needed, parents come after their children
+    std::vector<char> needed ( nodes.size(), 0 );
+    needed[alias.back()] = 1;
+    for ( std::size_t i = nodes.size(); i-- > 0; )
+    {
+        if ( needed[i] == 0 || known[i] || nodes[i].get_type() == AST_TYPE::VARIABLE ) { continue; }
+        needed[alias[nodes[i].m_lhand]] = 1;
+        if ( nodes[i].m_rhand != BinaryNode::NO_CHILD ) { needed[alias[nodes[i].m_rhand]] = 1; }
+    }
+
+    // the needed nodes keep their order, so every subtree stays in one piece
+    std::vector<BinaryNode>    specialized;
+    std::vector<std::uint32_t> index ( nodes.size(), BinaryNode::NO_CHILD );
+    std::vector<std::uint32_t> numbers ( m_program->m_variables.size(), BinaryNode::NO_CHILD );
+    std::vector<std::string>   variables;
+    for ( std::size_t i = 0; i < nodes.size(); ++i )
+    {
+        if ( needed[i] == 0 ) { continue; }
+        index[i] = static_cast<std::uint32_t> ( specialized.size() );
+        if ( known[i] ) { specialized.push_back ( BinaryNode::from_number ( *known[i] ) ); }
+        else if ( nodes[i].get_type() == AST_TYPE::VARIABLE )
+        {
+            auto& number = numbers[nodes[i].m_extra];
+            if ( number == BinaryNode::NO_CHILD )
+            {
+                number = static_cast<std::uint32_t> ( variables.size() );
+                variables.push_back ( m_program->m_variables[nodes[i].m_extra] );
+            }
+            specialized.push_back ( nodes[i] );
+            specialized.back().m_extra = number;
+        }
+        else
+        {
+            auto operation    = nodes[i];
+            operation.m_lhand = index[alias[operation.m_lhand]];
+            if ( operation.m_rhand != BinaryNode::NO_CHILD ) { operation.m_rhand = index[alias[operation.m_rhand]]; }
+            specialized.push_back ( operation );
+        }
+    }
+    return CompiledExpression ( std::move ( specialized ), std::move ( variables ) );
+}
+
+template <std::floating_point Float>
+auto CompiledExpression::evaluate ( basic_evaluation_context<Float>&    context,
+                                    std::span<const basic_num_t<Float>> variables,
+                                    const DecimalContext&               decimal_context ) const -> Result<basic_num_t<Float>>
+{
+    const trace::Scope scope ( trace::STAGE::EVALUATE );
+    const bool         trace_nodes = trace::get_level() == trace::TRACE_LEVEL::NODES;
+    const auto&        nodes       = m_program->m_nodes;
+    const auto&        shortcuts   = m_program->m_shortcuts;
+    auto&              values      = context.m_values;
+    values.resize ( nodes.size() );
+    for ( std::size_t i = 0; i < nodes.size(); ++i )
+    {
+        const auto& node  = nodes[i];
+        const auto  start = trace_nodes ? trace::now() : 0;
+        switch ( node.get_type() )
+        {
+        case AST_TYPE::ARGUMENT: break;    // read through the chain of the function
+        case AST_TYPE::ALTERNATIVE: break; // read by the condition
+        case AST_TYPE::CONDITION:
+        {
+            const auto& alternative = nodes[node.m_rhand];
+            const bool  condition   = is_true<Float> ( values[node.m_lhand] );
+            values[i]               = values[condition ? alternative.m_lhand : alternative.m_rhand];
+            break;
+        }
+        case AST_TYPE::FUNCTION:
+        {
+            auto& arguments = context.m_arguments;
+            arguments.assign ( 1, convert_number<LD> ( values[node.m_lhand] ) );
+            for ( auto next = node.m_rhand; next != BinaryNode::NO_CHILD; next = nodes[next].m_rhand )
+            {
+                arguments.push_back ( convert_number<LD> ( values[nodes[next].m_lhand] ) );
+            }
+            auto result = call ( node.m_extra, arguments );
+            if ( !result ) { return std::unexpected ( Error { result.error() } ); }
+            values[i] = convert_number<Float> ( *result );
+            if ( trace_nodes )
+            {
+                trace::record ( trace::STAGE::NODE, start, node.m_extra, static_cast<std::uint8_t> ( node.get_type() ) );
+            }
+            break;
+        }
+        case AST_TYPE::INTEGER: [[fallthrough]];
+        case AST_TYPE::FLOAT: [[fallthrough]];
+        case AST_TYPE::FRACTION: [[fallthrough]];
+        case AST_TYPE::DECIMAL: values[i] = convert_number<Float> ( node.to_number() ); break;
+        case AST_TYPE::VARIABLE:
+            if ( node.m_extra >= variables.size() ) { return std::unexpected ( Error { ERROR_CODE::UNBOUND_VARIABLE } ); }
+            values[i] = variables[node.m_extra];
+            break;
+        default:
+        {
+            auto result =
+                apply_operation<Float> ( node.get_type(), values[node.m_lhand], values[node.m_rhand], decimal_context );
+            if ( !result ) { return std::unexpected ( Error { result.error() } ); }
+            values[i] = *result;
+            if ( trace_nodes )
+            {
+                const auto type = static_cast<std::uint8_t> ( node.get_type() );
+                trace::record ( trace::STAGE::NODE, start, static_cast<std::uint32_t> ( i ), type );
+            }
+        }
+        }
+        if ( !shortcuts.empty() && shortcuts[i].m_target != Shortcut::NONE &&
+             shortcuts[i].jumps ( is_true<Float> ( values[i] ) ) )
+        {
+            i = shortcuts[i].m_target - 1;
+        }
+    }
+    return values.back();
+}
+
+template <std::floating_point Float>
+auto CompiledExpression::evaluate_batch ( basic_evaluation_context<Float>&       context,
+                                          std::span<const std::span<const Float>> variables,
+                                          std::span<Float>                        results ) const -> void
+{
+    const trace::Scope scope ( trace::STAGE::EVALUATE );
+    const auto&        nodes = m_program->m_nodes;
+    const auto         rows  = results.size();
+    if ( variables.size() < m_program->m_variables.size() )
+    {
+        throw std::runtime_error ( "Batch evaluation needs a column for every variable" );
+    }
+    for ( const auto column : variables )
+    {
+        if ( column.size() != rows ) { throw std::runtime_error ( "Batch evaluation columns need one value for every row" ); }
+    }
+
+    auto& block = context.m_block;
+    block.resize ( nodes.size() * BLOCK );
+    for ( std::size_t begin = 0; begin < rows; begin += BLOCK )
+    {
+        const auto size = std::min ( BLOCK, rows - begin );
+        // block[i * BLOCK + row] is the value of node i in the row
+        for ( std::size_t i = 0; i < nodes.size(); ++i )
+        {
+            evaluate_block<Float> (
+                nodes, i, block.data(), BLOCK, variables, begin, size, context.m_columns, context.m_arguments );
+        }
+        std::copy_n ( block.data() + ( ( nodes.size() - 1 ) * BLOCK ), size, results.data() + begin );
+    }
+}
+
+template class basic_evaluation_context<float>;
+template class basic_evaluation_context<double>;
+template class basic_evaluation_context<LD>;
+
+template auto CompiledExpression::evaluate<float> ( basic_evaluation_context<float>&,
+                                                    std::span<const basic_num_t<float>>,
+                                                    const DecimalContext& ) const -> Result<basic_num_t<float>>;
+template auto CompiledExpression::evaluate<double> ( basic_evaluation_context<double>&,
+                                                     std::span<const basic_num_t<double>>,
+                                                     const DecimalContext& ) const -> Result<basic_num_t<double>>;
+template auto CompiledExpression::evaluate<LD> ( basic_evaluation_context<LD>&,
+                                                 std::span<const basic_num_t<LD>>,
+                                                 const DecimalContext& ) const -> Result<basic_num_t<LD>>;
+
+template auto CompiledExpression::evaluate_batch<float> ( basic_evaluation_context<float>&,
+                                                          std::span<const std::span<const float>>,
+                                                          std::span<float> ) const -> void;
+template auto CompiledExpression::evaluate_batch<double> ( basic_evaluation_context<double>&,
+                                                           std::span<const std::span<const double>>,
+                                                           std::span<double> ) const -> void;
+template auto CompiledExpression::evaluate_batch<LD> ( basic_evaluation_context<LD>&,
+                                                       std::span<const std::span<const LD>>,
+                                                       std::span<LD> ) const -> void;
+} // namespace pfme
@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <pfme/Decimal.hpp>
+#include <stdexcept>
+
+namespace pfme
+{
+namespace
+{
+constexpr std::uint64_t LIMIT = std::numeric_limits<LLI>::max(); // the largest magnitude of a mantissa
+
+constexpr auto make_powers() -> std::array<std::uint64_t, 20>
+{
+    std::array<std::uint64_t, 20> powers {};
+    powers[0] = 1;
+    for ( std::size_t i = 1; i < powers.size(); ++i ) { powers[i] = powers[i - 1] * 10; }
+    return powers;
+}
+
+constexpr std::array<std::uint64_t, 20> POWERS = make_powers(); // every power of ten that fits into 64 bits
+
+/**
+ * Enum for how the remainder of a division compares to half of the divisor.
+ */
+enum class REMAINDER : std::uint8_t
+{
+    NONE,
+    BELOW_HALF,
+    HALF,
+    ABOVE_HALF,
+};
+
+auto magnitude ( LLI value ) -> std::uint64_t
+{
+    return value < 0 ? 0 - static_cast<std::uint64_t> ( value ) : static_cast<std::uint64_t> ( value );
+}
+
+// the smallest LLI is left out, so every mantissa can be negated
+auto to_signed ( bool negative, std::uint64_t value ) -> std::optional<LLI>
+{
+    if ( value > LIMIT ) { return std::nullopt; }
+    return negative ? -static_cast<LLI> ( value ) : static_cast<LLI> ( value );
+}
+
+auto checked_multiply ( std::uint64_t lhs, std::uint64_t rhs ) -> std::optional<std::uint64_t>
+{
+    if ( lhs != 0 && rhs > std::numeric_limits<std::uint64_t>::max() / lhs ) { return std::nullopt; }
+    return lhs * rhs;
+}
+
+// the mantissa of the same value with more digits after the point
+auto rescale ( const Decimal& number, std::uint8_t scale ) -> std::optional<LLI>
+{
+    const auto scaled = checked_multiply ( magnitude ( number.mantissa() ), POWERS[scale - number.scale()] );
+    if ( !scaled ) { return std::nullopt; }
+    return to_signed ( number.mantissa() < 0, *scaled );
+}
+
+auto sum ( const Decimal& lhs, const Decimal& rhs, bool negate ) -> std::optional<Decimal>
+{
+    const auto scale = std::max ( lhs.scale(), rhs.scale() );
+    const auto left  = rescale ( lhs, scale );
+    auto       right = rescale ( rhs, scale );
+    if ( !left || !right ) { return std::nullopt; }
+    if ( negate ) { *right = -*right; }
+    constexpr auto MAX = std::numeric_limits<LLI>::max();
+    if ( ( *right > 0 && *left > MAX - *right ) || ( *right < 0 && *left < -MAX - *right ) )
+    {
+        return std::nullopt;
+    }
+    return Decimal { *left + *right, scale };
+}
+
+auto round_away ( ROUNDING rounding, REMAINDER remainder, bool negative, bool odd ) -> bool
+{
+    if ( remainder == REMAINDER::NONE ) { return false; }
+    switch ( rounding )
+    {
+    case ROUNDING::HALF_EVEN: return remainder == REMAINDER::ABOVE_HALF || ( remainder == REMAINDER::HALF && odd );
+    case ROUNDING::HALF_UP: return remainder != REMAINDER::BELOW_HALF;
+    case ROUNDING::HALF_DOWN: return remainder == REMAINDER::ABOVE_HALF;
+    case ROUNDING::UP: return true;
+    case ROUNDING::FLOOR: return negative;
+    case ROUNDING::CEILING: return !negative;
+    default: return false;
+    }
+}
+} // namespace
+
+Decimal::Decimal ( LLI integer )
+    : m_mantissa ( integer )
+{
+}
+
+Decimal::Decimal ( LLI mantissa, std::uint8_t scale )
+    : m_mantissa ( mantissa )
+    , m_scale ( scale )
+{
+    if ( m_scale > MAX_SCALE ) { throw std::runtime_error ( "Decimal scale is too large" ); }
+    normalize();
+}
+
+auto Decimal::normalize() -> void
+{
+    if ( m_mantissa == 0 ) { m_scale = 0; }
+    while ( m_scale > 0 && m_mantissa % 10 == 0 )
+    {
+        m_mantissa /= 10;
+        --m_scale;
+    }
+}
+
+auto Decimal::from_chars ( std::string_view text ) -> std::optional<Decimal>
+{
+    // value = mantissa * 10^zeros / 10^fraction_digits, zeros are only multiplied in once a digit other than 0 follows
+    std::uint64_t mantissa        = 0;
+    int           zeros           = 0;
+    int           fraction_digits = 0;
+    bool          point           = false;
+    bool          digits          = false;
+    std::size_t   i               = 0;
+    for ( ; i < text.size(); ++i )
+    {
+        const char character = text[i];
+        if ( character == '.' && !point )
+        {
+            point = true;
+            continue;
+        }
+        if ( character < '0' || character > '9' ) { break; }
+        digits = true;
+        fraction_digits += point ? 1 : 0;
+        if ( character == '0' )
+        {
+            ++zeros;
+            continue;
+        }
+        if ( mantissa != 0 )
+        {
+            const auto power  = static_cast<std::size_t> ( zeros + 1 );
+            const auto scaled = power < POWERS.size() ? checked_multiply ( mantissa, POWERS[power] ) : std::nullopt;
+            if ( !scaled || *scaled > LIMIT ) { return std::nullopt; }
+            mantissa = *scaled;
+        }
+        mantissa += static_cast<std::uint64_t> ( character - '0' );
+        if ( mantissa > LIMIT ) { return std::nullopt; }
+        zeros = 0;
+    }
+    if ( !digits ) { return std::nullopt; }
+
+    int exponent = 0;
+    if ( i < text.size() && ( text[i] == 'e' || text[i] == 'E' ) )
+    {
+        ++i;
+        const bool negative = i < text.size() && text[i] == '-';
+        if ( i < text.size() && ( text[i] == '-' || text[i] == '+' ) ) { ++i; }
+        const auto first = i;
+        for ( ; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i )
+        {
+            // anything this large has no decimal anyway, unless the mantissa is 0
+            exponent = std::min ( exponent * 10 + ( text[i] - '0' ), 100000 );
+        }
+        if ( i == first ) { return std::nullopt; }
+        exponent = negative ? -exponent : exponent;
+    }
+    if ( i != text.size() ) { return std::nullopt; }
+    if ( mantissa == 0 ) { return Decimal {}; }
+
+    const auto shift = zeros - fraction_digits + exponent;
+    if ( shift >= 0 )
+    {
+        if ( shift >= static_cast<int> ( POWERS.size() ) ) { return std::nullopt; }
+        const auto scaled = checked_multiply ( mantissa, POWERS[static_cast<std::size_t> ( shift )] );
+        if ( !scaled || *scaled > LIMIT ) { return std::nullopt; }
+        return Decimal { static_cast<LLI> ( *scaled ) };
+    }
+    if ( -shift > MAX_SCALE ) { return std::nullopt; }
+    return Decimal { static_cast<LLI> ( mantissa ), static_cast<std::uint8_t> ( -shift ) };
+}
+
+auto Decimal::to_chars ( char* first, char* last ) const -> std::to_chars_result
+{
+    std::array<char, 24> digits {};
+    const auto*          end   = std::to_chars ( digits.data(), digits.data() + digits.size(), magnitude ( m_mantissa ) ).ptr;
+    const auto           count = static_cast<std::size_t> ( end - digits.data() );
+    // numbers smaller than 1 get zeros in front of their digits, e.g. 0.05
+    const auto width  = std::max ( count, std::size_t { m_scale } + 1 );
+    const auto length = width + ( m_mantissa < 0 ? 1U : 0U ) + ( m_scale > 0 ? 1U : 0U );
+    if ( static_cast<std::size_t> ( last - first ) < length ) { return { last, std::errc::value_too_large }; }
+
+    if ( m_mantissa < 0 ) { *first++ = '-'; }
+    for ( std::size_t i = 0; i < width; ++i )
+    {
+        if ( m_scale > 0 && i == width - m_scale ) { *first++ = '.'; }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        *first++ = i < width - count ? '0' : digits[i - ( width - count )];
+    }
+    return { first, std::errc {} };
+}
+
+auto Decimal::to_string() const -> std::string
+{
+    std::array<char, 48> buffer {};
+    return { buffer.data(), to_chars ( buffer.data(), buffer.data() + buffer.size() ).ptr };
+}
+
+auto Decimal::to_fraction() const -> Fraction { return Fraction { m_mantissa, static_cast<LLI> ( POWERS[m_scale] ) }; }
+
+Decimal::operator LD() const { return static_cast<LD> ( m_mantissa ) / static_cast<LD> ( POWERS[m_scale] ); }
+
+auto Decimal::add ( const Decimal& other ) const -> std::optional<Decimal> { return sum ( *this, other, false ); }
+
+auto Decimal::subtract ( const Decimal& other ) const -> std::optional<Decimal> { return sum ( *this, other, true ); }
+
+auto Decimal::multiply ( const Decimal& other ) const -> std::optional<Decimal>
+{
+    auto product = checked_multiply ( magnitude ( m_mantissa ), magnitude ( other.m_mantissa ) );
+    if ( !product ) { return std::nullopt; }
+    // the product of two normalized mantissas can still end in zeros, e.g. 5 * 2
+    int scale = m_scale + other.m_scale;
+    while ( scale > MAX_SCALE && *product % 10 == 0 && *product != 0 )
+    {
+        *product /= 10;
+        --scale;
+    }
+    const auto mantissa = to_signed ( ( m_mantissa < 0 ) != ( other.m_mantissa < 0 ), *product );
+    if ( !mantissa || scale > MAX_SCALE ) { return std::nullopt; }
+    return Decimal { *mantissa, static_cast<std::uint8_t> ( scale ) };
+}
+
+auto Decimal::divide ( const Decimal& other, const DecimalContext& context ) const -> std::optional<Decimal>
+{
+    const auto scale    = std::min ( context.m_scale, MAX_SCALE );
+    const bool negative = ( m_mantissa < 0 ) != ( other.m_mantissa < 0 );
+    const auto dividend = magnitude ( m_mantissa );
+    auto       divisor  = magnitude ( other.m_mantissa );
+    // the quotient is dividend * 10^shift / divisor, which has the scale of the context
+    const int  shift = scale + other.m_scale - m_scale;
+    if ( shift < 0 )
+    {
+        const auto scaled = checked_multiply ( divisor, POWERS[static_cast<std::size_t> ( -shift )] );
+        // a divisor beyond 64 bits is more than twice the dividend
+        if ( !scaled )
+        {
+            const auto remainder = dividend == 0 ? REMAINDER::NONE : REMAINDER::BELOW_HALF;
+            return Decimal { round_away ( context.m_rounding, remainder, negative, false ) ? ( negative ? -1 : 1 ) : 0, scale };
+        }
+        divisor = *scaled;
+    }
+
+    auto quotient  = dividend / divisor;
+    auto remainder = dividend % divisor;
+    for ( int i = 0; i < shift; ++i )
+    {
+        // 10 * remainder = digit * divisor + next, added up one remainder at a time so nothing overflows
+        std::uint64_t digit = 0, next = 0;
+        for ( int j = 0; j < 10; ++j )
+        {
+            if ( next >= divisor - remainder )
+            {
+                next -= divisor - remainder;
+                ++digit;
+            }
+            else { next += remainder; }
+        }
+        if ( quotient > ( std::numeric_limits<std::uint64_t>::max() - digit ) / 10 ) { return std::nullopt; }
+        quotient  = quotient * 10 + digit;
+        remainder = next;
+    }
+
+    const auto rest = divisor - remainder;
+    const auto kind = remainder == 0 ? REMAINDER::NONE
+                    : remainder < rest ? REMAINDER::BELOW_HALF
+                    : remainder == rest ? REMAINDER::HALF
+                                        : REMAINDER::ABOVE_HALF;
+    if ( round_away ( context.m_rounding, kind, negative, quotient % 2 == 1 ) ) { ++quotient; }
+    const auto mantissa = to_signed ( negative, quotient );
+    if ( !mantissa ) { return std::nullopt; }
+    return Decimal { *mantissa, scale };
+}
+
+namespace
+{
+auto exact ( const std::optional<Decimal>& result ) -> Decimal
+{
+    if ( !result ) { throw std::runtime_error ( "Decimal result does not fit into 64 bits" ); }
+    return *result;
+}
+} // namespace
+
+auto operator+ ( const Decimal& lhs, const Decimal& rhs ) -> Decimal { return exact ( lhs.add ( rhs ) ); }
+
+auto operator- ( const Decimal& lhs, const Decimal& rhs ) -> Decimal { return exact ( lhs.subtract ( rhs ) ); }
+
+auto operator* ( const Decimal& lhs, const Decimal& rhs ) -> Decimal { return exact ( lhs.multiply ( rhs ) ); }
+
+auto operator<< ( std::ostream& stream, const Decimal& obj ) -> std::ostream&
+{
+    stream << obj.to_string();
+    return stream;
+}
+} // namespace pfme
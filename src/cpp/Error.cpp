@@ -0,0 +1,87 @@
+#include <array>
+#include <format>
+#include <pfme/Error.hpp>
+
+namespace pfme
+{
+auto error_code_to_string ( ERROR_CODE code ) -> std::string_view
+{
+    switch ( code )
+    {
+    case ERROR_CODE::CHARACTER_TOO_LARGE: return "character too large";
+    case ERROR_CODE::TWO_POINTS: return "two points in one number are not allowed";
+    case ERROR_CODE::UNEXPECTED_TOKEN: return "Unexpected token";
+    case ERROR_CODE::INVALID_TOKEN: [[fallthrough]];
+    case ERROR_CODE::INVALID_OPERATOR: return "Invalid Token in expression";
+    case ERROR_CODE::INVALID_NUMBER: return "invalid number";
+    case ERROR_CODE::NUMBER_OUT_OF_RANGE: return "number out of range";
+    case ERROR_CODE::EMPTY_EXPRESSION: return "Empty expression";
+    case ERROR_CODE::DIVISION_BY_ZERO: return "Division by Zero";
+    case ERROR_CODE::UNKNOWN_FUNCTION: return "Unknown function";
+    case ERROR_CODE::ARGUMENT_COUNT: return "Wrong number of arguments";
+    case ERROR_CODE::DOMAIN_ERROR: return "Argument outside of the domain of the function";
+    case ERROR_CODE::UNBOUND_VARIABLE: return "Variable without a value";
+    case ERROR_CODE::NOT_DIFFERENTIABLE: return "Function without a derivative";
+    case ERROR_CODE::WORKER_FAILED: return "Worker process crashed or timed out";
+    case ERROR_CODE::INPUT_TOO_LONG: return "Expression too long";
+    case ERROR_CODE::LIMIT_EXCEEDED: return "Expression exceeds a limit";
+    case ERROR_CODE::UNSUPPORTED_RANGE: return "sum and prod can only be evaluated by the Visitor";
+    default: return "Unknown error";
+    }
+}
+
+auto Error::message ( std::string_view input ) const -> std::string
+{
+    std::string msg;
+    switch ( m_code )
+    {
+    case ERROR_CODE::UNEXPECTED_TOKEN:
+        msg = std::format ( "Unexpected token: '{}'\nIs {}\tShould be {}\n",
+                            m_position < input.size() ? input.substr ( m_position, 1 ) : std::string_view {},
+                            token_type_to_string ( m_found ),
+                            token_type_to_string ( m_expected ) );
+        break;
+    case ERROR_CODE::INVALID_TOKEN:
+        msg = std::format ( "Invalid Token '{}' in expression\nShould be {}, {}, {} or {}",
+                            token_type_to_string ( m_found ),
+                            token_type_to_string ( TOKEN_TYPE::TOKEN_L_PAREN ),
+                            token_type_to_string ( TOKEN_TYPE::TOKEN_IDENTIFIER ),
+                            token_type_to_string ( TOKEN_TYPE::TOKEN_INTEGER ),
+                            token_type_to_string ( TOKEN_TYPE::TOKEN_FLOAT ) );
+        break;
+    case ERROR_CODE::INVALID_OPERATOR:
+    {
+        // every operator that can follow an operand, including the comparisons, && || and both parts of ?:
+        constexpr std::array OPERATORS { TOKEN_TYPE::TOKEN_MULTIPLICATION, TOKEN_TYPE::TOKEN_DIVISION,
+                                         TOKEN_TYPE::TOKEN_ADDITION,       TOKEN_TYPE::TOKEN_SUBTRACTION,
+                                         TOKEN_TYPE::TOKEN_EXPONENTIATION, TOKEN_TYPE::TOKEN_LESS,
+                                         TOKEN_TYPE::TOKEN_LESS_EQUAL,     TOKEN_TYPE::TOKEN_GREATER,
+                                         TOKEN_TYPE::TOKEN_GREATER_EQUAL,  TOKEN_TYPE::TOKEN_EQUAL,
+                                         TOKEN_TYPE::TOKEN_NOT_EQUAL,      TOKEN_TYPE::TOKEN_AND,
+                                         TOKEN_TYPE::TOKEN_OR,             TOKEN_TYPE::TOKEN_CONDITION,
+                                         TOKEN_TYPE::TOKEN_ALTERNATIVE };
+        msg = std::format ( "Invalid Token '{}' in expression\nShould be ", token_type_to_string ( m_found ) );
+        for ( std::size_t i = 0; i < OPERATORS.size(); ++i )
+        {
+            if ( i > 0 ) { msg += i + 1 == OPERATORS.size() ? " or " : ", "; }
+            msg += token_type_to_string ( OPERATORS[i] );
+        }
+        break;
+    }
+    default: msg = error_code_to_string ( m_code ); break;
+    }
+    if ( m_position == NO_POSITION ) { return msg; }
+    return format_error ( msg, input, m_position );
+}
+
+auto format_error ( std::string_view msg, std::string_view input, std::size_t position ) -> std::string
+{
+    return std::format ( "{}\n"
+                         "First found here: \n"
+                         "\t {}\n"
+                         "\t {}",
+                         msg,
+                         input,
+                         std::string ( position, ' ' ) + "^\n" );
+}
+} // namespace pfme
@@ -0,0 +1,65 @@
+#include <array>
+#include <pfme/Format.hpp>
+#include <string_view>
+
+namespace pfme
+{
+namespace
+{
+template <std::floating_point Float>
+auto format_float ( char* first, char* last, Float number, NumberFormat format ) -> std::to_chars_result
+{
+    switch ( format.m_format )
+    {
+    case NUMBER_FORMAT::FIXED: return std::to_chars ( first, last, number, std::chars_format::fixed, format.m_precision );
+    case NUMBER_FORMAT::PRECISION: return std::to_chars ( first, last, number, std::chars_format::general, format.m_precision );
+    default: return std::to_chars ( first, last, number );
+    }
+}
+
+auto format_fraction ( char* first, char* last, const Fraction& number ) -> std::to_chars_result
+{
+    constexpr std::string_view SEPERATOR = " / ";
+
+    auto result = std::to_chars ( first, last, number.numerator() );
+    if ( result.ec != std::errc {} ) { return result; }
+    if ( last - result.ptr < static_cast<std::ptrdiff_t> ( SEPERATOR.size() ) ) { return { last, std::errc::value_too_large }; }
+    auto* denominator = SEPERATOR.copy ( result.ptr, SEPERATOR.size() ) + result.ptr;
+    return std::to_chars ( denominator, last, number.denominator() );
+}
+} // namespace
+
+template <std::floating_point Float>
+auto format_number ( char* first, char* last, const basic_num_t<Float>& number, NumberFormat format ) -> std::to_chars_result
+{
+    if ( const auto* integer = std::get_if<LLI> ( &number ) ) { return std::to_chars ( first, last, *integer ); }
+    if ( const auto* fraction = std::get_if<Fraction> ( &number ) ) { return format_fraction ( first, last, *fraction ); }
+    if ( const auto* decimal = std::get_if<Decimal> ( &number ) ) { return decimal->to_chars ( first, last ); }
+    return format_float ( first, last, std::get<Float> ( number ), format );
+}
+
+template <std::floating_point Float>
+auto format_number ( const basic_num_t<Float>& number, NumberFormat format ) -> std::string
+{
+    // enough for everything but floats with a lot of digits in front of the point
+    std::array<char, 64> buffer {};
+    auto                 result = format_number ( buffer.data(), buffer.data() + buffer.size(), number, format );
+    if ( result.ec == std::errc {} ) { return { buffer.data(), result.ptr }; }
+
+    std::string text ( buffer.size(), '\0' );
+    do
+    {
+        text.resize ( text.size() * 2 );
+        result = format_number ( text.data(), text.data() + text.size(), number, format );
+    } while ( result.ec == std::errc::value_too_large );
+    text.resize ( static_cast<std::size_t> ( result.ptr - text.data() ) );
+    return text;
+}
+
+template auto format_number<float> ( char*, char*, const basic_num_t<float>&, NumberFormat ) -> std::to_chars_result;
+template auto format_number<double> ( char*, char*, const basic_num_t<double>&, NumberFormat ) -> std::to_chars_result;
+template auto format_number<LD> ( char*, char*, const basic_num_t<LD>&, NumberFormat ) -> std::to_chars_result;
+template auto format_number<float> ( const basic_num_t<float>&, NumberFormat ) -> std::string;
+template auto format_number<double> ( const basic_num_t<double>&, NumberFormat ) -> std::string;
+template auto format_number<LD> ( const basic_num_t<LD>&, NumberFormat ) -> std::string;
+} // namespace pfme
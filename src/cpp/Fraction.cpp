@@ -74,9 +74,10 @@ auto operator^ ( const LLI& lhs, const Fraction& rhs ) -> LD { return std::powl
 auto operator+ ( const Fraction& lhs, const LLI& rhs ) -> Fraction { return rhs + lhs; }
 auto operator- ( const Fraction& lhs, const LLI& rhs ) -> Fraction { return lhs + -rhs; }
 auto operator* ( const Fraction& lhs, const LLI& rhs ) -> Fraction { return rhs * lhs; }
-auto operator/ ( const Fraction& lhs, const LLI& rhs ) -> Fraction { return lhs.inverse() * rhs; }
+auto operator/ ( const Fraction& lhs, const LLI& rhs ) -> Fraction { return lhs * Fraction { 1, rhs }; }
 auto operator^ ( const Fraction& lhs, const LLI& rhs ) -> Fraction
 {
+    if ( rhs < 0 ) { return lhs.inverse() ^ -rhs; }
     return Fraction { static_cast<LLI> ( std::powl ( lhs.m_numerator, rhs ) ),
                       static_cast<LLI> ( std::powl ( lhs.m_denominator, rhs ) ) };
 }
@@ -0,0 +1,641 @@
+#include "Range.hpp"
+#include "SimdTarget.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <pfme/Functions.hpp>
+#include <pfme/Simd.hpp>
+#include <stdexcept>
+#include <utility>
+
+namespace pfme
+{
+namespace
+{
+using simd::SIMD_LEVEL;
+using column_t = std::span<const std::span<const double>>;
+
+auto to_float ( const AST::num_t& number ) -> LD
+{
+    return std::visit ( [] ( auto value ) { return static_cast<LD> ( value ); }, number );
+}
+
+// the root of a square number, value has to be positive
+auto exact_root ( LLI value ) -> std::optional<LLI>
+{
+    const auto root = static_cast<std::uint64_t> ( std::sqrt ( static_cast<LD> ( value ) ) );
+    for ( const auto candidate : { root, root + 1 } )
+    {
+        if ( candidate * candidate == static_cast<std::uint64_t> ( value ) ) { return static_cast<LLI> ( candidate ); }
+    }
+    return std::nullopt;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// scalar implementations, they keep integers and fractions exact where the result is exact
+
+auto scalar_sqrt ( std::span<const AST::num_t> arguments ) -> std::expected<AST::num_t, ERROR_CODE>
+{
+    const auto& number = arguments[0];
+    if ( to_float ( number ) < 0 ) { return std::unexpected ( ERROR_CODE::DOMAIN_ERROR ); }
+    if ( const auto* integer = std::get_if<LLI> ( &number ) )
+    {
+        if ( const auto root = exact_root ( *integer ) ) { return *root; }
+    }
+    else if ( const auto* fraction = std::get_if<Fraction> ( &number ) )
+    {
+        const auto numerator = exact_root ( fraction->numerator() ), denominator = exact_root ( fraction->denominator() );
+        if ( numerator && denominator ) { return Fraction { *numerator, *denominator }; }
+    }
+    return std::sqrt ( to_float ( number ) );
+}
+
+auto scalar_exp ( std::span<const AST::num_t> arguments ) -> std::expected<AST::num_t, ERROR_CODE>
+{
+    return std::exp ( to_float ( arguments[0] ) );
+}
+
+auto scalar_log ( std::span<const AST::num_t> arguments ) -> std::expected<AST::num_t, ERROR_CODE>
+{
+    const auto number = to_float ( arguments[0] );
+    if ( !( number > 0 ) ) { return std::unexpected ( ERROR_CODE::DOMAIN_ERROR ); }
+    return std::log ( number );
+}
+
+auto scalar_sin ( std::span<const AST::num_t> arguments ) -> std::expected<AST::num_t, ERROR_CODE>
+{
+    return std::sin ( to_float ( arguments[0] ) );
+}
+
+auto scalar_cos ( std::span<const AST::num_t> arguments ) -> std::expected<AST::num_t, ERROR_CODE>
+{
+    return std::cos ( to_float ( arguments[0] ) );
+}
+
+auto scalar_abs ( std::span<const AST::num_t> arguments ) -> std::expected<AST::num_t, ERROR_CODE>
+{
+    const auto& number = arguments[0];
+    if ( const auto* integer = std::get_if<LLI> ( &number ) )
+    {
+        if ( *integer == std::numeric_limits<LLI>::min() ) { return std::unexpected ( ERROR_CODE::NUMBER_OUT_OF_RANGE ); }
+        return *integer < 0 ? -*integer : *integer;
+    }
+    if ( const auto* fraction = std::get_if<Fraction> ( &number ) )
+    {
+        return fraction->numerator() < 0 ? -*fraction : *fraction;
+    }
+    if ( const auto* decimal = std::get_if<Decimal> ( &number ) ) { return decimal->mantissa() < 0 ? -*decimal : *decimal; }
+    return std::fabs ( std::get<LD> ( number ) );
+}
+
+auto less ( const AST::num_t& lhs, const AST::num_t& rhs ) -> bool
+{
+    if ( std::holds_alternative<LLI> ( lhs ) && std::holds_alternative<LLI> ( rhs ) )
+    {
+        return std::get<LLI> ( lhs ) < std::get<LLI> ( rhs );
+    }
+    return to_float ( lhs ) < to_float ( rhs );
+}
+
+// the result is one of the arguments, so it keeps its type
+auto scalar_min ( std::span<const AST::num_t> arguments ) -> std::expected<AST::num_t, ERROR_CODE>
+{
+    const auto* smallest = arguments.data();
+    for ( const auto& argument : arguments.subspan ( 1 ) )
+    {
+        if ( less ( argument, *smallest ) ) { smallest = &argument; }
+    }
+    return *smallest;
+}
+
+auto scalar_max ( std::span<const AST::num_t> arguments ) -> std::expected<AST::num_t, ERROR_CODE>
+{
+    const auto* largest = arguments.data();
+    for ( const auto& argument : arguments.subspan ( 1 ) )
+    {
+        if ( less ( *largest, argument ) ) { largest = &argument; }
+    }
+    return *largest;
+}
+
+// the exact types are added in order like a chain of +, floats with the compensation of Neumaier, so the error does not
+// grow with the number of arguments
+auto scalar_ksum ( std::span<const AST::num_t> arguments ) -> std::expected<AST::num_t, ERROR_CODE>
+{
+    const auto is_float = [] ( const AST::num_t& argument ) { return std::holds_alternative<LD> ( argument ); };
+    if ( std::ranges::none_of ( arguments, is_float ) )
+    {
+        auto sum = arguments[0];
+        for ( const auto& argument : arguments.subspan ( 1 ) )
+        {
+            auto added = apply_operation<LD> ( AST_TYPE::ADDITION, sum, argument );
+            if ( !added ) { return std::unexpected ( added.error() ); }
+            sum = *added;
+        }
+        return sum;
+    }
+    LD sum          = 0;
+    LD compensation = 0;
+    for ( const auto& argument : arguments )
+    {
+        const auto value = to_float ( argument );
+        const auto total = sum + value;
+        compensation += std::fabs ( sum ) >= std::fabs ( value ) ? ( sum - total ) + value : ( value - total ) + sum;
+        sum = total;
+    }
+    return sum + compensation;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// derivatives, min and max pick the same argument as the scalar implementations
+
+auto derive_sqrt ( std::span<const LD> arguments, std::span<LD> partials ) -> void
+{
+    partials[0] = 0.5L / std::sqrt ( arguments[0] );
+}
+
+auto derive_exp ( std::span<const LD> arguments, std::span<LD> partials ) -> void { partials[0] = std::exp ( arguments[0] ); }
+
+auto derive_log ( std::span<const LD> arguments, std::span<LD> partials ) -> void { partials[0] = 1 / arguments[0]; }
+
+auto derive_sin ( std::span<const LD> arguments, std::span<LD> partials ) -> void { partials[0] = std::cos ( arguments[0] ); }
+
+auto derive_cos ( std::span<const LD> arguments, std::span<LD> partials ) -> void { partials[0] = -std::sin ( arguments[0] ); }
+
+auto derive_abs ( std::span<const LD> arguments, std::span<LD> partials ) -> void
+{
+    partials[0] = arguments[0] > 0 ? 1 : ( arguments[0] < 0 ? -1 : 0 );
+}
+
+auto derive_min ( std::span<const LD> arguments, std::span<LD> partials ) -> void
+{
+    std::ranges::fill ( partials, 0 );
+    partials[static_cast<std::size_t> ( std::ranges::min_element ( arguments ) - arguments.begin() )] = 1;
+}
+
+auto derive_max ( std::span<const LD> arguments, std::span<LD> partials ) -> void
+{
+    std::ranges::fill ( partials, 0 );
+    partials[static_cast<std::size_t> ( std::ranges::max_element ( arguments ) - arguments.begin() )] = 1;
+}
+
+auto derive_ksum ( std::span<const LD> /*arguments*/, std::span<LD> partials ) -> void { std::ranges::fill ( partials, 1 ); }
+
+// ---------------------------------------------------------------------------------------------------------------------
+// batched implementations, every kernel has a scalar function that is used for the last rows and the special cases
+
+struct Sqrt
+{
+    static auto scalar ( double value ) -> double { return std::sqrt ( value ); }
+#ifdef PFME_X86_SIMD
+    static auto sse2 ( __m128d value ) -> __m128d { return _mm_sqrt_pd ( value ); }
+    PFME_TARGET_AVX2 static auto avx2 ( __m256d value ) -> __m256d { return _mm256_sqrt_pd ( value ); }
+#endif
+};
+
+struct Abs
+{
+    static auto scalar ( double value ) -> double { return std::fabs ( value ); }
+#ifdef PFME_X86_SIMD
+    static auto sse2 ( __m128d value ) -> __m128d { return _mm_andnot_pd ( _mm_set1_pd ( -0.0 ), value ); }
+    PFME_TARGET_AVX2 static auto avx2 ( __m256d value ) -> __m256d
+    {
+        return _mm256_andnot_pd ( _mm256_set1_pd ( -0.0 ), value );
+    }
+#endif
+};
+
+// written like minpd and maxpd, so all levels agree on NaN and signed zeros
+struct Min
+{
+    static auto scalar ( double lhs, double rhs ) -> double { return lhs < rhs ? lhs : rhs; }
+#ifdef PFME_X86_SIMD
+    static auto sse2 ( __m128d lhs, __m128d rhs ) -> __m128d { return _mm_min_pd ( lhs, rhs ); }
+    PFME_TARGET_AVX2 static auto avx2 ( __m256d lhs, __m256d rhs ) -> __m256d { return _mm256_min_pd ( lhs, rhs ); }
+#endif
+};
+
+struct Max
+{
+    static auto scalar ( double lhs, double rhs ) -> double { return lhs > rhs ? lhs : rhs; }
+#ifdef PFME_X86_SIMD
+    static auto sse2 ( __m128d lhs, __m128d rhs ) -> __m128d { return _mm_max_pd ( lhs, rhs ); }
+    PFME_TARGET_AVX2 static auto avx2 ( __m256d lhs, __m256d rhs ) -> __m256d { return _mm256_max_pd ( lhs, rhs ); }
+#endif
+};
+
+// exp, log, sin and cos follow the Cephes library: a range reduction and a polynomial or rational approximation.
+// Inputs the reduction does not cover (e.g. overflows, non-positive logarithms, NaN) are marked as special and are
+// recomputed with the scalar function.
+#ifdef PFME_X86_SIMD
+PFME_TARGET_AVX2 auto broadcast ( double value ) -> __m256d { return _mm256_set1_pd ( value ); }
+
+// a * x + b without relying on FMA, which not every AVX2 CPU has
+PFME_TARGET_AVX2 auto mul_add ( __m256d a, __m256d x, __m256d b ) -> __m256d
+{
+    return _mm256_add_pd ( _mm256_mul_pd ( a, x ), b );
+}
+
+// widens a 32 bit lane mask to the double lanes
+PFME_TARGET_AVX2 auto lane_mask ( __m128i mask ) -> __m256d { return _mm256_castsi256_pd ( _mm256_cvtepi32_epi64 ( mask ) ); }
+#endif
+
+struct Exp
+{
+    static auto scalar ( double value ) -> double { return std::exp ( value ); }
+#ifdef PFME_X86_SIMD
+    // 2^n is built in the exponent bits, which only works for normal results
+    PFME_TARGET_AVX2 static auto special ( __m256d value ) -> __m256d
+    {
+        return _mm256_cmp_pd ( _mm256_andnot_pd ( broadcast ( -0.0 ), value ), broadcast ( 708.0 ), _CMP_NLE_UQ );
+    }
+    PFME_TARGET_AVX2 static auto avx2 ( __m256d value ) -> __m256d
+    {
+        const __m256d n = _mm256_round_pd ( _mm256_mul_pd ( value, broadcast ( 1.4426950408889634073599 ) ),
+                                            _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC );
+        // value - n * ln(2) with ln(2) split in two parts, the first one is exact when multiplied with n
+        __m256d x = _mm256_sub_pd ( value, _mm256_mul_pd ( n, broadcast ( 6.93145751953125E-1 ) ) );
+        x         = _mm256_sub_pd ( x, _mm256_mul_pd ( n, broadcast ( 1.42860682030941723212E-6 ) ) );
+
+        const __m256d xx = _mm256_mul_pd ( x, x );
+        __m256d       p  = mul_add ( broadcast ( 1.26177193074810590878E-4 ), xx, broadcast ( 3.02994407707441961300E-2 ) );
+        p                = _mm256_mul_pd ( x, mul_add ( p, xx, broadcast ( 9.99999999999999999910E-1 ) ) );
+        __m256d q        = mul_add ( broadcast ( 3.00198505138664455042E-6 ), xx, broadcast ( 2.52448340349684104192E-3 ) );
+        q                = mul_add ( q, xx, broadcast ( 2.27265548208155028766E-1 ) );
+        q                = mul_add ( q, xx, broadcast ( 2.00000000000000000009E0 ) );
+        x                = _mm256_div_pd ( p, _mm256_sub_pd ( q, p ) );
+        x                = mul_add ( x, broadcast ( 2.0 ), broadcast ( 1.0 ) );
+
+        const __m256i exponent =
+            _mm256_add_epi64 ( _mm256_cvtepi32_epi64 ( _mm256_cvtpd_epi32 ( n ) ), _mm256_set1_epi64x ( 1023 ) );
+        return _mm256_mul_pd ( x, _mm256_castsi256_pd ( _mm256_slli_epi64 ( exponent, 52 ) ) );
+    }
+#endif
+};
+
+struct Log
+{
+    static auto scalar ( double value ) -> double { return std::log ( value ); }
+#ifdef PFME_X86_SIMD
+    // everything but positive, normal and finite numbers
+    PFME_TARGET_AVX2 static auto special ( __m256d value ) -> __m256d
+    {
+        return _mm256_or_pd ( _mm256_cmp_pd ( value, broadcast ( std::numeric_limits<double>::min() ), _CMP_NGE_UQ ),
+                              _mm256_cmp_pd ( value, broadcast ( std::numeric_limits<double>::infinity() ), _CMP_EQ_OQ ) );
+    }
+    PFME_TARGET_AVX2 static auto avx2 ( __m256d value ) -> __m256d
+    {
+        // value = m * 2^e with m in [0.5, 1), the biased exponent is turned into a double with the 2^52 trick
+        const __m256i bits     = _mm256_castpd_si256 ( value );
+        const __m256i biased   = _mm256_or_si256 ( _mm256_srli_epi64 ( bits, 52 ), _mm256_set1_epi64x ( 0x4330000000000000 ) );
+        __m256d       exponent = _mm256_sub_pd ( _mm256_castsi256_pd ( biased ), broadcast ( 4503599627370496.0 + 1022.0 ) );
+        const __m256i mantissa = _mm256_and_si256 ( bits, _mm256_set1_epi64x ( 0x000FFFFFFFFFFFFF ) );
+        const __m256i half     = _mm256_set1_epi64x ( 0x3FE0000000000000 );
+        __m256d       x        = _mm256_castsi256_pd ( _mm256_or_si256 ( mantissa, half ) );
+
+        // m in [sqrt(0.5), sqrt(2)) keeps the approximation around 1 symmetric
+        const __m256d small = _mm256_cmp_pd ( x, broadcast ( 0.70710678118654752440 ), _CMP_LT_OQ );
+        exponent            = _mm256_sub_pd ( exponent, _mm256_and_pd ( small, broadcast ( 1.0 ) ) );
+        x                   = _mm256_sub_pd ( _mm256_add_pd ( x, _mm256_and_pd ( small, x ) ), broadcast ( 1.0 ) );
+
+        const __m256d z = _mm256_mul_pd ( x, x );
+        __m256d       p = mul_add ( broadcast ( 1.01875663804580931796E-4 ), x, broadcast ( 4.97494994976747001425E-1 ) );
+        p               = mul_add ( p, x, broadcast ( 4.70579119878881725854E0 ) );
+        p               = mul_add ( p, x, broadcast ( 1.44989225341610930846E1 ) );
+        p               = mul_add ( p, x, broadcast ( 1.79368678507819816313E1 ) );
+        p               = mul_add ( p, x, broadcast ( 7.70838733755885391666E0 ) );
+        __m256d q       = _mm256_add_pd ( x, broadcast ( 1.12873587189167450590E1 ) );
+        q               = mul_add ( q, x, broadcast ( 4.52279145837532221105E1 ) );
+        q               = mul_add ( q, x, broadcast ( 8.29875266912776603211E1 ) );
+        q               = mul_add ( q, x, broadcast ( 7.11544750618563894466E1 ) );
+        q               = mul_add ( q, x, broadcast ( 2.31251620126765340583E1 ) );
+
+        // ln(2) is split in two parts again
+        __m256d y = _mm256_mul_pd ( x, _mm256_div_pd ( _mm256_mul_pd ( z, p ), q ) );
+        y         = _mm256_sub_pd ( y, _mm256_mul_pd ( exponent, broadcast ( 2.121944400546905827679e-4 ) ) );
+        y         = _mm256_sub_pd ( y, _mm256_mul_pd ( z, broadcast ( 0.5 ) ) );
+        return mul_add ( exponent, broadcast ( 0.693359375 ), _mm256_add_pd ( x, y ) );
+    }
+#endif
+};
+
+#ifdef PFME_X86_SIMD
+// |value| up to 2^20 is reduced exactly enough with pi/4 split in three parts
+PFME_TARGET_AVX2 auto trigonometric_special ( __m256d value ) -> __m256d
+{
+    return _mm256_cmp_pd ( _mm256_andnot_pd ( broadcast ( -0.0 ), value ), broadcast ( 1048576.0 ), _CMP_NLE_UQ );
+}
+
+PFME_TARGET_AVX2 auto sin_cos ( __m256d value, bool cosine ) -> __m256d
+{
+    const __m256d sign_bit = broadcast ( -0.0 );
+    const __m256d absolute = _mm256_andnot_pd ( sign_bit, value );
+
+    // the octant of the argument, odd octants are moved to the next even one so the rest is in [-pi/4, pi/4]
+    __m256d       octant = _mm256_floor_pd ( _mm256_mul_pd ( absolute, broadcast ( 1.27323954473516268615 ) ) );
+    __m128i       index  = _mm256_cvttpd_epi32 ( octant );
+    const __m128i odd    = _mm_and_si128 ( index, _mm_set1_epi32 ( 1 ) );
+    index                = _mm_add_epi32 ( index, odd );
+    octant               = _mm256_add_pd ( octant, _mm256_cvtepi32_pd ( odd ) );
+
+    __m256d x = _mm256_sub_pd ( absolute, _mm256_mul_pd ( octant, broadcast ( 7.85398125648498535156E-1 ) ) );
+    x         = _mm256_sub_pd ( x, _mm256_mul_pd ( octant, broadcast ( 3.77489470793079817668E-8 ) ) );
+    x         = _mm256_sub_pd ( x, _mm256_mul_pd ( octant, broadcast ( 2.69515142907905952645E-15 ) ) );
+    const __m256d xx = _mm256_mul_pd ( x, x );
+
+    __m256d sine = mul_add ( broadcast ( 1.58962301576546568060E-10 ), xx, broadcast ( -2.50507477628578072866E-8 ) );
+    sine         = mul_add ( sine, xx, broadcast ( 2.75573136213857245213E-6 ) );
+    sine         = mul_add ( sine, xx, broadcast ( -1.98412698295895385996E-4 ) );
+    sine         = mul_add ( sine, xx, broadcast ( 8.33333333332211858878E-3 ) );
+    sine         = mul_add ( sine, xx, broadcast ( -1.66666666666666307295E-1 ) );
+    sine         = mul_add ( _mm256_mul_pd ( x, xx ), sine, x );
+
+    __m256d cosine_value = mul_add ( broadcast ( -1.13585365213876817300E-11 ), xx, broadcast ( 2.08757008419747316778E-9 ) );
+    cosine_value         = mul_add ( cosine_value, xx, broadcast ( -2.75573141792967388112E-7 ) );
+    cosine_value         = mul_add ( cosine_value, xx, broadcast ( 2.48015872888517045348E-5 ) );
+    cosine_value         = mul_add ( cosine_value, xx, broadcast ( -1.38888888888730564116E-3 ) );
+    cosine_value         = mul_add ( cosine_value, xx, broadcast ( 4.16666666666665929218E-2 ) );
+    cosine_value         = mul_add ( _mm256_mul_pd ( xx, xx ),
+                                     cosine_value,
+                                     mul_add ( xx, broadcast ( -0.5 ), broadcast ( 1.0 ) ) );
+
+    // octants 2 and 6 swap the approximations, 4 and 6 flip the sign of the sine, 2 and 4 the one of the cosine
+    const __m256d swap = lane_mask ( _mm_cmpeq_epi32 ( _mm_and_si128 ( index, _mm_set1_epi32 ( 2 ) ), _mm_set1_epi32 ( 2 ) ) );
+    const __m256d flip = lane_mask ( _mm_cmpeq_epi32 ( _mm_and_si128 ( index, _mm_set1_epi32 ( 4 ) ), _mm_set1_epi32 ( 4 ) ) );
+    if ( cosine )
+    {
+        const __m256d result = _mm256_blendv_pd ( cosine_value, sine, swap );
+        return _mm256_xor_pd ( result, _mm256_and_pd ( _mm256_xor_pd ( swap, flip ), sign_bit ) );
+    }
+    const __m256d result = _mm256_blendv_pd ( sine, cosine_value, swap );
+    return _mm256_xor_pd ( result, _mm256_xor_pd ( _mm256_and_pd ( value, sign_bit ), _mm256_and_pd ( flip, sign_bit ) ) );
+}
+#endif
+
+struct Sin
+{
+    static auto scalar ( double value ) -> double { return std::sin ( value ); }
+#ifdef PFME_X86_SIMD
+    PFME_TARGET_AVX2 static auto special ( __m256d value ) -> __m256d { return trigonometric_special ( value ); }
+    PFME_TARGET_AVX2 static auto avx2 ( __m256d value ) -> __m256d { return sin_cos ( value, false ); }
+#endif
+};
+
+struct Cos
+{
+    static auto scalar ( double value ) -> double { return std::cos ( value ); }
+#ifdef PFME_X86_SIMD
+    PFME_TARGET_AVX2 static auto special ( __m256d value ) -> __m256d { return trigonometric_special ( value ); }
+    PFME_TARGET_AVX2 static auto avx2 ( __m256d value ) -> __m256d { return sin_cos ( value, true ); }
+#endif
+};
+
+#ifdef PFME_X86_SIMD
+template <typename Kernel>
+concept has_special = requires ( __m256d value ) { Kernel::special ( value ); };
+
+template <typename Kernel>
+concept has_sse2 = requires ( __m128d value ) { Kernel::sse2 ( value ); };
+
+// each map returns the first row it did not compute
+template <typename Kernel>
+PFME_TARGET_AVX2 auto avx2_map ( std::span<const double> input, std::span<double> results ) -> std::size_t
+{
+    std::size_t row = 0;
+    for ( ; row + 4 <= results.size(); row += 4 )
+    {
+        const __m256d value = _mm256_loadu_pd ( input.data() + row );
+        if constexpr ( has_special<Kernel> )
+        {
+            const int special = _mm256_movemask_pd ( Kernel::special ( value ) );
+            _mm256_storeu_pd ( results.data() + row, Kernel::avx2 ( value ) );
+            if ( special == 0 ) { continue; }
+            // the input may be the same memory as the results
+            alignas ( 32 ) std::array<double, 4> lanes {};
+            _mm256_store_pd ( lanes.data(), value );
+            for ( std::size_t lane = 0; lane < lanes.size(); ++lane )
+            {
+                if ( ( special & ( 1 << lane ) ) != 0 ) { results[row + lane] = Kernel::scalar ( lanes[lane] ); }
+            }
+        }
+        else { _mm256_storeu_pd ( results.data() + row, Kernel::avx2 ( value ) ); }
+    }
+    return row;
+}
+
+template <typename Kernel>
+auto sse2_map ( std::span<const double> input, std::span<double> results ) -> std::size_t
+{
+    std::size_t row = 0;
+    for ( ; row + 2 <= results.size(); row += 2 )
+    {
+        _mm_storeu_pd ( results.data() + row, Kernel::sse2 ( _mm_loadu_pd ( input.data() + row ) ) );
+    }
+    return row;
+}
+
+template <typename Kernel>
+PFME_TARGET_AVX2 auto avx2_zip ( std::span<const double> lhs, std::span<const double> rhs, std::span<double> results )
+    -> std::size_t
+{
+    std::size_t row = 0;
+    for ( ; row + 4 <= results.size(); row += 4 )
+    {
+        _mm256_storeu_pd ( results.data() + row,
+                           Kernel::avx2 ( _mm256_loadu_pd ( lhs.data() + row ), _mm256_loadu_pd ( rhs.data() + row ) ) );
+    }
+    return row;
+}
+
+template <typename Kernel>
+auto sse2_zip ( std::span<const double> lhs, std::span<const double> rhs, std::span<double> results ) -> std::size_t
+{
+    std::size_t row = 0;
+    for ( ; row + 2 <= results.size(); row += 2 )
+    {
+        _mm_storeu_pd ( results.data() + row,
+                        Kernel::sse2 ( _mm_loadu_pd ( lhs.data() + row ), _mm_loadu_pd ( rhs.data() + row ) ) );
+    }
+    return row;
+}
+#endif
+
+template <typename Kernel>
+auto batch_map ( column_t arguments, std::span<double> results ) -> void
+{
+    const auto  input = arguments[0];
+    std::size_t row   = 0;
+#ifdef PFME_X86_SIMD
+    switch ( simd::get_level() )
+    {
+    case SIMD_LEVEL::AVX2: row = avx2_map<Kernel> ( input, results ); break;
+    case SIMD_LEVEL::SSE2:
+        if constexpr ( has_sse2<Kernel> ) { row = sse2_map<Kernel> ( input, results ); }
+        break;
+    default: break;
+    }
+#endif
+    for ( ; row < results.size(); ++row ) { results[row] = Kernel::scalar ( input[row] ); }
+}
+
+// folds all columns into the results, min(a, b, c) = min(min(a, b), c)
+template <typename Kernel>
+auto batch_fold ( column_t arguments, std::span<double> results ) -> void
+{
+    if ( arguments[0].data() != results.data() ) { std::ranges::copy ( arguments[0], results.begin() ); }
+    for ( const auto column : arguments.subspan ( 1 ) )
+    {
+        std::size_t row = 0;
+#ifdef PFME_X86_SIMD
+        switch ( simd::get_level() )
+        {
+        case SIMD_LEVEL::AVX2: row = avx2_zip<Kernel> ( results, column, results ); break;
+        case SIMD_LEVEL::SSE2: row = sse2_zip<Kernel> ( results, column, results ); break;
+        default: break;
+        }
+#endif
+        for ( ; row < results.size(); ++row ) { results[row] = Kernel::scalar ( results[row], column[row] ); }
+    }
+}
+
+// the compensation of every row is kept in a column of its own, the columns are added one after the other, a block of
+// rows at a time so the compensation fits on the stack
+auto batch_ksum ( column_t arguments, std::span<double> results ) -> void
+{
+    constexpr std::size_t     BLOCK = 256; // rows per block, the block size of evaluate_batch
+    std::array<double, BLOCK> compensation {};
+    if ( arguments[0].data() != results.data() ) { std::ranges::copy ( arguments[0], results.begin() ); }
+    for ( std::size_t begin = 0; begin < results.size(); begin += BLOCK )
+    {
+        const auto size = std::min ( BLOCK, results.size() - begin );
+        const auto rows = results.subspan ( begin, size );
+        compensation.fill ( 0.0 );
+        for ( const auto column : arguments.subspan ( 1 ) )
+        {
+            for ( std::size_t row = 0; row < size; ++row )
+            {
+                const double sum   = rows[row];
+                const double value = column[begin + row];
+                const double total = sum + value;
+                compensation[row] +=
+                    std::fabs ( sum ) >= std::fabs ( value ) ? ( sum - total ) + value : ( value - total ) + sum;
+                rows[row] = total;
+            }
+        }
+        for ( std::size_t row = 0; row < size; ++row ) { rows[row] += compensation[row]; }
+    }
+}
+
+auto is_name ( std::string_view name ) -> bool
+{
+    const auto is_letter = [] ( char character )
+    {
+        return ( character >= 'a' && character <= 'z' ) || ( character >= 'A' && character <= 'Z' );
+    };
+    const auto is_digit = [] ( char character ) { return character >= '0' && character <= '9'; };
+    return !name.empty() && is_letter ( name.front() ) &&
+           std::ranges::all_of ( name, [&] ( char character ) { return is_letter ( character ) || is_digit ( character ); } );
+}
+} // namespace
+
+FunctionRegistry::FunctionRegistry()
+{
+    // in the order of FUNCTION
+    add ( { "sqrt", 1, 1, scalar_sqrt, batch_map<Sqrt>, derive_sqrt } );
+    add ( { "exp", 1, 1, scalar_exp, batch_map<Exp>, derive_exp } );
+    add ( { "log", 1, 1, scalar_log, batch_map<Log>, derive_log } );
+    add ( { "sin", 1, 1, scalar_sin, batch_map<Sin>, derive_sin } );
+    add ( { "cos", 1, 1, scalar_cos, batch_map<Cos>, derive_cos } );
+    add ( { "min", 1, Function::VARIADIC, scalar_min, batch_fold<Min>, derive_min } );
+    add ( { "max", 1, Function::VARIADIC, scalar_max, batch_fold<Max>, derive_max } );
+    add ( { "abs", 1, 1, scalar_abs, batch_map<Abs>, derive_abs } );
+    add ( { "ksum", 1, Function::VARIADIC, scalar_ksum, batch_ksum, derive_ksum } );
+    // the term of a range depends on its index, so sum and prod have no implementation, the Visitor evaluates ranges
+    // itself and call() and call_batch() reject them
+    for ( const auto* name : { "sum", "prod" } )
+    {
+        m_functions[m_size.load ( std::memory_order_relaxed )] = Function { name, 4, 4, nullptr, nullptr, nullptr };
+        m_size.fetch_add ( 1, std::memory_order_release );
+    }
+}
+
+auto FunctionRegistry::global() -> FunctionRegistry&
+{
+    static FunctionRegistry registry;
+    return registry;
+}
+
+auto FunctionRegistry::add ( Function function ) -> std::uint32_t
+{
+    if ( !is_name ( function.m_name ) )
+    {
+        throw std::runtime_error ( std::format ( "'{}' can not be used as function name", function.m_name ) );
+    }
+    if ( function.m_scalar == nullptr || function.m_batch == nullptr || function.m_min_arguments == 0 ||
+         function.m_min_arguments > function.m_max_arguments )
+    {
+        throw std::runtime_error ( std::format ( "Function '{}' is incomplete", function.m_name ) );
+    }
+
+    const std::scoped_lock lock ( m_add_mutex );
+    if ( find ( function.m_name ) )
+    {
+        throw std::runtime_error ( std::format ( "Function '{}' already exists", function.m_name ) );
+    }
+    const auto id = m_size.load ( std::memory_order_relaxed );
+    if ( id == MAX_FUNCTIONS ) { throw std::runtime_error ( "Too many functions" ); }
+    m_functions[id] = std::move ( function );
+    // readers only see the function once it is complete
+    m_size.store ( id + 1, std::memory_order_release );
+    return id;
+}
+
+auto FunctionRegistry::find ( std::string_view name ) const -> std::optional<std::uint32_t>
+{
+    const auto count = size();
+    for ( std::uint32_t id = 0; id < count; ++id )
+    {
+        if ( m_functions[id].m_name == name ) { return id; }
+    }
+    return std::nullopt;
+}
+
+auto call ( std::uint32_t function, std::span<const AST::num_t> arguments ) -> std::expected<AST::num_t, ERROR_CODE>
+{
+    const auto& registry = FunctionRegistry::global();
+    if ( function >= registry.size() ) { return std::unexpected ( ERROR_CODE::UNKNOWN_FUNCTION ); }
+    if ( is_range ( function ) ) { return std::unexpected ( ERROR_CODE::UNSUPPORTED_RANGE ); }
+    const auto& callee = registry.get ( function );
+    if ( arguments.size() < callee.m_min_arguments || arguments.size() > callee.m_max_arguments )
+    {
+        return std::unexpected ( ERROR_CODE::ARGUMENT_COUNT );
+    }
+    return callee.m_scalar ( arguments );
+}
+
+auto call_batch ( std::uint32_t function, std::span<const std::span<const double>> arguments, std::span<double> results )
+    -> void
+{
+    const auto& registry = FunctionRegistry::global();
+    if ( function >= registry.size() ) { throw std::runtime_error ( std::format ( "Unknown function id {}", function ) ); }
+    if ( is_range ( function ) )
+    {
+        throw std::runtime_error (
+            std::format ( "{} is a range, only the Visitor evaluates it", registry.get ( function ).m_name ) );
+    }
+    const auto& callee = registry.get ( function );
+    if ( arguments.size() < callee.m_min_arguments || arguments.size() > callee.m_max_arguments )
+    {
+        throw std::runtime_error ( std::format ( "Wrong number of arguments for {}: {}", callee.m_name, arguments.size() ) );
+    }
+    if ( std::ranges::any_of ( arguments, [&] ( const auto column ) { return column.size() != results.size(); } ) )
+    {
+        throw std::runtime_error (
+            std::format ( "The arguments of {} have a different size than the results", callee.m_name ) );
+    }
+    callee.m_batch ( arguments, results );
+}
+} // namespace pfme
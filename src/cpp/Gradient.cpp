@@ -0,0 +1,457 @@
+#include "Block.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <pfme/Functions.hpp>
+#include <pfme/Gradient.hpp>
+#include <pfme/Trace.hpp>
+#include <stdexcept>
+
+namespace pfme
+{
+namespace
+{
+constexpr std::size_t BLOCK = 256; // rows per block of gradient_batch, a block of every node stays in the cache
+
+template <std::floating_point Float>
+struct Partials
+{
+    Float m_lhs; /**< The derivative with respect to the left operand */
+    Float m_rhs; /**< The derivative with respect to the right operand */
+};
+
+template <std::floating_point Float>
+auto real ( const basic_num_t<Float>& number ) -> Float
+{
+    if ( const auto* fraction = std::get_if<Fraction> ( &number ) )
+    {
+        return static_cast<Float> ( fraction->numerator() ) / static_cast<Float> ( fraction->denominator() );
+    }
+    if ( const auto* integer = std::get_if<LLI> ( &number ) ) { return static_cast<Float> ( *integer ); }
+    if ( const auto* decimal = std::get_if<Decimal> ( &number ) )
+    {
+        return static_cast<Float> ( static_cast<LD> ( *decimal ) );
+    }
+    return std::get<Float> ( number );
+}
+
+// the derivatives of lhs op rhs with respect to both operands, the one of an exponent is only computed if it is needed
+template <std::floating_point Float>
+auto operation_partials ( AST_TYPE type, Float lhs, Float rhs, Float result, bool rhs_dependent ) -> Partials<Float>
+{
+    switch ( type )
+    {
+    case AST_TYPE::ADDITION: return { 1, 1 };
+    case AST_TYPE::SUBTRACTION: return { 1, -1 };
+    case AST_TYPE::MULTIPLICATION: return { rhs, lhs };
+    case AST_TYPE::DIVISION: return { 1 / rhs, -result / rhs };
+    default:
+    {
+        const Float base = rhs == 0 ? Float { 0 } : rhs * std::pow ( lhs, rhs - 1 );
+        if ( !rhs_dependent ) { return { base, 0 }; }
+        if ( lhs > 0 ) { return { base, result * std::log ( lhs ) }; }
+        return { base, lhs == 0 && rhs > 0 ? Float { 0 } : std::numeric_limits<Float>::quiet_NaN() };
+    }
+    }
+}
+
+// one term of the chain rule, a zero partial or a zero incoming derivative contributes nothing, so an infinite partial
+// (e.g. of sqrt at 0) that is multiplied by 0 on its way to the result does not turn into NaN, in every mode alike
+template <std::floating_point Float>
+auto chain ( Float partial, Float incoming ) -> Float
+{
+    return partial == 0 || incoming == 0 ? Float { 0 } : partial * incoming;
+}
+
+auto is_number ( AST_TYPE type ) -> bool
+{
+    return type == AST_TYPE::INTEGER || type == AST_TYPE::FLOAT || type == AST_TYPE::FRACTION || type == AST_TYPE::DECIMAL;
+}
+
+// comparisons and the logical operators are constant between their jumps, so their derivative is 0
+auto is_logical ( AST_TYPE type ) -> bool
+{
+    switch ( type )
+    {
+    case AST_TYPE::LESS: [[fallthrough]];
+    case AST_TYPE::LESS_EQUAL: [[fallthrough]];
+    case AST_TYPE::GREATER: [[fallthrough]];
+    case AST_TYPE::GREATER_EQUAL: [[fallthrough]];
+    case AST_TYPE::EQUAL: [[fallthrough]];
+    case AST_TYPE::NOT_EQUAL: [[fallthrough]];
+    case AST_TYPE::AND: [[fallthrough]];
+    case AST_TYPE::OR: return true;
+    default: return false;
+    }
+}
+
+// collects the argument nodes of the function call at index
+auto collect_arguments ( std::span<const BinaryNode> nodes, std::size_t index, std::vector<std::uint32_t>& children ) -> void
+{
+    const auto& node = nodes[index];
+    children.assign ( 1, node.m_lhand );
+    for ( auto next = node.m_rhand; next != BinaryNode::NO_CHILD; next = nodes[next].m_rhand )
+    {
+        children.push_back ( nodes[next].m_lhand );
+    }
+}
+
+// marks every node that depends on a variable, returns false if such a node calls a function without a derivative
+auto mark_dependent ( std::span<const BinaryNode>  nodes,
+                      std::vector<std::uint8_t>&  dependent,
+                      std::vector<std::uint32_t>& children ) -> bool
+{
+    dependent.assign ( nodes.size(), 0 );
+    for ( std::size_t i = 0; i < nodes.size(); ++i )
+    {
+        const auto& node = nodes[i];
+        const auto  type = node.get_type();
+        if ( type == AST_TYPE::VARIABLE ) { dependent[i] = 1; }
+        else if ( type == AST_TYPE::FUNCTION )
+        {
+            collect_arguments ( nodes, i, children );
+            const auto depends = [&] ( std::uint32_t child ) { return dependent[child] != 0; };
+            dependent[i]       = std::ranges::any_of ( children, depends ) ? 1 : 0;
+            if ( dependent[i] != 0 && FunctionRegistry::global().get ( node.m_extra ).m_derivative == nullptr )
+            {
+                return false;
+            }
+        }
+        else if ( type != AST_TYPE::ARGUMENT && !is_number ( type ) && !is_logical ( type ) )
+        {
+            dependent[i] = dependent[node.m_lhand] | dependent[node.m_rhand];
+        }
+    }
+    return true;
+}
+
+// the result a condition at index selects, the value of the condition is read from values with a stride
+template <std::floating_point Float>
+auto taken ( std::span<const BinaryNode> nodes, std::size_t index, const Float* values, std::size_t stride ) -> std::uint32_t
+{
+    const auto& alternative = nodes[nodes[index].m_rhand];
+    return values[nodes[index].m_lhand * stride] != 0 ? alternative.m_lhand : alternative.m_rhand;
+}
+
+// the partial derivatives of a function call at one point, the arguments are read from values with a stride
+template <std::floating_point Float>
+auto function_partials ( basic_gradient_context<Float>& context,
+                         std::uint32_t                  function,
+                         const Float*                   values,
+                         std::size_t                    stride ) -> void
+{
+    auto& points = context.m_points;
+    points.clear();
+    for ( const auto child : context.m_children ) { points.push_back ( static_cast<LD> ( values[child * stride] ) ); }
+    context.m_partials.resize ( points.size() );
+    FunctionRegistry::global().get ( function ).m_derivative ( points, context.m_partials );
+}
+} // namespace
+
+template <std::floating_point Float>
+auto basic_gradient_context<Float>::local() -> basic_gradient_context&
+{
+    thread_local basic_gradient_context context;
+    return context;
+}
+
+template <std::floating_point Float>
+auto gradient ( const CompiledExpression&      expression,
+                std::span<const Float>         variables,
+                std::span<Float>               partials,
+                AD_MODE                        mode,
+                basic_gradient_context<Float>& context ) -> Result<Float>
+{
+    const trace::Scope scope ( trace::STAGE::GRADIENT );
+    const auto nodes = expression.get_nodes();
+    const auto count = expression.get_variables().size();
+    if ( partials.size() != count ) { throw std::runtime_error ( "Gradient needs one partial derivative for every variable" ); }
+    if ( !mark_dependent ( nodes, context.m_dependent, context.m_children ) )
+    {
+        return std::unexpected ( Error { ERROR_CODE::NOT_DIFFERENTIABLE } );
+    }
+
+    const auto shortcuts = expression.get_shortcuts();
+    auto&      dependent = context.m_dependent;
+    auto&      numbers   = context.m_numbers;
+    auto&      values    = context.m_values;
+    numbers.resize ( nodes.size() );
+    values.resize ( nodes.size() );
+    for ( std::size_t i = 0; i < nodes.size(); ++i )
+    {
+        const auto& node = nodes[i];
+        switch ( node.get_type() )
+        {
+        case AST_TYPE::ARGUMENT: continue;
+        case AST_TYPE::ALTERNATIVE: continue;
+        case AST_TYPE::CONDITION:
+            numbers[i] = numbers[taken ( nodes, i, values.data(), 1 )];
+            break;
+        case AST_TYPE::FUNCTION:
+        {
+            collect_arguments ( nodes, i, context.m_children );
+            auto& arguments = context.m_arguments;
+            arguments.clear();
+            for ( const auto child : context.m_children ) { arguments.push_back ( convert_number<LD> ( numbers[child] ) ); }
+            auto result = call ( node.m_extra, arguments );
+            if ( !result ) { return std::unexpected ( Error { result.error() } ); }
+            numbers[i] = convert_number<Float> ( *result );
+            break;
+        }
+        case AST_TYPE::INTEGER: [[fallthrough]];
+        case AST_TYPE::FLOAT: [[fallthrough]];
+        case AST_TYPE::FRACTION: [[fallthrough]];
+        case AST_TYPE::DECIMAL: numbers[i] = convert_number<Float> ( node.to_number() ); break;
+        case AST_TYPE::VARIABLE:
+            if ( node.m_extra >= variables.size() ) { return std::unexpected ( Error { ERROR_CODE::UNBOUND_VARIABLE } ); }
+            numbers[i] = variables[node.m_extra];
+            break;
+        default:
+        {
+            auto result = apply_operation<Float> ( node.get_type(), numbers[node.m_lhand], numbers[node.m_rhand] );
+            if ( !result ) { return std::unexpected ( Error { result.error() } ); }
+            numbers[i] = *result;
+        }
+        }
+        values[i] = real ( numbers[i] );
+        if ( !shortcuts.empty() && shortcuts[i].m_target != Shortcut::NONE &&
+             shortcuts[i].jumps ( is_true<Float> ( numbers[i] ) ) )
+        {
+            // the skipped nodes have no value, so nothing flows through them
+            std::fill (
+                dependent.begin() + static_cast<std::ptrdiff_t> ( i + 1 ), dependent.begin() + shortcuts[i].m_target, 0 );
+            i = shortcuts[i].m_target - 1;
+        }
+    }
+
+    auto& derivatives = context.m_derivatives;
+    if ( mode == AD_MODE::FORWARD )
+    {
+        // derivatives[i * count + k] is the derivative of node i with respect to variable k
+        derivatives.assign ( nodes.size() * count, 0 );
+        for ( std::size_t i = 0; i < nodes.size(); ++i )
+        {
+            if ( dependent[i] == 0 ) { continue; }
+            const auto& node    = nodes[i];
+            auto*       tangent = derivatives.data() + ( i * count );
+            if ( node.get_type() == AST_TYPE::VARIABLE ) { tangent[node.m_extra] = 1; }
+            else if ( node.get_type() == AST_TYPE::ALTERNATIVE ) { continue; }
+            else if ( node.get_type() == AST_TYPE::CONDITION )
+            {
+                const auto  selected = taken ( nodes, i, values.data(), 1 );
+                const auto* source   = derivatives.data() + ( selected * count );
+                if ( dependent[selected] != 0 ) { std::copy ( source, source + count, tangent ); }
+            }
+            else if ( node.get_type() == AST_TYPE::FUNCTION )
+            {
+                collect_arguments ( nodes, i, context.m_children );
+                function_partials ( context, node.m_extra, values.data(), 1 );
+                for ( std::size_t j = 0; j < context.m_children.size(); ++j )
+                {
+                    const auto child = context.m_children[j];
+                    if ( dependent[child] == 0 ) { continue; }
+                    const auto  partial = static_cast<Float> ( context.m_partials[j] );
+                    const auto* source  = derivatives.data() + ( child * count );
+                    for ( std::size_t k = 0; k < count; ++k ) { tangent[k] += chain ( partial, source[k] ); }
+                }
+            }
+            else
+            {
+                const auto [lhs, rhs] = operation_partials ( node.get_type(),
+                                                             values[node.m_lhand],
+                                                             values[node.m_rhand],
+                                                             values[i],
+                                                             dependent[node.m_rhand] != 0 );
+                for ( const auto& [child, partial] : { std::pair { node.m_lhand, lhs }, std::pair { node.m_rhand, rhs } } )
+                {
+                    if ( dependent[child] == 0 ) { continue; }
+                    const auto* source = derivatives.data() + ( child * count );
+                    for ( std::size_t k = 0; k < count; ++k ) { tangent[k] += chain ( partial, source[k] ); }
+                }
+            }
+        }
+        const auto* root = derivatives.data() + ( ( nodes.size() - 1 ) * count );
+        std::copy ( root, root + count, partials.begin() );
+        return values.back();
+    }
+
+    // reverse mode, derivatives[i] is the derivative of the result with respect to node i
+    std::ranges::fill ( partials, Float { 0 } );
+    derivatives.assign ( nodes.size(), 0 );
+    derivatives.back() = 1;
+    for ( std::size_t i = nodes.size(); i-- > 0; )
+    {
+        // a subtree that only feeds a comparison has an adjoint of 0 and passes nothing on, see chain()
+        if ( dependent[i] == 0 || derivatives[i] == 0 ) { continue; }
+        const auto& node    = nodes[i];
+        const auto  adjoint = derivatives[i];
+        if ( node.get_type() == AST_TYPE::VARIABLE ) { partials[node.m_extra] += adjoint; }
+        else if ( node.get_type() == AST_TYPE::ALTERNATIVE ) { continue; }
+        else if ( node.get_type() == AST_TYPE::CONDITION ) { derivatives[taken ( nodes, i, values.data(), 1 )] += adjoint; }
+        else if ( node.get_type() == AST_TYPE::FUNCTION )
+        {
+            collect_arguments ( nodes, i, context.m_children );
+            function_partials ( context, node.m_extra, values.data(), 1 );
+            for ( std::size_t j = 0; j < context.m_children.size(); ++j )
+            {
+                derivatives[context.m_children[j]] += chain ( static_cast<Float> ( context.m_partials[j] ), adjoint );
+            }
+        }
+        else
+        {
+            const auto [lhs, rhs] = operation_partials ( node.get_type(), values[node.m_lhand], values[node.m_rhand], values[i],
+                                                         dependent[node.m_rhand] != 0 );
+            if ( dependent[node.m_lhand] != 0 ) { derivatives[node.m_lhand] += chain ( lhs, adjoint ); }
+            if ( dependent[node.m_rhand] != 0 ) { derivatives[node.m_rhand] += chain ( rhs, adjoint ); }
+        }
+    }
+    return values.back();
+}
+
+template <std::floating_point Float>
+auto gradient_batch ( const CompiledExpression&               expression,
+                      std::span<const std::span<const Float>> variables,
+                      std::span<Float>                        values,
+                      std::span<const std::span<Float>>       partials,
+                      basic_gradient_context<Float>&          context ) -> void
+{
+    const trace::Scope scope ( trace::STAGE::GRADIENT );
+    const auto nodes = expression.get_nodes();
+    const auto count = expression.get_variables().size();
+    const auto rows  = values.size();
+    if ( variables.size() < count ) { throw std::runtime_error ( "Gradient batch needs a column for every variable" ); }
+    if ( partials.size() != count )
+    {
+        throw std::runtime_error ( "Gradient batch needs a partial derivative column for every variable" );
+    }
+    for ( const auto column : variables )
+    {
+        if ( column.size() != rows ) { throw std::runtime_error ( "Gradient batch columns need one value for every row" ); }
+    }
+    for ( const auto column : partials )
+    {
+        if ( column.size() != rows ) { throw std::runtime_error ( "Gradient batch columns need one value for every row" ); }
+    }
+    if ( !mark_dependent ( nodes, context.m_dependent, context.m_children ) )
+    {
+        throw std::runtime_error ( "Gradient batch calls a function without a derivative" );
+    }
+    for ( const auto column : partials ) { std::ranges::fill ( column, Float { 0 } ); }
+
+    // the rows a condition did not select carry an adjoint of 0, like in gradient() they pass nothing on, see chain()
+    const auto& dependent   = context.m_dependent;
+    auto&       block       = context.m_values;
+    auto&       derivatives = context.m_derivatives;
+    block.resize ( nodes.size() * BLOCK );
+    derivatives.resize ( nodes.size() * BLOCK );
+    for ( std::size_t begin = 0; begin < rows; begin += BLOCK )
+    {
+        const auto size = std::min ( BLOCK, rows - begin );
+        // block[i * BLOCK + row] is the value of node i in the row
+        for ( std::size_t i = 0; i < nodes.size(); ++i )
+        {
+            evaluate_block<Float> (
+                nodes, i, block.data(), BLOCK, variables, begin, size, context.m_columns, context.m_arguments );
+        }
+        std::copy_n ( block.data() + ( ( nodes.size() - 1 ) * BLOCK ), size, values.data() + begin );
+
+        // derivatives[i * BLOCK + row] is the derivative of the result of the row with respect to node i
+        std::fill ( derivatives.begin(), derivatives.end(), Float { 0 } );
+        std::fill_n ( derivatives.data() + ( ( nodes.size() - 1 ) * BLOCK ), size, Float { 1 } );
+        for ( std::size_t i = nodes.size(); i-- > 0; )
+        {
+            if ( dependent[i] == 0 ) { continue; }
+            const auto& node    = nodes[i];
+            const auto* adjoint = derivatives.data() + ( i * BLOCK );
+            if ( node.get_type() == AST_TYPE::VARIABLE )
+            {
+                auto* target = partials[node.m_extra].data() + begin;
+                for ( std::size_t row = 0; row < size; ++row ) { target[row] += adjoint[row]; }
+            }
+            else if ( node.get_type() == AST_TYPE::ALTERNATIVE ) { continue; }
+            else if ( node.get_type() == AST_TYPE::CONDITION )
+            {
+                // every row passes its adjoint to the result it selected, the other one gets 0
+                const auto& alternative = nodes[node.m_rhand];
+                const auto* condition   = block.data() + ( std::size_t { node.m_lhand } * BLOCK );
+                auto*       first       = derivatives.data() + ( std::size_t { alternative.m_lhand } * BLOCK );
+                auto*       second      = derivatives.data() + ( std::size_t { alternative.m_rhand } * BLOCK );
+                for ( std::size_t row = 0; row < size; ++row )
+                {
+                    first[row] += condition[row] != 0 ? adjoint[row] : Float { 0 };
+                    second[row] += condition[row] != 0 ? Float { 0 } : adjoint[row];
+                }
+            }
+            else if ( node.get_type() == AST_TYPE::FUNCTION )
+            {
+                collect_arguments ( nodes, i, context.m_children );
+                for ( std::size_t row = 0; row < size; ++row )
+                {
+                    if ( adjoint[row] == 0 ) { continue; }
+                    function_partials ( context, node.m_extra, block.data() + row, BLOCK );
+                    for ( std::size_t j = 0; j < context.m_children.size(); ++j )
+                    {
+                        derivatives[( context.m_children[j] * BLOCK ) + row] +=
+                            chain ( static_cast<Float> ( context.m_partials[j] ), adjoint[row] );
+                    }
+                }
+            }
+            else
+            {
+                const auto  type          = node.get_type();
+                const bool  lhs_dependent = dependent[node.m_lhand] != 0;
+                const bool  rhs_dependent = dependent[node.m_rhand] != 0;
+                const auto* lhs           = block.data() + ( std::size_t { node.m_lhand } * BLOCK );
+                const auto* rhs           = block.data() + ( std::size_t { node.m_rhand } * BLOCK );
+                const auto* result        = block.data() + ( i * BLOCK );
+                auto*       lhs_adjoint   = derivatives.data() + ( std::size_t { node.m_lhand } * BLOCK );
+                auto*       rhs_adjoint   = derivatives.data() + ( std::size_t { node.m_rhand } * BLOCK );
+                for ( std::size_t row = 0; row < size; ++row )
+                {
+                    if ( adjoint[row] == 0 ) { continue; }
+                    const auto partial = operation_partials ( type, lhs[row], rhs[row], result[row], rhs_dependent );
+                    if ( lhs_dependent ) { lhs_adjoint[row] += chain ( partial.m_lhs, adjoint[row] ); }
+                    if ( rhs_dependent ) { rhs_adjoint[row] += chain ( partial.m_rhs, adjoint[row] ); }
+                }
+            }
+        }
+    }
+}
+
+template struct basic_gradient_context<float>;
+template struct basic_gradient_context<double>;
+template struct basic_gradient_context<LD>;
+
+template auto gradient<float> ( const CompiledExpression&,
+                                std::span<const float>,
+                                std::span<float>,
+                                AD_MODE,
+                                basic_gradient_context<float>& ) -> Result<float>;
+template auto gradient<double> ( const CompiledExpression&,
+                                 std::span<const double>,
+                                 std::span<double>,
+                                 AD_MODE,
+                                 basic_gradient_context<double>& ) -> Result<double>;
+template auto gradient<LD> ( const CompiledExpression&,
+                             std::span<const LD>,
+                             std::span<LD>,
+                             AD_MODE,
+                             basic_gradient_context<LD>& ) -> Result<LD>;
+
+template auto gradient_batch<float> ( const CompiledExpression&,
+                                      std::span<const std::span<const float>>,
+                                      std::span<float>,
+                                      std::span<const std::span<float>>,
+                                      basic_gradient_context<float>& ) -> void;
+template auto gradient_batch<double> ( const CompiledExpression&,
+                                       std::span<const std::span<const double>>,
+                                       std::span<double>,
+                                       std::span<const std::span<double>>,
+                                       basic_gradient_context<double>& ) -> void;
+template auto gradient_batch<LD> ( const CompiledExpression&,
+                                   std::span<const std::span<const LD>>,
+                                   std::span<LD>,
+                                   std::span<const std::span<LD>>,
+                                   basic_gradient_context<LD>& ) -> void;
+} // namespace pfme
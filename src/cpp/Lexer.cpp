@@ -1,43 +1,201 @@
 #include "pfme/Lexer.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <limits>
+#include <utility>
+#include <pfme/Scan.hpp>
 namespace pfme
 {
+namespace
+{
+// the magnitude of the smallest LLI
+constexpr std::uint64_t MAX_MAGNITUDE = static_cast<std::uint64_t> ( std::numeric_limits<long long int>::max() ) + 1;
+} // namespace
+
+LexerConfig::LexerConfig()
+    : LexerConfig ( '.', { '\'', ',', '_' } )
+{
+}
+
+LexerConfig::LexerConfig ( char point_symbol, std::vector<char> seperators, char argument_seperator )
+    : m_point_symbol ( point_symbol )
+    , m_argument_seperator ( argument_seperator != '\0' ? argument_seperator : point_symbol == ',' ? ';' : ',' )
+{
+    const auto mark = [this] ( char character, CHAR_CLASS type )
+    { m_classes[static_cast<unsigned char> ( character )] |= static_cast<std::uint8_t> ( type ); };
+    for ( char digit = '0'; digit <= '9'; ++digit )
+    {
+        mark ( digit, CHAR_CLASS::DIGIT );
+        mark ( digit, CHAR_CLASS::HEX_DIGIT );
+    }
+    for ( char letter = 'a'; letter <= 'z'; ++letter )
+    {
+        const auto upper = static_cast<char> ( letter - 'a' + 'A' );
+        mark ( letter, CHAR_CLASS::LETTER );
+        mark ( upper, CHAR_CLASS::LETTER );
+        if ( letter > 'f' ) { continue; }
+        mark ( letter, CHAR_CLASS::HEX_DIGIT );
+        mark ( upper, CHAR_CLASS::HEX_DIGIT );
+    }
+    for ( const char operation : { '(', ')', '*', '/', '+', '-', '^', '<', '>', '=', '!', '&', '|', '?', ':' } )
+    {
+        mark ( operation, CHAR_CLASS::OPERATOR );
+    }
+    for ( const char space : { ' ', '\n', '\t' } ) { mark ( space, CHAR_CLASS::WHITESPACE ); }
+    mark ( 'e', CHAR_CLASS::EXPONENT );
+    mark ( 'E', CHAR_CLASS::EXPONENT );
+
+    // everything that already has a meaning (or is not printable ASCII) can not be used for the number format
+    const auto reserved = [this] ( char character )
+    {
+        return character <= ' ' || character > '~' || isalnum ( character ) != 0 || is ( character, CHAR_CLASS::OPERATOR );
+    };
+    if ( reserved ( point_symbol ) )
+    {
+        throw std::runtime_error ( std::format ( "'{}' can not be used as decimal point", point_symbol ) );
+    }
+    mark ( point_symbol, CHAR_CLASS::POINT );
+    for ( const char seperator : seperators )
+    {
+        if ( seperator == point_symbol || ( seperator != ' ' && reserved ( seperator ) ) )
+        {
+            throw std::runtime_error ( std::format ( "'{}' can not be used as seperator", seperator ) );
+        }
+        mark ( seperator, CHAR_CLASS::SEPERATOR );
+    }
+    if ( m_argument_seperator == point_symbol || reserved ( m_argument_seperator ) )
+    {
+        throw std::runtime_error ( std::format ( "'{}' can not be used as argument seperator", m_argument_seperator ) );
+    }
+
+    for ( std::size_t character = 0; character < m_classes.size(); ++character )
+    {
+        if ( !is_skipped ( static_cast<char> ( character ) ) ) { continue; }
+        // too many to compare against, the scanning falls back to the table
+        if ( m_skipped_count == MAX_SKIPPED )
+        {
+            m_skipped_count = 0;
+            break;
+        }
+        m_skipped[m_skipped_count++] = static_cast<char> ( character );
+    }
+}
+
+auto LexerConfig::standard() -> const LexerConfig&
+{
+    static const LexerConfig config;
+    return config;
+}
+
+auto LexerConfig::german() -> const LexerConfig&
+{
+    static const LexerConfig config ( ',', { '.', '\'', '_' } );
+    return config;
+}
+
+auto LexerConfig::swiss() -> const LexerConfig&
+{
+    static const LexerConfig config ( '.', { '\'' } );
+    return config;
+}
+
+auto LexerConfig::space_grouping() -> const LexerConfig&
+{
+    static const LexerConfig config ( '.', { ' ', '_' } );
+    return config;
+}
+
 Lexer::Lexer ( std::string_view data )
-    : m_contents ( data )
-    , m_current_char ( m_contents[m_index] )
+    : Lexer ( data, LexerConfig::standard() )
 {
 }
 
 Lexer::Lexer ( std::string_view data, char point_sym, std::vector<char>&& seperators )
+    : Lexer ( data, LexerConfig ( point_sym, std::move ( seperators ) ) )
+{
+}
+
+Lexer::Lexer ( std::string_view data, const LexerConfig& config )
     : m_contents ( data )
     , m_current_char ( m_contents[m_index] )
-    , m_point_symbol ( point_sym )
-    , m_seperators ( std::move(seperators) )
-
+    , m_config ( config )
 {
 }
 
 auto Lexer::get_next_token() -> std::unique_ptr<Token>
 {
+    auto token = try_next_token();
+    if ( !token ) { throw std::runtime_error ( token.error().message ( m_contents ) ); }
+    return std::move ( *token );
+}
+
+auto Lexer::try_next_token() -> Result<std::unique_ptr<Token>>
+{
+    auto token = std::make_unique<Token>();
+    if ( auto result = try_next_token ( *token ); !result ) { return std::unexpected ( result.error() ); }
+    return token;
+}
+
+auto Lexer::try_next_token ( Token& token ) -> Result<void>
+{
+    if ( m_tokens == 0 && m_contents.length() > m_limits.m_input_length )
+    {
+        return std::unexpected ( Error { ERROR_CODE::LIMIT_EXCEEDED, static_cast<std::uint32_t> ( m_limits.m_input_length ) } );
+    }
     while ( m_current_char != '\0' && m_index < m_contents.length() )
     {
-        if ( m_current_char == ' ' || m_current_char == '\n' || m_current_char == '\t' ||
-             std::find ( m_seperators.begin(), m_seperators.end(), m_current_char ) != m_seperators.end() )
+        const bool argument = m_current_char == m_config.get_argument_seperator() && in_call();
+        if ( !argument && m_config.is_skipped ( m_current_char ) )
         {
             skip_whitespace();
+            continue;
+        }
+        if ( ++m_tokens > m_limits.m_tokens ) { return std::unexpected ( Error { ERROR_CODE::LIMIT_EXCEEDED, m_index } ); }
+        if ( argument )
+        {
+            advance();
+            m_after_name = false;
+            token.assign ( TOKEN_TYPE::TOKEN_COMMA, "," );
+            return {};
         }
 
-        // check if it is a valid character and throw if not
-        if ( m_current_char < 0 ) { throw std::runtime_error ( error_string ( "character too large" ) ); }
-        if ( isdigit ( m_current_char ) != 0 || m_current_char == m_point_symbol ) { return collect_number(); }
-        auto token = std::make_unique<Token> ( m_current_char, get_current_char_as_string() );
+        // check if it is a valid character and fail if not
+        if ( m_current_char < 0 ) { return std::unexpected ( Error { ERROR_CODE::CHARACTER_TOO_LARGE, m_index } ); }
+        if ( m_config.is ( m_current_char, CHAR_CLASS::LETTER ) )
+        {
+            collect_identifier ( token );
+            return {};
+        }
+        const bool after_name = std::exchange ( m_after_name, false );
+        if ( m_config.is ( m_current_char, CHAR_CLASS::DIGIT ) || m_config.is ( m_current_char, CHAR_CLASS::POINT ) )
+        {
+            return collect_number ( token );
+        }
+        if ( collect_operator ( token ) ) { return {}; }
+        if ( m_current_char == '(' ) { m_calls.push_back ( after_name ); }
+        else if ( m_current_char == ')' && !m_calls.empty() ) { m_calls.pop_back(); }
+        token.assign ( static_cast<TOKEN_TYPE> ( m_current_char ), std::string_view ( m_contents ).substr ( m_index, 1 ) );
         advance();
-        return token;
+        return {};
     }
 
-    return std::make_unique<Token> ( TOKEN_TYPE::TOKEN_EOF, "\0" );
+    token.assign ( TOKEN_TYPE::TOKEN_EOF, "" );
+    return {};
 }
 
 
+auto Lexer::reset ( std::string_view data ) -> void
+{
+    m_contents.assign ( data );
+    m_index        = 0;
+    m_current_char = m_contents[m_index];
+    m_calls.clear();
+    m_after_name = false;
+    m_tokens     = 0;
+}
+
 auto Lexer::advance() -> void
 {
     if ( m_current_char != '\0' && m_index < m_contents.length() )
@@ -47,49 +205,197 @@ auto Lexer::advance() -> void
     }
 }
 
+auto Lexer::jump_to ( std::size_t index ) -> void
+{
+    m_index        = static_cast<std::uint32_t> ( index );
+    m_current_char = m_contents[m_index];
+}
+
 auto Lexer::skip_whitespace() -> void
 {
-    while ( m_current_char == ' ' || m_current_char == '\n' || m_current_char == '\t' ||
-            std::find ( m_seperators.begin(), m_seperators.end(), m_current_char ) != m_seperators.end() )
+    if ( !m_config.is_skipped ( m_current_char ) ) { return; }
+    const char argument_seperator = m_config.get_argument_seperator();
+    if ( in_call() && m_config.is_skipped ( argument_seperator ) )
     {
-        advance();
+        // the vector scan would skip the argument seperator as digit seperator
+        while ( m_index < m_contents.length() && m_config.is_skipped ( m_current_char ) &&
+                m_current_char != argument_seperator )
+        {
+            advance();
+        }
+        return;
     }
+    jump_to ( scan::skip_run_end ( m_contents, m_index, m_config ) );
+}
+
+auto Lexer::collect_identifier ( Token& token ) -> void
+{
+    const auto start   = m_index;
+    const auto is_name = [this] ( char character )
+    { return m_config.is ( character, CHAR_CLASS::LETTER ) || m_config.is ( character, CHAR_CLASS::DIGIT ); };
+    // a '_' between two characters of a name belongs to the name (e.g. unit_price), not to a number
+    while ( is_name ( m_current_char ) || ( m_current_char == '_' && is_name ( m_contents[m_index + 1] ) ) ) { advance(); }
+    m_after_name = true;
+    token.assign ( TOKEN_TYPE::TOKEN_IDENTIFIER, std::string_view ( m_contents ).substr ( start, m_index - start ) );
 }
 
-auto Lexer::collect_number() -> std::unique_ptr<Token>
+auto Lexer::collect_operator ( Token& token ) -> bool
 {
-    std::string value {};
-    bool        point = false;
-    while ( isdigit ( m_current_char ) != 0 || ( m_current_char == m_point_symbol && !point ) )
+    const char second = m_contents[m_index + 1];
+    auto       type   = TOKEN_TYPE::TOKEN_UNKNOWN;
+    switch ( m_current_char )
     {
-        if ( m_current_char == m_point_symbol ) { point = true; }
-        auto collector = get_current_char_as_string();
-        value += collector;
+    case '<': type = second == '=' ? TOKEN_TYPE::TOKEN_LESS_EQUAL : TOKEN_TYPE::TOKEN_LESS; break;
+    case '>': type = second == '=' ? TOKEN_TYPE::TOKEN_GREATER_EQUAL : TOKEN_TYPE::TOKEN_GREATER; break;
+    case '=': type = second == '=' ? TOKEN_TYPE::TOKEN_EQUAL : type; break;
+    case '!': type = second == '=' ? TOKEN_TYPE::TOKEN_NOT_EQUAL : type; break;
+    case '&': type = second == '&' ? TOKEN_TYPE::TOKEN_AND : type; break;
+    case '|': type = second == '|' ? TOKEN_TYPE::TOKEN_OR : type; break;
+    default: return false;
+    }
+    // only < and > are operators of a single character
+    const bool single =
+        type == TOKEN_TYPE::TOKEN_LESS || type == TOKEN_TYPE::TOKEN_GREATER || type == TOKEN_TYPE::TOKEN_UNKNOWN;
+    const std::size_t length = single ? 1 : 2;
+    token.assign ( type, std::string_view ( m_contents ).substr ( m_index, length ) );
+    for ( std::size_t i = 0; i < length; ++i ) { advance(); }
+    return true;
+}
+
+auto Lexer::collect_number ( Token& token ) -> Result<void>
+{
+    const auto start = m_index;
+    if ( m_current_char == '0' && ( m_contents[m_index + 1] == 'x' || m_contents[m_index + 1] == 'X' ) )
+    {
+        advance();
         advance();
-        if ( std::find ( m_seperators.begin(), m_seperators.end(), m_current_char ) != m_seperators.end() )
+        return collect_hex_number ( token, start );
+    }
+
+    auto end        = m_index;
+    bool point      = false;
+    bool contiguous = true; // the number can be converted in place if it has no seperators and a '.' as point
+    while ( m_config.is ( m_current_char, CHAR_CLASS::DIGIT ) ||
+            ( m_config.is ( m_current_char, CHAR_CLASS::POINT ) && !point ) )
+    {
+        if ( m_config.is ( m_current_char, CHAR_CLASS::POINT ) )
+        {
+            point = true;
+            contiguous &= m_current_char == '.';
+            advance();
+        }
+        else { jump_to ( scan::digit_run_end ( m_contents, m_index ) ); }
+        end = m_index;
+        if ( m_config.is ( m_current_char, CHAR_CLASS::SEPERATOR ) )
         {
             skip_whitespace();
+            contiguous &= m_index == end;
+        }
+    }
+    if ( m_config.is ( m_current_char, CHAR_CLASS::POINT ) && point )
+    {
+        return std::unexpected ( Error { ERROR_CODE::TWO_POINTS, m_index } );
+    }
+
+    // scientific notation, the 'e' only belongs to the number if digits follow it
+    bool exponent = false;
+    if ( m_config.is ( m_current_char, CHAR_CLASS::EXPONENT ) && end == m_index )
+    {
+        const auto digit = m_index + ( m_contents[m_index + 1] == '+' || m_contents[m_index + 1] == '-' ? 2U : 1U );
+        exponent         = m_config.is ( m_contents[digit], CHAR_CLASS::DIGIT );
+        if ( exponent )
+        {
+            while ( m_index < digit ) { advance(); }
+            jump_to ( scan::digit_run_end ( m_contents, m_index ) );
+            end = m_index;
         }
     }
-    if ( m_current_char == m_point_symbol && point )
+
+    if ( end - start > m_limits.m_literal_length ) { return std::unexpected ( Error { ERROR_CODE::LIMIT_EXCEEDED, start } ); }
+    const auto text =
+        contiguous ? std::string_view ( m_contents ).substr ( start, end - start ) : normalize_number ( start, end );
+    const auto* first = text.data();
+    const auto* last  = text.data() + text.size();
+    Token::number_t number;
+    std::from_chars_result result {};
+    if ( point || exponent )
     {
-        throw std::runtime_error ( error_string ( "two points in one number are not allowed" ).c_str() );
+        long double value {};
+        result = std::from_chars ( first, last, value, std::chars_format::general );
+        number = value;
+        if ( m_config.get_decimals() && result.ec == std::errc {} )
+        {
+            if ( const auto decimal = Decimal::from_chars ( text ) ) { number = *decimal; }
+        }
+    }
+    else
+    {
+        std::uint64_t value {};
+        result = std::from_chars ( first, last, value );
+        // one more than the largest LLI is allowed, it is valid if the Parser finds a '-' in front of it
+        if ( result.ec == std::errc {} && value > MAX_MAGNITUDE ) { result.ec = std::errc::result_out_of_range; }
+        number = value;
+    }
+    if ( result.ec == std::errc::result_out_of_range )
+    {
+        return std::unexpected ( Error { ERROR_CODE::NUMBER_OUT_OF_RANGE, start } );
+    }
+    if ( result.ec != std::errc {} || result.ptr != last )
+    {
+        return std::unexpected ( Error { ERROR_CODE::INVALID_NUMBER, start } );
     }
 
-    if ( point ) { return std::make_unique<Token> ( TOKEN_TYPE::TOKEN_FLOAT, value ); }
-    return std::make_unique<Token> ( TOKEN_TYPE::TOKEN_INTEGER, value );
+    token.assign ( point || exponent ? TOKEN_TYPE::TOKEN_FLOAT : TOKEN_TYPE::TOKEN_INTEGER,
+                   std::string_view ( m_contents ).substr ( start, end - start ),
+                   number );
+    return {};
 }
 
-auto Lexer::get_current_char_as_string() const -> std::string { return { m_current_char }; }
+auto Lexer::collect_hex_number ( Token& token, std::uint32_t start ) -> Result<void>
+{
+    const auto digits     = m_index;
+    auto       end        = m_index;
+    bool       contiguous = true;
+    while ( m_config.is ( m_current_char, CHAR_CLASS::HEX_DIGIT ) )
+    {
+        advance();
+        end = m_index;
+        if ( m_config.is ( m_current_char, CHAR_CLASS::SEPERATOR ) )
+        {
+            skip_whitespace();
+            contiguous &= m_index == end;
+        }
+    }
+    if ( end == digits ) { return std::unexpected ( Error { ERROR_CODE::INVALID_NUMBER, start } ); }
+    if ( end - start > m_limits.m_literal_length ) { return std::unexpected ( Error { ERROR_CODE::LIMIT_EXCEEDED, start } ); }
+
+    const auto text =
+        contiguous ? std::string_view ( m_contents ).substr ( digits, end - digits ) : normalize_number ( digits, end );
+    std::uint64_t value {};
+    const auto    result = std::from_chars ( text.data(), text.data() + text.size(), value, 16 );
+    if ( result.ec == std::errc::result_out_of_range || value > MAX_MAGNITUDE )
+    {
+        return std::unexpected ( Error { ERROR_CODE::NUMBER_OUT_OF_RANGE, start } );
+    }
+    token.assign ( TOKEN_TYPE::TOKEN_INTEGER, std::string_view ( m_contents ).substr ( start, end - start ), value );
+    return {};
+}
+
+auto Lexer::normalize_number ( std::uint32_t start, std::uint32_t end ) -> std::string_view
+{
+    m_buffer.clear();
+    for ( auto i = start; i < end; ++i )
+    {
+        const char character = m_contents[i];
+        if ( m_config.is ( character, CHAR_CLASS::POINT ) ) { m_buffer += '.'; }
+        else if ( !m_config.is_skipped ( character ) ) { m_buffer += character; }
+    }
+    return m_buffer;
+}
 
 auto Lexer::error_string ( std::string_view msg, int index_modifier ) -> std::string
 {
-    return std::format ( "{}\n"
-                         "First found here: \n"
-                         "\t {}\n"
-                         "\t {}",
-                         msg,
-                         m_contents,
-                         std::string ( m_index + index_modifier, ' ' ) + "^\n" );
+    const auto position = std::max ( static_cast<int> ( m_index ) + index_modifier, 0 );
+    return format_error ( msg, m_contents, static_cast<std::size_t> ( position ) );
 }
 } // namespace pfme
\ No newline at end of file
@@ -0,0 +1,399 @@
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <pfme/Functions.hpp>
+#include <pfme/ParallelParser.hpp>
+#include <pfme/Parser.hpp>
+#include <pfme/Trace.hpp>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace pfme
+{
+namespace
+{
+constexpr int              LEAF_LEVEL       = std::numeric_limits<int>::max(); // operands are below every operation
+constexpr std::string_view SPLIT_CHARACTERS = "+-*/^()";                       // never in a number, name or separator run
+
+/**
+ * @brief A part of the input that is lexed and parsed by its own thread.
+ */
+struct Chunk
+{
+    std::string_view     m_text;
+    bool                 m_after_operand      = false;   /**< The chunk starts behind a number, a name or a ')' */
+    int                  m_depth              = 0;       /**< The parenthesis level at the start of the chunk */
+    std::shared_ptr<AST> m_root               = nullptr; /**< The partial tree, its first or last operand can be missing */
+    std::vector<AST*>    m_right              = {};      /**< The operations on the right edge from the root down */
+    std::vector<AST*>    m_left               = {};      /**< The operations on the left edge from the bottom up */
+    bool                 m_valid              = false;
+    bool                 m_ends_after_operand = false;
+};
+
+/**
+ * @brief Parses the tokens of one chunk like the Parser, except for function calls.
+ *
+ * A chunk that starts behind an operand gets an empty lhand in its first operation, the operand is in the chunk in
+ * front of it. Every error makes the chunk invalid, the whole input is then parsed by a single Parser.
+ */
+class ChunkParser
+{
+public:
+    ChunkParser ( Chunk& chunk, const LexerConfig& config )
+        : m_chunk ( chunk )
+        , m_lexer ( chunk.m_text, config )
+        , m_parenthesis_level ( chunk.m_depth )
+    {
+    }
+
+    auto parse() -> bool
+    {
+        if ( !next() ) { return false; }
+        bool                 after_operand = m_chunk.m_after_operand;
+        std::shared_ptr<AST> operand       = nullptr;
+        while ( true )
+        {
+            if ( !after_operand )
+            {
+                const auto type = m_token.get_type();
+                if ( type == TOKEN_TYPE::TOKEN_EOF ) { break; }
+                if ( type == TOKEN_TYPE::TOKEN_L_PAREN )
+                {
+                    ++m_parenthesis_level;
+                    if ( !next() ) { return false; }
+                    continue;
+                }
+                if ( type == TOKEN_TYPE::TOKEN_SUBTRACTION || type == TOKEN_TYPE::TOKEN_ADDITION )
+                {
+                    m_negative_sign = type == TOKEN_TYPE::TOKEN_SUBTRACTION;
+                    if ( !next() ) { return false; }
+                }
+                operand = parse_operand();
+                if ( operand == nullptr ) { return false; }
+                after_operand = true;
+                continue;
+            }
+
+            while ( m_token.get_type() == TOKEN_TYPE::TOKEN_R_PAREN )
+            {
+                --m_parenthesis_level;
+                if ( !next() ) { return false; }
+            }
+            if ( m_token.get_type() == TOKEN_TYPE::TOKEN_EOF )
+            {
+                attach ( std::move ( operand ) );
+                break;
+            }
+            auto operation = make_operation ( std::move ( operand ) );
+            if ( operation == nullptr ) { return false; }
+            add_operation ( operation );
+            after_operand = false;
+            if ( !next() ) { return false; }
+        }
+        m_chunk.m_ends_after_operand = after_operand;
+        return true;
+    }
+
+private:
+    Chunk& m_chunk;
+    Lexer  m_lexer;
+    Token  m_token {};
+    int    m_parenthesis_level;
+    bool   m_negative_sign = false;
+
+    auto next() -> bool { return m_lexer.try_next_token ( m_token ).has_value(); }
+
+    // see Parser::parse_expression and Parser::parse_name
+    auto parse_operand() -> std::shared_ptr<AST>
+    {
+        std::shared_ptr<AST> operand = nullptr;
+        switch ( m_token.get_type() )
+        {
+        case TOKEN_TYPE::TOKEN_INTEGER:
+        {
+            const auto magnitude = std::get<std::uint64_t> ( m_token.get_number() );
+            if ( !m_negative_sign && magnitude > static_cast<std::uint64_t> ( std::numeric_limits<LLI>::max() ) )
+            {
+                return nullptr;
+            }
+            operand = std::make_shared<AST> ( static_cast<LLI> ( m_negative_sign ? 0 - magnitude : magnitude ) );
+            break;
+        }
+        case TOKEN_TYPE::TOKEN_FLOAT:
+        {
+            if ( const auto* decimal = std::get_if<Decimal> ( &m_token.get_number() ) )
+            {
+                operand = std::make_shared<AST> ( m_negative_sign ? -*decimal : *decimal );
+                break;
+            }
+            const auto value = std::get<long double> ( m_token.get_number() );
+            operand          = std::make_shared<AST> ( m_negative_sign ? -value : value );
+            break;
+        }
+        case TOKEN_TYPE::TOKEN_IDENTIFIER:
+        {
+            // function calls are left to the Parser
+            if ( FunctionRegistry::global().find ( m_token.get_value() ) ) { return nullptr; }
+            operand = std::make_shared<AST> ( AST_TYPE::VARIABLE, m_token.get_value() );
+            if ( m_negative_sign )
+            {
+                auto negated     = std::make_shared<AST> ( std::make_shared<AST> ( -1LL ) );
+                negated->m_type  = AST_TYPE::MULTIPLICATION;
+                negated->m_value = "*";
+                negated->rhand   = std::move ( operand );
+                operand          = std::move ( negated );
+            }
+            break;
+        }
+        default: return nullptr;
+        }
+        m_negative_sign = false;
+        return next() ? operand : nullptr;
+    }
+
+    // see Parser::parse_operation
+    auto make_operation ( std::shared_ptr<AST> operand ) const -> std::shared_ptr<AST>
+    {
+        auto operation = std::make_shared<AST> ( std::move ( operand ) );
+        auto level     = OPERATION_LEVEL::ADDITIVE;
+        switch ( m_token.get_type() )
+        {
+        case TOKEN_TYPE::TOKEN_MULTIPLICATION:
+            operation->m_type  = AST_TYPE::MULTIPLICATION;
+            operation->m_value = "*";
+            level              = OPERATION_LEVEL::MULTIPLICATIVE;
+            break;
+        case TOKEN_TYPE::TOKEN_DIVISION:
+            operation->m_type  = AST_TYPE::DIVISION;
+            operation->m_value = "/";
+            level              = OPERATION_LEVEL::MULTIPLICATIVE;
+            break;
+        case TOKEN_TYPE::TOKEN_ADDITION:
+            operation->m_type  = AST_TYPE::ADDITION;
+            operation->m_value = "+";
+            break;
+        case TOKEN_TYPE::TOKEN_SUBTRACTION:
+            operation->m_type  = AST_TYPE::SUBTRACTION;
+            operation->m_value = "-";
+            break;
+        case TOKEN_TYPE::TOKEN_EXPONENTIATION:
+            operation->m_type  = AST_TYPE::EXPONENTIATION;
+            operation->m_value = "^";
+            level              = OPERATION_LEVEL::EXPONENTIAL;
+            break;
+        default: return nullptr; // comparisons, logical operators and conditions are left to the Parser
+        }
+        operation->m_operation_level = operation_level ( level, m_parenthesis_level );
+        return operation;
+    }
+
+    auto attach ( std::shared_ptr<AST> operand ) -> void
+    {
+        if ( m_chunk.m_root == nullptr ) { m_chunk.m_root = std::move ( operand ); }
+        else { m_chunk.m_right.back()->rhand = std::move ( operand ); }
+    }
+
+    // see Parser::add_operation, a new root is also the top of the left edge
+    auto add_operation ( const std::shared_ptr<AST>& operation ) -> void
+    {
+        auto& right = m_chunk.m_right;
+        if ( m_chunk.m_root == nullptr )
+        {
+            m_chunk.m_root = operation;
+            m_chunk.m_left.push_back ( operation.get() );
+        }
+        else if ( right.back()->m_operation_level <= operation->m_operation_level ) { right.back()->rhand = operation; }
+        else
+        {
+            right.back()->rhand = std::move ( operation->lhand );
+            while ( !right.empty() && right.back()->m_operation_level > operation->m_operation_level ) { right.pop_back(); }
+            if ( right.empty() )
+            {
+                operation->lhand = std::move ( m_chunk.m_root );
+                m_chunk.m_root   = operation;
+                m_chunk.m_left.push_back ( operation.get() );
+            }
+            else
+            {
+                operation->lhand    = std::move ( right.back()->rhand );
+                right.back()->rhand = operation;
+            }
+        }
+        right.push_back ( operation.get() );
+    }
+};
+
+/**
+ * @brief The tree of all chunks behind the current one.
+ */
+struct Tree
+{
+    std::shared_ptr<AST> m_root = nullptr;
+    std::vector<AST*>    m_left {}; /**< The operations on the left edge from the bottom up */
+};
+
+/**
+ * Puts a chunk in front of the tree of the chunks behind it.
+ * The operations on the right edge of the chunk and on the left edge of the tree are merged by level, lower levels
+ * end up higher in the tree and of two equal levels the left one stays on top, just like in Parser::add_operation.
+ * Only the edges are walked, the right one with a binary search since its levels never decrease.
+ * @param chunk is the chunk, its tree is moved into the result
+ * @param tree is the tree behind it
+ * @return false if two operands meet, which only happens for invalid input
+ */
+auto zip ( Chunk& chunk, Tree& tree ) -> bool
+{
+    if ( chunk.m_root == nullptr ) { return true; }
+    if ( tree.m_root == nullptr )
+    {
+        tree.m_root = std::move ( chunk.m_root );
+        tree.m_left = std::move ( chunk.m_left );
+        return true;
+    }
+
+    const auto&                right       = chunk.m_right;
+    auto&                      left        = tree.m_left;
+    std::size_t                right_index = 0; // the position of x on the right edge, right.size() for an operand
+    std::size_t                taken       = 0; // the operations of the left edge already linked into the result
+    std::optional<std::size_t> left_edge;       // how many of them stay on the left edge, known once x is linked
+    auto                       x    = std::move ( chunk.m_root );
+    auto                       y    = std::move ( tree.m_root );
+    std::shared_ptr<AST>       root = nullptr;
+    auto*                      link = &root;
+    while ( x != nullptr && y != nullptr )
+    {
+        const bool x_operation = right_index < right.size();
+        const bool y_operation = taken < left.size();
+        if ( !x_operation && !y_operation ) { return false; }
+        const int y_level = y_operation ? y->m_operation_level : LEAF_LEVEL;
+        if ( x_operation && x->m_operation_level <= y_level )
+        {
+            if ( !left_edge ) { left_edge = taken; }
+            // the operations on the right edge that are not higher than y stay above it
+            const auto end = std::upper_bound ( right.begin() + static_cast<std::ptrdiff_t> ( right_index ),
+                                                right.end(),
+                                                y_level,
+                                                [] ( int level, const AST* node ) { return level < node->m_operation_level; } );
+            right_index = static_cast<std::size_t> ( end - right.begin() );
+            *link       = std::move ( x );
+            link        = &right[right_index - 1]->rhand;
+            x           = std::move ( *link );
+        }
+        else
+        {
+            *link = std::move ( y );
+            link  = &( *link )->lhand;
+            y     = std::move ( *link );
+            ++taken;
+        }
+    }
+    if ( !left_edge ) { left_edge = taken; }
+    *link = x != nullptr ? std::move ( x ) : std::move ( y );
+
+    // the top of the left edge of the tree, then the left edge of the chunk
+    std::vector<AST*> edge = std::move ( chunk.m_left );
+    edge.insert ( edge.end(), left.end() - static_cast<std::ptrdiff_t> ( *left_edge ), left.end() );
+    tree.m_root = std::move ( root );
+    tree.m_left = std::move ( edge );
+    return true;
+}
+
+// runs the function for every chunk, the first one on the calling thread
+template <typename Function>
+auto for_each_chunk ( std::vector<Chunk>& chunks, const Function& function ) -> void
+{
+    std::vector<std::jthread> threads;
+    threads.reserve ( chunks.size() - 1 );
+    for ( std::size_t i = 1; i < chunks.size(); ++i )
+    {
+        threads.emplace_back ( [&function, &chunk = chunks[i]] { function ( chunk ); } );
+    }
+    function ( chunks.front() );
+}
+
+auto split ( std::string_view input, const LexerConfig& config, std::size_t count ) -> std::vector<Chunk>
+{
+    std::vector<Chunk> chunks;
+    std::size_t        begin = 0;
+    for ( std::size_t i = 1; i <= count; ++i )
+    {
+        auto end = i == count ? input.size() : std::max ( begin + 1, input.size() / count * i );
+        // a '+' or '-' behind an 'e' can be the sign of an exponent
+        while ( end < input.size() &&
+                ( SPLIT_CHARACTERS.find ( input[end] ) == std::string_view::npos ||
+                  ( ( input[end] == '+' || input[end] == '-' ) && config.is ( input[end - 1], CHAR_CLASS::EXPONENT ) ) ) )
+        {
+            ++end;
+        }
+        if ( end <= begin ) { continue; }
+        // the last character in front of the chunk tells if an operand ended there
+        auto previous = begin;
+        while ( previous > 0 && config.is_skipped ( input[previous - 1] ) ) { --previous; }
+        const bool after_operand =
+            previous > 0 && std::string_view ( "+-*/^(" ).find ( input[previous - 1] ) == std::string_view::npos;
+        chunks.push_back ( { input.substr ( begin, end - begin ), after_operand } );
+        begin = end;
+        if ( begin == input.size() ) { break; }
+    }
+    return chunks;
+}
+
+auto parse_chunks ( std::string_view input, const LexerConfig& config, std::size_t count ) -> std::shared_ptr<AST>
+{
+    auto chunks = split ( input, config, count );
+    // parenthesis are always tokens of their own, so counting them gives the level every chunk starts at
+    std::vector<int> depths ( chunks.size(), 0 );
+    for_each_chunk ( chunks,
+                     [&chunks, &depths] ( const Chunk& chunk )
+                     {
+                         const auto index = static_cast<std::size_t> ( &chunk - chunks.data() );
+                         const auto opened = std::ranges::count ( chunk.m_text, '(' );
+                         depths[index]     = static_cast<int> ( opened - std::ranges::count ( chunk.m_text, ')' ) );
+                     } );
+    for ( std::size_t i = 1; i < chunks.size(); ++i ) { chunks[i].m_depth = chunks[i - 1].m_depth + depths[i - 1]; }
+    for_each_chunk ( chunks, [&config] ( Chunk& chunk ) { chunk.m_valid = ChunkParser ( chunk, config ).parse(); } );
+
+    for ( std::size_t i = 0; i < chunks.size(); ++i )
+    {
+        if ( !chunks[i].m_valid ) { return nullptr; }
+        if ( i + 1 < chunks.size() && chunks[i].m_ends_after_operand != chunks[i + 1].m_after_operand ) { return nullptr; }
+    }
+    // an operation at the very end gets a 0 as its right operand
+    AST* last = nullptr;
+    for ( auto chunk = chunks.rbegin(); chunk != chunks.rend(); ++chunk )
+    {
+        if ( chunk->m_root == nullptr ) { continue; }
+        if ( !chunk->m_right.empty() && chunk->m_right.back()->rhand == nullptr ) { last = chunk->m_right.back(); }
+        break;
+    }
+
+    Tree tree;
+    for ( auto chunk = chunks.rbegin(); chunk != chunks.rend(); ++chunk )
+    {
+        if ( !zip ( *chunk, tree ) ) { return nullptr; }
+    }
+    if ( last != nullptr ) { last->rhand = std::make_shared<AST> ( 0LL ); }
+    return tree.m_root;
+}
+} // namespace
+
+auto parse_parallel ( std::string_view       input,
+                      const LexerConfig&     config,
+                      const ParallelOptions& options ) -> Result<std::shared_ptr<AST>>
+{
+    const trace::Scope scope ( trace::STAGE::PARSE );
+    // the Lexer stops at the end of a C string
+    const auto text    = input.substr ( 0, input.find ( '\0' ) );
+    const auto threads = options.m_threads > 0 ? options.m_threads : std::max ( std::thread::hardware_concurrency(), 1U );
+    const auto size    = std::max<std::size_t> ( options.m_chunk_size, 1 );
+    const auto count   = std::clamp<std::size_t> ( text.size() / size, 1, threads );
+    if ( count > 1 )
+    {
+        if ( auto root = parse_chunks ( text, config, count ) ) { return root; }
+    }
+    // small inputs, function calls and errors
+    Parser parser ( std::make_unique<Lexer> ( input, config ) );
+    return parser.try_parse();
+}
+} // namespace pfme
@@ -1,118 +1,231 @@
-﻿#include <pfme/Parser.hpp>
+﻿#include "Range.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <pfme/Functions.hpp>
+#include <pfme/Parser.hpp>
+#include <pfme/Trace.hpp>
+#include <utility>
 namespace pfme
 {
-//NOLINTBEGIN(misc-no-recursion)
-auto Parser::print_binary_tree ( const std::string& prefix, const AST* node, bool isLeft ) -> void
+auto Parser::print_binary_tree ( const AST* node, std::ostream& stream ) -> void
 {
-    if ( node != nullptr )
+    // every entry remembers how much of the shared prefix belongs to it, deeper entries only ever append to it
+    struct Entry
+    {
+        const AST*  node;
+        std::size_t prefix_length;
+        bool        is_left;
+    };
+    std::string        prefix;
+    std::vector<Entry> worklist { { node, 0, false } };
+    while ( !worklist.empty() )
     {
-        std::cout << prefix;
+        const auto entry = worklist.back();
+        worklist.pop_back();
+        if ( entry.node == nullptr ) { continue; }
 
+        prefix.resize ( entry.prefix_length );
+        stream << prefix;
 #pragma warning( suppress : 4566 )
-        std::cout << ( isLeft ? "├──" : "└──" );
+        stream << ( entry.is_left ? "├──" : "└──" );
 
         // print the value of the node
-        std::cout << node->m_value << '\n';
+        stream << entry.node->to_string() << '\n';
 
-        // enter the next tree level - left and right branch
+        // enter the next tree level - left branch first, so it has to be pushed last
 #pragma warning( suppress : 4566 )
-        print_binary_tree ( prefix + ( isLeft ? "│   " : "    " ), node->lhand.get(), true );
-#pragma warning( suppress : 4566 )
-        print_binary_tree ( prefix + ( isLeft ? "│   " : "    " ), node->rhand.get(), false );
+        prefix += ( entry.is_left ? "│   " : "    " );
+        worklist.push_back ( { entry.node->rhand.get(), prefix.size(), false } );
+        worklist.push_back ( { entry.node->lhand.get(), prefix.size(), true } );
     }
-} //NOLINTEND(misc-no-recursion)
+}
 
 auto Parser::print_binary_tree ( const AST* node ) -> void
 {
-    print_binary_tree ( "", node, false );
+    print_binary_tree ( node, std::cout );
     std::cout << '\n';
 }
 
 Parser::Parser ( std::unique_ptr<Lexer>&& lexer )
     : m_lexer ( std::move ( lexer ) )
-    , m_current_token ( m_lexer->get_next_token() )
 {
+    next_token();
 }
 
 Parser::Parser ( const std::string& input )
     : m_lexer ( std::make_unique<Lexer> ( input ) )
-    , m_current_token ( m_lexer->get_next_token() )
 {
+    next_token();
 }
 
-auto Parser::eat ( TOKEN_TYPE token ) -> void
+Parser::Parser ( std::unique_ptr<Lexer>&& lexer, std::pmr::memory_resource* nodes )
+    : m_lexer ( std::move ( lexer ) )
+    , m_nodes ( nodes )
 {
-    if ( this->m_current_token->get_type() == token )
+    next_token();
+}
+
+auto Parser::reset ( std::string_view input ) -> void
+{
+    // the old tree goes back to the node storage before the new one is built
+    m_root = nullptr;
+    m_spine.clear();
+    m_spine_start = 0;
+    m_conditions.clear();
+    m_condition_start = 0;
+    m_calls.clear();
+    m_parenthesis_level = 0;
+    m_negative_sign     = false;
+    m_error             = std::nullopt;
+    m_lexer->reset ( input );
+    next_token();
+}
+
+template <typename... Args>
+auto Parser::make_node ( Args&&... args ) const -> std::shared_ptr<AST>
+{
+    if ( m_nodes == nullptr ) { return std::make_shared<AST> ( std::forward<Args> ( args )... ); }
+    return std::allocate_shared<AST> ( std::pmr::polymorphic_allocator<AST> ( m_nodes ), std::forward<Args> ( args )... );
+}
+
+auto Parser::next_token() -> Result<void>
+{
+    auto token = this->m_lexer->try_next_token ( *this->m_current_token );
+    if ( !token )
     {
-        this->m_current_token = this->m_lexer->get_next_token();
-        return;
+        // the error is reported by try_parse(), until then the Parser behaves as if the input ended
+        this->m_current_token->assign ( TOKEN_TYPE::TOKEN_EOF, "" );
+        this->m_error = token.error();
+        return std::unexpected ( token.error() );
     }
+    return {};
+}
+
+auto Parser::error ( ERROR_CODE code, TOKEN_TYPE expected ) const -> std::unexpected<Error>
+{
+    const auto position = this->m_lexer->get_position();
+    return std::unexpected ( Error { code, position > 0 ? position - 1 : 0, this->m_current_token->get_type(), expected } );
+}
 
-    throw std::runtime_error (
-        m_lexer->error_string ( std::format ( "Unexpected token: '{}'\nIs {}\tShould be {}\n",
-                                              this->m_current_token->get_value(),
-                                              pfme::token_type_to_string ( this->m_current_token->get_type() ),
-                                              token_type_to_string ( token ) ),
-                                -1 ) );
+auto Parser::eat ( TOKEN_TYPE token ) -> Result<void>
+{
+    if ( this->m_current_token->get_type() == token ) { return next_token(); }
+    return error ( ERROR_CODE::UNEXPECTED_TOKEN, token );
 }
 
 auto Parser::parse() -> std::shared_ptr<AST>
 {
+    auto root = try_parse();
+    if ( !root ) { throw std::runtime_error ( root.error().message ( this->m_lexer->get_content() ) ); }
+    return *root;
+}
+
+auto Parser::try_parse() -> Result<std::shared_ptr<AST>>
+{
+    if ( this->m_error ) { return std::unexpected ( *this->m_error ); }
+    const trace::Scope scope ( trace::STAGE::PARSE );
     while ( this->m_current_token->get_type() != TOKEN_TYPE::TOKEN_EOF )
     {
+        Result<void> step {};
         switch ( this->m_current_token->get_type() )
         {
         case TOKEN_TYPE::TOKEN_L_PAREN:
             ++this->m_parenthesis_level;
-            eat ( TOKEN_TYPE::TOKEN_L_PAREN );
+            step = check_depth();
+            if ( step ) { step = eat ( TOKEN_TYPE::TOKEN_L_PAREN ); }
+            break;
+        case TOKEN_TYPE::TOKEN_SUBTRACTION: m_negative_sign = true; [[fallthrough]];
+        case TOKEN_TYPE::TOKEN_ADDITION:
+            step = eat ( this->m_current_token->get_type() );
+            if ( step ) { step = parse_expression(); }
             break;
-        case TOKEN_TYPE::TOKEN_SUBTRACTION: m_negative_sign = true;
-        case TOKEN_TYPE::TOKEN_ADDITION: eat ( this->m_current_token->get_type() );
         case TOKEN_TYPE::TOKEN_INTEGER: [[fallthrough]];
-        case TOKEN_TYPE::TOKEN_FLOAT: parse_expression(); break;
-        default:
-            throw std::runtime_error (
-                m_lexer->error_string ( std::format ( "Invalid Token '{}' in expression\nShould be {}, {} or {}",
-                                                      pfme::token_type_to_string ( this->m_current_token->get_type() ),
-                                                      token_type_to_string ( TOKEN_TYPE::TOKEN_L_PAREN ),
-                                                      token_type_to_string ( TOKEN_TYPE::TOKEN_INTEGER ),
-                                                      token_type_to_string ( TOKEN_TYPE::TOKEN_FLOAT ) ),
-                                        -1 ) );
+        case TOKEN_TYPE::TOKEN_FLOAT: [[fallthrough]];
+        case TOKEN_TYPE::TOKEN_IDENTIFIER: step = parse_expression(); break;
+        default: step = error ( ERROR_CODE::INVALID_TOKEN ); break;
         }
+        if ( !step ) { return std::unexpected ( step.error() ); }
+    }
+    if ( this->m_error ) { return std::unexpected ( *this->m_error ); }
+    // like all other parentheses the ones of function calls do not have to be closed, unlike the ones of a '?'
+    while ( !this->m_calls.empty() )
+    {
+        auto function = close_call();
+        if ( !function ) { return std::unexpected ( function.error() ); }
+        attach ( std::move ( *function ) );
+    }
+    if ( !this->m_conditions.empty() ) { return error ( ERROR_CODE::UNEXPECTED_TOKEN, TOKEN_TYPE::TOKEN_ALTERNATIVE ); }
+    if ( this->m_root == nullptr ) { return std::unexpected ( Error { ERROR_CODE::EMPTY_EXPRESSION } ); }
+    if ( !spine_empty() && this->m_spine.back()->rhand == nullptr )
+    {
+        this->m_spine.back()->rhand = make_node ( 0LL );
     }
-    auto bot = find_bottom ( this->m_root );
-    if ( bot != nullptr ) { bot->rhand = std::make_shared<AST> ( AST_TYPE::INTEGER, "0" ); }
 
     return this->m_root;
 }
 
-auto Parser::parse_expression() -> void
+auto Parser::parse_expression() -> Result<void>
 {
-    std::shared_ptr<AST> number (
-        new AST ( TOKEN_TYPE::TOKEN_INTEGER == m_current_token->get_type() ? AST_TYPE::INTEGER : AST_TYPE::FLOAT,
-                  m_current_token->get_value().insert ( 0, ( m_negative_sign ? "-" : "" ) ) ) );
+    const auto type = m_current_token->get_type();
+    if ( type == TOKEN_TYPE::TOKEN_IDENTIFIER ) { return parse_name(); }
+    if ( type != TOKEN_TYPE::TOKEN_INTEGER && type != TOKEN_TYPE::TOKEN_FLOAT ) { return error ( ERROR_CODE::INVALID_TOKEN ); }
+    // the Lexer already converted the number, only the sign is left
+    std::shared_ptr<AST> number;
+    if ( const auto* magnitude = std::get_if<std::uint64_t> ( &m_current_token->get_number() ) )
+    {
+        if ( !m_negative_sign && *magnitude > static_cast<std::uint64_t> ( std::numeric_limits<LLI>::max() ) )
+        {
+            return error ( ERROR_CODE::NUMBER_OUT_OF_RANGE );
+        }
+        number = make_node ( static_cast<LLI> ( m_negative_sign ? 0 - *magnitude : *magnitude ) );
+    }
+    else if ( const auto* decimal = std::get_if<Decimal> ( &m_current_token->get_number() ) )
+    {
+        number = make_node ( m_negative_sign ? -*decimal : *decimal );
+    }
+    else
+    {
+        const auto value = std::get<long double> ( m_current_token->get_number() );
+        number           = make_node ( m_negative_sign ? -value : value );
+    }
     m_negative_sign = false;
 
-    eat ( m_current_token->get_type() );
+    if ( auto eaten = eat ( type ); !eaten ) { return eaten; }
+    return parse_operation ( std::move ( number ) );
+}
+
+auto Parser::parse_operation ( std::shared_ptr<AST> operand ) -> Result<void>
+{
     // special case ')' -> eat token (get next token)
     while ( m_current_token->get_type() == TOKEN_TYPE::TOKEN_R_PAREN )
     {
-        --m_parenthesis_level;
-        eat ( m_current_token->get_type() );
+        // the parenthesis the '?' opened can only be closed by its ':'
+        if ( condition_open() ) { return error ( ERROR_CODE::UNEXPECTED_TOKEN, TOKEN_TYPE::TOKEN_ALTERNATIVE ); }
+        if ( m_parenthesis_level == 0 && !m_calls.empty() )
+        {
+            // the parenthesis of the call itself, the call becomes the operand
+            attach ( std::move ( operand ) );
+            auto function = close_call();
+            if ( !function ) { return std::unexpected ( function.error() ); }
+            operand = std::move ( *function );
+        }
+        else { --m_parenthesis_level; }
+        if ( auto eaten = eat ( m_current_token->get_type() ); !eaten ) { return eaten; }
     }
-    const std::shared_ptr<AST> operation ( new AST ( std::move ( number ) ) );
-    operation->m_operation_level += m_parenthesis_level * 3;
+    const auto operation = make_node ( std::move ( operand ) );
+    auto       level     = OPERATION_LEVEL::ADDITIVE;
     switch ( m_current_token->get_type() )
     {
     case TOKEN_TYPE::TOKEN_MULTIPLICATION:
         operation->m_type  = AST_TYPE::MULTIPLICATION;
         operation->m_value = "*";
-        ++operation->m_operation_level;
+        level              = OPERATION_LEVEL::MULTIPLICATIVE;
         break;
     case TOKEN_TYPE::TOKEN_DIVISION:
         operation->m_type  = AST_TYPE::DIVISION;
         operation->m_value = "/";
-        ++operation->m_operation_level;
+        level              = OPERATION_LEVEL::MULTIPLICATIVE;
         break;
     case TOKEN_TYPE::TOKEN_ADDITION:
         operation->m_type  = AST_TYPE::ADDITION;
@@ -125,27 +238,185 @@ auto Parser::parse_expression() -> void
     case TOKEN_TYPE::TOKEN_EXPONENTIATION:
         operation->m_type  = AST_TYPE::EXPONENTIATION;
         operation->m_value = "^";
-        operation->m_operation_level += 2;
+        level              = OPERATION_LEVEL::EXPONENTIAL;
+        break;
+    case TOKEN_TYPE::TOKEN_LESS:
+        operation->m_type  = AST_TYPE::LESS;
+        operation->m_value = "<";
+        level              = OPERATION_LEVEL::RELATIONAL;
+        break;
+    case TOKEN_TYPE::TOKEN_LESS_EQUAL:
+        operation->m_type  = AST_TYPE::LESS_EQUAL;
+        operation->m_value = "<=";
+        level              = OPERATION_LEVEL::RELATIONAL;
+        break;
+    case TOKEN_TYPE::TOKEN_GREATER:
+        operation->m_type  = AST_TYPE::GREATER;
+        operation->m_value = ">";
+        level              = OPERATION_LEVEL::RELATIONAL;
+        break;
+    case TOKEN_TYPE::TOKEN_GREATER_EQUAL:
+        operation->m_type  = AST_TYPE::GREATER_EQUAL;
+        operation->m_value = ">=";
+        level              = OPERATION_LEVEL::RELATIONAL;
+        break;
+    case TOKEN_TYPE::TOKEN_EQUAL:
+        operation->m_type  = AST_TYPE::EQUAL;
+        operation->m_value = "==";
+        level              = OPERATION_LEVEL::EQUALITY;
+        break;
+    case TOKEN_TYPE::TOKEN_NOT_EQUAL:
+        operation->m_type  = AST_TYPE::NOT_EQUAL;
+        operation->m_value = "!=";
+        level              = OPERATION_LEVEL::EQUALITY;
         break;
+    case TOKEN_TYPE::TOKEN_AND:
+        operation->m_type  = AST_TYPE::AND;
+        operation->m_value = "&&";
+        level              = OPERATION_LEVEL::AND;
+        break;
+    case TOKEN_TYPE::TOKEN_OR:
+        operation->m_type  = AST_TYPE::OR;
+        operation->m_value = "||";
+        level              = OPERATION_LEVEL::OR;
+        break;
+    case TOKEN_TYPE::TOKEN_CONDITION:
+        operation->m_type  = AST_TYPE::CONDITION;
+        operation->m_value = "?";
+        level              = OPERATION_LEVEL::CONDITIONAL;
+        break;
+    case TOKEN_TYPE::TOKEN_ALTERNATIVE:
+        if ( !condition_open() ) { return error ( ERROR_CODE::INVALID_OPERATOR ); }
+        m_conditions.pop_back();
+        --m_parenthesis_level;
+        operation->m_type  = AST_TYPE::ALTERNATIVE;
+        operation->m_value = ":";
+        level              = OPERATION_LEVEL::CONDITIONAL;
+        break;
+    case TOKEN_TYPE::TOKEN_COMMA:
+        if ( m_calls.empty() || m_parenthesis_level != 0 ) { return error ( ERROR_CODE::INVALID_OPERATOR ); }
+        attach ( std::move ( operation->lhand ) );
+        if ( auto added = add_argument(); !added ) { return added; }
+        return eat ( TOKEN_TYPE::TOKEN_COMMA );
     case TOKEN_TYPE::TOKEN_EOF:
-        // if m_root is empty (happens if the input is only one number) set m_root to the one know operation
-        if ( this->m_root == nullptr ) { this->m_root = std::move ( operation->lhand ); }
-        // otherwise when the end is reached, add the last number to the (theoretically) last empty slot
-        else { find_bottom ( this->m_root )->rhand = std::move ( operation->lhand ); }
-        return;
-    default:
-        throw std::runtime_error (
-            m_lexer->error_string ( std::format ( "Invalid Token '{}' in expression\nShould be {}, {}, {}, {} or {}",
-                                                  pfme::token_type_to_string ( m_current_token->get_type() ),
-                                                  token_type_to_string ( TOKEN_TYPE::TOKEN_MULTIPLICATION ),
-                                                  token_type_to_string ( TOKEN_TYPE::TOKEN_DIVISION ),
-                                                  token_type_to_string ( TOKEN_TYPE::TOKEN_ADDITION ),
-                                                  token_type_to_string ( TOKEN_TYPE::TOKEN_SUBTRACTION ),
-                                                  token_type_to_string ( TOKEN_TYPE::TOKEN_EXPONENTIATION ) ),
-                                    -1 ) );
+        // when the end is reached, add the last number to the (theoretically) last empty slot
+        attach ( std::move ( operation->lhand ) );
+        return {};
+    default: return error ( ERROR_CODE::INVALID_OPERATOR );
     }
+    operation->m_operation_level = operation_level ( level, m_parenthesis_level );
     add_operation ( operation );
-    eat ( m_current_token->get_type() );
+    if ( auto checked = check_depth(); !checked ) { return checked; }
+    // everything up to the ':' is the first result, as if it was in parentheses
+    if ( operation->m_type == AST_TYPE::CONDITION ) { m_conditions.push_back ( ++m_parenthesis_level ); }
+    return eat ( m_current_token->get_type() );
+}
+
+auto Parser::attach ( std::shared_ptr<AST> operand ) -> void
+{
+    // if m_root is empty (happens if the input is only one number) set m_root to the one know operand
+    if ( this->m_root == nullptr ) { this->m_root = std::move ( operand ); }
+    else { this->m_spine.back()->rhand = std::move ( operand ); }
+}
+
+auto Parser::parse_name() -> Result<void>
+{
+    // only known after the name, but an unknown function is reported at the name
+    const auto unknown = error ( ERROR_CODE::UNKNOWN_FUNCTION );
+    auto       node    = make_node ( AST_TYPE::VARIABLE, m_current_token->get_value() );
+    if ( auto eaten = eat ( TOKEN_TYPE::TOKEN_IDENTIFIER ); !eaten ) { return eaten; }
+    // the names of functions are reserved, open_call() reports a missing '('
+    const auto id = FunctionRegistry::global().find ( node->m_value );
+    if ( id || m_current_token->get_type() == TOKEN_TYPE::TOKEN_L_PAREN )
+    {
+        if ( !id ) { return unknown; }
+        node->m_type     = AST_TYPE::FUNCTION;
+        node->m_function = *id;
+        return open_call ( std::move ( node ) );
+    }
+
+    if ( std::exchange ( m_negative_sign, false ) ) { node = negate ( std::move ( node ) ); }
+    return parse_operation ( std::move ( node ) );
+}
+
+auto Parser::negate ( std::shared_ptr<AST> operand ) const -> std::shared_ptr<AST>
+{
+    // -x is stored as -1 * x, which is exact for every type
+    auto negated     = make_node ( make_node ( -1LL ) );
+    negated->m_type  = AST_TYPE::MULTIPLICATION;
+    negated->m_value = "*";
+    negated->rhand   = std::move ( operand );
+    return negated;
+}
+
+auto Parser::open_call ( std::shared_ptr<AST> function ) -> Result<void>
+{
+    if ( auto eaten = eat ( TOKEN_TYPE::TOKEN_L_PAREN ); !eaten ) { return eaten; }
+
+    // the arguments start with an empty expression, the one around the call waits on the stack
+    auto* last = function.get();
+    m_calls.push_back ( { std::move ( m_root ),
+                          m_spine_start,
+                          m_condition_start,
+                          m_parenthesis_level,
+                          m_negative_sign,
+                          std::move ( function ),
+                          last,
+                          0 } );
+    m_root              = nullptr;
+    m_spine_start       = m_spine.size();
+    m_condition_start   = m_conditions.size();
+    m_parenthesis_level = 0;
+    m_negative_sign     = false;
+    return check_depth();
+}
+
+auto Parser::add_argument() -> Result<void>
+{
+    if ( m_root == nullptr ) { return std::unexpected ( Error { ERROR_CODE::EMPTY_EXPRESSION } ); }
+    if ( m_conditions.size() > m_condition_start )
+    {
+        return error ( ERROR_CODE::UNEXPECTED_TOKEN, TOKEN_TYPE::TOKEN_ALTERNATIVE );
+    }
+    if ( !spine_empty() && m_spine.back()->rhand == nullptr ) { m_spine.back()->rhand = make_node ( 0LL ); }
+
+    auto& call = m_calls.back();
+    if ( call.m_argument_count == 0 ) { call.m_function->lhand = std::move ( m_root ); }
+    else
+    {
+        auto argument             = make_node ( std::move ( m_root ) );
+        argument->m_type          = AST_TYPE::ARGUMENT;
+        argument->m_value         = ",";
+        call.m_last_argument->rhand = argument;
+        call.m_last_argument        = argument.get();
+    }
+    ++call.m_argument_count;
+    m_root              = nullptr;
+    m_spine.resize ( m_spine_start );
+    m_parenthesis_level = 0;
+    return {};
+}
+
+auto Parser::close_call() -> Result<std::shared_ptr<AST>>
+{
+    if ( auto added = add_argument(); !added ) { return std::unexpected ( added.error() ); }
+
+    const auto& function = FunctionRegistry::global().get ( m_calls.back().m_function->m_function );
+    const auto  count    = m_calls.back().m_argument_count;
+    if ( count < function.m_min_arguments || count > function.m_max_arguments ) { return error ( ERROR_CODE::ARGUMENT_COUNT ); }
+    // the index of sum and prod is a name, not a value
+    if ( is_range ( m_calls.back().m_function->m_function ) && m_calls.back().m_function->lhand->m_type != AST_TYPE::VARIABLE )
+    {
+        return error ( ERROR_CODE::UNEXPECTED_TOKEN, TOKEN_TYPE::TOKEN_IDENTIFIER );
+    }
+    auto call = std::move ( m_calls.back() );
+    m_calls.pop_back();
+    m_root              = std::move ( call.m_root );
+    m_spine_start       = call.m_spine_start;
+    m_condition_start   = call.m_condition_start;
+    m_parenthesis_level = call.m_parenthesis_level;
+    if ( !call.m_negative_sign ) { return std::move ( call.m_function ); }
+    return negate ( std::move ( call.m_function ) );
 }
 
 auto Parser::add_operation ( const std::shared_ptr<AST>& operation ) -> void
@@ -153,75 +424,51 @@ auto Parser::add_operation ( const std::shared_ptr<AST>& operation ) -> void
     if ( this->m_root == nullptr )
     {
         this->m_root = operation;
+        this->m_spine.push_back ( operation.get() );
         return;
     }
-    auto bottom = find_bottom ( this->m_root );
-    if ( bottom->m_operation_level <= operation->m_operation_level ) { bottom->rhand = operation; }
+    constexpr int LEVELS = static_cast<int> ( OPERATION_LEVEL::COUNT );
+    // comparisons chain to the left like in C, 1 < 2 < 3 is (1 < 2) < 3, the other operations chain to the right
+    const auto level  = static_cast<OPERATION_LEVEL> ( operation->m_operation_level % LEVELS );
+    const int  left   = level == OPERATION_LEVEL::EQUALITY || level == OPERATION_LEVEL::RELATIONAL ? 1 : 0;
+    auto*      bottom = this->m_spine.back();
+    if ( bottom->m_operation_level + left <= operation->m_operation_level ) { bottom->rhand = operation; }
     else
     {
         // case 5 * 1 + [...]
         //               +
         //   *     +    / \
-		//  /  +  / =  *  [...]
+        //  /  +  / =  *  [...]
         // 5     1    / \
-		//           5   1
+        //           5   1
         bottom->rhand = std::move ( operation->lhand );
-        if ( !bottom->lhand->is_num() ) { std::swap ( bottom->rhand, bottom->lhand ); }
-        auto node = bottom;
 
-        while ( node != nullptr )
+        // the levels on the spine never decrease, so the new operation belongs below the last one that is not higher
+        while ( !spine_empty() && this->m_spine.back()->m_operation_level + left > operation->m_operation_level )
         {
-            if ( node->m_operation_level <= operation->m_operation_level ) { break; }
-            node = find_parent ( this->m_root, node );
+            this->m_spine.pop_back();
         }
-        if ( node == nullptr )
+        if ( spine_empty() )
         {
-            auto head           = this->m_root;
-            this->m_root        = operation;
-            this->m_root->lhand = head;
+            operation->lhand = std::move ( this->m_root );
+            this->m_root     = operation;
         }
         else
         {
-            operation->lhand = node->rhand;
+            auto* node       = this->m_spine.back();
+            operation->lhand = std::move ( node->rhand );
             node->rhand      = operation;
         }
     }
+    this->m_spine.push_back ( operation.get() );
 }
 
-// recursively search through the tree for the first free position (left before right)
-//NOLINTBEGIN(misc-no-recursion)
-auto Parser::find_bottom ( std::shared_ptr<AST> start ) -> std::shared_ptr<AST>
+auto Parser::check_depth() const -> Result<void>
 {
-    if ( start->m_type == AST_TYPE::INTEGER || start->m_type == AST_TYPE::FLOAT ) { return nullptr; }
-
-    if ( start->rhand == nullptr ) { return start; }
-
-    if ( start->lhand->m_type == AST_TYPE::INTEGER || start->lhand->m_type == AST_TYPE::FLOAT )
-    {
-        if ( start->rhand->m_type == AST_TYPE::INTEGER || start->rhand->m_type == AST_TYPE::FLOAT ) { return nullptr; }
-    }
-    else if ( !start->rhand->is_num() )
-    {
-        auto position = find_bottom ( start->lhand );
-        if ( position != nullptr ) { return position; }
-    }
-    return find_bottom ( start->rhand );
+    // the parentheses of the calls around are not counted, the calls themselves are
+    const auto open  = static_cast<std::size_t> ( std::max ( this->m_parenthesis_level, 0 ) );
+    const auto depth = this->m_spine.size() + this->m_calls.size() + open;
+    if ( depth > this->m_lexer->get_limits().m_depth ) { return error ( ERROR_CODE::LIMIT_EXCEEDED ); }
+    return {};
 }
-
-// NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
-auto Parser::find_parent ( std::shared_ptr<AST> start, const std::shared_ptr<AST>& bottom ) -> std::shared_ptr<AST>
-{
-    if ( start->lhand == bottom || start->rhand == bottom ) { return start; }
-    if ( start == bottom ) { return nullptr; }
-
-    if ( start->lhand->m_type == AST_TYPE::INTEGER || start->lhand->m_type == AST_TYPE::FLOAT )
-    {
-        if ( start->rhand->m_type == AST_TYPE::INTEGER || start->rhand->m_type == AST_TYPE::FLOAT ) { return nullptr; }
-        return find_parent ( start->rhand, bottom );
-    }
-    auto position = find_parent ( start->lhand, bottom );
-    if ( position != nullptr ) { return position; }
-    return find_parent ( start->rhand, bottom );
-
-} //NOLINTEND(misc-no-recursion)
-} // namespace pfme
\ No newline at end of file
+} // namespace pfme
@@ -0,0 +1,239 @@
+#include "Range.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <optional>
+#include <pfme/Compiled.hpp>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace pfme
+{
+namespace
+{
+constexpr std::size_t MIN_CHUNK = std::size_t { 1 } << 14U; // fewer terms are not worth a thread of their own
+constexpr std::size_t BLOCK     = 256;                     // terms evaluated at once by the batch of a float range
+constexpr std::size_t LANES     = 4;                       // independent accumulators, a vector of doubles
+
+using time_point = std::chrono::steady_clock::time_point;
+
+// time_point::max() is no deadline, then the clock is never read
+auto expired ( time_point deadline ) -> bool
+{
+    return deadline != time_point::max() && std::chrono::steady_clock::now() > deadline;
+}
+
+template <std::floating_point Float>
+auto to_index ( const basic_num_t<Float>& bound ) -> std::optional<LLI>
+{
+    if ( const auto* integer = std::get_if<LLI> ( &bound ) ) { return *integer; }
+    if ( const auto* decimal = std::get_if<Decimal> ( &bound ); decimal != nullptr && decimal->is_whole() )
+    {
+        return decimal->mantissa();
+    }
+    return std::nullopt;
+}
+
+// the index of term number offset, the difference of the bounds always fits into 64 bits
+auto index_at ( LLI first, std::uint64_t offset ) -> LLI
+{
+    return static_cast<LLI> ( static_cast<std::uint64_t> ( first ) + offset );
+}
+
+// every term with the exact arithmetic, in the order of the index, the clock is read once per BLOCK terms
+template <std::floating_point Float>
+auto reduce_exact ( const CompiledExpression& term,
+                    AST_TYPE                  operation,
+                    LLI                       first,
+                    std::uint64_t             count,
+                    const DecimalContext&     context,
+                    time_point                deadline ) -> Result<basic_num_t<Float>>
+{
+    auto&                             evaluation = basic_evaluation_context<Float>::local();
+    basic_num_t<Float>                result     = LLI { operation == AST_TYPE::MULTIPLICATION };
+    std::array<basic_num_t<Float>, 1> index {};
+    for ( std::uint64_t i = 0; i < count; ++i )
+    {
+        if ( i % BLOCK == 0 && expired ( deadline ) ) { return std::unexpected ( Error { ERROR_CODE::LIMIT_EXCEEDED } ); }
+        index[0]   = index_at ( first, i );
+        auto value = term.evaluate<Float> ( evaluation, index, context );
+        if ( !value ) { return std::unexpected ( value.error() ); }
+        auto combined = apply_operation<Float> ( operation, result, *value, context );
+        if ( !combined ) { return std::unexpected ( Error { combined.error() } ); }
+        result = std::move ( *combined );
+    }
+    return result;
+}
+
+// the terms in blocks of Float, a row that is not finite is evaluated again on its own, so a term outside of the domain
+// of a function or a division by zero is the same error as in reduce_exact, not a NaN or inf in the result
+template <std::floating_point Float>
+auto reduce_float ( const CompiledExpression& term,
+                    AST_TYPE                  operation,
+                    LLI                       first,
+                    std::uint64_t             count,
+                    time_point                deadline ) -> Result<Float>
+{
+    auto&                             evaluation = basic_evaluation_context<Float>::local();
+    const bool                        sum        = operation == AST_TYPE::ADDITION;
+    const Float                       neutral    = sum ? 0 : 1;
+    std::array<Float, BLOCK>          indices {};
+    std::array<Float, BLOCK>          values {};
+    std::array<Float, LANES>          lanes {};
+    std::array<basic_num_t<Float>, 1> index {};
+    const auto                        variables = term.get_variables().size();
+    lanes.fill ( neutral );
+    for ( std::uint64_t done = 0; done < count; done += BLOCK )
+    {
+        if ( expired ( deadline ) ) { return std::unexpected ( Error { ERROR_CODE::LIMIT_EXCEEDED } ); }
+        const auto size = static_cast<std::size_t> ( std::min<std::uint64_t> ( BLOCK, count - done ) );
+        for ( std::size_t row = 0; row < size; ++row ) { indices[row] = static_cast<Float> ( index_at ( first, done + row ) ); }
+        const std::array<std::span<const Float>, 1> columns { std::span<const Float> ( indices.data(), size ) };
+        const std::span block ( values.data(), size );
+        term.evaluate_batch<Float> ( evaluation, std::span ( columns ).first ( variables ), block );
+        if ( !std::ranges::all_of ( block, [] ( Float value ) { return std::isfinite ( value ); } ) )
+        {
+            for ( std::size_t row = 0; row < size; ++row )
+            {
+                if ( std::isfinite ( values[row] ) ) { continue; }
+                index[0]         = index_at ( first, done + row );
+                const auto value = term.evaluate<Float> ( evaluation, index );
+                if ( !value ) { return std::unexpected ( value.error() ); }
+            }
+        }
+
+        // every lane keeps its own order, so the loop vectorizes without reassociating a single lane
+        std::size_t row = 0;
+        for ( ; row + LANES <= size; row += LANES )
+        {
+            for ( std::size_t lane = 0; lane < LANES; ++lane )
+            {
+                lanes[lane] = sum ? lanes[lane] + values[row + lane] : lanes[lane] * values[row + lane];
+            }
+        }
+        for ( ; row < size; ++row ) { lanes[0] = sum ? lanes[0] + values[row] : lanes[0] * values[row]; }
+    }
+    return sum ? ( lanes[0] + lanes[1] ) + ( lanes[2] + lanes[3] ) : ( lanes[0] * lanes[1] ) * ( lanes[2] * lanes[3] );
+}
+
+// the n-th argument of a call, counted from 0
+auto argument ( const AST& call, std::size_t n ) -> const AST*
+{
+    if ( n == 0 ) { return call.lhand.get(); }
+    const AST* chain = call.rhand.get();
+    for ( ; n > 1; --n ) { chain = chain->rhand.get(); }
+    return chain->lhand.get();
+}
+} // namespace
+
+template <std::floating_point Float>
+auto range_size ( const basic_num_t<Float>& first, const basic_num_t<Float>& last ) -> Result<std::uint64_t>
+{
+    const auto begin = to_index<Float> ( first );
+    const auto end   = to_index<Float> ( last );
+    if ( !begin || !end ) { return std::unexpected ( Error { ERROR_CODE::DOMAIN_ERROR } ); }
+    if ( *end < *begin ) { return 0; }
+    // the difference wraps around to 0 for the whole range of LLI
+    if ( *begin == std::numeric_limits<LLI>::min() && *end == std::numeric_limits<LLI>::max() )
+    {
+        return std::unexpected ( Error { ERROR_CODE::LIMIT_EXCEEDED } );
+    }
+    return static_cast<std::uint64_t> ( *end ) - static_cast<std::uint64_t> ( *begin ) + 1;
+}
+
+template <std::floating_point Float>
+auto reduce_range ( const AST&                call,
+                    const basic_num_t<Float>& first,
+                    const basic_num_t<Float>& last,
+                    const DecimalContext&     context,
+                    time_point                deadline ) -> Result<basic_num_t<Float>>
+{
+    const bool sum       = call.m_function == static_cast<std::uint32_t> ( FUNCTION::SUM );
+    const auto operation = sum ? AST_TYPE::ADDITION : AST_TYPE::MULTIPLICATION;
+    const auto count     = range_size<Float> ( first, last );
+    if ( !count ) { return std::unexpected ( count.error() ); }
+    if ( *count == 0 ) { return basic_num_t<Float> { LLI { operation == AST_TYPE::MULTIPLICATION } }; }
+
+    // a range inside the term would need the Visitor again
+    std::vector<std::string> variables;
+    const auto               term_nodes = flatten ( argument ( call, 3 ), variables );
+    if ( contains_range ( term_nodes ) ) { return std::unexpected ( Error { ERROR_CODE::UNSUPPORTED_RANGE } ); }
+    const CompiledExpression term ( term_nodes );
+    if ( variables.size() > 1 || ( variables.size() == 1 && variables[0] != argument ( call, 0 )->m_value ) )
+    {
+        return std::unexpected ( Error { ERROR_CODE::UNBOUND_VARIABLE } );
+    }
+
+    auto&                                   evaluation = basic_evaluation_context<Float>::local();
+    const auto                              begin      = *to_index<Float> ( first );
+    const std::array<basic_num_t<Float>, 1> index { basic_num_t<Float> { begin } };
+    const auto                              head = term.evaluate<Float> ( evaluation, index, context );
+    if ( !head ) { return std::unexpected ( head.error() ); }
+
+    // the first term decides, exact terms stay exact and a sum or product that does not fit is out of range like the
+    // written out expression, float terms are computed in blocks
+    const bool floating = std::holds_alternative<Float> ( *head );
+    const auto chunks   = static_cast<std::size_t> (
+        std::clamp<std::uint64_t> ( *count / MIN_CHUNK, 1, std::max ( std::thread::hardware_concurrency(), 1U ) ) );
+    std::vector<Result<basic_num_t<Float>>> partials ( chunks, basic_num_t<Float> { LLI { 0 } } );
+    const auto                              reduce_chunk = [&] ( std::size_t chunk )
+    {
+        const auto start = *count / chunks * chunk;
+        const auto size  = chunk + 1 == chunks ? *count - start : *count / chunks;
+        // an exception can not leave a thread, the exact arithmetic only throws where a number does not fit
+        try
+        {
+            if ( !floating )
+            {
+                partials[chunk] = reduce_exact<Float> ( term, operation, index_at ( begin, start ), size, context, deadline );
+            }
+            else if ( auto reduced = reduce_float<Float> ( term, operation, index_at ( begin, start ), size, deadline ) )
+            {
+                partials[chunk] = basic_num_t<Float> { *reduced };
+            }
+            else { partials[chunk] = std::unexpected ( reduced.error() ); }
+        }
+        catch ( const std::exception& )
+        {
+            partials[chunk] = std::unexpected ( Error { ERROR_CODE::NUMBER_OUT_OF_RANGE } );
+        }
+    };
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve ( chunks - 1 );
+        for ( std::size_t chunk = 1; chunk < chunks; ++chunk ) { threads.emplace_back ( reduce_chunk, chunk ); }
+        reduce_chunk ( 0 );
+    }
+
+    // the chunks are combined in the order of the index, so the error of the first failing term is reported
+    auto result = std::move ( partials[0] );
+    for ( std::size_t chunk = 1; chunk < chunks && result; ++chunk )
+    {
+        if ( !partials[chunk] ) { return std::unexpected ( partials[chunk].error() ); }
+        auto combined = apply_operation<Float> ( operation, *result, *partials[chunk], context );
+        if ( !combined ) { return std::unexpected ( Error { combined.error() } ); }
+        result = std::move ( *combined );
+    }
+    return result;
+}
+
+template auto range_size<float> ( const basic_num_t<float>&, const basic_num_t<float>& ) -> Result<std::uint64_t>;
+template auto range_size<double> ( const basic_num_t<double>&, const basic_num_t<double>& ) -> Result<std::uint64_t>;
+template auto range_size<LD> ( const basic_num_t<LD>&, const basic_num_t<LD>& ) -> Result<std::uint64_t>;
+template auto reduce_range<float> ( const AST&,
+                                    const basic_num_t<float>&,
+                                    const basic_num_t<float>&,
+                                    const DecimalContext&,
+                                    time_point ) -> Result<basic_num_t<float>>;
+template auto reduce_range<double> ( const AST&,
+                                     const basic_num_t<double>&,
+                                     const basic_num_t<double>&,
+                                     const DecimalContext&,
+                                     time_point ) -> Result<basic_num_t<double>>;
+template auto reduce_range<LD> ( const AST&, const basic_num_t<LD>&, const basic_num_t<LD>&, const DecimalContext&, time_point )
+    -> Result<basic_num_t<LD>>;
+} // namespace pfme
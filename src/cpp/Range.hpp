@@ -0,0 +1,64 @@
+#pragma once
+// The sum and prod ranges of the Visitor, not part of the public headers.
+
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <pfme/AST.hpp>
+#include <pfme/Error.hpp>
+#include <pfme/Functions.hpp>
+#include <pfme/Serialization.hpp>
+#include <span>
+
+namespace pfme
+{
+// sum(i, first, last, term) and prod(i, first, last, term) are not called like other functions
+inline auto is_range ( std::uint32_t function ) -> bool
+{
+    return function == static_cast<std::uint32_t> ( FUNCTION::SUM ) ||
+           function == static_cast<std::uint32_t> ( FUNCTION::PROD );
+}
+
+// whether the flat nodes of an expression contain a range, a CompiledExpression can not evaluate those
+inline auto contains_range ( std::span<const BinaryNode> nodes ) -> bool
+{
+    return std::ranges::any_of ( nodes,
+                                 [] ( const BinaryNode& node )
+                                 { return node.get_type() == AST_TYPE::FUNCTION && is_range ( node.m_extra ); } );
+}
+
+/**
+ * The number of terms of a range.
+ * @param first is the value of the first index, an integer or a whole decimal
+ * @param last is the value of the last index
+ * @return The number of terms, 0 if last is smaller than first, ERROR_CODE::DOMAIN_ERROR if a bound is not a whole
+ * number and ERROR_CODE::LIMIT_EXCEEDED if the range has every one of the 2^64 indices, which do not fit into the count
+ */
+template <std::floating_point Float>
+auto range_size ( const basic_num_t<Float>& first, const basic_num_t<Float>& last ) -> Result<std::uint64_t>;
+
+/**
+ * Reduces the terms of a range, the bounds are already evaluated.
+ * The term is compiled once and evaluated for every index, the index is its only variable. Large ranges are split into
+ * one chunk per core. If the first term is exact every term is evaluated and combined with the exact arithmetic, so
+ * integers and fractions stay exact. An exact sum or product that does not fit into 64 bits is
+ * ERROR_CODE::NUMBER_OUT_OF_RANGE like the written out expression, a float term (e.g. 1.0 / i) reduces the range with
+ * floats instead. Float terms are evaluated in blocks of Float (see CompiledExpression::evaluate_batch) and reduced
+ * in four independent lanes the compiler turns into vector operations. A term of a block that is not finite is evaluated
+ * again on its own, so a failing term is an error for every type of the first term and not a NaN or inf in the result.
+ * @param call is the function node of the range, its arguments are the index, the bounds and the term
+ * @param first is the value of the first index
+ * @param last is the value of the last index
+ * @param context rounds the quotients of decimals in the terms and where they are combined
+ * @param deadline is when ERROR_CODE::LIMIT_EXCEEDED is returned, checked once per block of terms, max() for none
+ * @return The sum or the product, the first error of a term or ERROR_CODE::UNBOUND_VARIABLE if the term has other
+ * variables than the index
+ */
+template <std::floating_point Float>
+auto reduce_range ( const AST&                            call,
+                    const basic_num_t<Float>&             first,
+                    const basic_num_t<Float>&             last,
+                    const DecimalContext&                 context,
+                    std::chrono::steady_clock::time_point deadline ) -> Result<basic_num_t<Float>>;
+} // namespace pfme
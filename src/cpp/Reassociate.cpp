@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <pfme/Functions.hpp>
+#include <pfme/Reassociate.hpp>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pfme
+{
+namespace
+{
+auto is_chain ( AST_TYPE type ) -> bool { return type == AST_TYPE::ADDITION || type == AST_TYPE::MULTIPLICATION; }
+
+auto is_call ( AST_TYPE type ) -> bool { return type == AST_TYPE::FUNCTION || type == AST_TYPE::ARGUMENT; }
+
+constexpr std::uint64_t LIMIT = std::numeric_limits<LLI>::max(); // the largest magnitude of an exact result
+
+// the products and sums of the bounds stop at the largest std::uint64_t, which is larger than LIMIT
+auto saturated_product ( std::uint64_t lhs, std::uint64_t rhs ) -> std::uint64_t
+{
+    constexpr auto MAX = std::numeric_limits<std::uint64_t>::max();
+    if ( lhs != 0 && rhs > MAX / lhs ) { return MAX; }
+    return lhs * rhs;
+}
+
+auto saturated_sum ( std::uint64_t lhs, std::uint64_t rhs ) -> std::uint64_t
+{
+    return lhs > std::numeric_limits<std::uint64_t>::max() - rhs ? std::numeric_limits<std::uint64_t>::max() : lhs + rhs;
+}
+
+auto magnitude ( LLI value ) -> std::uint64_t
+{
+    return value < 0 ? 0 - static_cast<std::uint64_t> ( value ) : static_cast<std::uint64_t> ( value );
+}
+
+// an exact node is a number n / d with |n| <= m_numerator and 0 < d <= m_denominator
+struct Exactness
+{
+    bool          m_exact       = false;
+    std::uint64_t m_numerator   = 0;
+    std::uint64_t m_denominator = 1;
+
+    // the bounds of a chain do not depend on the grouping and bound every partial result, as long as a factor bounded by 0
+    // counts as 1, so a chain whose bounds fit can not overflow however it is grouped, while regrouping one that does not
+    // fit may change which partial overflows
+    [[nodiscard]] auto fits() const -> bool { return m_exact && m_numerator <= LIMIT && m_denominator <= LIMIT; }
+};
+
+auto combine ( AST_TYPE type, const Exactness& lhs, const Exactness& rhs ) -> Exactness
+{
+    Exactness result { lhs.m_exact && rhs.m_exact };
+    switch ( type )
+    {
+    case AST_TYPE::ADDITION: [[fallthrough]];
+    case AST_TYPE::SUBTRACTION:
+        result.m_numerator = saturated_sum ( saturated_product ( lhs.m_numerator, rhs.m_denominator ),
+                                             saturated_product ( rhs.m_numerator, lhs.m_denominator ) );
+        result.m_denominator = saturated_product ( lhs.m_denominator, rhs.m_denominator );
+        break;
+    case AST_TYPE::MULTIPLICATION:
+        // 0 * 9223372036854775807 * 2 is 0, but 9223372036854775807 * 2 is a partial result of another grouping
+        result.m_numerator   = saturated_product ( std::max<std::uint64_t> ( lhs.m_numerator, 1 ),
+                                                   std::max<std::uint64_t> ( rhs.m_numerator, 1 ) );
+        result.m_denominator = saturated_product ( lhs.m_denominator, rhs.m_denominator );
+        break;
+    case AST_TYPE::DIVISION:
+        result.m_numerator   = saturated_product ( lhs.m_numerator, rhs.m_denominator );
+        result.m_denominator = std::max<std::uint64_t> ( saturated_product ( lhs.m_denominator, rhs.m_numerator ), 1 );
+        break;
+    default:
+        result.m_numerator   = std::max ( lhs.m_numerator, rhs.m_numerator );
+        result.m_denominator = std::max ( lhs.m_denominator, rhs.m_denominator );
+        break;
+    }
+    return result;
+}
+
+// the nodes whose result is always an integer or a fraction with the bounds of that number, found in one walk so chains
+// inside chains cost nothing extra
+auto find_exact ( const AST* root ) -> std::unordered_map<const AST*, Exactness>
+{
+    std::unordered_map<const AST*, Exactness> exact;
+    std::vector<std::pair<const AST*, bool>>  stack { { root, false } };
+    while ( !stack.empty() )
+    {
+        const auto [node, done] = stack.back();
+        stack.pop_back();
+        if ( node == nullptr ) { throw std::runtime_error ( "Can not reassociate an incomplete tree" ); }
+        if ( node->is_num() )
+        {
+            if ( const auto* integer = std::get_if<LLI> ( &node->m_number ) )
+            {
+                exact[node] = { true, magnitude ( *integer ), 1 };
+            }
+            else if ( const auto* fraction = std::get_if<Fraction> ( &node->m_number ) )
+            {
+                exact[node] = { true, magnitude ( fraction->numerator() ), magnitude ( fraction->denominator() ) };
+            }
+            else { exact[node] = {}; }
+            continue;
+        }
+        if ( node->m_type == AST_TYPE::VARIABLE || is_call ( node->m_type ) )
+        {
+            exact[node] = {};
+            // the arguments may contain chains of their own
+            if ( is_call ( node->m_type ) )
+            {
+                node->for_each_argument ( [&stack] ( const AST* argument ) { stack.emplace_back ( argument, false ); } );
+            }
+            continue;
+        }
+        if ( !done )
+        {
+            stack.emplace_back ( node, true );
+            stack.emplace_back ( node->lhand.get(), false );
+            stack.emplace_back ( node->rhand.get(), false );
+            continue;
+        }
+        switch ( node->m_type )
+        {
+        case AST_TYPE::ADDITION: [[fallthrough]];
+        case AST_TYPE::SUBTRACTION: [[fallthrough]];
+        case AST_TYPE::MULTIPLICATION: [[fallthrough]];
+        case AST_TYPE::DIVISION: [[fallthrough]];
+        case AST_TYPE::ALTERNATIVE:
+            exact[node] = combine ( node->m_type, exact[node->lhand.get()], exact[node->rhand.get()] );
+            break;
+        case AST_TYPE::CONDITION: exact[node] = exact[node->rhand.get()]; break;
+        case AST_TYPE::EXPONENTIATION: exact[node] = {}; break;
+        // comparisons and the logical operations result in 0 or 1
+        default: exact[node] = { true, 1, 1 }; break;
+        }
+    }
+    return exact;
+}
+
+// a new node like the operation, with new children
+auto copy_operation ( const AST& operation, std::shared_ptr<AST> lhs, std::shared_ptr<AST> rhs ) -> std::shared_ptr<AST>
+{
+    auto node               = std::make_shared<AST> ( std::move ( lhs ) );
+    node->m_type            = operation.m_type;
+    node->m_value           = operation.m_value;
+    node->m_function        = operation.m_function;
+    node->m_operation_level = operation.m_operation_level;
+    node->rhand             = std::move ( rhs );
+    return node;
+}
+
+// pairs neighbours until one node is left, a + b + c + d + e becomes ((a + b) + (c + d)) + e
+auto balance ( const AST& operation, std::span<std::shared_ptr<AST>> operands ) -> std::shared_ptr<AST>
+{
+    auto count = operands.size();
+    while ( count > 1 )
+    {
+        std::size_t next = 0;
+        for ( std::size_t i = 0; i < count; i += 2 )
+        {
+            if ( i + 1 < count )
+            {
+                operands[next++] = copy_operation ( operation, std::move ( operands[i] ), std::move ( operands[i + 1] ) );
+            }
+            else { operands[next++] = std::move ( operands[i] ); }
+        }
+        count = next;
+    }
+    return std::move ( operands[0] );
+}
+
+constexpr std::size_t KSUM_ARGUMENTS = 32; // the most arguments of one ksum, its arguments are a chain that deep
+
+// ksum(a, b, c, ...) with the arguments chained like the Parser does it
+auto ksum_call ( std::span<std::shared_ptr<AST>> operands ) -> std::shared_ptr<AST>
+{
+    auto call        = std::make_shared<AST> ( AST_TYPE::FUNCTION, "ksum" );
+    call->m_function = static_cast<std::uint32_t> ( FUNCTION::KSUM );
+    call->lhand      = std::move ( operands[0] );
+    auto* last       = call.get();
+    for ( auto& operand : operands.subspan ( 1 ) )
+    {
+        auto argument     = std::make_shared<AST> ( std::move ( operand ) );
+        argument->m_type  = AST_TYPE::ARGUMENT;
+        argument->m_value = ",";
+        last->rhand       = argument;
+        last              = argument.get();
+    }
+    return call;
+}
+
+// blocks of operands are summed by ksum calls, which are summed by ksum calls again until one is left, so the tree is
+// only KSUM_ARGUMENTS * log n deep and every partial sum is compensated
+auto compensated_sum ( std::span<std::shared_ptr<AST>> operands ) -> std::shared_ptr<AST>
+{
+    auto count = operands.size();
+    while ( count > KSUM_ARGUMENTS )
+    {
+        std::size_t next = 0;
+        for ( std::size_t i = 0; i < count; i += KSUM_ARGUMENTS )
+        {
+            const auto block = operands.subspan ( i, std::min ( KSUM_ARGUMENTS, count - i ) );
+            operands[next++] = block.size() > 1 ? ksum_call ( block ) : std::move ( block[0] );
+        }
+        count = next;
+    }
+    return ksum_call ( operands.first ( count ) );
+}
+} // namespace
+
+auto reassociate ( const AST* root, REASSOCIATE mode ) -> std::shared_ptr<AST>
+{
+    struct Frame
+    {
+        const AST*  m_node;
+        std::size_t m_operands; /**< The number of results the node takes from the stack, once they are computed */
+        bool        m_done;
+        bool        m_chain; /**< The operands are the flattened chain, not the two children */
+    };
+
+    const auto exact = find_exact ( root );
+
+    std::vector<Frame>                stack { { root, 0, false, false } };
+    std::vector<std::shared_ptr<AST>> results;
+    std::vector<const AST*>           links;
+    std::vector<const AST*>           operands;
+    while ( !stack.empty() )
+    {
+        const auto [node, count, done, chain] = stack.back();
+        stack.pop_back();
+        if ( node->is_num() || node->m_type == AST_TYPE::VARIABLE )
+        {
+            results.push_back ( std::make_shared<AST> ( *node ) );
+            continue;
+        }
+
+        if ( !done )
+        {
+            operands.clear();
+            // an exact chain is only regrouped if no grouping can overflow, so it keeps its result in every mode, the
+            // arguments of a call are not in exact, only their values
+            bool flatten = false;
+            if ( is_chain ( node->m_type ) )
+            {
+                const auto& bounds = exact.at ( node );
+                flatten            = bounds.m_exact ? bounds.fits() : mode != REASSOCIATE::EXACT;
+            }
+            if ( flatten )
+            {
+                // a + (b + c) and (a + b) + c have the same operands in the same order
+                links.assign ( 1, node );
+                while ( !links.empty() )
+                {
+                    const auto* link = links.back();
+                    links.pop_back();
+                    if ( link->m_type == node->m_type )
+                    {
+                        links.push_back ( link->rhand.get() );
+                        links.push_back ( link->lhand.get() );
+                    }
+                    else { operands.push_back ( link ); }
+                }
+            }
+            else
+            {
+                operands.push_back ( node->lhand.get() );
+                if ( node->rhand != nullptr || !is_call ( node->m_type ) ) { operands.push_back ( node->rhand.get() ); }
+            }
+            stack.push_back ( { node, operands.size(), true, flatten } );
+            for ( auto operand = operands.rbegin(); operand != operands.rend(); ++operand )
+            {
+                stack.push_back ( { *operand, 0, false, false } );
+            }
+            continue;
+        }
+
+        const auto      first = results.end() - static_cast<std::ptrdiff_t> ( count );
+        const std::span taken ( first, results.end() );
+        std::shared_ptr<AST> built;
+        if ( !chain )
+        {
+            built = copy_operation ( *node, std::move ( taken[0] ), count > 1 ? std::move ( taken[1] ) : nullptr );
+        }
+        else if ( mode == REASSOCIATE::KAHAN && node->m_type == AST_TYPE::ADDITION && !exact.at ( node ).m_exact )
+        {
+            built = compensated_sum ( taken );
+        }
+        else { built = balance ( *node, taken ); }
+        results.erase ( first, results.end() );
+        results.push_back ( std::move ( built ) );
+    }
+    return std::move ( results.back() );
+}
+} // namespace pfme
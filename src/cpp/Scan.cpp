@@ -0,0 +1,145 @@
+#include "SimdTarget.hpp"
+
+#include <algorithm>
+#include <pfme/Lexer.hpp>
+#include <pfme/Scan.hpp>
+
+namespace pfme::scan
+{
+namespace
+{
+using simd::SIMD_LEVEL;
+
+// short runs are the common case, the vector code only starts after this many characters
+constexpr std::size_t SCALAR_PREFIX = 8;
+
+auto is_digit ( char character ) -> bool { return character >= '0' && character <= '9'; }
+
+auto scalar_digit_run_end ( std::string_view input, std::size_t from ) -> std::size_t
+{
+    while ( from < input.size() && is_digit ( input[from] ) ) { ++from; }
+    return from;
+}
+
+auto scalar_skip_run_end ( std::string_view input, std::size_t from, const LexerConfig& config ) -> std::size_t
+{
+    while ( from < input.size() && config.is_skipped ( input[from] ) ) { ++from; }
+    return from;
+}
+
+#ifdef PFME_X86_SIMD
+auto count_trailing_zeros ( std::uint32_t mask ) -> std::size_t
+{
+#    ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanForward ( &index, mask );
+    return index;
+#    else
+    return static_cast<std::size_t> ( __builtin_ctz ( mask ) );
+#    endif
+}
+
+// the masks have a bit set for every character that belongs to the run, the run ends at the first cleared bit
+auto sse2_digit_run_end ( std::string_view input, std::size_t from ) -> std::size_t
+{
+    const __m128i zero = _mm_set1_epi8 ( '0' );
+    const __m128i nine = _mm_set1_epi8 ( 9 );
+    for ( ; from + 16 <= input.size(); from += 16 )
+    {
+        const __m128i chunk  = _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( input.data() + from ) ); // NOLINT
+        const __m128i offset = _mm_sub_epi8 ( chunk, zero );
+        // a digit has an offset of at most 9 as unsigned byte
+        const __m128i digits = _mm_cmpeq_epi8 ( _mm_min_epu8 ( offset, nine ), offset );
+        const auto    run    = static_cast<std::uint32_t> ( _mm_movemask_epi8 ( digits ) );
+        if ( run != 0xFFFFU ) { return from + count_trailing_zeros ( ~run ); }
+    }
+    return from;
+}
+
+auto sse2_skip_run_end ( std::string_view input, std::size_t from, std::string_view skipped ) -> std::size_t
+{
+    for ( ; from + 16 <= input.size(); from += 16 )
+    {
+        const __m128i chunk = _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( input.data() + from ) ); // NOLINT
+        __m128i       found = _mm_setzero_si128();
+        for ( const char character : skipped )
+        {
+            found = _mm_or_si128 ( found, _mm_cmpeq_epi8 ( chunk, _mm_set1_epi8 ( character ) ) );
+        }
+        const auto run = static_cast<std::uint32_t> ( _mm_movemask_epi8 ( found ) );
+        if ( run != 0xFFFFU ) { return from + count_trailing_zeros ( ~run ); }
+    }
+    return from;
+}
+
+PFME_TARGET_AVX2 auto avx2_digit_run_end ( std::string_view input, std::size_t from ) -> std::size_t
+{
+    const __m256i zero = _mm256_set1_epi8 ( '0' );
+    const __m256i nine = _mm256_set1_epi8 ( 9 );
+    for ( ; from + 32 <= input.size(); from += 32 )
+    {
+        const __m256i chunk  = _mm256_loadu_si256 ( reinterpret_cast<const __m256i*> ( input.data() + from ) ); // NOLINT
+        const __m256i offset = _mm256_sub_epi8 ( chunk, zero );
+        const __m256i digits = _mm256_cmpeq_epi8 ( _mm256_min_epu8 ( offset, nine ), offset );
+        const auto    run    = static_cast<std::uint32_t> ( _mm256_movemask_epi8 ( digits ) );
+        if ( run != 0xFFFF'FFFFU ) { return from + count_trailing_zeros ( ~run ); }
+    }
+    return from;
+}
+
+PFME_TARGET_AVX2 auto avx2_skip_run_end ( std::string_view input, std::size_t from, std::string_view skipped ) -> std::size_t
+{
+    for ( ; from + 32 <= input.size(); from += 32 )
+    {
+        const __m256i chunk = _mm256_loadu_si256 ( reinterpret_cast<const __m256i*> ( input.data() + from ) ); // NOLINT
+        __m256i       found = _mm256_setzero_si256();
+        for ( const char character : skipped )
+        {
+            found = _mm256_or_si256 ( found, _mm256_cmpeq_epi8 ( chunk, _mm256_set1_epi8 ( character ) ) );
+        }
+        const auto run = static_cast<std::uint32_t> ( _mm256_movemask_epi8 ( found ) );
+        if ( run != 0xFFFF'FFFFU ) { return from + count_trailing_zeros ( ~run ); }
+    }
+    return from;
+}
+#endif
+} // namespace
+
+auto digit_run_end ( std::string_view input, std::size_t from ) -> std::size_t
+{
+    const auto prefix = std::min ( from + SCALAR_PREFIX, input.size() );
+    while ( from < prefix && is_digit ( input[from] ) ) { ++from; }
+    if ( from < prefix ) { return from; }
+
+#ifdef PFME_X86_SIMD
+    switch ( simd::get_level() )
+    {
+    case SIMD_LEVEL::AVX2: from = avx2_digit_run_end ( input, from ); break;
+    case SIMD_LEVEL::SSE2: from = sse2_digit_run_end ( input, from ); break;
+    default: break;
+    }
+#endif
+    return scalar_digit_run_end ( input, from );
+}
+
+auto skip_run_end ( std::string_view input, std::size_t from, const LexerConfig& config ) -> std::size_t
+{
+    const auto prefix = std::min ( from + SCALAR_PREFIX, input.size() );
+    while ( from < prefix && config.is_skipped ( input[from] ) ) { ++from; }
+    if ( from < prefix ) { return from; }
+
+#ifdef PFME_X86_SIMD
+    const auto skipped = config.get_skipped();
+    if ( !skipped.empty() )
+    {
+        switch ( simd::get_level() )
+        {
+        case SIMD_LEVEL::AVX2: from = avx2_skip_run_end ( input, from, skipped ); break;
+        case SIMD_LEVEL::SSE2: from = sse2_skip_run_end ( input, from, skipped ); break;
+        default: break;
+        }
+    }
+#endif
+    return scalar_skip_run_end ( input, from, config );
+}
+} // namespace pfme::scan
@@ -0,0 +1,671 @@
+#include "Range.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <pfme/Functions.hpp>
+#include <pfme/Serialization.hpp>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pfme
+{
+namespace
+{
+auto checksum ( std::span<const std::byte> data ) -> std::uint64_t
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+    for ( const auto byte : data )
+    {
+        hash ^= static_cast<std::uint64_t> ( byte );
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+auto operation_symbol ( AST_TYPE type ) -> std::string
+{
+    switch ( type )
+    {
+    case AST_TYPE::MULTIPLICATION: return "*";
+    case AST_TYPE::DIVISION: return "/";
+    case AST_TYPE::ADDITION: return "+";
+    case AST_TYPE::SUBTRACTION: return "-";
+    case AST_TYPE::EXPONENTIATION: return "^";
+    case AST_TYPE::LESS: return "<";
+    case AST_TYPE::LESS_EQUAL: return "<=";
+    case AST_TYPE::GREATER: return ">";
+    case AST_TYPE::GREATER_EQUAL: return ">=";
+    case AST_TYPE::EQUAL: return "==";
+    case AST_TYPE::NOT_EQUAL: return "!=";
+    case AST_TYPE::AND: return "&&";
+    case AST_TYPE::OR: return "||";
+    case AST_TYPE::CONDITION: return "?";
+    case AST_TYPE::ALTERNATIVE: return ":";
+    default: return "";
+    }
+}
+
+auto is_operation ( AST_TYPE type ) -> bool { return !operation_symbol ( type ).empty(); }
+
+// function calls and their argument chains, their right child is optional
+auto is_call ( AST_TYPE type ) -> bool { return type == AST_TYPE::FUNCTION || type == AST_TYPE::ARGUMENT; }
+
+// the operations that only evaluate one of their operands, see Shortcut
+auto is_branch ( AST_TYPE type ) -> bool
+{
+    return type == AST_TYPE::CONDITION || type == AST_TYPE::ALTERNATIVE || type == AST_TYPE::AND || type == AST_TYPE::OR;
+}
+
+// the index of the first node of the subtree of every node, numbers and variables are a subtree of their own
+auto subtree_starts ( std::span<const BinaryNode> nodes ) -> std::vector<std::uint32_t>
+{
+    std::vector<std::uint32_t> starts ( nodes.size() );
+    for ( std::uint32_t i = 0; i < nodes.size(); ++i )
+    {
+        const auto type = nodes[i].get_type();
+        starts[i]       = is_operation ( type ) || is_call ( type ) ? starts[nodes[i].m_lhand] : i;
+    }
+    return starts;
+}
+
+} // namespace
+
+auto BinaryNode::from_number ( const AST::num_t& number ) -> BinaryNode
+{
+    BinaryNode node {};
+    if ( const auto* integer = std::get_if<LLI> ( &number ) )
+    {
+        node.m_type = static_cast<std::uint32_t> ( AST_TYPE::INTEGER );
+        std::memcpy ( node.m_payload.data(), integer, sizeof ( LLI ) );
+    }
+    else if ( const auto* floating = std::get_if<LD> ( &number ) )
+    {
+        node.m_type = static_cast<std::uint32_t> ( AST_TYPE::FLOAT );
+        std::memcpy ( node.m_payload.data(), floating, sizeof ( LD ) );
+        // x87 extended precision only uses 10 of its bytes, the rest is undefined and would make the output nondeterministic
+        if constexpr ( std::numeric_limits<LD>::digits == 64 )
+        {
+            std::fill ( node.m_payload.begin() + 10, node.m_payload.end(), std::byte { 0 } );
+        }
+    }
+    else if ( const auto* decimal = std::get_if<Decimal> ( &number ) )
+    {
+        const LLI mantissa = decimal->mantissa();
+        node.m_type        = static_cast<std::uint32_t> ( AST_TYPE::DECIMAL );
+        std::memcpy ( node.m_payload.data(), &mantissa, sizeof ( LLI ) );
+        node.m_payload[sizeof ( LLI )] = static_cast<std::byte> ( decimal->scale() );
+    }
+    else
+    {
+        const auto& fraction  = std::get<Fraction> ( number );
+        const LLI   numerator = fraction.numerator(), denominator = fraction.denominator();
+        node.m_type = static_cast<std::uint32_t> ( AST_TYPE::FRACTION );
+        std::memcpy ( node.m_payload.data(), &numerator, sizeof ( LLI ) );
+        std::memcpy ( node.m_payload.data() + sizeof ( LLI ), &denominator, sizeof ( LLI ) );
+    }
+    return node;
+}
+
+auto BinaryNode::to_number() const -> AST::num_t
+{
+    switch ( get_type() )
+    {
+    case AST_TYPE::INTEGER:
+    {
+        LLI integer {};
+        std::memcpy ( &integer, m_payload.data(), sizeof ( LLI ) );
+        return integer;
+    }
+    case AST_TYPE::FLOAT:
+    {
+        LD floating {};
+        std::memcpy ( &floating, m_payload.data(), sizeof ( LD ) );
+        return floating;
+    }
+    case AST_TYPE::FRACTION:
+    {
+        LLI numerator {}, denominator {};
+        std::memcpy ( &numerator, m_payload.data(), sizeof ( LLI ) );
+        std::memcpy ( &denominator, m_payload.data() + sizeof ( LLI ), sizeof ( LLI ) );
+        return Fraction { numerator, denominator };
+    }
+    case AST_TYPE::DECIMAL:
+    {
+        LLI mantissa {};
+        std::memcpy ( &mantissa, m_payload.data(), sizeof ( LLI ) );
+        return Decimal { mantissa, static_cast<std::uint8_t> ( m_payload[sizeof ( LLI )] ) };
+    }
+    default: throw std::runtime_error ( "Serialized node is not a number" );
+    }
+}
+
+auto BinaryNode::from_variable ( std::string_view name, std::uint32_t index ) -> BinaryNode
+{
+    if ( name.empty() ) { throw std::runtime_error ( "A variable needs a name" ); }
+    BinaryNode node {};
+    node.m_type  = static_cast<std::uint32_t> ( AST_TYPE::VARIABLE );
+    node.m_extra = index;
+    if ( name.size() <= MAX_NAME ) { std::memcpy ( node.m_payload.data(), name.data(), name.size() ); }
+    return node;
+}
+
+auto BinaryNode::from_function ( std::uint32_t id ) -> BinaryNode
+{
+    BinaryNode node {};
+    node.m_type      = static_cast<std::uint32_t> ( AST_TYPE::FUNCTION );
+    node.m_extra     = id;
+    const auto& name = FunctionRegistry::global().get ( id ).m_name;
+    if ( name.size() <= MAX_NAME ) { std::memcpy ( node.m_payload.data(), name.data(), name.size() ); }
+    return node;
+}
+
+auto BinaryNode::get_function() const -> std::optional<std::uint32_t>
+{
+    const auto& registry = FunctionRegistry::global();
+    const auto  name     = get_name();
+    if ( m_extra < registry.size() && ( name.empty() || registry.get ( m_extra ).m_name == name ) ) { return m_extra; }
+    if ( name.empty() ) { return std::nullopt; }
+    return registry.find ( name );
+}
+
+auto BinaryNode::get_name() const -> std::string_view
+{
+    const auto* name = reinterpret_cast<const char*> ( m_payload.data() );
+    return { name, static_cast<std::size_t> ( std::find ( name, name + MAX_NAME, '\0' ) - name ) };
+}
+
+auto flatten ( const AST* root ) -> std::vector<BinaryNode>
+{
+    std::vector<std::string> variables;
+    return flatten ( root, variables );
+}
+
+auto flatten ( const AST* root, std::vector<std::string>& variables ) -> std::vector<BinaryNode>
+{
+    if ( root == nullptr ) { throw std::runtime_error ( "Can not serialize an empty tree" ); }
+
+    std::vector<BinaryNode>                  nodes;
+    std::vector<std::uint32_t>               results;
+    std::vector<std::pair<const AST*, bool>> stack { { root, false } };
+    variables.clear();
+    while ( !stack.empty() )
+    {
+        auto [node, children_done] = stack.back();
+        stack.pop_back();
+        if ( node == nullptr ) { throw std::runtime_error ( "Can not serialize an incomplete tree" ); }
+        if ( node->m_type == AST_TYPE::VARIABLE )
+        {
+            auto found = std::ranges::find ( variables, node->m_value );
+            if ( found == variables.end() ) { found = variables.insert ( variables.end(), node->m_value ); }
+            const auto index = static_cast<std::uint32_t> ( found - variables.begin() );
+            results.push_back ( static_cast<std::uint32_t> ( nodes.size() ) );
+            nodes.push_back ( BinaryNode::from_variable ( node->m_value, index ) );
+            continue;
+        }
+        if ( node->is_num() )
+        {
+            results.push_back ( static_cast<std::uint32_t> ( nodes.size() ) );
+            nodes.push_back ( BinaryNode::from_number ( node->m_number ) );
+            continue;
+        }
+        const bool has_rhand = node->rhand != nullptr || !is_call ( node->m_type );
+        if ( !children_done )
+        {
+            stack.emplace_back ( node, true );
+            if ( has_rhand ) { stack.emplace_back ( node->rhand.get(), false ); }
+            stack.emplace_back ( node->lhand.get(), false );
+            continue;
+        }
+        BinaryNode operation =
+            node->m_type == AST_TYPE::FUNCTION ? BinaryNode::from_function ( node->m_function ) : BinaryNode {};
+        operation.m_type     = static_cast<std::uint32_t> ( node->m_type );
+        operation.m_rhand    = BinaryNode::NO_CHILD;
+        if ( has_rhand )
+        {
+            operation.m_rhand = results.back();
+            results.pop_back();
+        }
+        operation.m_lhand = results.back();
+        results.pop_back();
+        results.push_back ( static_cast<std::uint32_t> ( nodes.size() ) );
+        nodes.push_back ( operation );
+    }
+    if ( nodes.size() > std::numeric_limits<std::uint32_t>::max() )
+    {
+        throw std::runtime_error ( "Tree is too large to be serialized" );
+    }
+    return nodes;
+}
+
+auto serialize ( const AST* root ) -> std::vector<std::byte>
+{
+    std::vector<std::string> variables;
+    const auto               nodes      = flatten ( root, variables );
+    const auto               node_bytes = std::as_bytes ( std::span { nodes } );
+    // the index of a range is bound by the range, read back it would look like a free variable
+    if ( contains_range ( nodes ) )
+    {
+        throw std::runtime_error ( "sum and prod can not be serialized, evaluate them with the Visitor" );
+    }
+    // the reader finds functions and variables by their name, the id alone is not enough
+    for ( const auto& node : nodes )
+    {
+        if ( node.get_type() == AST_TYPE::FUNCTION && node.get_name().empty() )
+        {
+            const auto& name = FunctionRegistry::global().get ( node.m_extra ).m_name;
+            throw std::runtime_error ( std::format ( "Function name '{}' is too long to be serialized", name ) );
+        }
+    }
+    for ( const auto& name : variables )
+    {
+        if ( name.size() > BinaryNode::MAX_NAME )
+        {
+            throw std::runtime_error ( std::format ( "Variable name '{}' is too long to be serialized", name ) );
+        }
+    }
+
+    BinaryHeader header {};
+    header.m_node_size  = sizeof ( BinaryNode );
+    header.m_float_size = sizeof ( LD );
+    header.m_node_count = static_cast<std::uint32_t> ( nodes.size() );
+    header.m_checksum   = checksum ( node_bytes );
+
+    std::vector<std::byte> buffer ( sizeof ( BinaryHeader ) + node_bytes.size() );
+    std::memcpy ( buffer.data(), &header, sizeof ( BinaryHeader ) );
+    std::memcpy ( buffer.data() + sizeof ( BinaryHeader ), node_bytes.data(), node_bytes.size() );
+    return buffer;
+}
+
+auto save_expression ( const AST* root, const std::filesystem::path& path ) -> void
+{
+    const auto    buffer = serialize ( root );
+    std::ofstream file ( path, std::ios::binary | std::ios::trunc );
+    file.write ( reinterpret_cast<const char*> ( buffer.data() ), static_cast<std::streamsize> ( buffer.size() ) );
+    if ( !file ) { throw std::runtime_error ( "Could not write serialized expression to " + path.string() ); }
+}
+
+auto validate ( std::span<const std::byte> data ) -> std::span<const BinaryNode>
+{
+    if ( data.size() < sizeof ( BinaryHeader ) ) { throw std::runtime_error ( "Serialized expression is too small" ); }
+    if ( reinterpret_cast<std::uintptr_t> ( data.data() ) % alignof ( BinaryNode ) != 0 )
+    {
+        throw std::runtime_error ( "Serialized expression is not aligned" );
+    }
+
+    BinaryHeader header {};
+    std::memcpy ( &header, data.data(), sizeof ( BinaryHeader ) );
+    if ( header.m_magic != BinaryHeader::MAGIC ) { throw std::runtime_error ( "Not a serialized expression" ); }
+    if ( header.m_version != BinaryHeader::VERSION )
+    {
+        throw std::runtime_error ( std::format (
+            "Unsupported version of serialized expression: {} (expected {})", header.m_version, BinaryHeader::VERSION ) );
+    }
+    if ( header.m_byte_order != BinaryHeader::ENDIAN_MARK )
+    {
+        throw std::runtime_error ( "Serialized expression was written with a different byte order" );
+    }
+    if ( header.m_node_size != sizeof ( BinaryNode ) || header.m_float_size != sizeof ( LD ) )
+    {
+        throw std::runtime_error ( "Serialized expression was written with a different node or float layout" );
+    }
+    if ( header.m_node_count == 0 ||
+         data.size() != sizeof ( BinaryHeader ) + std::size_t { header.m_node_count } * sizeof ( BinaryNode ) )
+    {
+        throw std::runtime_error ( "Size of serialized expression does not match its header" );
+    }
+
+    const auto node_bytes = data.subspan ( sizeof ( BinaryHeader ) );
+    if ( checksum ( node_bytes ) != header.m_checksum )
+    {
+        throw std::runtime_error ( "Checksum mismatch in serialized expression" );
+    }
+
+    const std::span nodes { reinterpret_cast<const BinaryNode*> ( node_bytes.data() ), header.m_node_count };
+    // arguments can only be reached through the chain of their function and alternatives through their condition
+    const auto is_value = [&nodes] ( std::uint32_t index, std::uint32_t parent )
+    {
+        return index < parent && nodes[index].get_type() != AST_TYPE::ARGUMENT &&
+               nodes[index].get_type() != AST_TYPE::ALTERNATIVE;
+    };
+    const auto is_alternative = [&nodes] ( std::uint32_t index, std::uint32_t parent )
+    { return index < parent && nodes[index].get_type() == AST_TYPE::ALTERNATIVE; };
+    const auto is_chain = [&nodes] ( std::uint32_t index, std::uint32_t parent )
+    { return index == BinaryNode::NO_CHILD || ( index < parent && nodes[index].get_type() == AST_TYPE::ARGUMENT ); };
+    // a branch jumps over whole subtrees, so every subtree has to be stored in one piece right in front of its parent,
+    // otherwise a jump could skip a node of another parent
+    std::vector<std::uint32_t> starts ( nodes.size() );
+    const auto                 is_adjacent = [&starts] ( const BinaryNode& node, std::uint32_t index )
+    {
+        if ( node.m_rhand == BinaryNode::NO_CHILD ) { return node.m_lhand + 1 == index; }
+        return node.m_rhand + 1 == index && starts[node.m_rhand] == node.m_lhand + 1;
+    };
+    // variables[n] is the name of variable number n, numbers the number of every name
+    std::vector<std::string_view>                       variables;
+    std::unordered_map<std::string_view, std::uint32_t> numbers;
+    // the nodes form a tree, every node except the root is the child of exactly one node
+    std::vector<bool> referenced ( nodes.size() );
+    const auto        reference = [&referenced] ( std::uint32_t index )
+    {
+        if ( index == BinaryNode::NO_CHILD ) { return true; }
+        if ( referenced[index] ) { return false; }
+        referenced[index] = true;
+        return true;
+    };
+    for ( std::uint32_t i = 0; i < nodes.size(); ++i )
+    {
+        const auto type = nodes[i].get_type();
+        starts[i]       = i;
+        if ( type == AST_TYPE::INTEGER || type == AST_TYPE::FLOAT ) { continue; }
+        if ( type == AST_TYPE::FRACTION )
+        {
+            LLI denominator {};
+            std::memcpy ( &denominator, nodes[i].m_payload.data() + sizeof ( LLI ), sizeof ( LLI ) );
+            if ( denominator == 0 )
+            {
+                throw std::runtime_error ( std::format ( "Invalid fraction {} in serialized expression", i ) );
+            }
+            continue;
+        }
+        if ( type == AST_TYPE::DECIMAL )
+        {
+            if ( static_cast<std::uint8_t> ( nodes[i].m_payload[sizeof ( LLI )] ) > Decimal::MAX_SCALE )
+            {
+                throw std::runtime_error ( std::format ( "Invalid decimal {} in serialized expression", i ) );
+            }
+            continue;
+        }
+        if ( type == AST_TYPE::VARIABLE )
+        {
+            // every number belongs to exactly one name, otherwise the values would be bound to the wrong variables
+            const auto name = nodes[i].get_name();
+            if ( name.empty() || nodes[i].m_extra >= nodes.size() )
+            {
+                throw std::runtime_error ( std::format ( "Invalid variable {} in serialized expression", i ) );
+            }
+            if ( nodes[i].m_extra >= variables.size() ) { variables.resize ( nodes[i].m_extra + 1 ); }
+            auto&      known  = variables[nodes[i].m_extra];
+            const auto number = numbers.try_emplace ( name, nodes[i].m_extra ).first->second;
+            if ( ( !known.empty() && known != name ) || number != nodes[i].m_extra )
+            {
+                throw std::runtime_error ( std::format ( "Invalid variable {} in serialized expression", i ) );
+            }
+            known = name;
+            continue;
+        }
+        if ( type == AST_TYPE::FUNCTION && ( nodes[i].get_name().empty() || !nodes[i].get_function() ) )
+        {
+            throw std::runtime_error ( std::format ( "Unknown function '{}' in serialized expression", nodes[i].get_name() ) );
+        }
+        const bool rhand =
+            type == AST_TYPE::CONDITION ? is_alternative ( nodes[i].m_rhand, i ) : is_value ( nodes[i].m_rhand, i );
+        const bool valid = is_call ( type ) ? is_value ( nodes[i].m_lhand, i ) && is_chain ( nodes[i].m_rhand, i )
+                                            : is_operation ( type ) && is_value ( nodes[i].m_lhand, i ) && rhand;
+        if ( !valid || !is_adjacent ( nodes[i], i ) || !reference ( nodes[i].m_lhand ) || !reference ( nodes[i].m_rhand ) )
+        {
+            throw std::runtime_error ( std::format ( "Invalid node {} in serialized expression", i ) );
+        }
+        starts[i] = starts[nodes[i].m_lhand];
+    }
+    if ( !is_value ( static_cast<std::uint32_t> ( nodes.size() - 1 ), static_cast<std::uint32_t> ( nodes.size() ) ) )
+    {
+        throw std::runtime_error ( "Invalid root in serialized expression" );
+    }
+    if ( std::find ( referenced.begin(), referenced.end() - 1, false ) != referenced.end() - 1 )
+    {
+        throw std::runtime_error ( "Serialized expression has nodes outside of its tree" );
+    }
+    if ( std::ranges::find ( variables, std::string_view {} ) != variables.end() )
+    {
+        throw std::runtime_error ( "Serialized expression skips a variable number" );
+    }
+    return nodes;
+}
+
+auto evaluate ( std::span<const BinaryNode> nodes ) -> AST
+{
+    if ( nodes.empty() ) { throw std::runtime_error ( "Can not evaluate an empty expression" ); }
+
+    std::vector<AST>        values ( nodes.size() );
+    std::vector<AST::num_t> arguments;
+    const auto              shortcuts = find_shortcuts ( nodes );
+    for ( std::size_t i = 0; i < nodes.size(); ++i )
+    {
+        const auto& node = nodes[i];
+        if ( node.get_type() == AST_TYPE::ARGUMENT || node.get_type() == AST_TYPE::ALTERNATIVE ) { continue; }
+        if ( node.get_type() == AST_TYPE::VARIABLE )
+        {
+            throw std::runtime_error (
+                std::format ( "{}: {}", error_code_to_string ( ERROR_CODE::UNBOUND_VARIABLE ), node.get_name() ) );
+        }
+        if ( node.get_type() == AST_TYPE::FUNCTION )
+        {
+            arguments.assign ( 1, values[node.m_lhand].m_number );
+            for ( auto next = node.m_rhand; next != BinaryNode::NO_CHILD; next = nodes[next].m_rhand )
+            {
+                arguments.push_back ( values[nodes[next].m_lhand].m_number );
+            }
+            const auto function = node.get_function();
+            if ( !function )
+            {
+                throw std::runtime_error ( std::string ( error_code_to_string ( ERROR_CODE::UNKNOWN_FUNCTION ) ) );
+            }
+            auto result = call ( *function, arguments );
+            if ( !result ) { throw std::runtime_error ( std::string ( error_code_to_string ( result.error() ) ) ); }
+            std::visit ( [&] ( auto number ) { values[i] = AST { number }; }, *result );
+        }
+        else if ( node.get_type() == AST_TYPE::CONDITION )
+        {
+            const auto& alternative = nodes[node.m_rhand];
+            const bool  condition   = is_true<LD> ( values[node.m_lhand].m_number );
+            values[i]               = values[condition ? alternative.m_lhand : alternative.m_rhand];
+        }
+        else if ( is_operation ( node.get_type() ) )
+        {
+            auto result = apply ( node.get_type(), values[node.m_lhand], values[node.m_rhand] );
+            if ( !result ) { throw std::runtime_error ( std::string ( error_code_to_string ( result.error() ) ) ); }
+            values[i] = std::move ( *result );
+        }
+        else
+        {
+            std::visit ( [&] ( auto number ) { values[i] = AST { number }; }, node.to_number() );
+        }
+        if ( !shortcuts.empty() && shortcuts[i].m_target != Shortcut::NONE &&
+             shortcuts[i].jumps ( is_true<LD> ( values[i].m_number ) ) )
+        {
+            i = shortcuts[i].m_target - 1;
+        }
+    }
+    return std::move ( values.back() );
+}
+
+auto find_shortcuts ( std::span<const BinaryNode> nodes ) -> std::vector<Shortcut>
+{
+    if ( std::ranges::none_of ( nodes, [] ( const BinaryNode& node ) { return is_branch ( node.get_type() ); } ) )
+    {
+        return {};
+    }
+    const auto            starts = subtree_starts ( nodes );
+    std::vector<Shortcut> shortcuts ( nodes.size() );
+    for ( std::uint32_t i = 0; i < nodes.size(); ++i )
+    {
+        const auto& node = nodes[i];
+        if ( !is_branch ( node.get_type() ) ) { continue; }
+        // a condition continues with its second result, the others with themselves
+        auto& shortcut    = shortcuts[node.m_lhand];
+        shortcut.m_branch = node.get_type();
+        shortcut.m_target = node.get_type() == AST_TYPE::CONDITION ? starts[nodes[node.m_rhand].m_rhand] : i;
+    }
+    return shortcuts;
+}
+
+auto to_ast ( std::span<const BinaryNode> nodes, std::span<const std::string> variables ) -> std::shared_ptr<AST>
+{
+    if ( nodes.empty() ) { throw std::runtime_error ( "Can not rebuild an empty expression" ); }
+
+    std::vector<std::shared_ptr<AST>> built ( nodes.size() );
+    for ( std::size_t i = 0; i < nodes.size(); ++i )
+    {
+        const auto& node = nodes[i];
+        if ( is_call ( node.get_type() ) )
+        {
+            built[i]          = std::make_shared<AST> ( std::move ( built[node.m_lhand] ) );
+            built[i]->m_type  = node.get_type();
+            built[i]->m_value = ",";
+            if ( node.get_type() == AST_TYPE::FUNCTION )
+            {
+                const auto function = node.get_function();
+                if ( !function )
+                {
+                    throw std::runtime_error (
+                        std::format ( "Unknown function '{}' in serialized expression", node.get_name() ) );
+                }
+                built[i]->m_function = *function;
+                built[i]->m_value    = FunctionRegistry::global().get ( *function ).m_name;
+            }
+            if ( node.m_rhand != BinaryNode::NO_CHILD ) { built[i]->rhand = std::move ( built[node.m_rhand] ); }
+        }
+        else if ( node.get_type() == AST_TYPE::VARIABLE )
+        {
+            const auto name = node.m_extra < variables.size() ? std::string_view { variables[node.m_extra] } : node.get_name();
+            built[i]        = std::make_shared<AST> ( AST_TYPE::VARIABLE, std::string ( name ) );
+        }
+        else if ( is_operation ( node.get_type() ) )
+        {
+            built[i]          = std::make_shared<AST> ( std::move ( built[node.m_lhand] ) );
+            built[i]->m_type  = node.get_type();
+            built[i]->m_value = operation_symbol ( node.get_type() );
+            built[i]->rhand   = std::move ( built[node.m_rhand] );
+        }
+        else
+        {
+            std::visit ( [&] ( auto number ) { built[i] = std::make_shared<AST> ( number ); }, node.to_number() );
+        }
+    }
+    return std::move ( built.back() );
+}
+
+MappedExpression::MappedExpression ( const std::filesystem::path& path )
+{
+#ifdef _WIN32
+    m_file = CreateFileW (
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+    if ( m_file == INVALID_HANDLE_VALUE )
+    {
+        m_file = nullptr;
+        throw std::runtime_error ( "Could not open serialized expression " + path.string() );
+    }
+    LARGE_INTEGER size {};
+    if ( GetFileSizeEx ( m_file, &size ) == 0 || size.QuadPart < static_cast<LONGLONG> ( sizeof ( BinaryHeader ) ) )
+    {
+        unmap();
+        throw std::runtime_error ( "Serialized expression is too small: " + path.string() );
+    }
+    m_size    = static_cast<std::size_t> ( size.QuadPart );
+    m_mapping = CreateFileMappingW ( m_file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    if ( m_mapping != nullptr )
+    {
+        m_data = static_cast<const std::byte*> ( MapViewOfFile ( m_mapping, FILE_MAP_READ, 0, 0, 0 ) );
+    }
+#else
+    m_file = ::open ( path.c_str(), O_RDONLY | O_CLOEXEC ); // NOLINT(cppcoreguidelines-pro-type-vararg)
+    if ( m_file < 0 ) { throw std::runtime_error ( "Could not open serialized expression " + path.string() ); }
+    struct stat info
+    {
+    };
+    if ( ::fstat ( m_file, &info ) != 0 || info.st_size < static_cast<off_t> ( sizeof ( BinaryHeader ) ) )
+    {
+        unmap();
+        throw std::runtime_error ( "Serialized expression is too small: " + path.string() );
+    }
+    m_size        = static_cast<std::size_t> ( info.st_size );
+    void* mapping = ::mmap ( nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0 );
+    if ( mapping != MAP_FAILED ) { m_data = static_cast<const std::byte*> ( mapping ); }
+#endif
+    if ( m_data == nullptr )
+    {
+        unmap();
+        throw std::runtime_error ( "Could not map serialized expression " + path.string() );
+    }
+
+    try
+    {
+        m_nodes = validate ( { m_data, m_size } );
+    }
+    catch ( ... )
+    {
+        unmap();
+        throw;
+    }
+}
+
+MappedExpression::MappedExpression ( MappedExpression&& other ) noexcept
+    : m_data ( std::exchange ( other.m_data, nullptr ) )
+    , m_size ( std::exchange ( other.m_size, 0 ) )
+    , m_nodes ( std::exchange ( other.m_nodes, {} ) )
+#ifdef _WIN32
+    , m_file ( std::exchange ( other.m_file, nullptr ) )
+    , m_mapping ( std::exchange ( other.m_mapping, nullptr ) )
+#else
+    , m_file ( std::exchange ( other.m_file, -1 ) )
+#endif
+{
+}
+
+MappedExpression& MappedExpression::operator= ( MappedExpression&& other ) noexcept
+{
+    if ( this != &other )
+    {
+        unmap();
+        m_data  = std::exchange ( other.m_data, nullptr );
+        m_size  = std::exchange ( other.m_size, 0 );
+        m_nodes = std::exchange ( other.m_nodes, {} );
+#ifdef _WIN32
+        m_file    = std::exchange ( other.m_file, nullptr );
+        m_mapping = std::exchange ( other.m_mapping, nullptr );
+#else
+        m_file = std::exchange ( other.m_file, -1 );
+#endif
+    }
+    return *this;
+}
+
+MappedExpression::~MappedExpression() { unmap(); }
+
+auto MappedExpression::unmap() noexcept -> void
+{
+#ifdef _WIN32
+    if ( m_data != nullptr ) { UnmapViewOfFile ( m_data ); }
+    if ( m_mapping != nullptr ) { CloseHandle ( m_mapping ); }
+    if ( m_file != nullptr ) { CloseHandle ( m_file ); }
+    m_mapping = nullptr;
+    m_file    = nullptr;
+#else
+    if ( m_data != nullptr ) { ::munmap ( const_cast<std::byte*> ( m_data ), m_size ); }
+    if ( m_file >= 0 ) { ::close ( m_file ); }
+    m_file = -1;
+#endif
+    m_data  = nullptr;
+    m_size  = 0;
+    m_nodes = {};
+}
+} // namespace pfme
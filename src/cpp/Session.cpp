@@ -0,0 +1,21 @@
+#include <pfme/Session.hpp>
+
+namespace pfme
+{
+template <std::floating_point Float>
+basic_session<Float>::basic_session ( const LexerConfig& config )
+{
+    m_visitor.m_parser = std::make_unique<Parser> ( std::make_unique<Lexer> ( "", config ), &m_nodes );
+}
+
+template <std::floating_point Float>
+auto basic_session<Float>::evaluate ( std::string_view input ) -> Result<number_t>
+{
+    if ( auto parsed = m_visitor.try_reset ( input ); !parsed ) { return std::unexpected ( parsed.error() ); }
+    return m_visitor.try_evaluate();
+}
+
+template class basic_session<float>;
+template class basic_session<double>;
+template class basic_session<LD>;
+} // namespace pfme
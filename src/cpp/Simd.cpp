@@ -0,0 +1,60 @@
+#include "SimdTarget.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <pfme/Simd.hpp>
+
+namespace pfme::simd
+{
+namespace
+{
+#ifdef PFME_X86_SIMD
+auto detect_level() -> SIMD_LEVEL
+{
+#    ifdef _MSC_VER
+    std::array<int, 4> registers {};
+    __cpuid ( registers.data(), 0 );
+    if ( registers[0] < 7 ) { return SIMD_LEVEL::SSE2; }
+    __cpuid ( registers.data(), 1 );
+    // the OS has to save the AVX registers (OSXSAVE and the XMM and YMM state in XCR0)
+    const bool os_support = ( registers[2] & ( 1 << 27 ) ) != 0 && ( _xgetbv ( 0 ) & 0x6U ) == 0x6U;
+    __cpuidex ( registers.data(), 7, 0 );
+    return os_support && ( registers[1] & ( 1 << 5 ) ) != 0 ? SIMD_LEVEL::AVX2 : SIMD_LEVEL::SSE2;
+#    else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports ( "avx2" ) != 0 ? SIMD_LEVEL::AVX2 : SIMD_LEVEL::SSE2;
+#    endif
+}
+#else
+auto detect_level() -> SIMD_LEVEL { return SIMD_LEVEL::SCALAR; }
+#endif
+
+std::atomic<SIMD_LEVEL> active_level { supported_level() }; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+} // namespace
+
+auto simd_level_to_string ( SIMD_LEVEL level ) -> std::string_view
+{
+    switch ( level )
+    {
+    case SIMD_LEVEL::SSE2: return "SSE2";
+    case SIMD_LEVEL::AVX2: return "AVX2";
+    default: return "scalar";
+    }
+}
+
+auto supported_level() -> SIMD_LEVEL
+{
+    static const SIMD_LEVEL level = detect_level();
+    return level;
+}
+
+auto get_level() -> SIMD_LEVEL { return active_level.load ( std::memory_order_relaxed ); }
+
+auto set_level ( SIMD_LEVEL level ) -> SIMD_LEVEL
+{
+    const auto usable = std::min ( level, supported_level() );
+    active_level.store ( usable, std::memory_order_relaxed );
+    return usable;
+}
+} // namespace pfme::simd
@@ -0,0 +1,17 @@
+#pragma once
+// Shared by the translation units with vector code, not part of the public headers.
+
+#if !defined( PFME_NO_SIMD ) && ( defined( __x86_64__ ) || defined( _M_X64 ) )
+#    define PFME_X86_SIMD 1
+#    include <immintrin.h>
+#    ifdef _MSC_VER
+#        include <intrin.h>
+#    endif
+#endif
+
+// MSVC allows AVX2 intrinsics in every function, GCC and Clang only in functions compiled for it
+#if defined( PFME_X86_SIMD ) && !defined( _MSC_VER )
+#    define PFME_TARGET_AVX2 [[gnu::target ( "avx2" )]]
+#else
+#    define PFME_TARGET_AVX2
+#endif
@@ -0,0 +1,381 @@
+#include <array>
+#include <charconv>
+#include <limits>
+#include <pfme/Small.hpp>
+#include <pfme/Trace.hpp>
+#include <pfme/Visitor.hpp>
+#include <utility>
+
+namespace pfme
+{
+namespace
+{
+constexpr std::size_t   MAX_NODES     = SMALL_TOKEN_LIMIT + 1; // one node per token, plus the 0 of a missing operand
+constexpr std::size_t   MAX_NUMBER    = 64;                    // the longest number that is copied to replace the point
+constexpr std::uint8_t  NO_NODE       = std::numeric_limits<std::uint8_t>::max();
+constexpr std::uint64_t MAX_MAGNITUDE = static_cast<std::uint64_t> ( std::numeric_limits<LLI>::max() ) + 1;
+static_assert ( MAX_NODES < NO_NODE, "the nodes are indexed with a byte" );
+
+constexpr char NUMBER = '0'; // the type of a number token, the other tokens are their character
+constexpr char END    = '\0';
+
+// the tokens and nodes are not initialized, only the ones that are used are written
+struct SmallToken
+{
+    char          m_type;
+    bool          m_float;
+    std::uint64_t m_magnitude; /**< The integer without its sign, the Parser decides if it fits */
+    LD            m_value;
+};
+
+struct SmallNode
+{
+    AST_TYPE     m_type; /**< INTEGER or FLOAT for numbers */
+    int          m_level;
+    LLI          m_integer;
+    LD           m_float;
+    std::uint8_t m_lhand; /**< NO_NODE for numbers */
+    std::uint8_t m_rhand;
+};
+
+/**
+ * @brief The tokens of a small expression, collected like the Lexer does.
+ */
+class SmallLexer
+{
+public:
+    SmallLexer ( std::string_view input, const LexerConfig& config )
+        : m_input ( input )
+        , m_config ( config )
+    {
+    }
+
+    /**
+     * Collects all tokens and an END token.
+     * @return false if the input is too long or needs the Lexer
+     */
+    auto lex() -> bool
+    {
+        while ( m_index < m_input.size() )
+        {
+            const char character = m_input[m_index];
+            if ( m_config.is ( character, CHAR_CLASS::SEPERATOR ) ) { return false; }
+            if ( m_config.is ( character, CHAR_CLASS::WHITESPACE ) )
+            {
+                ++m_index;
+                continue;
+            }
+            if ( m_count == SMALL_TOKEN_LIMIT ) { return false; }
+            if ( m_config.is ( character, CHAR_CLASS::DIGIT ) || m_config.is ( character, CHAR_CLASS::POINT ) )
+            {
+                if ( !collect_number() ) { return false; }
+                continue;
+            }
+            switch ( character )
+            {
+            case '+':
+            case '-':
+            case '*':
+            case '/':
+            case '^':
+            case '(':
+            case ')': m_tokens[m_count++].m_type = character; break;
+            default: return false; // names, the end of a C string, other characters and errors
+            }
+            ++m_index;
+        }
+        m_tokens[m_count].m_type = END;
+        return true;
+    }
+
+    [[nodiscard]] auto get ( std::size_t index ) const -> const SmallToken& { return m_tokens[index]; }
+
+private:
+    std::string_view                              m_input;
+    const LexerConfig&                            m_config;
+    std::array<SmallToken, SMALL_TOKEN_LIMIT + 1> m_tokens;
+    std::size_t                                   m_count = 0;
+    std::size_t                                   m_index = 0;
+
+    [[nodiscard]] auto at ( std::size_t index ) const -> char { return index < m_input.size() ? m_input[index] : END; }
+
+    auto skip_digits() -> void
+    {
+        while ( m_config.is ( at ( m_index ), CHAR_CLASS::DIGIT ) ) { ++m_index; }
+    }
+
+    // the same digits, point and exponent as Lexer::collect_number() without seperators and hexadecimal numbers
+    auto collect_number() -> bool
+    {
+        const auto start = m_index;
+        skip_digits();
+        const bool point = m_config.is ( at ( m_index ), CHAR_CLASS::POINT );
+        if ( point )
+        {
+            ++m_index;
+            skip_digits();
+        }
+        bool exponent = false;
+        if ( m_config.is ( at ( m_index ), CHAR_CLASS::EXPONENT ) )
+        {
+            const auto digit = m_index + ( at ( m_index + 1 ) == '+' || at ( m_index + 1 ) == '-' ? 2U : 1U );
+            exponent         = m_config.is ( at ( digit ), CHAR_CLASS::DIGIT );
+            if ( exponent )
+            {
+                m_index = digit;
+                skip_digits();
+            }
+        }
+        // a second point, a seperator inside the number or a name right after it
+        const char next = at ( m_index );
+        if ( m_config.is ( next, CHAR_CLASS::POINT ) || m_config.is ( next, CHAR_CLASS::SEPERATOR ) ||
+             m_config.is ( next, CHAR_CLASS::LETTER ) )
+        {
+            return false;
+        }
+
+        auto text = m_input.substr ( start, m_index - start );
+        std::array<char, MAX_NUMBER> copy {};
+        if ( point && m_config.get_point_symbol() != '.' )
+        {
+            if ( text.size() > copy.size() ) { return false; }
+            for ( std::size_t i = 0; i < text.size(); ++i )
+            {
+                copy[i] = m_config.is ( text[i], CHAR_CLASS::POINT ) ? '.' : text[i];
+            }
+            text = { copy.data(), text.size() };
+        }
+
+        auto&       token = m_tokens[m_count++];
+        const auto* last  = text.data() + text.size();
+        token.m_type      = NUMBER;
+        token.m_float     = point || exponent;
+        const auto  read  = token.m_float ? std::from_chars ( text.data(), last, token.m_value, std::chars_format::general )
+                                          : std::from_chars ( text.data(), last, token.m_magnitude );
+        return read.ec == std::errc {} && read.ptr == last && ( token.m_float || token.m_magnitude <= MAX_MAGNITUDE );
+    }
+};
+
+/**
+ * @brief Builds the tree of the tokens in the same way as the Parser, the nodes are indices into an array.
+ * @see Parser::try_parse
+ */
+class SmallParser
+{
+public:
+    explicit SmallParser ( const SmallLexer& lexer )
+        : m_lexer ( lexer )
+    {
+    }
+
+    /**
+     * Parses all tokens.
+     * @return false on every error, the Parser reports it
+     */
+    auto parse() -> bool
+    {
+        while ( current() != END )
+        {
+            switch ( current() )
+            {
+            case '(':
+                ++m_parenthesis_level;
+                ++m_index;
+                break;
+            case '-': m_negative_sign = true; [[fallthrough]];
+            case '+':
+                ++m_index;
+                if ( !parse_expression() ) { return false; }
+                break;
+            case NUMBER:
+                if ( !parse_expression() ) { return false; }
+                break;
+            default: return false;
+            }
+        }
+        if ( m_root == NO_NODE ) { return false; }
+        if ( m_spine_size > 0 && m_nodes[m_spine[m_spine_size - 1]].m_rhand == NO_NODE )
+        {
+            m_nodes[m_spine[m_spine_size - 1]].m_rhand = add_number ( 0LL );
+        }
+        return true;
+    }
+
+    [[nodiscard]] auto get_root() const -> std::uint8_t { return m_root; }
+    [[nodiscard]] auto get ( std::uint8_t node ) const -> const SmallNode& { return m_nodes[node]; }
+
+private:
+    const SmallLexer&                   m_lexer;
+    std::array<SmallNode, MAX_NODES>    m_nodes;
+    std::array<std::uint8_t, MAX_NODES> m_spine;
+    std::size_t                         m_count             = 0;
+    std::size_t                         m_spine_size        = 0;
+    std::size_t                         m_index             = 0;
+    int                                 m_parenthesis_level = 0;
+    bool                                m_negative_sign     = false;
+    std::uint8_t                        m_root              = NO_NODE;
+
+    [[nodiscard]] auto current() const -> char { return m_lexer.get ( m_index ).m_type; }
+
+    auto add_number ( LLI number ) -> std::uint8_t
+    {
+        auto& node     = m_nodes[m_count];
+        node.m_type    = AST_TYPE::INTEGER;
+        node.m_integer = number;
+        node.m_lhand   = NO_NODE;
+        return static_cast<std::uint8_t> ( m_count++ );
+    }
+
+    auto add_number ( LD number ) -> std::uint8_t
+    {
+        auto& node   = m_nodes[m_count];
+        node.m_type  = AST_TYPE::FLOAT;
+        node.m_float = number;
+        node.m_lhand = NO_NODE;
+        return static_cast<std::uint8_t> ( m_count++ );
+    }
+
+    auto parse_expression() -> bool
+    {
+        if ( current() != NUMBER ) { return false; }
+        const auto&  token  = m_lexer.get ( m_index );
+        std::uint8_t number = NO_NODE;
+        if ( token.m_float ) { number = add_number ( m_negative_sign ? -token.m_value : token.m_value ); }
+        else
+        {
+            if ( !m_negative_sign && token.m_magnitude > static_cast<std::uint64_t> ( std::numeric_limits<LLI>::max() ) )
+            {
+                return false;
+            }
+            number = add_number ( static_cast<LLI> ( m_negative_sign ? 0 - token.m_magnitude : token.m_magnitude ) );
+        }
+        m_negative_sign = false;
+        ++m_index;
+        return parse_operation ( number );
+    }
+
+    auto parse_operation ( std::uint8_t operand ) -> bool
+    {
+        while ( current() == ')' )
+        {
+            --m_parenthesis_level;
+            ++m_index;
+        }
+        int      level = m_parenthesis_level * 3;
+        AST_TYPE type  = AST_TYPE::ADDITION;
+        switch ( current() )
+        {
+        case '*':
+            type = AST_TYPE::MULTIPLICATION;
+            ++level;
+            break;
+        case '/':
+            type = AST_TYPE::DIVISION;
+            ++level;
+            break;
+        case '+': break;
+        case '-': type = AST_TYPE::SUBTRACTION; break;
+        case '^':
+            type = AST_TYPE::EXPONENTIATION;
+            level += 2;
+            break;
+        case END:
+            attach ( operand );
+            return true;
+        default: return false;
+        }
+        auto& operation   = m_nodes[m_count];
+        operation.m_type  = type;
+        operation.m_level = level;
+        operation.m_lhand = operand;
+        operation.m_rhand = NO_NODE;
+        add_operation ( static_cast<std::uint8_t> ( m_count++ ) );
+        ++m_index;
+        return true;
+    }
+
+    auto attach ( std::uint8_t operand ) -> void
+    {
+        if ( m_root == NO_NODE ) { m_root = operand; }
+        else { m_nodes[m_spine[m_spine_size - 1]].m_rhand = operand; }
+    }
+
+    // see Parser::add_operation, equal levels are chained to the right
+    auto add_operation ( std::uint8_t operation ) -> void
+    {
+        auto& added = m_nodes[operation];
+        if ( m_root != NO_NODE )
+        {
+            auto& bottom = m_nodes[m_spine[m_spine_size - 1]];
+            if ( bottom.m_level <= added.m_level ) { bottom.m_rhand = operation; }
+            else
+            {
+                bottom.m_rhand = std::exchange ( added.m_lhand, NO_NODE );
+                while ( m_spine_size > 0 && m_nodes[m_spine[m_spine_size - 1]].m_level > added.m_level ) { --m_spine_size; }
+                if ( m_spine_size == 0 )
+                {
+                    added.m_lhand = m_root;
+                    m_root        = operation;
+                }
+                else
+                {
+                    auto& node    = m_nodes[m_spine[m_spine_size - 1]];
+                    added.m_lhand = node.m_rhand;
+                    node.m_rhand  = operation;
+                }
+            }
+        }
+        else { m_root = operation; }
+        m_spine[m_spine_size++] = operation;
+    }
+};
+
+// the depth is bounded by SMALL_TOKEN_LIMIT, so unlike the Visitor it can recurse, the left side is evaluated first
+template <std::floating_point Float>
+auto evaluate_node ( const SmallParser& parser, std::uint8_t index ) -> std::expected<basic_num_t<Float>, ERROR_CODE>
+{
+    const auto& node = parser.get ( index );
+    if ( node.m_lhand == NO_NODE )
+    {
+        if ( node.m_type == AST_TYPE::FLOAT ) { return static_cast<Float> ( node.m_float ); }
+        return node.m_integer;
+    }
+    const auto lhs = evaluate_node<Float> ( parser, node.m_lhand );
+    if ( !lhs ) { return lhs; }
+    const auto rhs = evaluate_node<Float> ( parser, node.m_rhand );
+    if ( !rhs ) { return rhs; }
+    return apply_operation<Float> ( node.m_type, *lhs, *rhs );
+}
+} // namespace
+
+template <std::floating_point Float>
+auto try_evaluate_small ( std::string_view input, const LexerConfig& config ) -> std::optional<Result<basic_num_t<Float>>>
+{
+    // the nodes only have room for long double
+    if ( config.get_decimals() ) { return std::nullopt; }
+    const trace::Scope scope ( trace::STAGE::EVALUATE );
+    SmallLexer         lexer ( input, config );
+    if ( !lexer.lex() ) { return std::nullopt; }
+    SmallParser parser ( lexer );
+    if ( !parser.parse() ) { return std::nullopt; }
+    auto result = evaluate_node<Float> ( parser, parser.get_root() );
+    if ( !result ) { return std::unexpected ( Error { result.error() } ); }
+    return *result;
+}
+
+template <std::floating_point Float>
+auto evaluate_small ( std::string_view input, const LexerConfig& config ) -> Result<basic_num_t<Float>>
+{
+    if ( auto result = try_evaluate_small<Float> ( input, config ) ) { return *result; }
+    auto visitor = basic_visitor<Float>::try_create ( std::make_unique<Lexer> ( input, config ) );
+    if ( !visitor ) { return std::unexpected ( visitor.error() ); }
+    return visitor->try_evaluate();
+}
+
+template auto try_evaluate_small<float> ( std::string_view, const LexerConfig& ) -> std::optional<Result<basic_num_t<float>>>;
+template auto try_evaluate_small<double> ( std::string_view, const LexerConfig& ) -> std::optional<Result<basic_num_t<double>>>;
+template auto try_evaluate_small<LD> ( std::string_view, const LexerConfig& ) -> std::optional<Result<basic_num_t<LD>>>;
+template auto evaluate_small<float> ( std::string_view, const LexerConfig& ) -> Result<basic_num_t<float>>;
+template auto evaluate_small<double> ( std::string_view, const LexerConfig& ) -> Result<basic_num_t<double>>;
+template auto evaluate_small<LD> ( std::string_view, const LexerConfig& ) -> Result<basic_num_t<LD>>;
+} // namespace pfme
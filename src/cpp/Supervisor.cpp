@@ -0,0 +1,362 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <pfme/Serialization.hpp>
+#include <pfme/Session.hpp>
+#include <pfme/Supervisor.hpp>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace pfme
+{
+#ifndef _WIN32
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t RING_SLOTS = 64; // requests a worker can have queued, a power of two so the index wraps cheaply
+
+static_assert ( std::atomic<std::uint64_t>::is_always_lock_free, "the rings are shared between processes" );
+
+/**
+ * @brief An expression sent to a worker.
+ */
+struct Request
+{
+    std::uint64_t                           m_id   = 0; /**< The index of the expression in the batch */
+    std::uint32_t                           m_size = 0; /**< The length of the expression */
+    std::array<char, Supervisor::MAX_LENGTH> m_text {};
+};
+
+/**
+ * @brief The answer of a worker, the number is stored like in the serialization.
+ */
+struct Response
+{
+    std::uint64_t m_id       = 0;
+    bool          m_ok       = false;
+    ERROR_CODE    m_code     = ERROR_CODE::WORKER_FAILED;
+    TOKEN_TYPE    m_found    = TOKEN_TYPE::TOKEN_UNKNOWN;
+    TOKEN_TYPE    m_expected = TOKEN_TYPE::TOKEN_UNKNOWN;
+    std::uint32_t m_position = Error::NO_POSITION;
+    BinaryNode    m_number {};
+};
+
+/**
+ * @brief A ring with a single producer and a single consumer that lives in memory shared by two processes.
+ *
+ * Both indices only grow, the producer writes a slot before it publishes the head and the consumer reads a slot
+ * before it publishes the tail. A process that dies in between leaves the ring as it was before the slot.
+ */
+template <typename T>
+struct Ring
+{
+    alignas ( 64 ) std::atomic<std::uint64_t> m_head { 0 }; /**< Written by the producer, the next slot it fills */
+    alignas ( 64 ) std::atomic<std::uint64_t> m_tail { 0 }; /**< Written by the consumer, the next slot it reads */
+    std::array<T, RING_SLOTS> m_slots {};
+
+    [[nodiscard]] auto full() const -> bool
+    {
+        return m_head.load ( std::memory_order_relaxed ) - m_tail.load ( std::memory_order_acquire ) == RING_SLOTS;
+    }
+    [[nodiscard]] auto empty() const -> bool
+    {
+        return m_tail.load ( std::memory_order_relaxed ) == m_head.load ( std::memory_order_acquire );
+    }
+    auto back() -> T& { return m_slots[m_head.load ( std::memory_order_relaxed ) % RING_SLOTS]; }
+    auto push() -> void
+    {
+        m_head.store ( m_head.load ( std::memory_order_relaxed ) + 1, std::memory_order_release );
+    }
+    auto front() -> const T& { return m_slots[m_tail.load ( std::memory_order_relaxed ) % RING_SLOTS]; }
+    auto pop() -> void
+    {
+        m_tail.store ( m_tail.load ( std::memory_order_relaxed ) + 1, std::memory_order_release );
+    }
+};
+
+/**
+ * @brief Everything a worker shares with the Supervisor.
+ */
+struct Channel
+{
+    Ring<Request>              m_requests;  /**< Produced by the Supervisor */
+    Ring<Response>             m_responses; /**< Produced by the worker */
+    std::atomic<std::uint32_t> m_stop { 0 };
+};
+
+// spins first, then yields and finally sleeps, so an idle process costs almost no time
+auto pause ( std::size_t round ) -> bool
+{
+    if ( round < 64 ) { return false; }
+    if ( round < 256 )
+    {
+        std::this_thread::yield();
+        return false;
+    }
+    std::this_thread::sleep_for ( std::chrono::microseconds { 50 } );
+    return true;
+}
+
+[[noreturn]] auto run_worker ( Channel& channel, const SupervisorOptions& options, pid_t parent ) -> void
+{
+    Session session ( options.m_config );
+    session.set_decimal_context ( options.m_decimal_context );
+    session.set_limits ( options.m_limits );
+    std::string input;
+    std::size_t idle = 0;
+    while ( channel.m_stop.load ( std::memory_order_acquire ) == 0 )
+    {
+        auto& requests = channel.m_requests;
+        if ( requests.empty() )
+        {
+            // nobody is left to send requests or read responses
+            if ( pause ( idle++ ) && ::getppid() != parent ) { break; }
+            continue;
+        }
+        idle = 0;
+        input.assign ( requests.front().m_text.data(), requests.front().m_size );
+        const auto id = requests.front().m_id;
+        // taken before it is evaluated, so the Supervisor knows which expression a crash belongs to
+        requests.pop();
+        const auto result = session.evaluate ( input );
+
+        auto& responses = channel.m_responses;
+        for ( std::size_t round = 0; responses.full(); ++round )
+        {
+            if ( pause ( round ) && ( ::getppid() != parent || channel.m_stop.load ( std::memory_order_acquire ) != 0 ) )
+            {
+                ::_exit ( 0 );
+            }
+        }
+        auto& response = responses.back();
+        response       = Response {};
+        response.m_id  = id;
+        response.m_ok  = result.has_value();
+        if ( result ) { response.m_number = BinaryNode::from_number ( *result ); }
+        else
+        {
+            response.m_code     = result.error().m_code;
+            response.m_found    = result.error().m_found;
+            response.m_expected = result.error().m_expected;
+            response.m_position = result.error().m_position;
+        }
+        responses.push();
+    }
+    ::_exit ( 0 );
+}
+
+auto decode ( const Response& response ) -> Result<AST::num_t>
+{
+    if ( response.m_ok ) { return response.m_number.to_number(); }
+    return std::unexpected ( Error { response.m_code, response.m_position, response.m_found, response.m_expected } );
+}
+} // namespace
+
+struct Supervisor::State
+{
+    /**
+     * @brief A worker process as the Supervisor sees it.
+     */
+    struct Worker
+    {
+        Channel*                m_channel   = nullptr;
+        pid_t                   m_pid       = -1;
+        std::deque<std::size_t> m_pending   = {}; /**< The expressions sent to the worker that are not answered, in order */
+        std::uint64_t           m_completed = 0;  /**< The requests that were answered or failed, never more than were taken */
+        std::uint64_t           m_taken     = 0;  /**< The tail of the requests when it was last looked at */
+        Clock::time_point       m_progress  = {}; /**< When the worker last took or answered a request */
+    };
+
+    SupervisorOptions   m_options;
+    pid_t               m_parent   = ::getpid();
+    Channel*            m_channels = nullptr;
+    std::size_t         m_size     = 0;
+    std::vector<Worker> m_workers;
+    std::size_t         m_restarts = 0;
+
+    auto start ( Worker& worker ) -> void
+    {
+        const auto pid = ::fork();
+        if ( pid < 0 ) { throw std::runtime_error ( "Could not fork a worker process" ); }
+        if ( pid == 0 ) { run_worker ( *worker.m_channel, m_options, m_parent ); }
+        worker.m_pid      = pid;
+        worker.m_progress = Clock::now();
+    }
+
+    // the responses of a worker, returns the number of finished expressions
+    static auto collect ( Worker& worker, std::vector<Result<AST::num_t>>& results ) -> std::size_t
+    {
+        auto&       responses = worker.m_channel->m_responses;
+        std::size_t finished  = 0;
+        for ( ; !responses.empty(); ++finished )
+        {
+            results[worker.m_pending.front()] = decode ( responses.front() );
+            responses.pop();
+            worker.m_pending.pop_front();
+            ++worker.m_completed;
+            worker.m_progress = Clock::now();
+        }
+        return finished;
+    }
+
+    // restarts a worker that died or hangs, returns the number of failed expressions
+    auto check ( Worker& worker, std::vector<Result<AST::num_t>>& results ) -> std::size_t
+    {
+        int        status = 0;
+        bool       dead   = ::waitpid ( worker.m_pid, &status, WNOHANG ) == worker.m_pid;
+        const auto taken  = worker.m_channel->m_requests.m_tail.load ( std::memory_order_acquire );
+        if ( taken != worker.m_taken )
+        {
+            worker.m_taken    = taken;
+            worker.m_progress = Clock::now();
+        }
+        if ( !dead && taken > worker.m_completed && Clock::now() - worker.m_progress > m_options.m_timeout )
+        {
+            ::kill ( worker.m_pid, SIGKILL );
+            ::waitpid ( worker.m_pid, &status, 0 );
+            dead = true;
+        }
+        if ( !dead ) { return 0; }
+
+        // answers written before the crash are still valid, the expression after them was the one being evaluated
+        std::size_t finished = collect ( worker, results );
+        if ( worker.m_channel->m_requests.m_tail.load ( std::memory_order_acquire ) > worker.m_completed )
+        {
+            results[worker.m_pending.front()] = std::unexpected ( Error { ERROR_CODE::WORKER_FAILED } );
+            worker.m_pending.pop_front();
+            ++worker.m_completed;
+            ++finished;
+        }
+        ++m_restarts;
+        start ( worker );
+        return finished;
+    }
+};
+
+Supervisor::Supervisor ( const SupervisorOptions& options )
+    : m_state ( std::make_unique<State>() )
+{
+    m_state->m_options = options;
+    const auto workers = options.m_workers != 0 ? options.m_workers : std::max ( std::thread::hardware_concurrency(), 1U );
+    m_state->m_size    = workers * sizeof ( Channel );
+    void* memory       = ::mmap ( nullptr, m_state->m_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+    if ( memory == MAP_FAILED ) { throw std::runtime_error ( "Could not map the shared memory of the workers" ); }
+    m_state->m_channels = static_cast<Channel*> ( memory );
+    m_state->m_workers.resize ( workers );
+    for ( std::size_t i = 0; i < workers; ++i )
+    {
+        m_state->m_workers[i].m_channel = std::construct_at ( m_state->m_channels + i );
+        m_state->start ( m_state->m_workers[i] );
+    }
+}
+
+Supervisor::~Supervisor()
+{
+    for ( auto& worker : m_state->m_workers ) { worker.m_channel->m_stop.store ( 1, std::memory_order_release ); }
+    const auto deadline = Clock::now() + std::chrono::seconds { 1 };
+    for ( auto& worker : m_state->m_workers )
+    {
+        int status = 0;
+        while ( ::waitpid ( worker.m_pid, &status, WNOHANG ) == 0 )
+        {
+            if ( Clock::now() > deadline )
+            {
+                ::kill ( worker.m_pid, SIGKILL );
+                ::waitpid ( worker.m_pid, &status, 0 );
+                break;
+            }
+            std::this_thread::sleep_for ( std::chrono::microseconds { 100 } );
+        }
+    }
+    for ( std::size_t i = 0; i < m_state->m_workers.size(); ++i ) { std::destroy_at ( m_state->m_channels + i ); }
+    ::munmap ( m_state->m_channels, m_state->m_size );
+}
+
+auto Supervisor::evaluate ( std::span<const std::string_view> expressions ) -> std::vector<Result<AST::num_t>>
+{
+    std::vector<Result<AST::num_t>> results ( expressions.size(), std::unexpected ( Error { ERROR_CODE::WORKER_FAILED } ) );
+    auto&                           workers  = m_state->m_workers;
+    std::size_t                     next     = 0;
+    std::size_t                     finished = 0;
+    for ( std::size_t round = 0; finished < expressions.size(); )
+    {
+        std::size_t progress = 0;
+        // one request per worker at a time, so even a few expressions are spread over all of them
+        for ( bool sent = true; sent && next < expressions.size(); )
+        {
+            sent = false;
+            for ( auto& worker : workers )
+            {
+                auto& requests = worker.m_channel->m_requests;
+                if ( next == expressions.size() || requests.full() ) { continue; }
+                const auto expression = expressions[next];
+                if ( expression.size() > MAX_LENGTH )
+                {
+                    results[next++] = std::unexpected ( Error { ERROR_CODE::INPUT_TOO_LONG } );
+                    ++finished;
+                    continue;
+                }
+                auto& request  = requests.back();
+                request.m_id   = next;
+                request.m_size = static_cast<std::uint32_t> ( expression.size() );
+                std::copy ( expression.begin(), expression.end(), request.m_text.begin() );
+                if ( worker.m_pending.empty() ) { worker.m_progress = Clock::now(); }
+                worker.m_pending.push_back ( next++ );
+                requests.push();
+                sent = true;
+                ++progress;
+            }
+        }
+        for ( auto& worker : workers )
+        {
+            const auto answered = State::collect ( worker, results ) + m_state->check ( worker, results );
+            finished += answered;
+            progress += answered;
+        }
+        round = progress == 0 ? round + 1 : 0;
+        pause ( round );
+    }
+    return results;
+}
+
+auto Supervisor::get_workers() const -> std::size_t { return m_state->m_workers.size(); }
+
+auto Supervisor::get_restarts() const -> std::size_t { return m_state->m_restarts; }
+#else
+struct Supervisor::State
+{
+};
+
+Supervisor::Supervisor ( const SupervisorOptions& /*options*/ )
+{
+    throw std::runtime_error ( "Worker processes need fork, which this platform does not have" );
+}
+
+Supervisor::~Supervisor() = default;
+
+auto Supervisor::evaluate ( std::span<const std::string_view> expressions ) -> std::vector<Result<AST::num_t>>
+{
+    return { expressions.size(), std::unexpected ( Error { ERROR_CODE::WORKER_FAILED } ) };
+}
+
+auto Supervisor::get_workers() const -> std::size_t { return 0; }
+
+auto Supervisor::get_restarts() const -> std::size_t { return 0; }
+#endif
+
+auto Supervisor::evaluate ( std::string_view expression ) -> Result<AST::num_t>
+{
+    return std::move ( evaluate ( std::span<const std::string_view> { &expression, 1 } ).front() );
+}
+} // namespace pfme
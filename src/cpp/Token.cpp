@@ -16,6 +16,18 @@ auto token_type_to_string ( TOKEN_TYPE type ) -> std::string
     case TOKEN_TYPE::TOKEN_EXPONENTIATION: ret = "TOKEN_EXPONENTIATION"; break;
     case TOKEN_TYPE::TOKEN_INTEGER: ret = "TOKEN_INTEGER"; break;
     case TOKEN_TYPE::TOKEN_FLOAT: ret = "TOKEN_FLOAT"; break;
+    case TOKEN_TYPE::TOKEN_IDENTIFIER: ret = "TOKEN_IDENTIFIER"; break;
+    case TOKEN_TYPE::TOKEN_COMMA: ret = "TOKEN_COMMA"; break;
+    case TOKEN_TYPE::TOKEN_LESS: ret = "TOKEN_LESS"; break;
+    case TOKEN_TYPE::TOKEN_LESS_EQUAL: ret = "TOKEN_LESS_EQUAL"; break;
+    case TOKEN_TYPE::TOKEN_GREATER: ret = "TOKEN_GREATER"; break;
+    case TOKEN_TYPE::TOKEN_GREATER_EQUAL: ret = "TOKEN_GREATER_EQUAL"; break;
+    case TOKEN_TYPE::TOKEN_EQUAL: ret = "TOKEN_EQUAL"; break;
+    case TOKEN_TYPE::TOKEN_NOT_EQUAL: ret = "TOKEN_NOT_EQUAL"; break;
+    case TOKEN_TYPE::TOKEN_AND: ret = "TOKEN_AND"; break;
+    case TOKEN_TYPE::TOKEN_OR: ret = "TOKEN_OR"; break;
+    case TOKEN_TYPE::TOKEN_CONDITION: ret = "TOKEN_CONDITION"; break;
+    case TOKEN_TYPE::TOKEN_ALTERNATIVE: ret = "TOKEN_ALTERNATIVE"; break;
     case TOKEN_TYPE::TOKEN_EOF: ret = "TOKEN_EOF"; break;
     default: break;
     }
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <pfme/AST.hpp>
+#include <pfme/Functions.hpp>
+#include <pfme/Trace.hpp>
+#include <stdexcept>
+#include <vector>
+
+namespace pfme::trace
+{
+namespace
+{
+static_assert ( ( CAPACITY & ( CAPACITY - 1 ) ) == 0, "the ring buffer is indexed with a mask" );
+
+struct Buffer
+{
+    std::vector<Event>         m_events = std::vector<Event> ( CAPACITY );
+    std::atomic<std::uint64_t> m_written { 0 }; /**< All events ever recorded, the newest is at (m_written - 1) % CAPACITY */
+    std::uint32_t              m_thread = 0;    /**< The number of the thread in the trace */
+};
+
+// the buffers outlive their threads, so the events of finished workers can still be exported
+struct Registry
+{
+    std::mutex                           m_mutex;
+    std::vector<std::shared_ptr<Buffer>> m_buffers; /**< Every buffer, one for each thread that recorded at the same time */
+    std::vector<std::shared_ptr<Buffer>> m_free;    /**< The buffers of finished threads, reused by new ones */
+};
+
+auto registry() -> Registry&
+{
+    static Registry instance;
+    return instance;
+}
+
+// a thread records into its buffer until it exits, then the buffer goes to the next new thread, so short lived threads
+// (e.g. of a sum) do not add a buffer each, the events stay in the buffer until the next thread overwrites them
+class Lease
+{
+public:
+    Lease()
+    {
+        auto&                  all = registry();
+        const std::scoped_lock lock ( all.m_mutex );
+        if ( !all.m_free.empty() )
+        {
+            m_buffer = std::move ( all.m_free.back() );
+            all.m_free.pop_back();
+            return;
+        }
+        m_buffer           = std::make_shared<Buffer>();
+        m_buffer->m_thread = static_cast<std::uint32_t> ( all.m_buffers.size() );
+        all.m_buffers.push_back ( m_buffer );
+        // returning a buffer never allocates, so the destructor can not throw
+        all.m_free.reserve ( all.m_buffers.size() );
+    }
+    ~Lease()
+    {
+        auto&                  all = registry();
+        const std::scoped_lock lock ( all.m_mutex );
+        all.m_free.push_back ( std::move ( m_buffer ) );
+    }
+    Lease ( const Lease& )            = delete;
+    Lease ( Lease&& )                 = delete;
+    Lease& operator= ( const Lease& ) = delete;
+    Lease& operator= ( Lease&& )      = delete;
+
+    [[nodiscard]] auto get() const -> Buffer& { return *m_buffer; }
+
+private:
+    std::shared_ptr<Buffer> m_buffer;
+};
+
+auto local_buffer() -> Buffer&
+{
+    thread_local const Lease lease;
+    return lease.get();
+}
+
+auto buffers() -> std::vector<std::shared_ptr<Buffer>>
+{
+    auto&                  all = registry();
+    const std::scoped_lock lock ( all.m_mutex );
+    return all.m_buffers;
+}
+
+// the events of a buffer from the oldest to the newest
+template <typename Function>
+auto for_each_event ( const Buffer& buffer, Function&& function ) -> void
+{
+    const auto written = buffer.m_written.load ( std::memory_order_acquire );
+    const auto first   = written > CAPACITY ? written - CAPACITY : 0;
+    for ( auto i = first; i < written; ++i ) { function ( buffer.m_events[i & ( CAPACITY - 1 )] ); }
+}
+
+auto node_name ( const Event& event ) -> std::string_view
+{
+    const auto type = static_cast<AST_TYPE> ( event.m_type );
+    switch ( type )
+    {
+    case AST_TYPE::MULTIPLICATION: return "*";
+    case AST_TYPE::DIVISION: return "/";
+    case AST_TYPE::ADDITION: return "+";
+    case AST_TYPE::SUBTRACTION: return "-";
+    case AST_TYPE::EXPONENTIATION: return "^";
+    case AST_TYPE::LESS: return "<";
+    case AST_TYPE::LESS_EQUAL: return "<=";
+    case AST_TYPE::GREATER: return ">";
+    case AST_TYPE::GREATER_EQUAL: return ">=";
+    case AST_TYPE::EQUAL: return "==";
+    case AST_TYPE::NOT_EQUAL: return "!=";
+    case AST_TYPE::AND: return "&&";
+    case AST_TYPE::OR: return "||";
+    case AST_TYPE::CONDITION: return "?:";
+    case AST_TYPE::FUNCTION:
+        if ( const auto& registry = FunctionRegistry::global(); event.m_detail < registry.size() )
+        {
+            return registry.get ( event.m_detail ).m_name;
+        }
+        return "call";
+    default: return "node";
+    }
+}
+
+// microseconds with three decimals, written from the integer nanoseconds so no precision is lost
+auto write_microseconds ( std::ostream& output, std::uint64_t nanoseconds ) -> void
+{
+    output << nanoseconds / 1000 << '.' << std::setw ( 3 ) << std::setfill ( '0' ) << nanoseconds % 1000;
+}
+} // namespace
+
+auto record ( STAGE stage, std::uint64_t start, std::uint32_t detail, std::uint8_t type ) -> void
+{
+    const auto end     = now();
+    auto&      buffer  = local_buffer();
+    const auto written = buffer.m_written.load ( std::memory_order_relaxed );
+    buffer.m_events[written & ( CAPACITY - 1 )] = { start, end - start, detail, stage, type };
+    buffer.m_written.store ( written + 1, std::memory_order_release );
+}
+
+auto write_chrome_trace ( std::ostream& output ) -> void
+{
+    const auto all    = buffers();
+    auto       origin = std::numeric_limits<std::uint64_t>::max();
+    for ( const auto& buffer : all )
+    {
+        for_each_event ( *buffer, [&origin] ( const Event& event ) { origin = std::min ( origin, event.m_start ); } );
+    }
+
+    const auto fill  = output.fill();
+    bool       first = true;
+    output << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    for ( const auto& buffer : all )
+    {
+        output << ( first ? "\n" : ",\n" ) << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->m_thread
+               << R"(,"args":{"name":"pfme thread )" << buffer->m_thread << "\"}}";
+        first = false;
+        for_each_event ( *buffer,
+                         [&] ( const Event& event )
+                         {
+                             const bool node = event.m_stage == STAGE::NODE;
+                             output << ",\n{\"name\":\"" << ( node ? node_name ( event ) : stage_to_string ( event.m_stage ) )
+                                    << "\",\"cat\":\"" << ( node ? "node" : "stage" ) << R"(","ph":"X","pid":1,"tid":)"
+                                    << buffer->m_thread << ",\"ts\":";
+                             write_microseconds ( output, event.m_start - origin );
+                             output << ",\"dur\":";
+                             write_microseconds ( output, event.m_duration );
+                             if ( node ) { output << R"(,"args":{"detail":)" << event.m_detail << '}'; }
+                             output << '}';
+                         } );
+    }
+    output << "\n]}\n";
+    output.fill ( fill );
+}
+
+auto save_chrome_trace ( const std::filesystem::path& path ) -> void
+{
+    std::ofstream file ( path, std::ios::trunc );
+    write_chrome_trace ( file );
+    if ( !file ) { throw std::runtime_error ( "Could not write trace to " + path.string() ); }
+}
+
+auto clear() -> void
+{
+    for ( const auto& buffer : buffers() ) { buffer->m_written.store ( 0, std::memory_order_relaxed ); }
+}
+
+auto stage_to_string ( STAGE stage ) -> std::string_view
+{
+    switch ( stage )
+    {
+    case STAGE::PARSE: return "parse";
+    case STAGE::COMPILE: return "compile";
+    case STAGE::EVALUATE: return "evaluate";
+    case STAGE::GRADIENT: return "gradient";
+    case STAGE::NODE: return "node";
+    default: return "unknown";
+    }
+}
+} // namespace pfme::trace
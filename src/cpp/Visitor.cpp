@@ -1,54 +1,237 @@
+#include "Range.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <pfme/Functions.hpp>
+#include <pfme/Trace.hpp>
 #include <pfme/Visitor.hpp>
 
 namespace pfme
 {
-Visitor::Visitor ( std::unique_ptr<Parser>&& parser )
+namespace
+{
+// the long double of the tree holds every Float exactly, so the next operation sees the rounded result
+template <std::floating_point Float>
+auto store ( AST& node, const basic_num_t<Float>& number ) -> void
+{
+    std::visit ( [&node] ( auto value ) { node = AST { value }; }, convert_number<LD> ( number ) );
+}
+
+// conditions and the logical operators only evaluate their left hand first, the rest depends on its value
+auto is_lazy ( AST_TYPE type ) -> bool { return type == AST_TYPE::CONDITION || type == AST_TYPE::AND || type == AST_TYPE::OR; }
+
+// replaces a lazy node whose left hand is a number with what is left to evaluate
+auto resolve ( AST& node ) -> void
+{
+    const bool value = is_true<LD> ( node.lhand->m_number );
+    if ( node.m_type == AST_TYPE::CONDITION )
+    {
+        // the chosen branch is kept alive while the node, which owns it, is overwritten
+        const auto chosen = value ? node.rhand->lhand : node.rhand->rhand;
+        node              = std::move ( *chosen );
+    }
+    else if ( ( node.m_type == AST_TYPE::OR ) == value ) { node = AST { LLI { value } }; }
+    else
+    {
+        // the right hand decides, it only has to become 0 or 1
+        AST logical;
+        logical.m_type = AST_TYPE::NOT_EQUAL;
+        logical.lhand  = node.rhand;
+        logical.rhand  = std::make_shared<AST> ( 0LL );
+        node           = std::move ( logical );
+    }
+}
+
+// the exact types are raised by repeated multiplication, floats and fractions as exponent go through pow
+auto exact_exponent ( const AST::num_t& exponent ) -> std::uint64_t
+{
+    LLI value = 0;
+    if ( const auto* integer = std::get_if<LLI> ( &exponent ) ) { value = *integer; }
+    else if ( const auto* decimal = std::get_if<Decimal> ( &exponent ); decimal != nullptr && decimal->is_whole() )
+    {
+        value = decimal->mantissa();
+    }
+    return value < 0 ? 0 - static_cast<std::uint64_t> ( value ) : static_cast<std::uint64_t> ( value );
+}
+} // namespace
+
+template <std::floating_point Float>
+basic_visitor<Float>::basic_visitor ( std::unique_ptr<Parser>&& parser )
     : m_parser ( std::move ( parser ) )
 {
     m_parser->parse();
 }
 
-Visitor::Visitor ( const std::string& input )
+template <std::floating_point Float>
+basic_visitor<Float>::basic_visitor ( const std::string& input )
     : m_parser ( std::make_unique<Parser> ( input ) )
 {
     m_parser->parse();
 }
 
-Visitor::Visitor ( std::unique_ptr<Lexer>&& lexer )
+template <std::floating_point Float>
+basic_visitor<Float>::basic_visitor ( std::unique_ptr<Lexer>&& lexer )
     : m_parser ( std::make_unique<Parser> ( std::move ( lexer ) ) )
 {
     m_parser->parse();
 }
 
-auto Visitor::print_tree() const -> void { this->m_parser->print_binary_tree ( m_parser->get_root().get() ); }
+template <std::floating_point Float>
+auto basic_visitor<Float>::try_create ( const std::string& input ) -> Result<basic_visitor>
+{
+    return try_create ( std::make_unique<Lexer> ( input ) );
+}
+
+template <std::floating_point Float>
+auto basic_visitor<Float>::try_create ( std::unique_ptr<Lexer>&& lexer ) -> Result<basic_visitor>
+{
+    basic_visitor visitor;
+    visitor.m_parser = std::make_unique<Parser> ( std::move ( lexer ) );
+    if ( auto root = visitor.m_parser->try_parse(); !root ) { return std::unexpected ( root.error() ); }
+    return visitor;
+}
+
+template <std::floating_point Float>
+auto basic_visitor<Float>::try_reset ( std::string_view input ) -> Result<void>
+{
+    m_parser->reset ( input );
+    if ( auto root = m_parser->try_parse(); !root ) { return std::unexpected ( root.error() ); }
+    return {};
+}
+
+template <std::floating_point Float>
+auto basic_visitor<Float>::print_tree() const -> void { this->m_parser->print_binary_tree ( m_parser->get_root().get() ); }
 
-auto Visitor::visit() -> std::string
+template <std::floating_point Float>
+auto basic_visitor<Float>::visit() -> std::string
 {
-    auto root = this->m_parser->get_root();
-    while ( !root->is_num() )
+    auto result = try_visit();
+    if ( !result ) { throw std::runtime_error ( std::string ( error_code_to_string ( result.error().m_code ) ) ); }
+    return *result;
+}
+
+template <std::floating_point Float>
+auto basic_visitor<Float>::try_visit() -> Result<std::string>
+{
+    auto result = try_evaluate();
+    if ( !result ) { return std::unexpected ( result.error() ); }
+    // only the result is ever turned into a string
+    return this->m_parser->get_root()->to_string();
+}
+
+template <std::floating_point Float>
+auto basic_visitor<Float>::try_evaluate() -> Result<number_t>
+{
+    const trace::Scope scope ( trace::STAGE::EVALUATE );
+    const bool         trace_nodes = trace::get_level() == trace::TRACE_LEVEL::NODES;
+    auto               root        = this->m_parser->get_root();
+    const auto&        limits      = this->m_parser->get_limits();
+    const bool         timed       = limits.m_time != std::chrono::nanoseconds::max();
+    const auto         started     = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point {};
+    std::size_t        steps       = 0;
+    // every node is entered twice: first its children are pushed (left ones on top), then it is evaluated
+    auto& worklist  = m_worklist;
+    auto& arguments = m_arguments;
+    worklist.assign ( 1, { root.get(), false } );
+    while ( !worklist.empty() )
     {
-        const auto& operation = traverse_tree ( root );
+        auto [operation, children_done] = worklist.back();
+        if ( operation->is_num() )
+        {
+            worklist.pop_back();
+            continue;
+        }
+        // the Visitor has no values for variables, see CompiledExpression
+        if ( operation->m_type == AST_TYPE::VARIABLE ) { return std::unexpected ( Error { ERROR_CODE::UNBOUND_VARIABLE } ); }
+        if ( !children_done )
+        {
+            worklist.back().second = true;
+            const auto first       = worklist.size();
+            const auto push        = [&worklist] ( AST* child )
+            {
+                if ( !child->is_num() ) { worklist.emplace_back ( child, false ); }
+            };
+            // only the bounds of a range are evaluated here, its term is evaluated once for every index
+            if ( operation->m_type == AST_TYPE::FUNCTION && is_range ( operation->m_function ) )
+            {
+                push ( operation->rhand->lhand.get() );
+                push ( operation->rhand->rhand->lhand.get() );
+            }
+            else if ( operation->m_type == AST_TYPE::FUNCTION ) { operation->for_each_argument ( push ); }
+            else if ( is_lazy ( operation->m_type ) ) { push ( operation->lhand.get() ); }
+            else
+            {
+                push ( operation->lhand.get() );
+                push ( operation->rhand.get() );
+            }
+            std::reverse ( worklist.begin() + static_cast<std::ptrdiff_t> ( first ), worklist.end() );
+            continue;
+        }
+
+        // the clock is only read every few steps, so a budget costs almost nothing
+        if ( ++steps > limits.m_steps ) { return std::unexpected ( Error { ERROR_CODE::LIMIT_EXCEEDED } ); }
+        if ( timed && steps % Limits::CLOCK_INTERVAL == 0 && std::chrono::steady_clock::now() - started > limits.m_time )
+        {
+            return std::unexpected ( Error { ERROR_CODE::LIMIT_EXCEEDED } );
+        }
+        if ( operation->m_type == AST_TYPE::EXPONENTIATION &&
+             exact_exponent ( operation->rhand->m_number ) > limits.m_exponent )
+        {
+            return std::unexpected ( Error { ERROR_CODE::LIMIT_EXCEEDED } );
+        }
+        if ( is_lazy ( operation->m_type ) )
+        {
+            // the node is entered again as the branch that was taken
+            resolve ( *operation );
+            worklist.back().second = false;
+            continue;
+        }
         if ( m_debug_mode ) { std::cout << *operation; }
-        switch ( operation->m_type )
+        // the node becomes its result, so what it was is kept for the trace
+        const auto start    = trace_nodes ? trace::now() : 0;
+        const auto type     = operation->m_type;
+        const auto function = operation->m_function;
+        if ( operation->m_type == AST_TYPE::FUNCTION && is_range ( operation->m_function ) )
         {
-        case AST_TYPE::MULTIPLICATION: *operation = *operation->lhand * *operation->rhand; break;
-        case AST_TYPE::DIVISION: *operation = *operation->lhand / *operation->rhand; break;
-        case AST_TYPE::ADDITION: *operation = *operation->lhand + *operation->rhand; break;
-        case AST_TYPE::SUBTRACTION: *operation = *operation->lhand - *operation->rhand; break;
-        case AST_TYPE::EXPONENTIATION: *operation = *operation->lhand ^ *operation->rhand; break;
-        default: break;
+            const auto first = convert_number<Float> ( operation->rhand->lhand->m_number );
+            const auto last  = convert_number<Float> ( operation->rhand->rhand->lhand->m_number );
+            const auto size  = range_size<Float> ( first, last );
+            if ( !size ) { return std::unexpected ( size.error() ); }
+            // every term counts as a step, so the budget is checked before the first one is evaluated
+            if ( *size > limits.m_steps - steps ) { return std::unexpected ( Error { ERROR_CODE::LIMIT_EXCEEDED } ); }
+            steps += static_cast<std::size_t> ( *size );
+            const auto deadline = timed ? started + limits.m_time : std::chrono::steady_clock::time_point::max();
+            auto       result   = reduce_range<Float> ( *operation, first, last, m_decimal_context, deadline );
+            if ( !result ) { return std::unexpected ( result.error() ); }
+            store ( *operation, *result );
         }
+        else if ( operation->m_type == AST_TYPE::FUNCTION )
+        {
+            arguments.clear();
+            operation->for_each_argument ( [&arguments] ( const AST* argument )
+                                           { arguments.push_back ( argument->m_number ); } );
+            auto result = call ( operation->m_function, arguments );
+            if ( !result ) { return std::unexpected ( Error { result.error() } ); }
+            store ( *operation, convert_number<Float> ( *result ) );
+        }
+        else
+        {
+            auto result = apply_operation<Float> ( operation->m_type,
+                                                   convert_number<Float> ( operation->lhand->m_number ),
+                                                   convert_number<Float> ( operation->rhand->m_number ),
+                                                   m_decimal_context );
+            if ( !result ) { return std::unexpected ( Error { result.error() } ); }
+            store ( *operation, *result );
+        }
+        if ( trace_nodes ) { trace::record ( trace::STAGE::NODE, start, function, static_cast<std::uint8_t> ( type ) ); }
         if ( m_debug_mode ) { std::cout << " = " << *operation << '\n'; }
+        worklist.pop_back();
     }
-    return root->m_value;
+    return convert_number<Float> ( root->m_number );
 }
 
-//NOLINTBEGIN(misc-no-recursion)
-auto Visitor::traverse_tree ( std::shared_ptr<AST>& node ) -> std::shared_ptr<AST>&
-{
-    if ( node->lhand->is_num() && node->rhand->is_num() ) { return node; }
-    if ( node->lhand->is_num() ) { return traverse_tree ( node->rhand ); }
-    return traverse_tree ( node->lhand );
-}
-//NOLINTEND(misc-no-recursion)
-} // namespace pfme
\ No newline at end of file
+template class basic_visitor<float>;
+template class basic_visitor<double>;
+template class basic_visitor<LD>;
+} // namespace pfme
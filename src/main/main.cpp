@@ -1,13 +1,21 @@
 ﻿#include <algorithm>
+#include <charconv>
+#include <exception>
+#include <fstream>
 #include <iostream>
 #include <iterator>
 #include <locale>
 #include <memory>
+#include <pfme/Columns.hpp>
+#include <pfme/Compiled.hpp>
+#include <pfme/Format.hpp>
 #include <pfme/Lexer.hpp>
-#include <pfme/Parser.hpp>
-#include <pfme/Visitor.hpp>
+#include <pfme/Session.hpp>
+#include <pfme/Supervisor.hpp>
+#include <pfme/Trace.hpp>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -16,64 +24,120 @@ struct Modes
     bool debugInfo     = false;
     bool verboseOutput = false;
     bool german_mode   = false;
+
+    pfme::NumberFormat   format {};          /**< How results are written, shortest round trip by default */
+    bool                 decimals = false;   /**< Numbers with a point are exact decimals, see pfme::Decimal */
+    pfme::DecimalContext decimal_context {}; /**< The scale and rounding of decimal quotients */
+    std::string_view     trace_file {};      /**< Where the trace of all evaluations is written on exit, empty for no trace */
+    bool                 supervised = false; /**< The prompt evaluates in worker processes, see pfme::Supervisor */
+    std::size_t          workers    = 0;     /**< The number of worker processes, 0 for one per core */
+
+    std::string_view expression {};  /**< The expression evaluated for every row of a data file, empty for the REPL */
+    std::string_view csv_file {};    /**< The CSV data file, - for the standard input */
+    std::string_view binary_file {}; /**< The binary data file, - for the standard input */
+    std::string_view columns {};     /**< The comma seperated names of the columns of the binary file */
+    std::string_view output_file {}; /**< Where the results of the data file go, empty or - for the standard output */
+    std::size_t      block_rows = 0; /**< Rows evaluated at once, 0 for the default */
 };
 
 
 auto parse_arguments ( const std::vector<std::string_view>& args ) -> Modes;
+auto evaluate_file ( const Modes& modes ) -> int;
 
 // "5 * 3 * 3 + ( ( 4.3 + 3 * 5 ) + 24 ) * 3 / 7"
 
 int main ( int argc, char** argv )
 {
     [[maybe_unused]] auto* ignore = setlocale ( LC_ALL, "en_US.UTF-8" ); // NOLINT(concurrency-mt-unsafe)
-    std::cout << "\n\tParser for Mathematical expressions - written by Johannes Konstantin Post\n"
-              << "\tFor questions and feedback consult the readme, use --help or -h for more options, q to quit\n"
-              << "\t------------------------------------ Copyright(C) 2023 ------------------------------------\n\n";
     std::vector<std::string_view> args ( argc ); // NOLINT(cppcorequidelines-init-variables)
     for ( int i = 0; i < argc; ++i ) { args.emplace_back ( *std::next ( argv, static_cast<ptrdiff_t> ( i ) ) ); }
 
+    // the results of a data file may go to the standard output, so only the REPL greets
+    const bool data_mode = std::find ( args.begin(), args.end(), "--eval" ) != args.end();
+    if ( !data_mode )
+    {
+        std::cout << "\n\tParser for Mathematical expressions - written by Johannes Konstantin Post\n"
+                  << "\tFor questions and feedback consult the readme, use --help or -h for more options, q to quit\n"
+                  << "\t------------------------------------ Copyright(C) 2023 ------------------------------------\n\n";
+    }
+
     auto modes = parse_arguments ( args );
-    
+    if ( !modes.trace_file.empty() ) { pfme::trace::set_level ( pfme::trace::TRACE_LEVEL::NODES ); }
+    if ( data_mode )
+    {
+        const auto status = evaluate_file ( modes );
+        if ( !modes.trace_file.empty() ) { pfme::trace::save_chrome_trace ( modes.trace_file ); }
+        return status;
+    }
+
+    // one Session for all lines, so its buffers and nodes are reused
+    auto config = modes.german_mode ? pfme::LexerConfig::german() : pfme::LexerConfig::standard();
+    config.set_decimals ( modes.decimals );
+    pfme::Session session ( config );
+    session.set_decimal_context ( modes.decimal_context );
+    // the workers are forked before anything else runs, a line that crashes one only loses that line
+    std::unique_ptr<pfme::Supervisor> supervisor;
+    if ( modes.supervised )
+    {
+        try
+        {
+            supervisor = std::make_unique<pfme::Supervisor> ( pfme::SupervisorOptions {
+                .m_workers = modes.workers, .m_config = config, .m_decimal_context = modes.decimal_context } );
+        }
+        catch ( const std::exception& exception )
+        {
+            std::cerr << exception.what() << '\n';
+            return 1;
+        }
+    }
+    std::string input {};
     while ( true )
     {
         std::cout << "$ = ";
 
-        std::string input {};
-        std::getline ( std::cin, input );
+        if ( !std::getline ( std::cin, input ) ) { break; }
 
         if ( std::all_of ( input.begin(), input.end(), ::isspace ) ) { continue; }
         if ( input == "q" || input == "Q" ) { break; }
-        std::unique_ptr<pfme::Lexer> lexer;
-        if ( !modes.german_mode )
-        {
-            lexer = std::make_unique<pfme::Lexer> ( input ); // NOLINT(cppcorequidelines-init-variables)
-        }
-        else
-        {
-            lexer = std::make_unique<pfme::Lexer> (
-                input, ',', std::vector<char> { '.', '\'', '_' } ); // NOLINT(cppcorequidelines-init-variables)
-        }
 
+        // malformed input is the common case in a REPL, so it is reported without exceptions
+        pfme::Result<pfme::AST::num_t> result { std::unexpect, pfme::Error { pfme::ERROR_CODE::EMPTY_EXPRESSION } };
         try
         {
-            const std::unique_ptr<pfme::Visitor> visitor { std::make_unique<pfme::Visitor> (
-                std::move ( lexer ) ) }; // NOLINT(cppcorequidelines-init-variables)
-            if ( modes.debugInfo )
+            // the tree of a supervised line only exists in the worker, so there is no tree to print
+            if ( supervisor ) { result = supervisor->evaluate ( input ); }
+            else
             {
-                visitor->set_debug_mode ( true );
-                visitor->print_tree();
-                auto res = visitor->visit();
-                std::cout << '\n' << input << " = " << res;
+                auto parsed = session.parse ( input );
+                if ( parsed && modes.debugInfo )
+                {
+                    session.set_debug_mode ( true );
+                    session.print_tree();
+                }
+                result = parsed ? session.evaluate() : pfme::Result<pfme::AST::num_t> { std::unexpect, parsed.error() };
             }
-            else { std::cout << "" << visitor->visit(); }
         }
-        catch ( const std::exception& e )
+        catch ( const std::exception& exception )
+        {
+            // a backstop, a bug that still throws ends the expression and not the whole session
+            std::cerr << ( modes.verboseOutput ? exception.what() : "illformed expression" );
+            std::cout << '\n';
+            continue;
+        }
+        if ( !result )
         {
-            if ( modes.verboseOutput ) { std::cerr << '\n' << e.what(); }
+            if ( modes.verboseOutput ) { std::cerr << '\n' << result.error().message ( input ); }
             else { std::cerr << "illformed expression"; }
+            std::cout << '\n';
+            continue;
         }
+
+        const auto text = pfme::format_number ( *result, modes.format );
+        if ( modes.debugInfo ) { std::cout << '\n' << input << " = " << text; }
+        else { std::cout << text; }
         std::cout << '\n';
     }
+    if ( !modes.trace_file.empty() ) { pfme::trace::save_chrome_trace ( modes.trace_file ); }
 }
 
 
@@ -81,6 +145,22 @@ int main ( int argc, char** argv )
 auto parse_arguments (const std::vector<std::string_view>& args ) -> Modes
 {
     Modes modes;
+    // a number that does not parse completely would silently keep the default, so it ends the program
+    const auto number_of = [] ( std::string_view flag, std::string_view digits, auto& value )
+    {
+        const auto [end, ec] = std::from_chars ( digits.data(), digits.data() + digits.size(), value );
+        if ( ec != std::errc {} || end != digits.data() + digits.size() )
+        {
+            std::cerr << "Invalid value " << digits << " for " << flag << ", see --help\n";
+            exit ( 1 );
+        }
+    };
+    // N is optional, the argument after the flag is only N if it is not the next flag
+    const auto number_after = [&args] ( std::vector<std::string_view>::const_iterator found ) -> std::string_view
+    {
+        const auto next = std::next ( found );
+        return next != args.end() && !next->starts_with ( '-' ) ? *next : std::string_view {};
+    };
     if ( std::find ( args.begin(), args.end(), "-d" ) != args.end() ||
          std::find ( args.begin(), args.end(), "--debug" ) != args.end() )
     {
@@ -96,14 +176,147 @@ auto parse_arguments (const std::vector<std::string_view>& args ) -> Modes
         [[maybe_unused]] auto* ignore = setlocale ( LC_ALL, "de_DE.UTF-8" );
         modes.german_mode             = true;
     }
+    for ( const auto& [flag, format] : { std::pair { "--fixed", pfme::NUMBER_FORMAT::FIXED },
+                                         std::pair { "--precision", pfme::NUMBER_FORMAT::PRECISION } } )
+    {
+        const auto found = std::find ( args.begin(), args.end(), flag );
+        if ( found == args.end() ) { continue; }
+        modes.format.m_format = format;
+        if ( const auto digits = number_after ( found ); !digits.empty() )
+        {
+            number_of ( flag, digits, modes.format.m_precision );
+        }
+    }
+    if ( const auto found = std::find ( args.begin(), args.end(), "--workers" ); found != args.end() )
+    {
+        modes.supervised = true;
+        if ( const auto digits = number_after ( found ); !digits.empty() ) { number_of ( "--workers", digits, modes.workers ); }
+    }
+    if ( const auto found = std::find ( args.begin(), args.end(), "--decimal" ); found != args.end() )
+    {
+        modes.decimals = true;
+        if ( const auto digits = number_after ( found ); !digits.empty() )
+        {
+            int scale = modes.decimal_context.m_scale;
+            number_of ( "--decimal", digits, scale );
+            scale                         = std::clamp ( scale, 0, int { pfme::Decimal::MAX_SCALE } );
+            modes.decimal_context.m_scale = static_cast<std::uint8_t> ( scale );
+        }
+    }
+    const auto value_of = [&args] ( std::string_view flag ) -> std::string_view
+    {
+        const auto found = std::find ( args.begin(), args.end(), flag );
+        return found != args.end() && std::next ( found ) != args.end() ? *std::next ( found ) : std::string_view {};
+    };
+    modes.trace_file  = value_of ( "--trace" );
+    modes.expression  = value_of ( "--eval" );
+    modes.csv_file    = value_of ( "--csv" );
+    modes.binary_file = value_of ( "--binary" );
+    modes.columns     = value_of ( "--columns" );
+    modes.output_file = value_of ( "--output" );
+    if ( const auto rows = value_of ( "--block" ); !rows.empty() ) { number_of ( "--block", rows, modes.block_rows ); }
     if ( std::find ( args.begin(), args.end(), "-h" ) != args.end() ||
          std::find ( args.begin(), args.end(), "--help" ) != args.end() )
     {
         std::cout << "\nPossible arguments are:\n"
                   << "\t-d, --debug    activate debug mode for more verbose output\n"
                   << "\t-ger           activate german input mode (the comma seperator and the point switch roles)\n"
+                  << "\t--fixed N      print results with N digits after the point (default is the shortest exact form)\n"
+                  << "\t--precision N  print results with N significant digits\n"
+                  << "\t--decimal N    exact decimal math for numbers with a point, quotients are rounded to N digits,\n"
+                  << "\t               only at the prompt, --eval computes every row in double\n"
+                  << "\t--workers N    evaluate every line of the prompt in N worker processes (0 for one per core), a\n"
+                  << "\t               line that crashes or hangs a worker only loses its own result\n"
+                  << "\t--trace FILE   record every evaluation and write a Chrome trace (chrome://tracing, Perfetto) on exit\n"
+                  << "\t--eval EXPR    evaluate EXPR for every row of a data file instead of starting the prompt, the\n"
+                  << "\t               variables of EXPR are read from the columns with their names\n"
+                  << "\t--csv FILE     the data file is a CSV file with a header row (- for the standard input), with -ger\n"
+                  << "\t               its fields are seperated by ; and its numbers use , as point\n"
+                  << "\t--binary FILE  the data file is raw little-endian doubles, one for every column per row\n"
+                  << "\t--columns A,B  the names of the columns of the binary file\n"
+                  << "\t--output FILE  write the results to FILE instead of the standard output\n"
+                  << "\t--block N      evaluate N rows at once (default 65536)\n"
                   << "\t-h, --help     show all possible arguments\n\n";
         exit ( 0 );
     }
     return modes;
 }
+
+auto evaluate_file ( const Modes& modes ) -> int
+{
+    // the rows are evaluated in double, exact decimals would be silently lost
+    if ( modes.decimals )
+    {
+        std::cerr << "--decimal can not be used with --eval, see --help\n";
+        return 1;
+    }
+    // the rows are compiled and evaluated in this process, the workers would never be asked
+    if ( modes.supervised )
+    {
+        std::cerr << "--workers can not be used with --eval, see --help\n";
+        return 1;
+    }
+    const auto config = modes.german_mode ? pfme::LexerConfig::german() : pfme::LexerConfig::standard();
+    // every error of the expression or the file ends in a message, not in std::terminate
+    try
+    {
+        const auto expression = pfme::CompiledExpression::compile ( modes.expression, config );
+        if ( !expression )
+        {
+            std::cerr << expression.error().message ( modes.expression ) << '\n';
+            return 1;
+        }
+        const bool binary = !modes.binary_file.empty();
+        const auto path   = binary ? modes.binary_file : modes.csv_file;
+        if ( path.empty() )
+        {
+            std::cerr << "--eval needs a data file, see --help\n";
+            return 1;
+        }
+
+        std::ios::sync_with_stdio ( false );
+        std::ifstream input_file;
+        std::ofstream output_file;
+        if ( path != "-" ) { input_file.open ( std::string ( path ), std::ios::binary ); }
+        if ( !modes.output_file.empty() && modes.output_file != "-" )
+        {
+            output_file.open ( std::string ( modes.output_file ), std::ios::binary | std::ios::trunc );
+        }
+        std::istream& input  = path != "-" ? input_file : std::cin;
+        std::ostream& output = output_file.is_open() ? output_file : std::cout;
+        if ( !input || !output )
+        {
+            std::cerr << "Could not open " << ( !input ? path : modes.output_file ) << '\n';
+            return 1;
+        }
+
+        pfme::ColumnOptions options;
+        options.m_seperator    = modes.german_mode ? ';' : ',';
+        options.m_point_symbol = config.get_point_symbol();
+        if ( modes.block_rows != 0 ) { options.m_block_rows = modes.block_rows; }
+        if ( binary )
+        {
+            std::vector<std::string> columns;
+            for ( std::size_t begin = 0; begin <= modes.columns.size(); )
+            {
+                const auto end = std::min ( modes.columns.find ( ',', begin ), modes.columns.size() );
+                columns.emplace_back ( modes.columns.substr ( begin, end - begin ) );
+                begin = end + 1;
+            }
+            pfme::evaluate_binary ( *expression, input, columns, output, options );
+        }
+        else { pfme::evaluate_csv ( *expression, input, output, options ); }
+        output.flush();
+        if ( !output )
+        {
+            std::cerr << "Could not write the results\n";
+            return 1;
+        }
+    }
+    catch ( const std::exception& error )
+    {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
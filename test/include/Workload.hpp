@@ -0,0 +1,165 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pfme::workload
+{
+/**
+ * @brief The knobs of the generator.
+ *
+ * The weights do not have to add up to anything, an operator or number type with weight 0 is never generated.
+ */
+struct Options
+{
+    std::size_t m_operands  = 64; /**< The number of numbers in the expression */
+    int         m_max_depth = 4;  /**< The maximum nesting depth of parenthesis */
+
+    double m_open_probability     = 0.15; /**< The chance to open a parenthesis in front of a number */
+    double m_close_probability    = 0.3;  /**< The chance to close a parenthesis after a number */
+    double m_negative_probability = 0.05; /**< The chance of a leading '-' in front of a number */
+
+    /** The weights of +, -, *, / and ^ (in that order) */
+    std::array<unsigned, 5> m_operator_weights { 4, 3, 2, 1, 0 };
+
+    unsigned m_integer_weight = 1; /**< The weight of integers */
+    unsigned m_float_weight   = 1; /**< The weight of floats */
+    int      m_max_digits     = 4; /**< The maximum number of digits in front of the point */
+
+    char              m_point_symbol          = '.';           /**< The decimal point, has to match the Lexer */
+    std::vector<char> m_seperators            = { '\'', '_' }; /**< The digit seperators, have to match the Lexer */
+    double            m_seperator_probability = 0.0;           /**< The chance of a seperator between two digits */
+    double            m_space_probability     = 0.5;           /**< The chance of a space between two tokens */
+
+    std::uint64_t m_seed = 0x5EED; /**< The seed, equal seeds and options generate equal expressions */
+};
+
+/**
+ * @brief Generates random but valid expressions.
+ *
+ * The generator uses its own random number generator and distributions, so the output is the same on all platforms.
+ * Numbers never start with a 0, exponents are always a single digit integer and never followed by another '^', which
+ * keeps the integer exponentiation cheap. Division by zero can still happen if a divisor evaluates to 0.
+ */
+class Generator
+{
+public:
+    explicit Generator ( Options options )
+        : m_options ( std::move ( options ) )
+        , m_state ( m_options.m_seed )
+    {
+    }
+
+    /**
+     * Generates the next expression.
+     * @return An expression with exactly m_operands numbers
+     */
+    auto generate() -> std::string
+    {
+        std::string out;
+        out.reserve ( m_options.m_operands * static_cast<std::size_t> ( m_options.m_max_digits + 4 ) );
+        int  depth            = 0;
+        bool exponent_operand = false;
+        for ( std::size_t i = 0; i < m_options.m_operands; ++i )
+        {
+            if ( !exponent_operand )
+            {
+                while ( depth < m_options.m_max_depth && chance ( m_options.m_open_probability ) )
+                {
+                    token ( out, '(' );
+                    ++depth;
+                }
+                if ( chance ( m_options.m_negative_probability ) ) { token ( out, '-' ); }
+                number ( out );
+            }
+            else { token ( out, static_cast<char> ( '0' + below ( 4 ) ) ); }
+
+            while ( depth > 0 && chance ( m_options.m_close_probability ) )
+            {
+                token ( out, ')' );
+                --depth;
+            }
+            if ( i + 1 == m_options.m_operands ) { break; }
+
+            const auto op    = pick_operator ( exponent_operand );
+            exponent_operand = op == '^';
+            token ( out, op );
+        }
+        while ( depth-- > 0 ) { token ( out, ')' ); }
+        return out;
+    }
+
+    /**
+     * The next raw random number (splitmix64).
+     * @return A uniformly distributed 64 bit number
+     */
+    auto next() -> std::uint64_t
+    {
+        std::uint64_t z = ( m_state += 0x9E3779B97F4A7C15ULL );
+        z               = ( z ^ ( z >> 30U ) ) * 0xBF58476D1CE4E5B9ULL;
+        z               = ( z ^ ( z >> 27U ) ) * 0x94D049BB133111EBULL;
+        return z ^ ( z >> 31U );
+    }
+
+private:
+    Options       m_options;
+    std::uint64_t m_state;
+
+    auto below ( std::uint64_t bound ) -> std::uint64_t { return bound == 0 ? 0 : next() % bound; }
+    auto chance ( double probability ) -> bool
+    {
+        return static_cast<double> ( next() >> 11U ) * 0x1.0p-53 < probability;
+    }
+
+    auto token ( std::string& out, char symbol ) -> void
+    {
+        out += symbol;
+        if ( chance ( m_options.m_space_probability ) ) { out += ' '; }
+    }
+
+    auto digits ( std::string& out, int count, bool leading ) -> void
+    {
+        for ( int i = 0; i < count; ++i )
+        {
+            if ( i > 0 && !m_options.m_seperators.empty() && chance ( m_options.m_seperator_probability ) )
+            {
+                out += m_options.m_seperators[below ( m_options.m_seperators.size() )];
+            }
+            out += static_cast<char> ( leading && i == 0 ? '1' + below ( 9 ) : '0' + below ( 10 ) );
+        }
+    }
+
+    auto number ( std::string& out ) -> void
+    {
+        const auto total = std::uint64_t { m_options.m_integer_weight } + m_options.m_float_weight;
+        digits ( out, 1 + static_cast<int> ( below ( static_cast<std::uint64_t> ( m_options.m_max_digits ) ) ), true );
+        if ( below ( total ) >= m_options.m_integer_weight )
+        {
+            out += m_options.m_point_symbol;
+            digits ( out, 1 + static_cast<int> ( below ( 3 ) ), true );
+        }
+        if ( chance ( m_options.m_space_probability ) ) { out += ' '; }
+    }
+
+    auto pick_operator ( bool after_exponent ) -> char
+    {
+        static constexpr std::array<char, 5> OPERATORS { '+', '-', '*', '/', '^' };
+        std::uint64_t                        total = 0;
+        for ( std::size_t i = 0; i < OPERATORS.size(); ++i )
+        {
+            if ( !( after_exponent && OPERATORS[i] == '^' ) ) { total += m_options.m_operator_weights[i]; }
+        }
+        if ( total == 0 ) { return '+'; }
+        auto roll = below ( total );
+        for ( std::size_t i = 0; i < OPERATORS.size(); ++i )
+        {
+            if ( after_exponent && OPERATORS[i] == '^' ) { continue; }
+            if ( roll < m_options.m_operator_weights[i] ) { return OPERATORS[i]; }
+            roll -= m_options.m_operator_weights[i];
+        }
+        return '+';
+    }
+};
+} // namespace pfme::workload
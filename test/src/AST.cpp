@@ -30,11 +30,13 @@ TEST ( AST, Constructor )
     ASSERT_NE ( ast_node.lhand, nullptr );
 
     ASSERT_EQ ( ast_float.m_type, pfme::AST_TYPE::FLOAT );
-    ASSERT_EQ ( ast_float.m_value, std::to_string ( 2.37l ) );
+    ASSERT_TRUE ( ast_float.m_value.empty() );
+    ASSERT_EQ ( ast_float.to_string(), std::to_string ( 2.37l ) );
     ASSERT_DOUBLE_EQ ( std::get<LD> ( ast_float.m_number ), 2.37l );
 
     ASSERT_EQ ( ast_integer.m_type, pfme::AST_TYPE::INTEGER );
-    ASSERT_EQ ( ast_integer.m_value, std::to_string ( 5 ) );
+    ASSERT_TRUE ( ast_integer.m_value.empty() );
+    ASSERT_EQ ( ast_integer.to_string(), std::to_string ( 5 ) );
     ASSERT_EQ ( std::get<LLI> ( ast_integer.m_number ), 5 );
 }
 
@@ -134,6 +136,24 @@ TEST ( AST, exponent_operator )
     ASSERT_EQ ( std::get<LLI> ( ( ast_float ^ ast_zero_f ).m_number ), 1 );
 }
 
+TEST ( AST, deep_teardown )
+{
+    constexpr int depth = 1'000'000;
+    auto          root  = std::make_shared<pfme::AST> ( 1LL );
+    for ( int i = 0; i < depth; ++i )
+    {
+        auto node    = std::make_shared<pfme::AST> ( std::move ( root ) );
+        node->m_type = pfme::AST_TYPE::ADDITION;
+        node->rhand  = std::make_shared<pfme::AST> ( 1LL );
+        root         = std::move ( node );
+    }
+    auto shared_leaf = root->lhand->rhand;
+    root.reset();
+
+    ASSERT_EQ ( shared_leaf.use_count(), 1 );
+    ASSERT_EQ ( std::get<LLI> ( shared_leaf->m_number ), 1 );
+}
+
 int main ( int argc, char** argv )
 {
     ::testing::InitGoogleTest ( &argc, argv );
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <pfme/Canonical.hpp>
+#include <pfme/Compiled.hpp>
+#include <pfme/Parser.hpp>
+#include <string>
+#include <vector>
+
+namespace
+{
+auto hash ( const std::string& input, pfme::CANONICAL mode = pfme::CANONICAL::EXACT ) -> pfme::Hash128
+{
+    return pfme::canonical_hash ( input, pfme::LexerConfig::standard(), mode ).value();
+}
+} // namespace
+
+TEST ( Canonical, equal_expressions )
+{
+    // the way an expression is written does not matter
+    ASSERT_EQ ( hash ( "1'000 * x + 2" ), hash ( "1_000*x+2" ) );
+    ASSERT_EQ ( hash ( "1'000 * x + 2" ), hash ( "((0x3E8) * (x)) + 2" ) );
+    ASSERT_EQ ( hash ( "sqrt(x) * 1.50" ), hash ( "sqrt( x )*1.5" ) );
+
+    // commutative operands are ordered
+    ASSERT_EQ ( hash ( "a + b" ), hash ( "b + a" ) );
+    ASSERT_EQ ( hash ( "a * sqrt(b)" ), hash ( "sqrt(b) * a" ) );
+    ASSERT_EQ ( hash ( "a == b ? 1 : 2" ), hash ( "b == a ? 1 : 2" ) );
+    ASSERT_NE ( hash ( "a - b" ), hash ( "b - a" ) );
+    ASSERT_NE ( hash ( "a / b" ), hash ( "b / a" ) );
+    ASSERT_NE ( hash ( "a < b" ), hash ( "b < a" ) );
+    ASSERT_NE ( hash ( "max(a, b)" ), hash ( "max(b, a)" ) );
+
+    // chains are only flattened if they may be reassociated
+    ASSERT_NE ( hash ( "a + (b + c)" ), hash ( "(a + b) + c" ) );
+    ASSERT_EQ ( hash ( "a + (b + c)", pfme::CANONICAL::ASSOCIATIVE ), hash ( "(c + b) + a", pfme::CANONICAL::ASSOCIATIVE ) );
+    ASSERT_EQ ( hash ( "2 * x * (y * 3)", pfme::CANONICAL::ASSOCIATIVE ),
+                hash ( "y * 3 * x * 2", pfme::CANONICAL::ASSOCIATIVE ) );
+    ASSERT_NE ( hash ( "a + b * c", pfme::CANONICAL::ASSOCIATIVE ), hash ( "(a + b) * c", pfme::CANONICAL::ASSOCIATIVE ) );
+
+    // different numbers, types and names are different expressions
+    ASSERT_NE ( hash ( "2 * x" ), hash ( "2 * y" ) );
+    ASSERT_NE ( hash ( "1 / 2" ), hash ( "0.5" ) );
+    ASSERT_NE ( hash ( "1" ), hash ( "1.0" ) );
+    ASSERT_NE ( hash ( "sqrt(4)" ), hash ( "exp(4)" ) );
+
+    ASSERT_EQ ( pfme::canonical_hash ( "1 +* 2" ).error().m_code, pfme::ERROR_CODE::INVALID_TOKEN );
+}
+
+TEST ( Canonical, canonical_tree )
+{
+    for ( const auto mode : { pfme::CANONICAL::EXACT, pfme::CANONICAL::ASSOCIATIVE } )
+    {
+        const std::string input = "y * 3 + 0x10 * max(x, y) - (x > y ? x : 2 * y) + 1 / 3";
+        pfme::Parser      parser ( input );
+        const auto        canonical = pfme::canonicalize ( parser.parse().get(), mode );
+        // the hash of the canonical tree is the canonical hash, and the canonical tree is its own canonical form
+        ASSERT_EQ ( pfme::structural_hash ( canonical.get() ), hash ( input, mode ) );
+        ASSERT_EQ ( pfme::structural_hash ( pfme::canonicalize ( canonical.get(), mode ).get() ), hash ( input, mode ) );
+        ASSERT_NE ( pfme::structural_hash ( parser.get_root().get() ), hash ( input, mode ) );
+
+        const auto original = pfme::CompiledExpression ( parser.get_root().get() );
+        const auto ordered  = pfme::CompiledExpression ( canonical.get() );
+        for ( const auto x : { -2LL, 5LL } )
+        {
+            const std::vector<pfme::AST::num_t> values { 7LL, x };
+            const std::vector<pfme::AST::num_t> swapped { x, 7LL };
+            const auto&                         ordered_values = ordered.get_variables()[0] == "y" ? values : swapped;
+            ASSERT_EQ ( ordered.evaluate<pfme::LD> ( ordered_values ).value(), original.evaluate<pfme::LD> ( values ).value() );
+        }
+    }
+
+    // the hash is part of the keys of caches, it must not change between versions
+    ASSERT_EQ ( hash ( "1 + 2 * x" ).to_string(), "53c9fb1a8e9f428530781e2d722c2230" );
+    ASSERT_EQ ( hash ( "x * 2 + 1" ).m_low, 0x3078'1e2d'722c'2230ULL );
+}
+
+TEST ( Canonical, deep_trees )
+{
+    constexpr int depth = 200'000;
+    std::string   chain;
+    for ( int i = 0; i < depth; ++i ) { chain += std::to_string ( i % 7 ) + "+"; }
+    chain += 'x';
+
+    std::string reversed = "x";
+    for ( int i = depth; i-- > 0; ) { reversed += "+" + std::to_string ( i % 7 ); }
+    ASSERT_EQ ( hash ( chain, pfme::CANONICAL::ASSOCIATIVE ), hash ( reversed, pfme::CANONICAL::ASSOCIATIVE ) );
+    ASSERT_NE ( hash ( chain ), hash ( reversed ) );
+
+    pfme::Parser parser ( chain );
+    const auto   canonical = pfme::canonicalize ( parser.parse().get(), pfme::CANONICAL::ASSOCIATIVE );
+    ASSERT_EQ ( pfme::structural_hash ( canonical.get() ), hash ( reversed, pfme::CANONICAL::ASSOCIATIVE ) );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
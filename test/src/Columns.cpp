@@ -0,0 +1,190 @@
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <gtest/gtest.h>
+#include <map>
+#include <pfme/Columns.hpp>
+#include <pfme/Compiled.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+auto compile ( const std::string& input ) -> pfme::CompiledExpression
+{
+    auto compiled = pfme::CompiledExpression::compile ( input );
+    if ( !compiled ) { throw std::runtime_error ( "Can not compile " + input ); }
+    return *compiled;
+}
+
+auto csv ( const std::string& expression, const std::string& input, std::size_t block_rows = 4 ) -> std::string
+{
+    std::istringstream  in ( input );
+    std::ostringstream  out;
+    pfme::ColumnOptions options;
+    options.m_block_rows = block_rows;
+    pfme::evaluate_csv ( compile ( expression ), in, out, options );
+    return out.str();
+}
+
+auto to_bytes ( const std::vector<double>& values ) -> std::string
+{
+    std::string bytes ( values.size() * sizeof ( double ), '\0' );
+    std::memcpy ( bytes.data(), values.data(), bytes.size() );
+    return bytes;
+}
+} // namespace
+
+TEST ( Columns, batch_matches_scalar )
+{
+    constexpr std::size_t ROWS = 700; // several blocks and a partial one
+    for ( const std::string input :
+          { "price * qty * (1 + tax)", "sqrt(price) - max(qty, 3, tax * 100) / 7", "1 / 3 + qty ^ 2 - abs(-tax)" } )
+    {
+        const auto          expression = compile ( input );
+        std::vector<double> price ( ROWS );
+        std::vector<double> qty ( ROWS );
+        std::vector<double> tax ( ROWS );
+        for ( std::size_t row = 0; row < ROWS; ++row )
+        {
+            price[row] = 1.25 * static_cast<double> ( row );
+            qty[row]   = static_cast<double> ( row % 13 );
+            tax[row]   = 0.01 * static_cast<double> ( row % 7 );
+        }
+        const std::map<std::string, std::span<const double>, std::less<>> data {
+            { "price", price }, { "qty", qty }, { "tax", tax } };
+        std::vector<std::span<const double>>                              columns;
+        for ( const auto& name : expression.get_variables() ) { columns.push_back ( data.find ( name )->second ); }
+        std::vector<double> results ( ROWS );
+        expression.evaluate_batch<double> ( columns, results );
+
+        for ( std::size_t row = 0; row < ROWS; ++row )
+        {
+            std::vector<pfme::basic_num_t<double>> values;
+            for ( const auto column : columns ) { values.emplace_back ( column[row] ); }
+            const auto expected = std::get<double> ( *expression.evaluate<double> ( values ) );
+            ASSERT_NEAR ( results[row], expected, 1e-12 * ( 1 + std::abs ( expected ) ) ) << input << " row " << row;
+        }
+    }
+
+    // rows outside of the domain do not stop the others
+    const auto          expression = compile ( "sqrt(x) / (x - 4)" );
+    const std::vector   x { 4.0, -1.0, 9.0 };
+    std::vector<double> results ( 3 );
+    expression.evaluate_batch<double> ( std::vector<std::span<const double>> { x }, results );
+    ASSERT_TRUE ( std::isinf ( results[0] ) );
+    ASSERT_TRUE ( std::isnan ( results[1] ) );
+    ASSERT_DOUBLE_EQ ( results[2], 0.6 );
+
+    std::vector<float> single ( 3 );
+    const std::vector  x_single { 4.0F, 16.0F, 9.0F };
+    compile ( "sqrt(x) * 2" ).evaluate_batch<float> ( std::vector<std::span<const float>> { x_single }, single );
+    ASSERT_EQ ( single, ( std::vector<float> { 4, 8, 6 } ) );
+
+    ASSERT_THROW ( expression.evaluate_batch<double> ( {}, results ), std::runtime_error );
+    ASSERT_THROW ( expression.evaluate_batch<double> ( std::vector<std::span<const double>> { x },
+                                                       std::span<double> ( results ).first ( 2 ) ),
+                   std::runtime_error );
+}
+
+TEST ( Columns, csv )
+{
+    ASSERT_EQ ( csv ( "price * qty * (1 + tax)", "id,price,qty,tax\n1,2.5,4,0.5\n2,10,1,0\n" ), "result\n15\n10\n" );
+    ASSERT_THROW ( csv ( "b - a", "a;b\n1;2\n" ), std::runtime_error ); // the seperator is ','
+    // the columns are found by name, other columns are skipped, even if they are not numbers
+    pfme::ColumnOptions options;
+    options.m_seperator   = ';';
+    options.m_output_name = "difference";
+    std::istringstream in ( " \"a\" ; b ;name\r\n1;2;x\r\n\r\n+3 ; 1e1;y\r\n-0.5;0.25;z" );
+    std::ostringstream out;
+    ASSERT_EQ ( pfme::evaluate_csv ( compile ( "b - a" ), in, out, options ), 3 );
+    ASSERT_EQ ( out.str(), "difference\n1\n7\n0.75\n" );
+
+    // german files use ',' as point, for the numbers that are read as well as the written results
+    options.m_point_symbol = ',';
+    options.m_output_name  = "result";
+    std::istringstream german ( "a;b\n1,5;2\n-0,25;1e1\n" );
+    out.str ( "" );
+    ASSERT_EQ ( pfme::evaluate_csv ( compile ( "a * b" ), german, out, options ), 2 );
+    ASSERT_EQ ( out.str(), "result\n3\n-2,5\n" );
+    std::istringstream point ( "a;b\n1.5;2\n" );
+    ASSERT_THROW ( pfme::evaluate_csv ( compile ( "a * b" ), point, out, options ), std::runtime_error );
+
+    // many blocks
+    std::string input    = "x\n";
+    std::string expected = "result\n";
+    for ( int i = 0; i < 1000; ++i )
+    {
+        input += std::to_string ( i ) + "\n";
+        expected += std::to_string ( i * 2 ) + "\n";
+    }
+    ASSERT_EQ ( csv ( "x * 2", input, 7 ), expected );
+    ASSERT_EQ ( csv ( "x * 2", input, 1 ), expected );
+
+    // a line that is longer than the read buffer
+    ASSERT_EQ ( csv ( "x + y", "x,y\n1" + std::string ( 3 << 20, ' ' ) + ",2\n" ), "result\n3\n" );
+    // '_' is a digit seperator, but inside a name it is part of the name
+    ASSERT_EQ ( csv ( "unit_price * qty", "unit_price,qty\n2.5,4\n3,2\n" ), "result\n10\n6\n" );
+    // an expression without variables still has one result per row
+    ASSERT_EQ ( csv ( "2 ^ 3", "x\n1\n2\n" ), "result\n8\n8\n" );
+}
+
+TEST ( Columns, csv_errors )
+{
+    ASSERT_THROW ( csv ( "x", "" ), std::runtime_error );
+    ASSERT_THROW ( csv ( "x + z", "x,y\n1,2\n" ), std::runtime_error );
+    ASSERT_THROW ( csv ( "x + y", "x,y\n1\n" ), std::runtime_error );
+    ASSERT_THROW ( csv ( "x + y", "x,y\n1,2\n3,four\n" ), std::runtime_error );
+    ASSERT_THROW ( csv ( "x + y", "x,y\n1,2\n3,\n" ), std::runtime_error );
+    ASSERT_THROW ( csv ( "x", "x\n1e999\n" ), std::runtime_error );
+    try
+    {
+        csv ( "x", "x\n1\n2\n3.3.3\n" );
+        FAIL();
+    }
+    catch ( const std::runtime_error& error )
+    {
+        ASSERT_STREQ ( error.what(), "Invalid number '3.3.3' in row 4, column 1" );
+    }
+}
+
+TEST ( Columns, binary )
+{
+    static_assert ( std::endian::native == std::endian::little, "the test writes the file in native order" );
+    const auto                     expression = compile ( "price * qty * (1 + tax)" );
+    const std::vector<std::string> columns { "qty", "unused", "tax", "price" };
+    std::vector<double>            rows;
+    std::vector<double>            expected;
+    for ( int i = 0; i < 1000; ++i )
+    {
+        const double qty   = i % 10;
+        const double tax   = 0.25;
+        const double price = 2.0 * i;
+        rows.insert ( rows.end(), { qty, -1.0, tax, price } );
+        expected.push_back ( price * qty * ( 1 + tax ) );
+    }
+
+    pfme::ColumnOptions options;
+    options.m_block_rows = 64;
+    std::istringstream in ( to_bytes ( rows ) );
+    std::ostringstream out;
+    ASSERT_EQ ( pfme::evaluate_binary ( expression, in, columns, out, options ), 1000 );
+    ASSERT_EQ ( out.str(), to_bytes ( expected ) );
+
+    std::istringstream partial ( to_bytes ( rows ).substr ( 0, 100 ) );
+    ASSERT_THROW ( pfme::evaluate_binary ( expression, partial, columns, out ), std::runtime_error );
+    std::istringstream missing ( to_bytes ( rows ) );
+    ASSERT_THROW ( pfme::evaluate_binary ( expression, missing, std::vector<std::string> { "qty", "price" }, out ),
+                   std::runtime_error );
+    std::istringstream empty;
+    ASSERT_EQ ( pfme::evaluate_binary ( expression, empty, columns, out ), 0 );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+#include <pfme/Compiled.hpp>
+#include <pfme/Visitor.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST ( Compiled, same_results_as_visitor )
+{
+    for ( const std::string input : { "5 * 3 * 3 + ( ( 4.3 + 3 * 5 ) + 24 ) * 3 / 7",
+                                      "1 / 3 + 2^-2",
+                                      "max(1, 2 + 3, -sqrt(16)) * 2",
+                                      "0x10 + 1.5e3",
+                                      "42" } )
+    {
+        const auto compiled = pfme::CompiledExpression::compile ( input );
+        ASSERT_TRUE ( compiled ) << input;
+        ASSERT_EQ ( *compiled->evaluate(), *pfme::Visitor ( input ).try_evaluate() ) << input;
+        ASSERT_EQ ( *compiled->evaluate<double>(), *pfme::basic_visitor<double> ( input ).try_evaluate() ) << input;
+        ASSERT_EQ ( *compiled->evaluate<float>(), *pfme::basic_visitor<float> ( input ).try_evaluate() ) << input;
+        // evaluating does not change the expression
+        ASSERT_EQ ( *compiled->evaluate(), *compiled->evaluate() ) << input;
+    }
+}
+
+TEST ( Compiled, errors )
+{
+    ASSERT_EQ ( pfme::CompiledExpression::compile ( "1 +* 2" ).error().m_code, pfme::ERROR_CODE::INVALID_TOKEN );
+    ASSERT_EQ ( pfme::CompiledExpression::compile ( "max(1;2)", pfme::LexerConfig::german() )->evaluate().value(),
+                pfme::AST::num_t { 2LL } );
+
+    const auto division = pfme::CompiledExpression::compile ( "1 / (2 - 2)" );
+    ASSERT_TRUE ( division );
+    ASSERT_EQ ( division->evaluate().error().m_code, pfme::ERROR_CODE::DIVISION_BY_ZERO );
+    ASSERT_EQ ( pfme::CompiledExpression::compile ( "sqrt(-1)" )->evaluate().error().m_code, pfme::ERROR_CODE::DOMAIN_ERROR );
+}
+
+TEST ( Compiled, from_trees_and_serialized_nodes )
+{
+    pfme::Parser                   parser ( "2 * (3 + max(4, 5))" );
+    const pfme::CompiledExpression from_tree ( parser.parse().get() );
+    ASSERT_EQ ( from_tree.evaluate().value(), pfme::AST::num_t { 16LL } );
+
+    const auto                     buffer = pfme::serialize ( parser.get_root().get() );
+    const pfme::CompiledExpression from_nodes ( pfme::validate ( buffer ) );
+    ASSERT_EQ ( from_nodes.evaluate().value(), pfme::AST::num_t { 16LL } );
+    ASSERT_EQ ( from_nodes.get_nodes().size(), from_tree.get_nodes().size() );
+    ASSERT_EQ ( pfme::evaluate ( from_nodes.get_nodes() ).m_number, pfme::AST::num_t { 16LL } );
+    ASSERT_EQ ( from_nodes.to_ast()->m_type, pfme::AST_TYPE::MULTIPLICATION );
+
+    // copies are handles to the same nodes
+    const auto copy = from_tree; // NOLINT(performance-unnecessary-copy-initialization)
+    ASSERT_EQ ( copy.get_nodes().data(), from_tree.get_nodes().data() );
+    // names longer than a node keep their full name in memory, only serializing them fails
+    const auto long_names = pfme::CompiledExpression::compile ( "averylongcolumnnamehere * b + averylongcolumnnamehere" );
+    ASSERT_TRUE ( long_names );
+    ASSERT_EQ ( long_names->get_variables()[0], "averylongcolumnnamehere" );
+    ASSERT_EQ ( long_names->find_variable ( "averylongcolumnnamehere" ), 0 );
+    ASSERT_EQ ( long_names->evaluate<pfme::LD> ( std::vector<pfme::AST::num_t> { 3LL, 4LL } ).value(),
+                pfme::AST::num_t { 15LL } );
+    const auto specialized = long_names->specialize ( std::vector<pfme::Binding> { { "b", pfme::AST::num_t { 2LL } } } );
+    ASSERT_EQ ( specialized.get_variables()[0], "averylongcolumnnamehere" );
+    ASSERT_EQ ( specialized.to_ast()->lhand->lhand->m_value, "averylongcolumnnamehere" );
+    ASSERT_ANY_THROW ( pfme::serialize ( long_names->to_ast().get() ) );
+}
+
+TEST ( Compiled, shared_between_threads )
+{
+    std::string input = "sqrt(2.5) * 3";
+    for ( int i = 0; i < 200; ++i ) { input += " + " + std::to_string ( i ) + " / 7 ^ 2 - max(1, 2.5)"; }
+    const auto compiled = pfme::CompiledExpression::compile ( input );
+    ASSERT_TRUE ( compiled );
+    const auto expected = compiled->evaluate().value();
+
+    constexpr int            THREADS = 8;
+    std::vector<int>         mismatches ( THREADS, 0 );
+    std::vector<std::thread> threads;
+    for ( int thread = 0; thread < THREADS; ++thread )
+    {
+        threads.emplace_back (
+            [&, thread]
+            {
+                pfme::EvaluationContext context;
+                for ( int round = 0; round < 500; ++round )
+                {
+                    // both the thread local context and an own one
+                    const auto result = round % 2 == 0 ? compiled->evaluate() : compiled->evaluate ( context );
+                    if ( !result || *result != expected ) { ++mismatches[static_cast<std::size_t> ( thread )]; }
+                }
+            } );
+    }
+    for ( auto& thread : threads ) { thread.join(); }
+    ASSERT_EQ ( mismatches, std::vector<int> ( THREADS, 0 ) );
+}
+
+TEST ( Compiled, conditions )
+{
+    for ( const std::string input :
+          { "1 + 2 < 4 && 3 > 2 || 0", "2 < 1 ? 5 : 1 > 0 ? 6 : 7", "1 ? 0 ? 5 : 6 : 7", "0 != 0 ? 1/0 : 9", "0 && 1/0" } )
+    {
+        const auto compiled = pfme::CompiledExpression::compile ( input );
+        ASSERT_TRUE ( compiled ) << input;
+        ASSERT_EQ ( *compiled->evaluate(), *pfme::Visitor ( input ).try_evaluate() ) << input;
+    }
+
+    // only the taken branch is evaluated, in a batch both are computed and the result is selected per row
+    const auto relu = pfme::CompiledExpression::compile ( "x > 0 ? sqrt(x) : 0" );
+    ASSERT_TRUE ( relu );
+    ASSERT_EQ ( relu->evaluate<double> ( std::vector<pfme::basic_num_t<double>> { -4.0 } ).value(),
+                pfme::basic_num_t<double> { 0LL } );
+    ASSERT_EQ ( relu->evaluate<double> ( std::vector<pfme::basic_num_t<double>> { 4.0 } ).value(),
+                pfme::basic_num_t<double> { 2.0 } );
+
+    const std::vector<double> x { -4, 0, 4, 9 };
+    std::vector<double>       results ( x.size() );
+    relu->evaluate_batch<double> ( std::vector<std::span<const double>> { x }, results );
+    ASSERT_EQ ( results, ( std::vector<double> { 0, 0, 2, 3 } ) );
+
+    const std::vector<double> y { 1, -1, 2, 0 };
+    const auto logical = pfme::CompiledExpression::compile ( "x < y || y == 0" );
+    logical->evaluate_batch<double> ( std::vector<std::span<const double>> { x, y }, results );
+    ASSERT_EQ ( results, ( std::vector<double> { 1, 0, 0, 1 } ) );
+}
+
+TEST ( Compiled, specialize )
+{
+    const auto expression = pfme::CompiledExpression::compile ( "a * x + sqrt(b) * 2 - x / c + max(a, b, x)" );
+    ASSERT_TRUE ( expression );
+    const std::vector<pfme::Binding> bindings { { "c", pfme::AST::num_t { 4LL } },
+                                                { "b", pfme::AST::num_t { 16LL } },
+                                                { "z", pfme::AST::num_t { 1LL } } };
+    const auto                       specialized = expression->specialize ( bindings );
+    ASSERT_EQ ( specialized.get_variables().size(), 2 );
+    ASSERT_EQ ( specialized.get_variables()[0], "a" );
+    ASSERT_EQ ( specialized.get_variables()[1], "x" );
+    ASSERT_LT ( specialized.get_nodes().size(), expression->get_nodes().size() );
+    for ( const auto x : { -3LL, 0LL, 7LL, 20LL } )
+    {
+        const std::vector<pfme::AST::num_t> all { 3LL, x, 16LL, 4LL };
+        const std::vector<pfme::AST::num_t> rest { 3LL, x };
+        ASSERT_EQ ( specialized.evaluate<pfme::LD> ( rest ).value(), expression->evaluate<pfme::LD> ( all ).value() ) << x;
+    }
+
+    // folding is exact and binding everything leaves a single number
+    const auto exact = pfme::CompiledExpression::compile ( "(rate * 3) * x" )->specialize ( std::vector<pfme::Binding> {
+        { "rate", pfme::AST::num_t { pfme::Fraction ( 1, 3 ) } } } );
+    ASSERT_EQ ( exact.get_nodes().size(), 3 );
+    ASSERT_EQ ( exact.get_nodes()[0].to_number(), pfme::AST::num_t { pfme::Fraction ( 1, 1 ) } );
+    ASSERT_EQ ( exact.specialize ( std::vector<pfme::Binding> { { "x", pfme::AST::num_t { 5LL } } } ).get_nodes().size(), 1 );
+
+    // a decided condition keeps only its branch, errors are left for the evaluation
+    const auto branches = pfme::CompiledExpression::compile ( "mode == 1 ? x * 2 : x / (mode - mode)" );
+    const auto first    = branches->specialize ( std::vector<pfme::Binding> { { "mode", pfme::AST::num_t { 1LL } } } );
+    ASSERT_EQ ( first.get_nodes().size(), 3 );
+    ASSERT_TRUE ( first.get_shortcuts().empty() );
+    ASSERT_EQ ( first.evaluate<pfme::LD> ( std::vector<pfme::AST::num_t> { 4LL } ).value(), pfme::AST::num_t { 8LL } );
+    const auto second = branches->specialize ( std::vector<pfme::Binding> { { "mode", pfme::AST::num_t { 0LL } } } );
+    ASSERT_EQ ( second.evaluate<pfme::LD> ( std::vector<pfme::AST::num_t> { 4LL } ).error().m_code,
+                pfme::ERROR_CODE::DIVISION_BY_ZERO );
+    const auto lazy = pfme::CompiledExpression::compile ( "y > 0 && x > 1 || 0 ? x : y" );
+    ASSERT_EQ ( lazy->specialize ( std::vector<pfme::Binding> { { "y", pfme::AST::num_t { -2LL } } } ).get_nodes().size(), 1 );
+
+    // the specialized expression is still a valid serialized expression
+    const auto branched = branches->specialize ( std::vector<pfme::Binding> { { "x", pfme::AST::num_t { 6LL } } } );
+    const auto buffer   = pfme::serialize ( branched.to_ast().get() );
+    ASSERT_EQ ( pfme::validate ( buffer ).size(), branched.get_nodes().size() );
+    ASSERT_EQ ( branched.evaluate<pfme::LD> ( std::vector<pfme::AST::num_t> { 1LL } ).value(), pfme::AST::num_t { 12LL } );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+#include <pfme/Decimal.hpp>
+#include <pfme/Format.hpp>
+#include <pfme/Parser.hpp>
+#include <pfme/Serialization.hpp>
+#include <pfme/Session.hpp>
+#include <random>
+#include <string>
+
+namespace
+{
+auto decimal_config() -> pfme::LexerConfig
+{
+    auto config = pfme::LexerConfig::standard();
+    config.set_decimals ( true );
+    return config;
+}
+
+// the sign is a Token of its own, so from_chars only reads magnitudes
+auto decimal ( std::string_view text ) -> pfme::Decimal
+{
+    if ( text.starts_with ( '-' ) ) { return -decimal ( text.substr ( 1 ) ); }
+    return pfme::Decimal::from_chars ( text ).value();
+}
+
+auto quotient ( const std::string& lhs, const std::string& rhs, pfme::DecimalContext context ) -> std::string
+{
+    return decimal ( lhs ).divide ( decimal ( rhs ), context ).value().to_string();
+}
+
+// rounds numerator / denominator to a whole number the simple way, for numbers far from the limits
+auto rounded ( pfme::LLI numerator, pfme::LLI denominator, pfme::ROUNDING rounding ) -> pfme::LLI
+{
+    if ( denominator < 0 )
+    {
+        numerator   = -numerator;
+        denominator = -denominator;
+    }
+    auto       floor     = numerator / denominator;
+    auto       remainder = numerator % denominator;
+    if ( remainder < 0 )
+    {
+        --floor;
+        remainder += denominator;
+    }
+    if ( remainder == 0 ) { return floor; }
+    const auto twice = 2 * remainder;
+    switch ( rounding )
+    {
+    case pfme::ROUNDING::HALF_EVEN:
+        return twice > denominator || ( twice == denominator && floor % 2 != 0 ) ? floor + 1 : floor;
+    case pfme::ROUNDING::HALF_UP: return twice > denominator || ( twice == denominator && floor >= 0 ) ? floor + 1 : floor;
+    case pfme::ROUNDING::HALF_DOWN: return twice > denominator || ( twice == denominator && floor < 0 ) ? floor + 1 : floor;
+    case pfme::ROUNDING::DOWN: return floor < 0 ? floor + 1 : floor;
+    case pfme::ROUNDING::UP: return floor >= 0 ? floor + 1 : floor;
+    case pfme::ROUNDING::FLOOR: return floor;
+    default: return floor + 1;
+    }
+}
+} // namespace
+
+TEST ( Decimal, from_chars_and_to_string )
+{
+    ASSERT_EQ ( decimal ( "0.1" ), ( pfme::Decimal { 1, 1 } ) );
+    ASSERT_EQ ( decimal ( "12.50" ), ( pfme::Decimal { 125, 1 } ) );
+    ASSERT_EQ ( decimal ( "1.5e-3" ), ( pfme::Decimal { 15, 4 } ) );
+    ASSERT_EQ ( decimal ( "1.5e3" ), pfme::Decimal { 1500 } );
+    ASSERT_EQ ( decimal ( ".5" ), ( pfme::Decimal { 5, 1 } ) );
+    ASSERT_EQ ( decimal ( "3." ), pfme::Decimal { 3 } );
+    ASSERT_EQ ( decimal ( "0e99999" ), pfme::Decimal {} );
+    ASSERT_EQ ( decimal ( "0.000000000000000001" ), ( pfme::Decimal { 1, 18 } ) );
+    ASSERT_EQ ( decimal ( "9223372036854775807.000000000000000000000" ), pfme::Decimal { 9223372036854775807LL } );
+    ASSERT_FALSE ( pfme::Decimal::from_chars ( "0.0000000000000000001" ) );
+    ASSERT_FALSE ( pfme::Decimal::from_chars ( "9223372036854775808.0" ) );
+    ASSERT_FALSE ( pfme::Decimal::from_chars ( "1e19" ) );
+    ASSERT_FALSE ( pfme::Decimal::from_chars ( "1.2.3" ) );
+    ASSERT_FALSE ( pfme::Decimal::from_chars ( "." ) );
+    ASSERT_FALSE ( pfme::Decimal::from_chars ( "1e" ) );
+
+    ASSERT_EQ ( decimal ( "0.05" ).to_string(), "0.05" );
+    ASSERT_EQ ( ( -decimal ( "0.05" ) ).to_string(), "-0.05" );
+    ASSERT_EQ ( decimal ( "123.4500" ).to_string(), "123.45" );
+    ASSERT_EQ ( decimal ( "100" ).to_string(), "100" );
+    ASSERT_EQ ( ( pfme::Decimal { -9223372036854775807LL, 18 } ).to_string(), "-9.223372036854775807" );
+    ASSERT_EQ ( static_cast<pfme::LD> ( decimal ( "2.5" ) ), 2.5L );
+    ASSERT_EQ ( decimal ( "0.25" ).to_fraction(), ( pfme::Fraction { 1, 4 } ) );
+    ASSERT_ANY_THROW ( ( pfme::Decimal { 1, 19 } ) );
+}
+
+TEST ( Decimal, exact_operations )
+{
+    ASSERT_EQ ( *decimal ( "0.1" ).add ( decimal ( "0.2" ) ), decimal ( "0.3" ) );
+    ASSERT_EQ ( *decimal ( "19.99" ).subtract ( decimal ( "0.99" ) ), pfme::Decimal { 19 } );
+    ASSERT_EQ ( *decimal ( "1.05" ).multiply ( decimal ( "-0.2" ) ), decimal ( "-0.21" ) );
+    ASSERT_EQ ( *decimal ( "0.000000001" ).multiply ( decimal ( "0.000000001" ) ), decimal ( "0.000000000000000001" ) );
+    ASSERT_EQ ( decimal ( "0.5" ) + decimal ( "0.5" ), pfme::Decimal { 1 } );
+
+    // results that need more than 64 bits or more than 18 digits after the point
+    ASSERT_FALSE ( decimal ( "9223372036854775807" ).add ( decimal ( "1" ) ) );
+    ASSERT_FALSE ( decimal ( "-9223372036854775807" ).subtract ( decimal ( "1" ) ) );
+    ASSERT_FALSE ( decimal ( "922337203685477580.7" ).add ( decimal ( "0.01" ) ) );
+    ASSERT_FALSE ( decimal ( "3037000500" ).multiply ( decimal ( "3037000500" ) ) );
+    ASSERT_FALSE ( decimal ( "0.0000000001" ).multiply ( decimal ( "0.000000001" ) ) );
+    ASSERT_FALSE ( pfme::Decimal { std::numeric_limits<pfme::LLI>::min() }.add ( pfme::Decimal {} ) );
+    ASSERT_ANY_THROW ( decimal ( "9223372036854775807" ) * decimal ( "2" ) );
+}
+
+TEST ( Decimal, division_rounding )
+{
+    using enum pfme::ROUNDING;
+    ASSERT_EQ ( quotient ( "1", "3", {} ), "0.333333333" );
+    ASSERT_EQ ( quotient ( "2", "3", { 2, HALF_EVEN } ), "0.67" );
+    ASSERT_EQ ( quotient ( "1", "8", { 18, HALF_EVEN } ), "0.125" );
+    ASSERT_EQ ( quotient ( "10", "4", { 0, HALF_EVEN } ), "2" );
+    ASSERT_EQ ( quotient ( "14", "4", { 0, HALF_EVEN } ), "4" );
+    ASSERT_EQ ( quotient ( "10", "4", { 0, HALF_UP } ), "3" );
+    ASSERT_EQ ( quotient ( "-10", "4", { 0, HALF_UP } ), "-3" );
+    ASSERT_EQ ( quotient ( "10", "4", { 0, HALF_DOWN } ), "2" );
+    ASSERT_EQ ( quotient ( "-2", "3", { 1, DOWN } ), "-0.6" );
+    ASSERT_EQ ( quotient ( "-2", "3", { 1, UP } ), "-0.7" );
+    ASSERT_EQ ( quotient ( "-2", "3", { 1, FLOOR } ), "-0.7" );
+    ASSERT_EQ ( quotient ( "-2", "3", { 1, CEILING } ), "-0.6" );
+    ASSERT_EQ ( quotient ( "0.0001", "3", { 2, CEILING } ), "0.01" );
+    ASSERT_EQ ( quotient ( "0.0001", "3", { 2, HALF_EVEN } ), "0" );
+    ASSERT_EQ ( quotient ( "0.000000000000000001", "9000000000000000000", { 18, UP } ), "0.000000000000000001" );
+    ASSERT_EQ ( quotient ( "9223372036854775807", "9223372036854775806", { 18, HALF_EVEN } ), "1" );
+    ASSERT_EQ ( quotient ( "9223372036854775807", "9223372036854775806", { 18, UP } ), "1.000000000000000001" );
+    ASSERT_FALSE ( decimal ( "1" ).divide ( decimal ( "0.000000000000000003" ), {} ) );
+    ASSERT_FALSE ( decimal ( "9223372036854775807" ).divide ( decimal ( "0.5" ), {} ) );
+}
+
+TEST ( Decimal, division_matches_reference )
+{
+    std::mt19937 random ( 5 );
+    const auto   number = [&random] ( int scale )
+    {
+        const auto mantissa = std::uniform_int_distribution<pfme::LLI> { -1000000, 1000000 }( random );
+        const auto digits   = std::uniform_int_distribution<int> { 0, scale }( random );
+        return pfme::Decimal { mantissa, static_cast<std::uint8_t> ( digits ) };
+    };
+    for ( int i = 0; i < 20000; ++i )
+    {
+        const auto                 scale    = std::uniform_int_distribution<int> { 3, 6 }( random );
+        const auto                 rounding = std::uniform_int_distribution<int> { 0, 6 }( random );
+        const pfme::DecimalContext context { static_cast<std::uint8_t> ( scale ), static_cast<pfme::ROUNDING> ( rounding ) };
+        const auto                 dividend = number ( 3 );
+        const auto                 divisor  = number ( 3 );
+        if ( divisor.mantissa() == 0 ) { continue; }
+
+        pfme::LLI numerator = dividend.mantissa(), denominator = divisor.mantissa();
+        for ( int shift = context.m_scale + divisor.scale() - dividend.scale(); shift > 0; --shift ) { numerator *= 10; }
+        const pfme::Decimal expected { rounded ( numerator, denominator, context.m_rounding ), context.m_scale };
+        ASSERT_EQ ( dividend.divide ( divisor, context ), expected ) << dividend << " / " << divisor;
+    }
+}
+
+TEST ( Decimal, session )
+{
+    pfme::Session session ( decimal_config() );
+    ASSERT_EQ ( session.evaluate ( "0.1 + 0.2" ).value(), pfme::AST::num_t { decimal ( "0.3" ) } );
+    ASSERT_EQ ( session.evaluate ( "19.99 * 3 - 0.97" ).value(), pfme::AST::num_t { decimal ( "59" ) } );
+    ASSERT_EQ ( session.evaluate ( "-1.25 * 2 ^ 3" ).value(), pfme::AST::num_t { decimal ( "-10" ) } );
+    ASSERT_EQ ( session.evaluate ( "1.5 ^ 2.0" ).value(), pfme::AST::num_t { decimal ( "2.25" ) } );
+    ASSERT_EQ ( session.evaluate ( "2 ^ -1.0" ).value(), ( pfme::AST::num_t { pfme::Fraction { 1, 2 } } ) );
+    ASSERT_EQ ( session.evaluate ( "0.5 ^ -2" ).value(), pfme::AST::num_t { decimal ( "4" ) } );
+    ASSERT_EQ ( session.evaluate ( "1 / 3 + 0.5" ).value(), ( pfme::AST::num_t { pfme::Fraction { 5, 6 } } ) );
+    ASSERT_EQ ( session.evaluate ( "10.00 / 3" ).value(), pfme::AST::num_t { decimal ( "3.333333333" ) } );
+    ASSERT_EQ ( session.evaluate ( "1.5 / (0.5 - 0.5)" ).error().m_code, pfme::ERROR_CODE::DIVISION_BY_ZERO );
+
+    session.set_decimal_context ( { 2, pfme::ROUNDING::HALF_UP } );
+    ASSERT_EQ ( session.evaluate ( "(10.00 / 3) * 3" ).value(), pfme::AST::num_t { decimal ( "9.99" ) } );
+    ASSERT_EQ ( session.evaluate ( "0.125 / 1" ).value(), pfme::AST::num_t { decimal ( "0.13" ) } );
+
+    // a decimal result that does not fit is out of range like an integer, only a float operand makes it a long double
+    ASSERT_EQ ( session.evaluate ( "9223372036854775807.0 + 1" ).error().m_code, pfme::ERROR_CODE::NUMBER_OUT_OF_RANGE );
+    ASSERT_EQ ( session.evaluate ( "9999999999.99 * 9999999999.99" ).error().m_code, pfme::ERROR_CODE::NUMBER_OUT_OF_RANGE );
+    ASSERT_EQ ( session.evaluate ( "0.0000000001 * 0.000000001" ).error().m_code, pfme::ERROR_CODE::NUMBER_OUT_OF_RANGE );
+    ASSERT_EQ ( session.evaluate ( "9223372036854775807.0 / 0.5" ).error().m_code, pfme::ERROR_CODE::NUMBER_OUT_OF_RANGE );
+    ASSERT_TRUE ( std::holds_alternative<pfme::LD> ( session.evaluate ( "1e30 * 0.5" ).value() ) );
+    ASSERT_TRUE ( std::holds_alternative<pfme::LD> ( session.evaluate ( "sqrt(2.25)" ).value() ) );
+
+    // a Session without decimals still uses long double
+    pfme::Session binary;
+    ASSERT_TRUE ( std::holds_alternative<pfme::LD> ( binary.evaluate ( "0.1 + 0.2" ).value() ) );
+}
+
+TEST ( Decimal, sums_stay_exact )
+{
+    pfme::Session session ( decimal_config() );
+    std::string   input = "0";
+    for ( int i = 0; i < 1000; ++i ) { input += " + 0.01"; }
+    ASSERT_EQ ( session.evaluate ( input ).value(), pfme::AST::num_t { pfme::Decimal { 10 } } );
+    ASSERT_EQ ( pfme::format_number ( *session.evaluate ( "1.10 + 2.20" ) ), "3.3" );
+
+    pfme::basic_session<double> in_double ( decimal_config() );
+    ASSERT_EQ ( in_double.evaluate ( "0.1 * 3" ).value(), pfme::basic_num_t<double> { decimal ( "0.3" ) } );
+}
+
+TEST ( Decimal, serialization )
+{
+    pfme::Parser parser ( std::make_unique<pfme::Lexer> ( "0.1 * -2.75 + 3", decimal_config() ) );
+    const auto   root   = parser.parse();
+    const auto   buffer = pfme::serialize ( root.get() );
+    const auto   nodes  = pfme::validate ( buffer );
+    ASSERT_EQ ( pfme::evaluate ( nodes ).m_number, pfme::AST::num_t { decimal ( "2.725" ) } );
+    ASSERT_EQ ( pfme::to_ast ( nodes )->lhand->lhand->m_number, pfme::AST::num_t { decimal ( "0.1" ) } );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <pfme/Visitor.hpp>
+
+namespace
+{
+auto parse_error ( const std::string& input ) -> pfme::Error
+{
+    pfme::Parser parser ( input );
+    auto         root = parser.try_parse();
+    EXPECT_FALSE ( root.has_value() ) << input;
+    return root.has_value() ? pfme::Error { pfme::ERROR_CODE::EMPTY_EXPRESSION } : root.error();
+}
+} // namespace
+
+TEST ( Error, lexer_errors )
+{
+    pfme::Lexer lex ( "1.2.3" );
+    auto        token = lex.try_next_token();
+    ASSERT_FALSE ( token.has_value() );
+    ASSERT_EQ ( token.error().m_code, pfme::ERROR_CODE::TWO_POINTS );
+
+    ASSERT_EQ ( parse_error ( "1 + ä" ).m_code, pfme::ERROR_CODE::CHARACTER_TOO_LARGE );
+    ASSERT_EQ ( parse_error ( "1 + ä" ).m_position, 4 );
+}
+
+TEST ( Error, parser_errors )
+{
+    ASSERT_EQ ( parse_error ( "" ).m_code, pfme::ERROR_CODE::EMPTY_EXPRESSION );
+    ASSERT_EQ ( parse_error ( "   " ).m_code, pfme::ERROR_CODE::EMPTY_EXPRESSION );
+    ASSERT_EQ ( parse_error ( "*3" ).m_code, pfme::ERROR_CODE::INVALID_TOKEN );
+    ASSERT_EQ ( parse_error ( "-(3)" ).m_code, pfme::ERROR_CODE::INVALID_TOKEN );
+    ASSERT_EQ ( parse_error ( "3 4" ).m_code, pfme::ERROR_CODE::INVALID_OPERATOR );
+    ASSERT_EQ ( parse_error ( "." ).m_code, pfme::ERROR_CODE::INVALID_NUMBER );
+    ASSERT_EQ ( parse_error ( "99999999999999999999 + 1" ).m_code, pfme::ERROR_CODE::NUMBER_OUT_OF_RANGE );
+
+    const auto error = parse_error ( "3 4" );
+    ASSERT_EQ ( error.m_position, 2 );
+    ASSERT_EQ ( error.m_found, pfme::TOKEN_TYPE::TOKEN_INTEGER );
+}
+
+TEST ( Error, evaluation_errors )
+{
+    for ( const auto* input : { "1 / 0", "1.5 / 0.0", "3 / (1/2 - 1/2)", "0 ^ -1" } )
+    {
+        auto visitor = pfme::Visitor::try_create ( input );
+        ASSERT_TRUE ( visitor.has_value() ) << input;
+        auto result = visitor->try_visit();
+        ASSERT_FALSE ( result.has_value() ) << input;
+        ASSERT_EQ ( result.error().m_code, pfme::ERROR_CODE::DIVISION_BY_ZERO ) << input;
+    }
+}
+
+TEST ( Error, exact_overflow )
+{
+    // exact results that do not fit into 64 bits are an error instead of a wrapped number or an exception
+    for ( const auto* input : { "(1/2^62) * (1/4)",
+                                "9223372036854775807 + 1",
+                                "3037000500 * 3037000500",
+                                "1/3 - 1/9223372036854775807",
+                                "-9223372036854775808 / -1" } )
+    {
+        auto visitor = pfme::Visitor::try_create ( input );
+        ASSERT_TRUE ( visitor.has_value() ) << input;
+        auto result = visitor->try_visit();
+        ASSERT_FALSE ( result.has_value() ) << input;
+        ASSERT_EQ ( result.error().m_code, pfme::ERROR_CODE::NUMBER_OUT_OF_RANGE ) << input;
+    }
+
+    // a power that does not fit is a float
+    auto visitor = pfme::Visitor::try_create ( "2^-64" );
+    ASSERT_TRUE ( visitor.has_value() );
+    ASSERT_TRUE ( std::holds_alternative<long double> ( visitor->try_evaluate().value() ) );
+    ASSERT_EQ ( pfme::Visitor::try_create ( "(1/2^31) * (1/2^31)" )->try_visit().value(), "1 / 4611686018427387904" );
+
+    // the smallest integer divides as a whole number
+    ASSERT_EQ ( pfme::Visitor::try_create ( "-9223372036854775808 / 2" )->try_visit().value(), "-4611686018427387904" );
+    ASSERT_EQ ( pfme::Visitor::try_create ( "-9223372036854775808 / -9223372036854775808" )->try_visit().value(), "1" );
+}
+
+TEST ( Error, try_visit )
+{
+    auto visitor = pfme::Visitor::try_create ( "2 ^ -2 + (1/2) / 2" );
+    ASSERT_TRUE ( visitor.has_value() );
+    ASSERT_EQ ( visitor->try_visit().value(), "1 / 2" );
+
+    ASSERT_FALSE ( pfme::Visitor::try_create ( "1 + * 2" ).has_value() );
+}
+
+TEST ( Error, message )
+{
+    const std::string input = "3 4";
+    const auto        error = parse_error ( input );
+    ASSERT_TRUE ( error.message ( input ).starts_with ( "Invalid Token 'TOKEN_INTEGER' in expression" ) );
+    // the hint lists the arithmetic, comparison, logical and conditional operators
+    for ( const auto* expected :
+          { "TOKEN_EXPONENTIATION, ", "TOKEN_LESS_EQUAL, ", "TOKEN_OR, ", "TOKEN_CONDITION or TOKEN_ALTERNATIVE" } )
+    {
+        ASSERT_NE ( error.message ( input ).find ( expected ), std::string::npos ) << expected;
+    }
+    ASSERT_NE ( error.message ( input ).find ( "First found here" ), std::string::npos );
+
+    const pfme::Error division { pfme::ERROR_CODE::DIVISION_BY_ZERO };
+    ASSERT_EQ ( division.message ( input ), "Division by Zero" );
+}
+
+TEST ( Error, exceptions_unchanged )
+{
+    ASSERT_THROW ( pfme::Parser ( "3 4" ).parse(), std::runtime_error );
+    ASSERT_THROW ( pfme::Visitor ( "1 / 0" ).visit(), std::runtime_error );
+    ASSERT_THROW ( pfme::Lexer ( "1.2.3" ).get_next_token(), std::runtime_error );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,65 @@
+#include <array>
+#include <gtest/gtest.h>
+#include <pfme/Format.hpp>
+#include <pfme/Visitor.hpp>
+
+TEST ( Format, integers_and_fractions )
+{
+    ASSERT_EQ ( pfme::format_number ( pfme::AST::num_t { -42LL } ), "-42" );
+    ASSERT_EQ ( pfme::format_number ( pfme::AST::num_t { pfme::Fraction { 5, 7 } } ), pfme::Fraction ( 5, 7 ).to_string() );
+    // the format only affects floats
+    ASSERT_EQ ( pfme::format_number ( pfme::AST::num_t { 7LL }, { pfme::NUMBER_FORMAT::FIXED, 2 } ), "7" );
+}
+
+TEST ( Format, floats )
+{
+    const pfme::AST::num_t number { 0.1L };
+    ASSERT_EQ ( pfme::format_number ( number ), "0.1" );
+    ASSERT_EQ ( pfme::format_number ( number, pfme::TO_STRING_FORMAT ), std::to_string ( 0.1L ) );
+    ASSERT_EQ ( pfme::format_number ( number, { pfme::NUMBER_FORMAT::FIXED, 3 } ), "0.100" );
+    ASSERT_EQ ( pfme::format_number ( pfme::AST::num_t { 1234.5678L }, { pfme::NUMBER_FORMAT::PRECISION, 3 } ), "1.23e+03" );
+    ASSERT_EQ ( pfme::format_number ( pfme::AST::num_t { 1.5e-9L } ), "1.5e-09" );
+
+    // shortest round trip reads back to the same value
+    const pfme::LD third = 1.0L / 3.0L;
+    pfme::LD       read {};
+    const auto     text = pfme::format_number ( pfme::AST::num_t { third } );
+    std::from_chars ( text.data(), text.data() + text.size(), read );
+    ASSERT_EQ ( read, third );
+}
+
+TEST ( Format, caller_buffer )
+{
+    std::array<char, 8> buffer {};
+    auto result = pfme::format_number ( buffer.data(), buffer.data() + buffer.size(), pfme::AST::num_t { 2.5L } );
+    ASSERT_EQ ( result.ec, std::errc {} );
+    ASSERT_EQ ( std::string_view ( buffer.data(), result.ptr ), "2.5" );
+
+    result = pfme::format_number (
+        buffer.data(), buffer.data() + buffer.size(), pfme::AST::num_t { pfme::Fraction { 1, 1'000'000 } } );
+    ASSERT_EQ ( result.ec, std::errc::value_too_large );
+
+    // the string version grows until the number fits
+    const auto large = pfme::format_number ( pfme::AST::num_t { 1e300L }, pfme::TO_STRING_FORMAT );
+    ASSERT_EQ ( large, std::to_string ( 1e300L ) );
+}
+
+TEST ( Format, lazy_results )
+{
+    pfme::Visitor visitor ( "1.5 * 2 + 1/3" );
+    auto          result = visitor.try_evaluate();
+    ASSERT_TRUE ( result.has_value() );
+    ASSERT_DOUBLE_EQ ( static_cast<double> ( std::get<pfme::LD> ( *result ) ), 3.0 + 1.0 / 3.0 );
+
+    // intermediate and final nodes are not turned into strings
+    pfme::Parser parser ( "2 * 3" );
+    const auto   root = parser.parse();
+    ASSERT_TRUE ( root->lhand->m_value.empty() );
+    ASSERT_EQ ( root->lhand->to_string(), "2" );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,231 @@
+#include <cmath>
+#include <gtest/gtest.h>
+#include <limits>
+#include <pfme/Functions.hpp>
+#include <pfme/Serialization.hpp>
+#include <pfme/Simd.hpp>
+#include <pfme/Visitor.hpp>
+#include <random>
+#include <vector>
+
+namespace
+{
+auto evaluate ( const std::string& input, const pfme::LexerConfig& config = pfme::LexerConfig::standard() )
+    -> pfme::Result<pfme::AST::num_t>
+{
+    auto visitor = pfme::Visitor::try_create ( std::make_unique<pfme::Lexer> ( input, config ) );
+    if ( !visitor ) { return std::unexpected ( visitor.error() ); }
+    return visitor->try_evaluate();
+}
+
+auto as_float ( const pfme::Result<pfme::AST::num_t>& result ) -> long double
+{
+    EXPECT_TRUE ( result.has_value() );
+    return result ? std::visit ( [] ( auto value ) { return static_cast<long double> ( value ); }, *result ) : 0;
+}
+
+auto levels() -> std::vector<pfme::simd::SIMD_LEVEL>
+{
+    std::vector<pfme::simd::SIMD_LEVEL> usable { pfme::simd::SIMD_LEVEL::SCALAR };
+    for ( const auto level : { pfme::simd::SIMD_LEVEL::SSE2, pfme::simd::SIMD_LEVEL::AVX2 } )
+    {
+        if ( level <= pfme::simd::supported_level() ) { usable.push_back ( level ); }
+    }
+    return usable;
+}
+
+auto id ( pfme::FUNCTION function ) -> std::uint32_t { return static_cast<std::uint32_t> ( function ); }
+
+// restores the detected level after each test
+class Functions : public ::testing::Test
+{
+protected:
+    void TearDown() override { pfme::simd::set_level ( pfme::simd::supported_level() ); }
+};
+} // namespace
+
+TEST_F ( Functions, calls )
+{
+    ASSERT_EQ ( evaluate ( "sqrt(16)" ).value(), pfme::AST::num_t { 4LL } );
+    ASSERT_EQ ( evaluate ( "sqrt(9 / 4)" ).value(), pfme::AST::num_t { pfme::Fraction ( 3, 2 ) } );
+    ASSERT_NEAR ( as_float ( evaluate ( "sqrt(2)" ) ), std::sqrt ( 2.0L ), 1e-18L );
+    ASSERT_NEAR ( as_float ( evaluate ( "exp(1) + log(exp(2))" ) ), std::exp ( 1.0L ) + 2, 1e-15L );
+    ASSERT_NEAR ( as_float ( evaluate ( "sin(1)^2 + cos(1)^2" ) ), 1, 1e-15L );
+    ASSERT_EQ ( evaluate ( "abs(-3) * 2" ).value(), pfme::AST::num_t { 6LL } );
+    ASSERT_EQ ( evaluate ( "abs(-1 / 2)" ).value(), pfme::AST::num_t { pfme::Fraction ( 1, 2 ) } );
+    ASSERT_EQ ( evaluate ( "max(1, 7, 3) - min(4, 2.5, 8)" ).value(), pfme::AST::num_t { 4.5L } );
+    ASSERT_EQ ( evaluate ( "min(3)" ).value(), pfme::AST::num_t { 3LL } );
+
+    // arguments are whole expressions and calls are operands like numbers
+    ASSERT_EQ ( evaluate ( "2 * max(1 + 2 * 3, (2 + 3) * 2) ^ 2" ).value(), pfme::AST::num_t { 200LL } );
+    ASSERT_EQ ( evaluate ( "-abs(-5) + 1" ).value(), pfme::AST::num_t { -4LL } );
+    ASSERT_EQ ( evaluate ( "max(abs(-9), sqrt(sqrt(256)), min(20, 30)" ).value(), pfme::AST::num_t { 20LL } );
+    ASSERT_EQ ( evaluate ( "1 + max(2, 3" ).value(), pfme::AST::num_t { 4LL } );
+}
+
+TEST_F ( Functions, argument_seperators )
+{
+    // inside a call the ',' seperates arguments, outside it is still a digit seperator
+    ASSERT_EQ ( evaluate ( "max(1,000, 2) + 1,000" ).value(), pfme::AST::num_t { 1002LL } );
+    ASSERT_EQ ( evaluate ( "max(1'000,2)" ).value(), pfme::AST::num_t { 1000LL } );
+    ASSERT_EQ ( evaluate ( "max(1 000, 2 000)", pfme::LexerConfig::space_grouping() ).value(), pfme::AST::num_t { 2000LL } );
+    ASSERT_EQ ( evaluate ( "max(1,5; 2,5)", pfme::LexerConfig::german() ).value(), pfme::AST::num_t { 2.5L } );
+    ASSERT_EQ ( pfme::LexerConfig::german().get_argument_seperator(), ';' );
+    ASSERT_THROW ( pfme::LexerConfig ( '.', {}, '.' ), std::runtime_error );
+    ASSERT_THROW ( pfme::LexerConfig ( '.', {}, 'x' ), std::runtime_error );
+
+    pfme::Lexer lexer ( "abs (1, 2)" );
+    ASSERT_EQ ( lexer.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_IDENTIFIER );
+    ASSERT_EQ ( lexer.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_L_PAREN );
+    ASSERT_EQ ( lexer.get_next_token()->get_value(), "1" );
+    ASSERT_EQ ( lexer.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_COMMA );
+}
+
+TEST_F ( Functions, errors )
+{
+    ASSERT_EQ ( evaluate ( "sqrt(-1)" ).error().m_code, pfme::ERROR_CODE::DOMAIN_ERROR );
+    ASSERT_EQ ( evaluate ( "log(0)" ).error().m_code, pfme::ERROR_CODE::DOMAIN_ERROR );
+    ASSERT_EQ ( evaluate ( "abs(-9223372036854775808)" ).error().m_code, pfme::ERROR_CODE::NUMBER_OUT_OF_RANGE );
+    ASSERT_EQ ( evaluate ( "foo(1)" ).error().m_code, pfme::ERROR_CODE::UNKNOWN_FUNCTION );
+    ASSERT_EQ ( evaluate ( "sqrt(1, 2)" ).error().m_code, pfme::ERROR_CODE::ARGUMENT_COUNT );
+    ASSERT_EQ ( evaluate ( "sqrt(1, 2)" ).error().m_position, 9 );
+    ASSERT_EQ ( evaluate ( "sqrt 4" ).error().m_code, pfme::ERROR_CODE::UNEXPECTED_TOKEN );
+    ASSERT_EQ ( evaluate ( "max()" ).error().m_code, pfme::ERROR_CODE::INVALID_TOKEN );
+    ASSERT_EQ ( evaluate ( "max(1,)" ).error().m_code, pfme::ERROR_CODE::INVALID_TOKEN );
+    ASSERT_EQ ( evaluate ( "2 max(1)" ).error().m_code, pfme::ERROR_CODE::INVALID_OPERATOR );
+    ASSERT_THROW ( pfme::Visitor ( "sqrt(-4)" ).visit(), std::runtime_error );
+}
+
+TEST_F ( Functions, tree_and_serialization )
+{
+    pfme::Parser      parser ( "max(1, 2 + 3, 4)" );
+    std::stringstream tree;
+    pfme::Parser::print_binary_tree ( parser.parse().get(), tree );
+    ASSERT_EQ ( tree.str(), "└──max\n"
+                            "    ├──1\n"
+                            "    └──,\n"
+                            "        ├──+\n"
+                            "        │   ├──2\n"
+                            "        │   └──3\n"
+                            "        └──,\n"
+                            "            ├──4\n" );
+
+    const auto root   = parser.get_root();
+    const auto buffer = pfme::serialize ( root.get() );
+    ASSERT_EQ ( pfme::evaluate ( pfme::validate ( buffer ) ).m_number, pfme::AST::num_t { 5LL } );
+    pfme::Parser::print_binary_tree ( pfme::to_ast ( pfme::validate ( buffer ) ).get(), tree );
+    ASSERT_EQ ( tree.str().substr ( tree.str().size() / 2 ), tree.str().substr ( 0, tree.str().size() / 2 ) );
+}
+
+TEST_F ( Functions, registry )
+{
+    auto& registry = pfme::FunctionRegistry::global();
+    ASSERT_EQ ( registry.find ( "cos" ), id ( pfme::FUNCTION::COS ) );
+    ASSERT_FALSE ( registry.find ( "cosh" ).has_value() );
+
+    pfme::Function twice;
+    twice.m_name   = "twice";
+    twice.m_scalar = [] ( std::span<const pfme::AST::num_t> arguments ) -> std::expected<pfme::AST::num_t, pfme::ERROR_CODE>
+    { return std::visit ( [] ( auto value ) { return pfme::AST::num_t { value + value }; }, arguments[0] ); };
+    twice.m_batch = [] ( std::span<const std::span<const double>> arguments, std::span<double> results )
+    {
+        for ( std::size_t row = 0; row < results.size(); ++row ) { results[row] = 2 * arguments[0][row]; }
+    };
+    const auto twice_id = registry.add ( twice );
+    ASSERT_EQ ( registry.find ( "twice" ), twice_id );
+    ASSERT_EQ ( evaluate ( "twice(sqrt(4)) + 1" ).value(), pfme::AST::num_t { 5LL } );
+    ASSERT_THROW ( registry.add ( twice ), std::runtime_error );
+    twice.m_name = "2x";
+    ASSERT_THROW ( registry.add ( twice ), std::runtime_error );
+}
+
+TEST_F ( Functions, ranges )
+{
+    // sum and prod are only evaluated by the Visitor, calling them directly fails instead of computing anything
+    ASSERT_EQ ( evaluate ( "sum(i, 1, 3, i)" ).value(), pfme::AST::num_t { 6LL } );
+    const std::vector<pfme::AST::num_t> arguments { 0LL, 1LL, 3LL, 2LL };
+    for ( const auto function : { pfme::FUNCTION::SUM, pfme::FUNCTION::PROD } )
+    {
+        ASSERT_EQ ( pfme::call ( id ( function ), arguments ).error(), pfme::ERROR_CODE::UNSUPPORTED_RANGE );
+
+        const std::vector<double>                    column { 1, 2 };
+        std::vector<double>                          results ( column.size(), 5 );
+        const std::array<std::span<const double>, 4> columns { column, column, column, column };
+        ASSERT_THROW ( pfme::call_batch ( id ( function ), columns, results ), std::runtime_error );
+        ASSERT_EQ ( results, ( std::vector<double> { 5, 5 } ) );
+    }
+}
+
+TEST_F ( Functions, batches )
+{
+    std::mt19937_64                        random ( 34 );
+    std::uniform_real_distribution<double> wide ( -800, 800 ), narrow ( -10, 10 );
+
+    std::vector<double> inputs { 0.0, -0.0, 1.0, -1.0, 0.5, 1e-310, 1e300, 709.5, -740.0, 2e6, -3e7,
+                                 std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+                                 std::numeric_limits<double>::quiet_NaN() };
+    for ( int i = 0; i < 500; ++i )
+    {
+        inputs.push_back ( wide ( random ) );
+        inputs.push_back ( narrow ( random ) );
+        inputs.push_back ( std::exp ( wide ( random ) * 0.85 ) ); // positive numbers of every magnitude
+    }
+    std::vector<double> others ( inputs.rbegin(), inputs.rend() );
+
+    // the results are compared with the scalar functions of the standard library
+    const auto close = [] ( double result, double expected )
+    {
+        if ( std::isnan ( expected ) ) { return std::isnan ( result ); }
+        if ( std::isinf ( expected ) ) { return result == expected; }
+        return std::fabs ( result - expected ) <= 1e-15 * std::max ( 1.0, std::fabs ( expected ) );
+    };
+    const std::array<std::pair<pfme::FUNCTION, double ( * ) ( double )>, 6> unary {
+        { { pfme::FUNCTION::SQRT, [] ( double x ) { return std::sqrt ( x ); } },
+          { pfme::FUNCTION::EXP, [] ( double x ) { return std::exp ( x ); } },
+          { pfme::FUNCTION::LOG, [] ( double x ) { return std::log ( x ); } },
+          { pfme::FUNCTION::SIN, [] ( double x ) { return std::sin ( x ); } },
+          { pfme::FUNCTION::COS, [] ( double x ) { return std::cos ( x ); } },
+          { pfme::FUNCTION::ABS, [] ( double x ) { return std::fabs ( x ); } } }
+    };
+
+    std::vector<double> results ( inputs.size() );
+    for ( const auto level : levels() )
+    {
+        pfme::simd::set_level ( level );
+        for ( const auto& [function, reference] : unary )
+        {
+            const std::array<std::span<const double>, 1> arguments { inputs };
+            pfme::call_batch ( id ( function ), arguments, results );
+            for ( std::size_t row = 0; row < inputs.size(); ++row )
+            {
+                ASSERT_TRUE ( close ( results[row], reference ( inputs[row] ) ) )
+                    << pfme::FunctionRegistry::global().get ( id ( function ) ).m_name << '(' << inputs[row]
+                    << ") = " << results[row] << " on " << pfme::simd::simd_level_to_string ( level );
+            }
+        }
+
+        const std::array<std::span<const double>, 2> arguments { inputs, others };
+        pfme::call_batch ( id ( pfme::FUNCTION::MAX ), arguments, results );
+        for ( std::size_t row = 0; row < inputs.size(); ++row )
+        {
+            const auto expected = inputs[row] > others[row] ? inputs[row] : others[row];
+            ASSERT_TRUE ( close ( results[row], expected ) ) << row;
+        }
+
+        // in place
+        std::vector<double> column = inputs;
+        const std::array<std::span<const double>, 1> same { column };
+        pfme::call_batch ( id ( pfme::FUNCTION::ABS ), same, column );
+        ASSERT_EQ ( column[3], 1.0 );
+    }
+
+    const std::array<std::span<const double>, 1> short_argument { std::span { inputs }.first ( 3 ) };
+    ASSERT_THROW ( pfme::call_batch ( id ( pfme::FUNCTION::SQRT ), short_argument, results ), std::runtime_error );
+    ASSERT_THROW ( pfme::call_batch ( id ( pfme::FUNCTION::SQRT ), {}, results ), std::runtime_error );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,287 @@
+#include <cmath>
+#include <expected>
+#include <gtest/gtest.h>
+#include <pfme/Gradient.hpp>
+#include <pfme/Functions.hpp>
+#include <pfme/Serialization.hpp>
+#include <pfme/Visitor.hpp>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+auto compile ( const std::string& input ) -> pfme::CompiledExpression
+{
+    auto compiled = pfme::CompiledExpression::compile ( input );
+    if ( !compiled ) { throw std::runtime_error ( "Can not compile " + input ); }
+    return *compiled;
+}
+
+// the value of the expression at point, evaluated in double
+auto value_at ( const pfme::CompiledExpression& expression, const std::vector<double>& point ) -> double
+{
+    const std::vector<pfme::basic_num_t<double>> values ( point.begin(), point.end() );
+    return std::get<double> ( *expression.evaluate<double> ( values ) );
+}
+
+// central differences of the expression at point
+auto numeric_gradient ( const pfme::CompiledExpression& expression, std::vector<double> point ) -> std::vector<double>
+{
+    constexpr double    STEP = 1e-6;
+    std::vector<double> partials;
+    for ( auto& value : point )
+    {
+        const auto original = value;
+        value               = original + STEP;
+        const auto upper    = value_at ( expression, point );
+        value               = original - STEP;
+        const auto lower    = value_at ( expression, point );
+        value               = original;
+        partials.push_back ( ( upper - lower ) / ( 2 * STEP ) );
+    }
+    return partials;
+}
+} // namespace
+
+TEST ( Gradient, variables )
+{
+    const auto expression = compile ( "x * y + x / 2" );
+    ASSERT_EQ ( expression.get_variables().size(), 2 );
+    ASSERT_EQ ( expression.get_variables()[0], "x" );
+    ASSERT_EQ ( expression.find_variable ( "y" ), 1 );
+    ASSERT_FALSE ( expression.find_variable ( "z" ).has_value() );
+
+    const std::vector<pfme::AST::num_t> values { 3LL, 4LL };
+    ASSERT_EQ ( expression.evaluate<pfme::LD> ( values ).value(), pfme::AST::num_t ( pfme::Fraction ( 27, 2 ) ) );
+    ASSERT_EQ ( expression.evaluate().error().m_code, pfme::ERROR_CODE::UNBOUND_VARIABLE );
+    ASSERT_EQ ( pfme::Visitor ( "2 * x" ).try_evaluate().error().m_code, pfme::ERROR_CODE::UNBOUND_VARIABLE );
+    ASSERT_EQ ( compile ( "-x" ).evaluate<pfme::LD> ( values ).value(), pfme::AST::num_t { -3LL } );
+
+    // variables survive the binary format, but can not be evaluated without values
+    const auto nodes = pfme::validate ( pfme::serialize ( expression.to_ast().get() ) );
+    ASSERT_EQ ( pfme::CompiledExpression ( nodes ).evaluate<pfme::LD> ( values ).value(),
+                pfme::AST::num_t ( pfme::Fraction ( 27, 2 ) ) );
+    ASSERT_THROW ( pfme::evaluate ( nodes ), std::runtime_error );
+    // a name longer than a node only fails when it is written
+    ASSERT_TRUE ( pfme::BinaryNode::from_variable ( "anamethatistoolong", 0 ).get_name().empty() );
+    ASSERT_THROW ( pfme::serialize ( compile ( "anamethatistoolong * 2" ).to_ast().get() ), std::runtime_error );
+}
+
+TEST ( Gradient, matches_finite_differences )
+{
+    const std::vector<std::pair<std::string, std::vector<double>>> cases {
+        { "x * y + x / 2", { 3, 4 } },
+        { "x ^ 3 - 2 * x ^ y", { 1.5, 2.5 } },
+        { "y ^ x", { 0.7, 2.0 } },
+        { "sqrt(x) * exp(y) / log(x + y)", { 2.0, 0.5 } },
+        { "sin(x * y) + cos(x) - abs(y - 3)", { 0.3, 1.2 } },
+        { "max(x, y, 1) * min(x, 2 * y)", { 2.0, 0.75 } },
+        { "(a + b) * (a - c) / (1 + c ^ 2)", { 1.0, 2.0, 3.0 } },
+    };
+    for ( const auto& [input, point] : cases )
+    {
+        const auto          expression = compile ( input );
+        const auto          expected   = numeric_gradient ( expression, point );
+        std::vector<double> forward ( point.size() );
+        std::vector<double> reverse ( point.size() );
+        const auto          value = value_at ( expression, point );
+        ASSERT_DOUBLE_EQ ( pfme::gradient<double> ( expression, point, forward, pfme::AD_MODE::FORWARD ).value(), value )
+            << input;
+        ASSERT_DOUBLE_EQ ( pfme::gradient<double> ( expression, point, reverse ).value(), value ) << input;
+        for ( std::size_t i = 0; i < point.size(); ++i )
+        {
+            ASSERT_NEAR ( forward[i], expected[i], 1e-5 ) << input << " variable " << i;
+            ASSERT_NEAR ( reverse[i], forward[i], 1e-12 ) << input << " variable " << i;
+        }
+    }
+}
+
+TEST ( Gradient, special_cases )
+{
+    // a variable that appears several times collects the derivatives of every use
+    std::vector<double> partials ( 1 );
+    ASSERT_DOUBLE_EQ ( pfme::gradient<double> ( compile ( "x * x * x" ), std::vector { 2.0 }, partials ).value(), 8 );
+    ASSERT_DOUBLE_EQ ( partials[0], 12 );
+
+    // the derivative with respect to the exponent only exists for a positive base
+    partials.resize ( 2 );
+    ASSERT_DOUBLE_EQ ( pfme::gradient<double> ( compile ( "x ^ y" ), std::vector { -2.0, 2.0 }, partials ).value(), 4 );
+    ASSERT_DOUBLE_EQ ( partials[0], -4 );
+    ASSERT_TRUE ( std::isnan ( partials[1] ) );
+    // forward mode agrees, the NaN of one variable does not spread to the others
+    std::vector<double> forward ( 2 );
+    for ( const auto& point : { std::vector { -2.0, 2.0 }, std::vector { 0.0, 0.5 } } )
+    {
+        pfme::gradient<double> ( compile ( "x ^ y" ), point, partials, pfme::AD_MODE::REVERSE ).value();
+        pfme::gradient<double> ( compile ( "x ^ y" ), point, forward, pfme::AD_MODE::FORWARD ).value();
+        for ( std::size_t k = 0; k < 2; ++k )
+        {
+            ASSERT_TRUE ( forward[k] == partials[k] || ( std::isnan ( forward[k] ) && std::isnan ( partials[k] ) ) )
+                << point[0] << ' ' << k;
+        }
+    }
+    ASSERT_DOUBLE_EQ ( forward[1], 0 );
+    // but a constant exponent does not need it
+    partials.resize ( 1 );
+    ASSERT_DOUBLE_EQ ( pfme::gradient<double> ( compile ( "x ^ 2" ), std::vector { -2.0 }, partials ).value(), 4 );
+    ASSERT_DOUBLE_EQ ( partials[0], -4 );
+
+    // other precisions
+    std::vector<float> single ( 1 );
+    ASSERT_FLOAT_EQ ( pfme::gradient<float> ( compile ( "3 * x ^ 2" ), std::vector { 2.0F }, single ).value(), 12 );
+    ASSERT_FLOAT_EQ ( single[0], 12 );
+    std::vector<pfme::LD> extended ( 1 );
+    ASSERT_EQ (
+        pfme::gradient<pfme::LD> ( compile ( "1 / x" ), std::vector<pfme::LD> { 4 }, extended, pfme::AD_MODE::FORWARD ).value(),
+        0.25L );
+    ASSERT_EQ ( extended[0], -0.0625L );
+
+    // an infinite partial that is multiplied by 0 passes nothing on, the same in both modes and in a batch
+    const std::vector<double>                  x { 0, 4 };
+    std::vector<double>                        values ( 2 );
+    std::vector<double>                        dx ( 2 );
+    const std::vector<std::span<const double>> variables { x };
+    const std::vector<std::span<double>>       columns { dx };
+    for ( const auto& [input, expected] : { std::pair { "0 * sqrt(x)", 0.0 }, std::pair { "sqrt(x) * 0 + x", 1.0 } } )
+    {
+        const auto expression = compile ( input );
+        pfme::gradient_batch<double> ( expression, variables, values, columns );
+        for ( std::size_t row = 0; row < x.size(); ++row )
+        {
+            std::vector<double> forward ( 1 );
+            std::vector<double> reverse ( 1 );
+            pfme::gradient<double> ( expression, std::vector { x[row] }, forward, pfme::AD_MODE::FORWARD ).value();
+            pfme::gradient<double> ( expression, std::vector { x[row] }, reverse, pfme::AD_MODE::REVERSE ).value();
+            ASSERT_EQ ( forward[0], expected ) << input << " at " << x[row];
+            ASSERT_EQ ( reverse[0], expected ) << input << " at " << x[row];
+            ASSERT_EQ ( dx[row], expected ) << input << " at " << x[row];
+        }
+    }
+}
+
+TEST ( Gradient, errors )
+{
+    std::vector<double> partials ( 2 );
+    ASSERT_EQ ( pfme::gradient<double> ( compile ( "x + y" ), std::vector { 1.0 }, partials ).error().m_code,
+                pfme::ERROR_CODE::UNBOUND_VARIABLE );
+    ASSERT_EQ ( pfme::gradient<double> ( compile ( "x / (y - y)" ), std::vector { 1.0, 2.0 }, partials ).error().m_code,
+                pfme::ERROR_CODE::DIVISION_BY_ZERO );
+    ASSERT_THROW ( (void)pfme::gradient<double> ( compile ( "x" ), std::vector { 1.0 }, partials ), std::runtime_error );
+
+    pfme::Function halve;
+    halve.m_name   = "halve";
+    halve.m_scalar = [] ( std::span<const pfme::AST::num_t> arguments ) -> std::expected<pfme::AST::num_t, pfme::ERROR_CODE>
+    {
+        const auto half = [] ( auto value ) { return static_cast<pfme::LD> ( value ) / 2; };
+        return pfme::AST::num_t { std::visit ( half, arguments[0] ) };
+    };
+    halve.m_batch = [] ( std::span<const std::span<const double>> arguments, std::span<double> results )
+    {
+        for ( std::size_t row = 0; row < results.size(); ++row ) { results[row] = arguments[0][row] / 2; }
+    };
+    pfme::FunctionRegistry::global().add ( halve );
+    partials.resize ( 1 );
+    ASSERT_EQ ( pfme::gradient<double> ( compile ( "halve(x)" ), std::vector { 1.0 }, partials ).error().m_code,
+                pfme::ERROR_CODE::NOT_DIFFERENTIABLE );
+    // calls with constant arguments do not need a derivative
+    ASSERT_DOUBLE_EQ ( pfme::gradient<double> ( compile ( "halve(3) * x" ), std::vector { 2.0 }, partials ).value(), 3 );
+    ASSERT_DOUBLE_EQ ( partials[0], 1.5 );
+
+    std::vector<double>                        values ( 1 );
+    const std::vector<double>                  column { 1.0 };
+    const std::vector<std::span<const double>> columns { column };
+    const std::vector<std::span<double>>       partial_columns { partials };
+    ASSERT_THROW ( pfme::gradient_batch<double> ( compile ( "halve(x)" ), columns, values, partial_columns ),
+                   std::runtime_error );
+}
+
+TEST ( Gradient, batch_matches_scalar )
+{
+    constexpr std::size_t ROWS = 1000; // several blocks and a partial one
+    for ( const std::string input : { "x * y + x / 2", "sqrt(x) * exp(y) / log(x + y)", "max(x, y) ^ 2 - sin(x) * y ^ 0.5" } )
+    {
+        const auto          expression = compile ( input );
+        std::vector<double> x ( ROWS );
+        std::vector<double> y ( ROWS );
+        for ( std::size_t row = 0; row < ROWS; ++row )
+        {
+            x[row] = 0.5 + ( static_cast<double> ( row ) / 100 );
+            y[row] = 3.0 - ( static_cast<double> ( row ) / 400 );
+        }
+        std::vector<double>                        values ( ROWS );
+        std::vector<double>                        dx ( ROWS, 42 );
+        std::vector<double>                        dy ( ROWS, 42 );
+        const std::vector<std::span<const double>> variables { x, y };
+        const std::vector<std::span<double>>       partials { dx, dy };
+        pfme::gradient_batch<double> ( expression, variables, values, partials );
+
+        std::vector<double> scalar ( 2 );
+        for ( std::size_t row = 0; row < ROWS; ++row )
+        {
+            const auto value = pfme::gradient<double> ( expression, std::vector { x[row], y[row] }, scalar );
+            ASSERT_NEAR ( values[row], *value, 1e-12 * std::abs ( *value ) ) << input << " row " << row;
+            ASSERT_NEAR ( dx[row], scalar[0], 1e-12 * ( 1 + std::abs ( scalar[0] ) ) ) << input << " row " << row;
+            ASSERT_NEAR ( dy[row], scalar[1], 1e-12 * ( 1 + std::abs ( scalar[1] ) ) ) << input << " row " << row;
+        }
+    }
+
+    // every precision uses the same code, float calls the functions row by row
+    const auto         expression = compile ( "x * sqrt(x)" );
+    std::vector<float> x { 1, 4, 9 };
+    std::vector<float> values ( 3 );
+    std::vector<float> dx ( 3 );
+    pfme::gradient_batch<float> ( expression,
+                                  std::vector<std::span<const float>> { x },
+                                  values,
+                                  std::vector<std::span<float>> { dx } );
+    ASSERT_EQ ( values, ( std::vector<float> { 1, 8, 27 } ) );
+    ASSERT_EQ ( dx, ( std::vector<float> { 1.5, 3, 4.5 } ) );
+
+    std::vector<float> wrong ( 2 );
+    ASSERT_THROW ( pfme::gradient_batch<float> ( expression,
+                                                 std::vector<std::span<const float>> { x },
+                                                 values,
+                                                 std::vector<std::span<float>> { wrong } ),
+                   std::runtime_error );
+}
+
+TEST ( Gradient, conditions )
+{
+    // the derivative follows the taken branch, comparisons are constant
+    const auto          expression = compile ( "x > 0 ? x * x : 0 * log(-x)" );
+    std::vector<double> partials ( 1 );
+    ASSERT_EQ ( *pfme::gradient<double> ( expression, std::vector { 3.0 }, partials ), 9 );
+    ASSERT_EQ ( partials[0], 6 );
+    ASSERT_EQ ( *pfme::gradient<double> ( expression, std::vector { -3.0 }, partials ), 0 );
+    ASSERT_EQ ( partials[0], 0 );
+
+    // a subtree that only feeds a comparison has no derivative, even if the partials inside of it are infinite
+    std::vector<double> forward ( 2 );
+    std::vector<double> reverse ( 2 );
+    for ( const auto* input : { "x < 8 / 9 ^ exp(3.5 * z)", "x + 1 < exp(exp(5.5 ^ z))" } )
+    {
+        const auto comparison = compile ( input );
+        pfme::gradient<double> ( comparison, std::vector { 3.19, 3.19 }, forward, pfme::AD_MODE::FORWARD ).value();
+        pfme::gradient<double> ( comparison, std::vector { 3.19, 3.19 }, reverse, pfme::AD_MODE::REVERSE ).value();
+        ASSERT_EQ ( forward, ( std::vector<double> { 0, 0 } ) ) << input;
+        ASSERT_EQ ( reverse, forward ) << input;
+    }
+
+    // the branch that is not taken in a row can not make its derivative NaN
+    const std::vector<double>                  x { -2, 4 };
+    std::vector<double>                        values ( 2 );
+    std::vector<double>                        dx ( 2 );
+    const std::vector<std::span<const double>> variables { x };
+    const std::vector<std::span<double>>       columns { dx };
+    pfme::gradient_batch<double> ( compile ( "x > 0 ? sqrt(x) : 1" ), variables, values, columns );
+    ASSERT_EQ ( values, ( std::vector<double> { 1, 2 } ) );
+    ASSERT_EQ ( dx, ( std::vector<double> { 0, 0.25 } ) );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -21,6 +21,95 @@ TEST ( Lexer, get_next_token )
     ASSERT_EQ ( lex.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_EOF );
 }
 
+TEST ( Lexer, numbers )
+{
+    pfme::Lexer lex ( "42 0.5 1'000_000 1.5e-9 2E+3 3e 0x1F 0XfF 9223372036854775808" );
+
+    ASSERT_EQ ( std::get<std::uint64_t> ( lex.get_next_token()->get_number() ), 42 );
+    ASSERT_EQ ( std::get<long double> ( lex.get_next_token()->get_number() ), 0.5L );
+    ASSERT_EQ ( std::get<std::uint64_t> ( lex.get_next_token()->get_number() ), 1'000'000 );
+
+    auto scientific = lex.get_next_token();
+    ASSERT_EQ ( scientific->get_type(), pfme::TOKEN_TYPE::TOKEN_FLOAT );
+    ASSERT_EQ ( scientific->get_value(), "1.5e-9" );
+    ASSERT_EQ ( std::get<long double> ( scientific->get_number() ), 1.5e-9L );
+    ASSERT_EQ ( std::get<long double> ( lex.get_next_token()->get_number() ), 2000.0L );
+
+    // without digits the 'e' is not part of the number
+    ASSERT_EQ ( std::get<std::uint64_t> ( lex.get_next_token()->get_number() ), 3 );
+    ASSERT_EQ ( lex.get_next_token()->get_value(), "e" );
+
+    auto hex = lex.get_next_token();
+    ASSERT_EQ ( hex->get_type(), pfme::TOKEN_TYPE::TOKEN_INTEGER );
+    ASSERT_EQ ( hex->get_value(), "0x1F" );
+    ASSERT_EQ ( std::get<std::uint64_t> ( hex->get_number() ), 31 );
+    ASSERT_EQ ( std::get<std::uint64_t> ( lex.get_next_token()->get_number() ), 255 );
+
+    // one more than the largest integer, only valid with a '-' in front of it
+    ASSERT_EQ ( std::get<std::uint64_t> ( lex.get_next_token()->get_number() ), 9'223'372'036'854'775'808ULL );
+    ASSERT_EQ ( lex.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_EOF );
+
+    // a '_' between the characters of a name belongs to the name
+    pfme::Lexer names ( "unit_price 1_000 x_1 y_" );
+    ASSERT_EQ ( names.get_next_token()->get_value(), "unit_price" );
+    ASSERT_EQ ( std::get<std::uint64_t> ( names.get_next_token()->get_number() ), 1'000 );
+    ASSERT_EQ ( names.get_next_token()->get_value(), "x_1" );
+    ASSERT_EQ ( names.get_next_token()->get_value(), "y" );
+    ASSERT_EQ ( names.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_EOF );
+}
+
+TEST ( Lexer, german_numbers )
+{
+    pfme::Lexer lex ( "3,5 1.000,25 2,5e2", ',', std::vector<char> { '.', '\'', '_' } );
+
+    ASSERT_EQ ( std::get<long double> ( lex.get_next_token()->get_number() ), 3.5L );
+    ASSERT_EQ ( std::get<long double> ( lex.get_next_token()->get_number() ), 1000.25L );
+    ASSERT_EQ ( std::get<long double> ( lex.get_next_token()->get_number() ), 250.0L );
+}
+
+TEST ( Lexer, config )
+{
+    const auto& swiss = pfme::LexerConfig::swiss();
+    ASSERT_TRUE ( swiss.is ( '\'', pfme::CHAR_CLASS::SEPERATOR ) );
+    ASSERT_TRUE ( swiss.is ( '.', pfme::CHAR_CLASS::POINT ) );
+    ASSERT_FALSE ( swiss.is ( ',', pfme::CHAR_CLASS::SEPERATOR ) );
+    ASSERT_TRUE ( swiss.is ( 'b', pfme::CHAR_CLASS::HEX_DIGIT ) );
+    ASSERT_FALSE ( swiss.is ( 'g', pfme::CHAR_CLASS::HEX_DIGIT ) );
+    ASSERT_FALSE ( swiss.is ( static_cast<char> ( 0xE4 ), pfme::CHAR_CLASS::DIGIT ) );
+
+    pfme::Lexer swiss_lex ( "1'234.5", swiss );
+    ASSERT_EQ ( std::get<long double> ( swiss_lex.get_next_token()->get_number() ), 1234.5L );
+
+    // spaces only join digits if they are seperators
+    pfme::Lexer spaced ( "1 000 000.5 + 2", pfme::LexerConfig::space_grouping() );
+    ASSERT_EQ ( std::get<long double> ( spaced.get_next_token()->get_number() ), 1'000'000.5L );
+    ASSERT_EQ ( spaced.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_ADDITION );
+    pfme::Lexer standard ( "1 000" );
+    ASSERT_EQ ( std::get<std::uint64_t> ( standard.get_next_token()->get_number() ), 1 );
+
+    // the same config can be used by any number of lexers
+    for ( const auto* input : { "3,5", "1.000,5" } )
+    {
+        pfme::Lexer german ( input, pfme::LexerConfig::german() );
+        ASSERT_EQ ( german.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_FLOAT ) << input;
+    }
+
+    ASSERT_THROW ( pfme::LexerConfig ( '.', { '.' } ), std::runtime_error );
+    ASSERT_THROW ( pfme::LexerConfig ( '5', {} ), std::runtime_error );
+    ASSERT_THROW ( pfme::LexerConfig ( '.', { 'e' } ), std::runtime_error );
+    ASSERT_THROW ( pfme::LexerConfig ( '.', { '-' } ), std::runtime_error );
+    ASSERT_THROW ( pfme::LexerConfig ( ' ', {} ), std::runtime_error );
+}
+
+TEST ( Lexer, invalid_numbers )
+{
+    ASSERT_EQ ( pfme::Lexer ( "0x" ).try_next_token().error().m_code, pfme::ERROR_CODE::INVALID_NUMBER );
+    ASSERT_EQ ( pfme::Lexer ( "." ).try_next_token().error().m_code, pfme::ERROR_CODE::INVALID_NUMBER );
+    ASSERT_EQ ( pfme::Lexer ( "1e99999" ).try_next_token().error().m_code, pfme::ERROR_CODE::NUMBER_OUT_OF_RANGE );
+    ASSERT_EQ ( pfme::Lexer ( "0x8000000000000001" ).try_next_token().error().m_code, pfme::ERROR_CODE::NUMBER_OUT_OF_RANGE );
+    ASSERT_EQ ( pfme::Lexer ( "99999999999999999999" ).try_next_token().error().m_code, pfme::ERROR_CODE::NUMBER_OUT_OF_RANGE );
+}
+
 TEST ( Lexer, error_string )
 {
     pfme::Lexer lex ( "5 + (6/0.6)" );
@@ -28,6 +117,38 @@ TEST ( Lexer, error_string )
     ASSERT_EQ ( lex.error_string ( "test1" ).starts_with ( "test1" ), true );
 }
 
+TEST ( Lexer, comparisons_and_conditions )
+{
+    pfme::Lexer lex ( "1<=2 >3 == 4!=5 && x || y ? 6 : 7 < 8 >= 9" );
+
+    ASSERT_EQ ( lex.get_next_token()->get_value(), "1" );
+    ASSERT_EQ ( lex.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_LESS_EQUAL );
+    ASSERT_EQ ( lex.get_next_token()->get_value(), "2" );
+    ASSERT_EQ ( lex.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_GREATER );
+    ASSERT_EQ ( lex.get_next_token()->get_value(), "3" );
+    ASSERT_EQ ( lex.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_EQUAL );
+    ASSERT_EQ ( lex.get_next_token()->get_value(), "4" );
+    ASSERT_EQ ( lex.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_NOT_EQUAL );
+    ASSERT_EQ ( lex.get_next_token()->get_value(), "5" );
+    ASSERT_EQ ( lex.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_AND );
+    ASSERT_EQ ( lex.get_next_token()->get_value(), "x" );
+    ASSERT_EQ ( lex.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_OR );
+    ASSERT_EQ ( lex.get_next_token()->get_value(), "y" );
+    ASSERT_EQ ( lex.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_CONDITION );
+    ASSERT_EQ ( lex.get_next_token()->get_value(), "6" );
+    ASSERT_EQ ( lex.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_ALTERNATIVE );
+    ASSERT_EQ ( lex.get_next_token()->get_value(), "7" );
+    ASSERT_EQ ( lex.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_LESS );
+    ASSERT_EQ ( lex.get_next_token()->get_value(), "8" );
+    ASSERT_EQ ( lex.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_GREATER_EQUAL );
+    ASSERT_EQ ( lex.get_next_token()->get_value(), "9" );
+    ASSERT_EQ ( lex.get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_EOF );
+
+    // a single = or & is not an operator
+    ASSERT_EQ ( pfme::Lexer ( "= 2" ).get_next_token()->get_type(), pfme::TOKEN_TYPE::TOKEN_UNKNOWN );
+    ASSERT_EQ ( pfme::Lexer ( "& 2" ).get_next_token()->get_value(), "&" );
+}
+
 int main ( int argc, char** argv )
 {
     ::testing::InitGoogleTest ( &argc, argv );
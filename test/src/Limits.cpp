@@ -0,0 +1,120 @@
+#include <cmath>
+#include <gtest/gtest.h>
+#include <pfme/Limits.hpp>
+#include <pfme/Session.hpp>
+#include <string>
+
+namespace
+{
+auto evaluate ( const std::string& input, const pfme::Limits& limits ) -> pfme::Result<pfme::AST::num_t>
+{
+    pfme::Session session;
+    session.set_limits ( limits );
+    return session.evaluate ( input );
+}
+
+auto exceeded ( const std::string& input, const pfme::Limits& limits ) -> bool
+{
+    const auto result = evaluate ( input, limits );
+    return !result && result.error().m_code == pfme::ERROR_CODE::LIMIT_EXCEEDED;
+}
+} // namespace
+
+TEST ( Limits, lexer_limits )
+{
+    pfme::Limits limits;
+    limits.m_input_length = 9;
+    ASSERT_EQ ( evaluate ( "1 + 2 + 3", limits ).value(), pfme::AST::num_t { 6LL } );
+    ASSERT_TRUE ( exceeded ( "1 + 2 + 34", limits ) );
+    ASSERT_EQ ( evaluate ( "1 + 2 + 34", limits ).error().m_position, 9 );
+
+    limits                = {};
+    limits.m_tokens       = 3;
+    ASSERT_EQ ( evaluate ( "1 + 2", limits ).value(), pfme::AST::num_t { 3LL } );
+    ASSERT_TRUE ( exceeded ( "1 + 2 + 3", limits ) );
+    ASSERT_EQ ( evaluate ( "1 + 2 + 3", limits ).error().m_position, 6 );
+    ASSERT_TRUE ( exceeded ( "max(1, 2)", limits ) );
+
+    limits                  = {};
+    limits.m_literal_length = 4;
+    ASSERT_EQ ( evaluate ( "1234 + 0x1F", limits ).value(), pfme::AST::num_t { 1265LL } );
+    ASSERT_TRUE ( exceeded ( "1 + 12'345", limits ) );
+    ASSERT_EQ ( evaluate ( "1 + 12'345", limits ).error().m_position, 4 );
+    ASSERT_TRUE ( exceeded ( "0x1F2", limits ) );
+    ASSERT_TRUE ( exceeded ( "1.2345", limits ) );
+}
+
+TEST ( Limits, exponent_overflow )
+{
+    // exact powers that do not fit into 64 bits are calculated as floats instead of wrapping around
+    ASSERT_EQ ( evaluate ( "2 ^ 62", {} ).value(), pfme::AST::num_t { 4'611'686'018'427'387'904LL } );
+    ASSERT_EQ ( evaluate ( "(-3) ^ 39", {} ).value(), pfme::AST::num_t { -4'052'555'153'018'976'267LL } );
+    ASSERT_EQ ( evaluate ( "2 ^ 63", {} ).value(), pfme::AST::num_t { std::ldexp ( pfme::LD { 1 }, 63 ) } );
+    ASSERT_EQ ( evaluate ( "2 ^ 64", {} ).value(), pfme::AST::num_t { std::ldexp ( pfme::LD { 1 }, 64 ) } );
+    ASSERT_EQ ( evaluate ( "2 ^ -64", {} ).value(), pfme::AST::num_t { std::ldexp ( pfme::LD { 1 }, -64 ) } );
+    const auto power = evaluate ( "3 ^ 41", {} ).value();
+    ASSERT_TRUE ( std::holds_alternative<pfme::LD> ( power ) );
+    ASSERT_NEAR ( static_cast<double> ( std::get<pfme::LD> ( power ) ), 3.6472996377170786e19, 1e5 );
+    ASSERT_EQ ( evaluate ( "(2 / 3) ^ 3", {} ).value(), ( pfme::AST::num_t { pfme::Fraction ( 8, 27 ) } ) );
+    ASSERT_EQ ( evaluate ( "(1 / 2) ^ -62", {} ).value(),
+                ( pfme::AST::num_t { pfme::Fraction ( 4'611'686'018'427'387'904LL, 1 ) } ) );
+    ASSERT_EQ ( evaluate ( "(1 / 2) ^ 64", {} ).value(), pfme::AST::num_t { std::ldexp ( pfme::LD { 1 }, -64 ) } );
+}
+
+TEST ( Limits, parser_limits )
+{
+    pfme::Limits limits;
+    limits.m_depth = 4;
+    ASSERT_EQ ( evaluate ( "(1 + 2) * (3 + 4)", limits ).value(), pfme::AST::num_t { 21LL } );
+    ASSERT_EQ ( evaluate ( "max(1, min(2, 3)) + 1", limits ).value(), pfme::AST::num_t { 3LL } );
+    ASSERT_TRUE ( exceeded ( "((((((1))))))", limits ) );
+    ASSERT_TRUE ( exceeded ( "1 + 1 + 1 + 1 + 1 + 1", limits ) );
+    ASSERT_TRUE ( exceeded ( "abs(abs(abs(abs(abs(1)))))", limits ) );
+    // an unbalanced ')' does not count as nesting
+    ASSERT_FALSE ( exceeded ( "1) + 1", limits ) );
+}
+
+TEST ( Limits, evaluation_limits )
+{
+    pfme::Limits limits;
+    limits.m_exponent = 64;
+    ASSERT_EQ ( evaluate ( "2 ^ 62", limits ).value(), pfme::AST::num_t { 1LL << 62 } );
+    ASSERT_TRUE ( exceeded ( "2 ^ 65", limits ) );
+    ASSERT_TRUE ( exceeded ( "1 ^ -100", limits ) );
+    ASSERT_TRUE ( evaluate ( "2 ^ 100.5", limits ).has_value() );
+
+    limits         = {};
+    limits.m_steps = 3;
+    ASSERT_EQ ( evaluate ( "1 + 2 * 3 - 4", limits ).value(), pfme::AST::num_t { 3LL } );
+    ASSERT_TRUE ( exceeded ( "1 + 2 * 3 - 4 + 5", limits ) );
+    ASSERT_TRUE ( exceeded ( "1 < 2 ? 3 + 4 * 5 : 6", limits ) );
+
+    // the clock is read every Limits::CLOCK_INTERVAL steps, short expressions never look at it
+    limits        = {};
+    limits.m_time = std::chrono::nanoseconds { 0 };
+    ASSERT_EQ ( evaluate ( "1 + 2", limits ).value(), pfme::AST::num_t { 3LL } );
+    std::string chain = "1";
+    for ( std::size_t i = 0; i < pfme::Limits::CLOCK_INTERVAL; ++i ) { chain += " + 1"; }
+    ASSERT_TRUE ( exceeded ( chain, limits ) );
+    ASSERT_EQ ( evaluate ( chain, {} ).value(),
+                pfme::AST::num_t { static_cast<pfme::LLI> ( pfme::Limits::CLOCK_INTERVAL + 1 ) } );
+}
+
+TEST ( Limits, untrusted )
+{
+    const auto limits = pfme::Limits::untrusted();
+    ASSERT_EQ ( evaluate ( "max(1.5, 2) * (3 + 4) ^ 2", limits ).value(), pfme::AST::num_t { 98LL } );
+    ASSERT_TRUE ( exceeded ( std::string ( 20'000, '1' ), limits ) );
+    ASSERT_TRUE ( exceeded ( "7 ^ 1000000000000", limits ) );
+
+    // without limits a huge exponent still only takes a few multiplications
+    ASSERT_EQ ( evaluate ( "1 ^ 1000000000000", {} ).value(), pfme::AST::num_t { 1LL } );
+    ASSERT_EQ ( evaluate ( "3 ^ 39", {} ).value(), pfme::AST::num_t { 4'052'555'153'018'976'267LL } );
+    ASSERT_EQ ( evaluate ( "(-2) ^ 3", {} ).value(), pfme::AST::num_t { -8LL } );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,160 @@
+#include <Workload.hpp>
+#include <gtest/gtest.h>
+#include <pfme/ParallelParser.hpp>
+#include <pfme/Parser.hpp>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+auto sequential ( const std::string& input, const pfme::LexerConfig& config ) -> pfme::Result<std::shared_ptr<pfme::AST>>
+{
+    pfme::Parser parser ( std::make_unique<pfme::Lexer> ( input, config ) );
+    return parser.try_parse();
+}
+
+// compares everything the Parser sets, including the operation levels
+auto same_tree ( const pfme::AST* lhs, const pfme::AST* rhs ) -> bool
+{
+    std::vector<std::pair<const pfme::AST*, const pfme::AST*>> worklist { { lhs, rhs } };
+    while ( !worklist.empty() )
+    {
+        const auto [left, right] = worklist.back();
+        worklist.pop_back();
+        if ( left == nullptr || right == nullptr )
+        {
+            if ( left != right ) { return false; }
+            continue;
+        }
+        if ( left->m_type != right->m_type || left->m_value != right->m_value || left->m_number != right->m_number ||
+             left->m_operation_level != right->m_operation_level || left->m_function != right->m_function )
+        {
+            return false;
+        }
+        worklist.emplace_back ( left->lhand.get(), right->lhand.get() );
+        worklist.emplace_back ( left->rhand.get(), right->rhand.get() );
+    }
+    return true;
+}
+
+auto expect_same ( const std::string&           input,
+                   const pfme::ParallelOptions& options,
+                   const pfme::LexerConfig&     config = pfme::LexerConfig::standard() ) -> void
+{
+    const auto expected = sequential ( input, config );
+    const auto parallel = pfme::parse_parallel ( input, config, options );
+    ASSERT_EQ ( parallel.has_value(), expected.has_value() ) << input;
+    if ( expected ) { ASSERT_TRUE ( same_tree ( parallel->get(), expected->get() ) ) << input; }
+    else
+    {
+        ASSERT_EQ ( parallel.error().m_code, expected.error().m_code ) << input;
+        ASSERT_EQ ( parallel.error().m_position, expected.error().m_position ) << input;
+    }
+}
+
+// every chunk size, so there is a boundary in front of every operator
+auto expect_same_everywhere ( const std::string& input, const pfme::LexerConfig& config = pfme::LexerConfig::standard() )
+    -> void
+{
+    for ( std::size_t chunk_size = 1; chunk_size <= input.size(); ++chunk_size )
+    {
+        expect_same ( input, { input.size(), chunk_size }, config );
+        if ( ::testing::Test::HasFatalFailure() ) { return; }
+    }
+}
+} // namespace
+
+TEST ( ParallelParser, same_tree_as_parser )
+{
+    for ( const std::string input : { "1 + 2 * 3 - 4 / 5 ^ 6",
+                                      "5 * 3 * 3 + ( ( 4.3 + 3 * 5 ) + 24 ) * 3 / 7",
+                                      "8 - 3 - 2 - 1",
+                                      "2 ^ 3 ^ 2 * 4 ^ 2 + 1",
+                                      "-2 ^ 2 - -3 * +4",
+                                      "1.5e-3 + 2E+2 - 1e5 * 3.",
+                                      "(((1 + 2) * 3) ^ (4 - 5)) / ((6))",
+                                      "1 + 2) * 3 + (4",
+                                      "(1 + 2",
+                                      "1 * (2 + (3 * (4 + 5",
+                                      "1 +",
+                                      "5 * (",
+                                      "x * -y + 2 ^ z / (x - 1)",
+                                      "-9223372036854775808 * 1_000 + 0x1F",
+                                      "1 + 2 * 3 ^ 4 * 5 + 6 ^ 7 ^ 8 - 9 * 10" } )
+    {
+        expect_same_everywhere ( input );
+        if ( HasFatalFailure() ) { return; }
+    }
+    expect_same_everywhere ( "1 000 + 2 000 * 3 000.5", pfme::LexerConfig::space_grouping() );
+    expect_same_everywhere ( "1.000,5 * 2 - 3,25", pfme::LexerConfig::german() );
+}
+
+TEST ( ParallelParser, generated )
+{
+    pfme::workload::Options options;
+    options.m_operands             = 4000;
+    options.m_max_depth            = 6;
+    options.m_negative_probability = 0.2;
+    options.m_operator_weights     = { 4, 3, 2, 1, 2 };
+    options.m_seperator_probability = 0.1;
+    for ( std::uint64_t seed = 1; seed <= 4; ++seed )
+    {
+        options.m_seed   = seed;
+        const auto input = pfme::workload::Generator ( options ).generate();
+        for ( const std::size_t threads : { 2, 3, 8, 64 } )
+        {
+            expect_same ( input, { threads, 16 } );
+            if ( HasFatalFailure() ) { return; }
+        }
+    }
+}
+
+TEST ( ParallelParser, fallback )
+{
+    // function calls and errors are parsed again by a single Parser
+    for ( const std::string input : { "sqrt(16) + 2 * max(1, 2, 3) - 4",
+                                      "1 + x (2)",
+                                      "1 +* 2",
+                                      "1 + 2 3 * 4",
+                                      "2 * (3 + 4) (5)",
+                                      "1 + - (2)",
+                                      "1 + 2 -",
+                                      "9223372036854775808 + 1",
+                                      "1 + 2.3.4 * 5",
+                                      "1 + \xc3\xa4 * 2",
+                                      "1 + 2 # 3",
+                                      ") + 1",
+                                      "()",
+                                      "",
+                                      "1 + 2\0 * 3x" } )
+    {
+        expect_same_everywhere ( input );
+        if ( HasFatalFailure() ) { return; }
+    }
+    expect_same ( std::string ( "1 + 2\0 * 3", 10 ), { 10, 1 } );
+}
+
+TEST ( ParallelParser, random_inputs )
+{
+    const std::vector<std::string> parts { "1", "2", "30", "4.5", "1e2", "x", "-", "+", "*", "/", "^", "(", ")", " " };
+    std::mt19937                   random ( 11 );
+    for ( int i = 0; i < 3000; ++i )
+    {
+        std::string input;
+        const auto  length = std::uniform_int_distribution<std::size_t> { 1, 30 }( random );
+        for ( std::size_t part = 0; part < length; ++part )
+        {
+            input += parts[std::uniform_int_distribution<std::size_t> { 0, parts.size() - 1 }( random )];
+        }
+        expect_same ( input, { 16, std::uniform_int_distribution<std::size_t> { 1, 8 }( random ) } );
+        if ( HasFatalFailure() ) { return; }
+    }
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -43,6 +43,34 @@ TEST ( Parser, printBT )
     ASSERT_EQ ( output_2.starts_with ( "└──*\n" ), true );
 }
 
+TEST ( Parser, deep_trees )
+{
+    constexpr int depth = 1'000'000;
+    std::string   right_leaning;
+    for ( int i = 0; i < depth; ++i ) { right_leaning += "1+"; }
+    right_leaning += '1';
+
+    pfme::Parser right ( right_leaning );
+    const auto*  node = right.parse().get();
+    int          levels = 0;
+    while ( !node->is_num() )
+    {
+        node = node->rhand.get();
+        ++levels;
+    }
+    ASSERT_EQ ( levels, depth );
+
+    // nothing is written into a stream without a buffer, which keeps the (quadratic) output of the walk out of the test
+    std::ostream discard ( nullptr );
+    pfme::Parser::print_binary_tree ( right.get_root().get(), discard );
+
+    std::string left_leaning ( depth / 5, '(' );
+    left_leaning += '1';
+    for ( int i = 0; i < depth / 5; ++i ) { left_leaning += "+1)"; }
+    pfme::Parser left ( left_leaning );
+    ASSERT_EQ ( left.parse()->m_type, pfme::AST_TYPE::ADDITION );
+    ASSERT_EQ ( left.get_root()->rhand->is_num(), true );
+}
 
 int main ( int argc, char** argv )
 {
@@ -0,0 +1,139 @@
+#include <chrono>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <numbers>
+#include <pfme/Compiled.hpp>
+#include <pfme/Decimal.hpp>
+#include <pfme/Limits.hpp>
+#include <pfme/Parser.hpp>
+#include <pfme/Session.hpp>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+auto evaluate ( const std::string& input, const pfme::Limits& limits = {} ) -> pfme::Result<pfme::AST::num_t>
+{
+    pfme::Session session;
+    session.set_limits ( limits );
+    return session.evaluate ( input );
+}
+
+auto failure ( const std::string& input, const pfme::Limits& limits = {} ) -> pfme::ERROR_CODE
+{
+    return evaluate ( input, limits ).error().m_code;
+}
+} // namespace
+
+TEST ( Range, exact_terms )
+{
+    ASSERT_EQ ( evaluate ( "sum(i, 1, 100, i)" ).value(), pfme::AST::num_t { 5050LL } );
+    ASSERT_EQ ( evaluate ( "prod(i, 1, 10, i)" ).value(), pfme::AST::num_t { 3'628'800LL } );
+    ASSERT_EQ ( evaluate ( "sum(k, 1, 4, 1 / k)" ).value(), ( pfme::AST::num_t { pfme::Fraction ( 25, 12 ) } ) );
+    ASSERT_EQ ( evaluate ( "sum(i, -3, 3, i * i * i) + 1" ).value(), pfme::AST::num_t { 1LL } );
+    ASSERT_EQ ( evaluate ( "sum(i, 1, 2 + 3, 2)" ).value(), pfme::AST::num_t { 10LL } );
+    // large enough to be split into chunks, which are combined exactly
+    ASSERT_EQ ( evaluate ( "sum(i, 1, 200000, i)" ).value(), pfme::AST::num_t { 20'000'100'000LL } );
+}
+
+TEST ( Range, empty_range )
+{
+    ASSERT_EQ ( evaluate ( "sum(i, 5, 4, i)" ).value(), pfme::AST::num_t { 0LL } );
+    ASSERT_EQ ( evaluate ( "prod(i, 5, 4, i)" ).value(), pfme::AST::num_t { 1LL } );
+
+    // all 2^64 indices are too many to count, not an empty range
+    ASSERT_EQ ( failure ( "sum(i, -9223372036854775807 - 1, 9223372036854775807, 1)" ), pfme::ERROR_CODE::LIMIT_EXCEEDED );
+    ASSERT_EQ ( failure ( "prod(i, -9223372036854775807 - 1, 9223372036854775807, 0)" ), pfme::ERROR_CODE::LIMIT_EXCEEDED );
+}
+
+TEST ( Range, float_terms )
+{
+    const auto basel = evaluate ( "sum(i, 1, 1000000, 1 / i ^ 2.0)" ).value();
+    ASSERT_TRUE ( std::holds_alternative<pfme::LD> ( basel ) );
+    ASSERT_NEAR ( static_cast<double> ( std::get<pfme::LD> ( basel ) ), std::numbers::pi * std::numbers::pi / 6, 1e-5 );
+
+    const auto powers = evaluate ( "prod(i, 1, 10, 2.0)" ).value();
+    ASSERT_NEAR ( static_cast<double> ( std::get<pfme::LD> ( powers ) ), 1024.0, 1e-9 );
+
+    // the terms are added in the precision of the Visitor, 1e-17 is lost in a double
+    ASSERT_EQ ( evaluate ( "sum(i, 1, 2, 1.0 + 1e-17)" ).value(), evaluate ( "(1.0 + 1e-17) + (1.0 + 1e-17)" ).value() );
+    ASSERT_NE ( evaluate ( "sum(i, 1, 2, 1.0 + 1e-17)" ).value(), pfme::AST::num_t { 2.0L } );
+
+    // a failing term is an error like outside of a range, whatever the type of the first term is
+    ASSERT_EQ ( failure ( "sum(i, 1, 3, log(3 - i))" ), failure ( "log(0)" ) );
+    ASSERT_EQ ( failure ( "sum(i, 1, 3, 1.0 / (i - 2))" ), pfme::ERROR_CODE::DIVISION_BY_ZERO );
+    ASSERT_EQ ( failure ( "sum(i, 1, 3, sqrt(2 - i))" ), pfme::ERROR_CODE::DOMAIN_ERROR );
+    ASSERT_EQ ( failure ( "sum(i, 1, 3, sqrt(2.5 - i))" ), pfme::ERROR_CODE::DOMAIN_ERROR );
+    ASSERT_EQ ( failure ( "prod(i, 1, 100000, 1.0 / (i - 70000))" ), pfme::ERROR_CODE::DIVISION_BY_ZERO );
+}
+
+TEST ( Range, exact_overflow )
+{
+    // an exact sum or product that does not fit into 64 bits is out of range like the written out expression
+    ASSERT_EQ ( failure ( "prod(i, 1, 25, i)" ), pfme::ERROR_CODE::NUMBER_OUT_OF_RANGE );
+    ASSERT_EQ ( failure ( "1*2*3*4*5*6*7*8*9*10*11*12*13*14*15*16*17*18*19*20*21*22*23*24*25" ),
+                pfme::ERROR_CODE::NUMBER_OUT_OF_RANGE );
+    ASSERT_EQ ( failure ( "sum(i, 1, 100, 1 / i)" ), pfme::ERROR_CODE::NUMBER_OUT_OF_RANGE );
+    ASSERT_EQ ( failure ( "sum(i, 1, 1000000, 1 / i^2)" ), pfme::ERROR_CODE::NUMBER_OUT_OF_RANGE );
+    ASSERT_EQ ( evaluate ( "prod(i, 1, 20, i)" ).value(), pfme::AST::num_t { 2'432'902'008'176'640'000LL } );
+
+    // with a float term the same ranges are reduced with floats
+    const auto near = [] ( const std::string& input, double expected )
+    {
+        const auto result = evaluate ( input ).value();
+        ASSERT_TRUE ( std::holds_alternative<pfme::LD> ( result ) ) << input;
+        ASSERT_NEAR ( static_cast<double> ( std::get<pfme::LD> ( result ) ), expected, 1e-9 * expected ) << input;
+    };
+    near ( "sum(i, 1, 100, 1.0 / i)", 5.187377517639621 );
+    near ( "prod(i, 1, 25, i * 1.0)", 1.5511210043330986e25 );
+}
+
+TEST ( Range, decimal_terms )
+{
+    auto config = pfme::LexerConfig::standard();
+    config.set_decimals ( true );
+    pfme::Session session ( config );
+    session.set_decimal_context ( { 2, pfme::ROUNDING::HALF_UP } );
+
+    // the quotients inside of the term are rounded with the context of the Session like outside of a range
+    const auto expected = session.evaluate ( "1.00 / 3 + 1.00 / 3 + 1.00 / 3" ).value();
+    ASSERT_EQ ( expected, pfme::AST::num_t { pfme::Decimal ( 99, 2 ) } );
+    ASSERT_EQ ( session.evaluate ( "sum(i, 1, 3, 1.00 / 3)" ).value(), expected );
+    ASSERT_EQ ( session.evaluate ( "sum(i, 1, 200000, 1.00 / 3)" ).value(),
+                pfme::AST::num_t { pfme::Decimal ( 6'600'000, 2 ) } );
+}
+
+TEST ( Range, errors )
+{
+    ASSERT_EQ ( failure ( "sum(2, 1, 10, 2)" ), pfme::ERROR_CODE::UNEXPECTED_TOKEN );
+    ASSERT_EQ ( failure ( "sum(i, 1, 10)" ), pfme::ERROR_CODE::ARGUMENT_COUNT );
+    ASSERT_EQ ( failure ( "sum(i, 1, 10, i * j)" ), pfme::ERROR_CODE::UNBOUND_VARIABLE );
+    ASSERT_EQ ( failure ( "sum(i, 1, 2.5, i)" ), pfme::ERROR_CODE::DOMAIN_ERROR );
+    ASSERT_EQ ( failure ( "sum(i, 0, 10, 1 / i)" ), pfme::ERROR_CODE::DIVISION_BY_ZERO );
+    ASSERT_EQ ( failure ( "sum(i, 1, 3, sum(j, 1, i, j))" ), pfme::ERROR_CODE::UNSUPPORTED_RANGE );
+
+    // only the Visitor evaluates ranges, compiled the index would look like a free variable
+    ASSERT_EQ ( pfme::CompiledExpression::compile ( "sum(i, 1, 3, i)" ).error().m_code, pfme::ERROR_CODE::UNSUPPORTED_RANGE );
+    ASSERT_EQ ( pfme::CompiledExpression::compile ( "x + prod(i, 1, 3, i)" ).error().m_code,
+                pfme::ERROR_CODE::UNSUPPORTED_RANGE );
+    pfme::Parser parser ( "sum(i, 1, 3, i)" );
+    ASSERT_THROW ( pfme::CompiledExpression ( parser.parse().get() ), std::runtime_error );
+
+    // every term is a step of its own
+    pfme::Limits limits;
+    limits.m_steps = 100;
+    ASSERT_EQ ( evaluate ( "sum(i, 1, 90, i)", limits ).value(), pfme::AST::num_t { 4095LL } );
+    ASSERT_EQ ( failure ( "sum(i, 1, 1000000, i)", limits ), pfme::ERROR_CODE::LIMIT_EXCEEDED );
+
+    // the time is checked while the terms are reduced
+    limits        = {};
+    limits.m_time = std::chrono::milliseconds { 10 };
+    ASSERT_EQ ( failure ( "sum(i, 1, 10^12, i)", limits ), pfme::ERROR_CODE::LIMIT_EXCEEDED );
+    ASSERT_EQ ( failure ( "sum(i, 1, 10^12, i * 0.5)", limits ), pfme::ERROR_CODE::LIMIT_EXCEEDED );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
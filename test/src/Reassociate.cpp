@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <pfme/Canonical.hpp>
+#include <pfme/Compiled.hpp>
+#include <pfme/Functions.hpp>
+#include <pfme/Parser.hpp>
+#include <pfme/Reassociate.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+auto depth ( const pfme::AST* root ) -> std::size_t
+{
+    std::size_t                                     deepest = 0;
+    std::vector<std::pair<const pfme::AST*, std::size_t>> stack { { root, 1 } };
+    while ( !stack.empty() )
+    {
+        const auto [node, level] = stack.back();
+        stack.pop_back();
+        if ( node == nullptr ) { continue; }
+        deepest = std::max ( deepest, level );
+        stack.emplace_back ( node->lhand.get(), level + 1 );
+        stack.emplace_back ( node->rhand.get(), level + 1 );
+    }
+    return deepest;
+}
+
+auto chain ( std::size_t terms, const std::string& term, const std::string& operation = " + " ) -> std::string
+{
+    std::string input = term;
+    for ( std::size_t i = 1; i < terms; ++i ) { input += operation + term; }
+    return input;
+}
+
+template <std::floating_point Float = pfme::LD>
+auto evaluate ( const pfme::AST* root, std::vector<pfme::basic_num_t<Float>> variables = {} ) -> pfme::basic_num_t<Float>
+{
+    return pfme::CompiledExpression ( root ).evaluate<Float> ( variables ).value();
+}
+} // namespace
+
+TEST ( Reassociate, exact_chains )
+{
+    std::string input = "1";
+    for ( int i = 2; i <= 100'000; ++i ) { input += " + " + std::to_string ( i ); }
+    pfme::Parser parser ( input );
+    const auto   root     = parser.parse();
+    const auto   balanced = pfme::reassociate ( root.get() );
+    ASSERT_EQ ( depth ( root.get() ), 100'000 );
+    ASSERT_LE ( depth ( balanced.get() ), 18 );
+    ASSERT_EQ ( evaluate ( balanced.get() ), pfme::AST::num_t { 5'000'050'000LL } );
+
+    // fractions, products and comparisons are exact as well
+    for ( const auto* exact :
+          { "1 / 3 + 1 / 6 + 1 / 2 + 2 / 3", "2 * 3 * (1 / 4) * 5 * (7 - 2)", "1 + (2 < 3) + (4 == 4) + 2 * 3" } )
+    {
+        pfme::Parser exact_parser ( exact );
+        const auto   original = exact_parser.parse();
+        const auto   rebuilt  = pfme::reassociate ( original.get() );
+        ASSERT_NE ( pfme::structural_hash ( rebuilt.get() ), pfme::structural_hash ( original.get() ) ) << exact;
+        ASSERT_EQ ( evaluate ( rebuilt.get() ), evaluate ( original.get() ) ) << exact;
+    }
+
+    // floats, variables and calls may round differently, so those chains stay as they are
+    for ( const auto* inexact : { "0.1 + 0.2 + 0.3 + 0.4", "1 + 2 + x + 4", "sqrt(2) * 3 * 4", "2 ^ 3 + 1 + 1" } )
+    {
+        pfme::Parser inexact_parser ( inexact );
+        const auto   original = inexact_parser.parse();
+        ASSERT_EQ ( pfme::structural_hash ( pfme::reassociate ( original.get() ).get() ),
+                    pfme::structural_hash ( original.get() ) )
+            << inexact;
+    }
+
+    // chains that might overflow in another grouping are not regrouped, only their parts that can not overflow
+    pfme::Parser largest ( "9223372036854775807 + 1 + -1" );
+    const auto   sum = largest.parse();
+    ASSERT_EQ ( pfme::structural_hash ( pfme::reassociate ( sum.get() ).get() ), pfme::structural_hash ( sum.get() ) );
+    ASSERT_EQ ( evaluate ( pfme::reassociate ( sum.get() ).get() ), pfme::AST::num_t { 9223372036854775807LL } );
+    pfme::Parser halved ( "4611686018427387904 * 2 * (1 / 2) * 1" );
+    const auto   product = halved.parse();
+    ASSERT_EQ ( evaluate ( pfme::reassociate ( product.get() ).get() ), evaluate ( product.get() ) );
+
+    // a factor of 0 does not bound the partial results of another grouping, so these chains keep their result or error
+    for ( const auto* zero : { "2 * 9223372036854775807 * 0",
+                               "0 * 9223372036854775807 * 9223372036854775807",
+                               "-4 * 1 / 0 * 9223372036854775807 * 5" } )
+    {
+        pfme::Parser zero_parser ( zero );
+        const auto   original  = zero_parser.parse();
+        const auto   expected  = pfme::CompiledExpression ( original.get() ).evaluate<pfme::LD>();
+        const auto   rebuilt   = pfme::reassociate ( original.get() );
+        const auto   evaluated = pfme::CompiledExpression ( rebuilt.get() ).evaluate<pfme::LD>();
+        ASSERT_EQ ( evaluated.has_value(), expected.has_value() ) << zero;
+        if ( expected ) { ASSERT_EQ ( *evaluated, *expected ) << zero; }
+        else { ASSERT_EQ ( evaluated.error().m_code, expected.error().m_code ) << zero; }
+    }
+
+    // the exact part of a chain is rebalanced on its own
+    pfme::Parser mixed ( "x + 1 + 2 + 3 + 4" );
+    const auto   partly = pfme::reassociate ( mixed.parse().get() );
+    ASSERT_EQ ( depth ( partly.get() ), 4 );
+    ASSERT_EQ ( evaluate ( partly.get(), { 10LL } ), pfme::AST::num_t { 20LL } );
+}
+
+TEST ( Reassociate, pairwise )
+{
+    pfme::Parser parser ( chain ( 1 << 16, "0.1" ) );
+    const auto   root     = parser.parse();
+    const auto   pairwise = pfme::reassociate ( root.get(), pfme::REASSOCIATE::PAIRWISE );
+    ASSERT_EQ ( depth ( pairwise.get() ), 17 );
+
+    // in double the rounding errors of the chain add up, the ones of the pairs mostly cancel
+    const auto exact      = 6553.6;
+    const auto sequential = std::get<double> ( evaluate<double> ( root.get() ) );
+    const auto paired     = std::get<double> ( evaluate<double> ( pairwise.get() ) );
+    ASSERT_LT ( std::fabs ( paired - exact ), std::fabs ( sequential - exact ) );
+
+    pfme::Parser product ( "x * y * 2 * x * 3" );
+    const auto   balanced = pfme::reassociate ( product.parse().get(), pfme::REASSOCIATE::PAIRWISE );
+    ASSERT_EQ ( depth ( balanced.get() ), 4 );
+    ASSERT_EQ ( evaluate ( balanced.get(), { 2LL, 5LL } ), pfme::AST::num_t { 120LL } );
+}
+
+TEST ( Reassociate, kahan )
+{
+    // the chain adds from the right, so every 1e-17 is lost when it is added to 1 in double, the compensation keeps them
+    pfme::Parser parser ( chain ( 1000, "1e-17" ) + " + 1" );
+    const auto   root        = parser.parse();
+    const auto   compensated = pfme::reassociate ( root.get(), pfme::REASSOCIATE::KAHAN );
+    ASSERT_EQ ( compensated->m_type, pfme::AST_TYPE::FUNCTION );
+    ASSERT_EQ ( compensated->m_function, static_cast<std::uint32_t> ( pfme::FUNCTION::KSUM ) );
+    ASSERT_LE ( depth ( compensated.get() ), 70 );
+    ASSERT_EQ ( std::get<double> ( evaluate<double> ( root.get() ) ), 1.0 );
+    ASSERT_NEAR ( std::get<double> ( evaluate<double> ( compensated.get() ) ), 1.0 + 1e-14, 1e-16 );
+
+    // more rows than one block of the compensation
+    std::vector<double>                 ones ( 600, 1.0 );
+    std::vector<double>                 tiny ( 600, 1e-17 );
+    std::vector<std::span<const double>> columns { ones };
+    for ( int i = 0; i < 1000; ++i ) { columns.emplace_back ( tiny ); }
+    std::vector<double> results ( 600 );
+    pfme::call_batch ( static_cast<std::uint32_t> ( pfme::FUNCTION::KSUM ), columns, results );
+    ASSERT_NEAR ( results[1], 1.0 + 1e-14, 1e-16 );
+    ASSERT_NEAR ( results[599], 1.0 + 1e-14, 1e-16 );
+
+    // the ksum calls of a long chain are nested, so the tree stays shallow
+    pfme::Parser long_chain ( chain ( 100'000, "0.5" ) );
+    const auto   nested = pfme::reassociate ( long_chain.parse().get(), pfme::REASSOCIATE::KAHAN );
+    ASSERT_LE ( depth ( nested.get() ), 140 );
+    ASSERT_EQ ( std::get<double> ( evaluate<double> ( nested.get() ) ), 50'000.0 );
+
+    // exact chains stay exact and products are paired
+    pfme::Parser exact ( "1 / 3 + x * 2 * x * 3 + 2 / 3" );
+    const auto   mixed = pfme::reassociate ( exact.parse().get(), pfme::REASSOCIATE::KAHAN );
+    ASSERT_EQ ( evaluate ( mixed.get(), { 2LL } ), evaluate ( exact.get_root().get(), { 2LL } ) );
+    ASSERT_EQ ( evaluate ( mixed.get(), { 2LL } ), ( pfme::AST::num_t { pfme::Fraction ( 25, 1 ) } ) );
+
+    // calls with several arguments, including the ksum calls of the pass itself, can be reassociated in every mode
+    for ( const auto mode : { pfme::REASSOCIATE::EXACT, pfme::REASSOCIATE::PAIRWISE, pfme::REASSOCIATE::KAHAN } )
+    {
+        for ( const auto* call : { "max(1, 2)", "1 + max(2, 3) + 4", "ksum(1, 2, 3) * 2 * 3" } )
+        {
+            pfme::Parser call_parser ( call );
+            const auto   original = call_parser.parse();
+            ASSERT_EQ ( evaluate ( pfme::reassociate ( original.get(), mode ).get() ), evaluate ( original.get() ) ) << call;
+        }
+        ASSERT_EQ ( std::get<double> ( evaluate<double> ( pfme::reassociate ( compensated.get(), mode ).get() ) ),
+                    std::get<double> ( evaluate<double> ( compensated.get() ) ) );
+    }
+    pfme::Parser integers ( "1 + 2 + 3 + 4" );
+    ASSERT_EQ ( pfme::reassociate ( integers.parse().get(), pfme::REASSOCIATE::KAHAN )->m_type, pfme::AST_TYPE::ADDITION );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,186 @@
+#include <Workload.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <format>
+#include <functional>
+#include <gtest/gtest.h>
+#include <vector>
+#include <pfme/Visitor.hpp>
+
+// The scaling tests time every stage at geometrically growing input sizes and fit the growth exponent k of t = c * n^k.
+// They fail if k exceeds PFME_SCALING_MAX_EXPONENT (environment variable, defaults to DEFAULT_MAX_EXPONENT).
+// Every size runs once to warm up and the median of the repetitions is fitted. The runs are timed in processor time, which
+// other processes do not add to, and the sizes are large enough that a single run takes milliseconds. The test still runs
+// serially (see RUN_SERIAL), since other processes compete for the caches.
+
+namespace
+{
+constexpr double      DEFAULT_MAX_EXPONENT = 1.5;
+constexpr std::size_t SMALLEST_SIZE        = 4096;
+constexpr int         SIZE_STEPS           = 5;
+constexpr int         REPETITIONS          = 7;
+
+auto max_exponent() -> double
+{
+    const char* configured = std::getenv ( "PFME_SCALING_MAX_EXPONENT" ); // NOLINT(concurrency-mt-unsafe)
+    return configured != nullptr ? std::stod ( configured ) : DEFAULT_MAX_EXPONENT;
+}
+
+auto float_workload ( std::size_t operands ) -> pfme::workload::Options
+{
+    pfme::workload::Options options;
+    options.m_operands              = operands;
+    options.m_max_depth             = 8;
+    options.m_operator_weights      = { 4, 3, 2, 0, 1 };
+    options.m_integer_weight        = 0;
+    options.m_seperator_probability = 0.1;
+    return options;
+}
+
+auto integer_workload ( std::size_t operands ) -> pfme::workload::Options
+{
+    pfme::workload::Options options;
+    options.m_operands         = operands;
+    options.m_max_depth        = 32;
+    options.m_open_probability = 0.3;
+    options.m_operator_weights = { 1, 1, 0, 0, 0 };
+    options.m_float_weight     = 0;
+    return options;
+}
+
+// the median processor time of several runs after one run to warm up, setup runs before every run and is not measured
+auto median_time ( const std::function<void()>& setup, const std::function<void()>& run ) -> double
+{
+    setup();
+    run();
+    std::vector<double> times;
+    for ( int i = 0; i < REPETITIONS; ++i )
+    {
+        setup();
+        const auto start = std::clock();
+        run();
+        times.push_back ( static_cast<double> ( std::clock() - start ) / CLOCKS_PER_SEC );
+    }
+    std::ranges::nth_element ( times, times.begin() + REPETITIONS / 2 );
+    return times[REPETITIONS / 2];
+}
+
+// least squares slope of log(time) over log(size)
+auto growth_exponent ( const std::vector<double>& sizes, const std::vector<double>& times ) -> double
+{
+    double mean_x = 0, mean_y = 0;
+    for ( std::size_t i = 0; i < sizes.size(); ++i )
+    {
+        mean_x += std::log ( sizes[i] );
+        mean_y += std::log ( times[i] );
+    }
+    mean_x /= static_cast<double> ( sizes.size() );
+    mean_y /= static_cast<double> ( sizes.size() );
+    double covariance = 0, variance = 0;
+    for ( std::size_t i = 0; i < sizes.size(); ++i )
+    {
+        const double x = std::log ( sizes[i] ) - mean_x;
+        covariance += x * ( std::log ( times[i] ) - mean_y );
+        variance += x * x;
+    }
+    return covariance / variance;
+}
+
+using Stage = std::function<double ( const std::string& )>;
+
+auto check_scaling ( const std::string& name, const Stage& stage ) -> void
+{
+    for ( const auto& workload : { float_workload, integer_workload } )
+    {
+        std::vector<double> sizes, times;
+        std::string         report;
+        for ( int step = 0; step < SIZE_STEPS; ++step )
+        {
+            const auto operands = SMALLEST_SIZE << static_cast<unsigned> ( step );
+            const auto input    = pfme::workload::Generator ( workload ( operands ) ).generate();
+            sizes.push_back ( static_cast<double> ( input.size() ) );
+            times.push_back ( std::max ( stage ( input ), 1e-9 ) );
+            report += std::format ( "\n\t{} characters: {} s", input.size(), times.back() );
+        }
+        const auto exponent = growth_exponent ( sizes, times );
+        EXPECT_LE ( exponent, max_exponent() ) << name << " grows with n^" << exponent << report;
+    }
+}
+} // namespace
+
+TEST ( Workload, deterministic )
+{
+    pfme::workload::Options options;
+    options.m_operands = 200;
+    pfme::workload::Generator first ( options ), second ( options );
+    ASSERT_EQ ( first.generate(), second.generate() );
+
+    options.m_seed = 42;
+    pfme::workload::Generator third ( options );
+    ASSERT_NE ( first.generate(), third.generate() );
+}
+
+TEST ( Workload, valid )
+{
+    for ( std::uint64_t seed = 0; seed < 100; ++seed )
+    {
+        pfme::workload::Options options;
+        options.m_operands              = 1 + seed;
+        options.m_seed                  = seed;
+        options.m_operator_weights      = { 3, 3, 2, 0, 1 };
+        options.m_seperator_probability = 0.2;
+        const auto input                = pfme::workload::Generator ( options ).generate();
+        ASSERT_NO_THROW ( pfme::Visitor ( input ).visit() ) << input;
+
+        options.m_point_symbol = ',';
+        options.m_seperators   = { '.', '_' };
+        const auto german      = pfme::workload::Generator ( options ).generate();
+        ASSERT_NO_THROW ( pfme::Visitor ( std::make_unique<pfme::Lexer> ( german, ',', std::vector<char> { '.', '\'', '_' } ) )
+                              .visit() )
+            << german;
+    }
+}
+
+TEST ( Scaling, Lexer )
+{
+    check_scaling ( "Lexer",
+                    [] ( const std::string& input )
+                    {
+                        return median_time ( [] {},
+                                           [&]
+                                           {
+                                               pfme::Lexer lexer ( input );
+                                               while ( lexer.get_next_token()->get_type() != pfme::TOKEN_TYPE::TOKEN_EOF ) {}
+                                           } );
+                    } );
+}
+
+TEST ( Scaling, Parser )
+{
+    check_scaling ( "Parser",
+                    [] ( const std::string& input )
+                    {
+                        std::unique_ptr<pfme::Parser> parser;
+                        return median_time ( [&] { parser = std::make_unique<pfme::Parser> ( input ); },
+                                           [&] { parser->parse(); } );
+                    } );
+}
+
+TEST ( Scaling, Visitor )
+{
+    check_scaling ( "Visitor",
+                    [] ( const std::string& input )
+                    {
+                        std::unique_ptr<pfme::Visitor> visitor;
+                        return median_time ( [&] { visitor = std::make_unique<pfme::Visitor> ( input ); },
+                                           [&] { visitor->visit(); } );
+                    } );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,102 @@
+#include <Workload.hpp>
+#include <gtest/gtest.h>
+#include <pfme/Lexer.hpp>
+#include <pfme/Scan.hpp>
+#include <vector>
+
+namespace
+{
+auto levels() -> std::vector<pfme::simd::SIMD_LEVEL>
+{
+    std::vector<pfme::simd::SIMD_LEVEL> usable { pfme::simd::SIMD_LEVEL::SCALAR };
+    for ( const auto level : { pfme::simd::SIMD_LEVEL::SSE2, pfme::simd::SIMD_LEVEL::AVX2 } )
+    {
+        if ( level <= pfme::simd::supported_level() ) { usable.push_back ( level ); }
+    }
+    return usable;
+}
+
+auto tokens ( const std::string& input, const pfme::LexerConfig& config ) -> std::vector<std::string>
+{
+    std::vector<std::string> values;
+    pfme::Lexer              lexer ( input, config );
+    for ( auto token = lexer.get_next_token(); token->get_type() != pfme::TOKEN_TYPE::TOKEN_EOF;
+          token = lexer.get_next_token() )
+    {
+        values.push_back ( token->get_value() );
+    }
+    return values;
+}
+
+// restores the detected level after each test
+class Scan : public ::testing::Test
+{
+protected:
+    void TearDown() override { pfme::simd::set_level ( pfme::simd::supported_level() ); }
+};
+} // namespace
+
+TEST_F ( Scan, run_ends )
+{
+    const auto& config = pfme::LexerConfig::standard();
+    // every run length around the vector widths, followed by a character that ends the run
+    for ( const auto level : levels() )
+    {
+        pfme::simd::set_level ( level );
+        for ( std::size_t length = 0; length < 100; ++length )
+        {
+            for ( std::size_t tail = 0; tail < 3; ++tail )
+            {
+                const auto digits = std::string ( length, '7' ) + std::string ( tail, '+' );
+                ASSERT_EQ ( pfme::scan::digit_run_end ( digits, 0 ), length ) << pfme::simd::simd_level_to_string ( level );
+
+                auto spaces = std::string ( length, ' ' ) + std::string ( tail, '1' );
+                for ( std::size_t i = 0; i < length; i += 3 ) { spaces[i] = i % 2 == 0 ? '_' : '\t'; }
+                ASSERT_EQ ( pfme::scan::skip_run_end ( spaces, 0, config ), length )
+                    << pfme::simd::simd_level_to_string ( level );
+            }
+        }
+        // bytes that are only digits or spaces after subtracting '0' or as signed chars
+        const std::string tricky = std::string ( 40, '5' ) + static_cast<char> ( 0xB0 ) + "9";
+        ASSERT_EQ ( pfme::scan::digit_run_end ( tricky, 3 ), 40 );
+        ASSERT_EQ ( pfme::scan::digit_run_end ( std::string ( 40, '0' ) + '/', 0 ), 40 );
+        ASSERT_EQ ( pfme::scan::digit_run_end ( std::string ( 40, '9' ) + ':', 0 ), 40 );
+    }
+}
+
+TEST_F ( Scan, same_tokens_on_all_levels )
+{
+    pfme::workload::Options options;
+    options.m_operands              = 2000;
+    options.m_max_digits            = 40;
+    options.m_seperator_probability = 0.05;
+    options.m_seperators            = { '_' }; // the only seperator of both configs
+    options.m_operator_weights      = { 1, 1, 1, 0, 0 };
+    options.m_integer_weight        = 0; // long integers would be out of range
+    const auto input                = pfme::workload::Generator ( options ).generate() + std::string ( 100, ' ' ) + "+ 1";
+
+    pfme::simd::set_level ( pfme::simd::SIMD_LEVEL::SCALAR );
+    const auto expected        = tokens ( input, pfme::LexerConfig::standard() );
+    const auto expected_spaced = tokens ( input, pfme::LexerConfig::space_grouping() );
+    for ( const auto level : levels() )
+    {
+        pfme::simd::set_level ( level );
+        ASSERT_EQ ( tokens ( input, pfme::LexerConfig::standard() ), expected ) << pfme::simd::simd_level_to_string ( level );
+        ASSERT_EQ ( tokens ( input, pfme::LexerConfig::space_grouping() ), expected_spaced )
+            << pfme::simd::simd_level_to_string ( level );
+    }
+}
+
+TEST_F ( Scan, set_level )
+{
+    ASSERT_EQ ( pfme::simd::set_level ( pfme::simd::SIMD_LEVEL::SCALAR ), pfme::simd::SIMD_LEVEL::SCALAR );
+    ASSERT_EQ ( pfme::simd::get_level(), pfme::simd::SIMD_LEVEL::SCALAR );
+    ASSERT_EQ ( pfme::simd::set_level ( pfme::simd::SIMD_LEVEL::AVX2 ), pfme::simd::supported_level() );
+    ASSERT_FALSE ( pfme::LexerConfig::standard().get_skipped().empty() );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <pfme/Functions.hpp>
+#include <pfme/Serialization.hpp>
+#include <pfme/Visitor.hpp>
+
+namespace
+{
+auto temp_file ( const std::string& name ) -> std::filesystem::path
+{
+    return std::filesystem::temp_directory_path() / ( "pfme_test_" + name + ".pfme" );
+}
+
+// a buffer with a valid header and checksum around any nodes, like a file that was written on purpose
+auto wrap ( std::span<const pfme::BinaryNode> nodes ) -> std::vector<std::byte>
+{
+    const auto         node_bytes = std::as_bytes ( nodes );
+    pfme::BinaryHeader header {};
+    header.m_node_size  = sizeof ( pfme::BinaryNode );
+    header.m_float_size = sizeof ( pfme::LD );
+    header.m_node_count = static_cast<std::uint32_t> ( nodes.size() );
+    header.m_checksum   = 14695981039346656037ULL;
+    for ( const auto byte : node_bytes )
+    {
+        header.m_checksum ^= static_cast<std::uint64_t> ( byte );
+        header.m_checksum *= 1099511628211ULL;
+    }
+    std::vector<std::byte> buffer ( sizeof ( pfme::BinaryHeader ) + node_bytes.size() );
+    std::memcpy ( buffer.data(), &header, sizeof ( pfme::BinaryHeader ) );
+    std::memcpy ( buffer.data() + sizeof ( pfme::BinaryHeader ), node_bytes.data(), node_bytes.size() );
+    return buffer;
+}
+} // namespace
+
+TEST ( Serialization, flatten )
+{
+    pfme::Parser parser ( "5*(2+2)" );
+    auto         nodes = pfme::flatten ( parser.parse().get() );
+
+    ASSERT_EQ ( nodes.size(), 5 );
+    ASSERT_EQ ( nodes.back().get_type(), pfme::AST_TYPE::MULTIPLICATION );
+    for ( std::uint32_t i = 0; i < nodes.size(); ++i )
+    {
+        if ( nodes[i].get_type() == pfme::AST_TYPE::INTEGER ) { continue; }
+        ASSERT_LT ( nodes[i].m_lhand, i );
+        ASSERT_LT ( nodes[i].m_rhand, i );
+    }
+}
+
+TEST ( Serialization, round_trip )
+{
+    const std::vector<std::string> inputs { "5", "5/7", "5+ 3.8", "2+-5", "5 * 3 * 3 + ( ( 4.3 + 3 * 5 ) + 24 ) * 3 / 7" };
+    for ( const auto& input : inputs )
+    {
+        pfme::Parser parser ( input );
+        const auto   buffer = pfme::serialize ( parser.parse().get() );
+        const auto   nodes  = pfme::validate ( buffer );
+
+        pfme::Visitor visitor ( input );
+        const auto    expected = visitor.visit();
+        ASSERT_EQ ( pfme::evaluate ( nodes ).to_string(), expected ) << input;
+        ASSERT_EQ ( pfme::to_ast ( nodes )->m_type, parser.get_root()->m_type ) << input;
+    }
+
+    // the index of a range would be read back as an unbound variable
+    for ( const auto* range : { "sum(i, 1, 3, i)", "2 * prod(i, 1, 3, i + 1)" } )
+    {
+        pfme::Parser parser ( range );
+        ASSERT_THROW ( pfme::serialize ( parser.parse().get() ), std::runtime_error ) << range;
+    }
+}
+
+TEST ( Serialization, conditions )
+{
+    for ( const std::string input :
+          { "1 + 2 < 4 && 3 > 2 || 0", "2 < 1 ? 5 : 1 > 0 ? 6 : 7", "0 != 0 ? 1/0 : 9", "0 ? 1 ? 2 : 3 : 4" } )
+    {
+        pfme::Parser parser ( input );
+        const auto   nodes = pfme::validate ( pfme::serialize ( parser.parse().get() ) );
+        ASSERT_EQ ( pfme::evaluate ( nodes ).to_string(), pfme::Visitor ( input ).visit() ) << input;
+        ASSERT_EQ ( pfme::to_ast ( nodes )->m_type, parser.get_root()->m_type ) << input;
+    }
+
+    // a condition must be followed by its two results
+    pfme::Parser parser ( "1 ? 2 : 3" );
+    auto         buffer = pfme::serialize ( parser.parse().get() );
+    ASSERT_EQ ( pfme::find_shortcuts ( pfme::validate ( buffer ) ).size(), 5 );
+    const auto plain = pfme::serialize ( pfme::Parser ( "1 + 2" ).parse().get() );
+    ASSERT_TRUE ( pfme::find_shortcuts ( pfme::validate ( plain ) ).empty() );
+}
+
+TEST ( Serialization, mapped_expression )
+{
+    const auto   path = temp_file ( "mapped" );
+    pfme::Parser parser ( "5 * 3 * 3 + ( ( 4.3 + 3 * 5 ) + 24 ) * 3 / 7" );
+    pfme::save_expression ( parser.parse().get(), path );
+
+    {
+        pfme::MappedExpression mapped ( path );
+        pfme::Visitor          visitor ( "5 * 3 * 3 + ( ( 4.3 + 3 * 5 ) + 24 ) * 3 / 7" );
+        ASSERT_EQ ( mapped.evaluate().to_string(), visitor.visit() );
+
+        testing::internal::CaptureStdout();
+        pfme::Parser::print_binary_tree ( mapped.to_ast().get() );
+        auto output = testing::internal::GetCapturedStdout();
+#pragma warning( suppress : 4566 )
+        ASSERT_EQ ( output.starts_with ( "└──+\n" ), true );
+
+        const pfme::MappedExpression moved ( std::move ( mapped ) );
+        ASSERT_EQ ( moved.get_nodes().size(), 17 );
+    }
+    std::filesystem::remove ( path );
+}
+
+TEST ( Serialization, validation )
+{
+    pfme::Parser parser ( "1+2*3" );
+    const auto   buffer = pfme::serialize ( parser.parse().get() );
+
+    auto corrupted = buffer;
+    corrupted.back() ^= std::byte { 1 };
+    ASSERT_ANY_THROW ( pfme::validate ( corrupted ) );
+
+    auto wrong_version = buffer;
+    wrong_version[4] = std::byte { 0xFF };
+    ASSERT_ANY_THROW ( pfme::validate ( wrong_version ) );
+
+    auto truncated = buffer;
+    truncated.resize ( truncated.size() - sizeof ( pfme::BinaryNode ) );
+    ASSERT_ANY_THROW ( pfme::validate ( truncated ) );
+
+    // the checksums are valid, but the nodes are not a tree or a number is not
+    pfme::Parser parser_twice ( "1+2" );
+    auto         shared = pfme::flatten ( parser_twice.parse().get() );
+    ASSERT_NO_THROW ( pfme::validate ( wrap ( shared ) ) );
+    shared.back().m_rhand = shared.back().m_lhand;
+    ASSERT_ANY_THROW ( pfme::validate ( wrap ( shared ) ) );
+
+    // every subtree has to be in one piece, otherwise the shortcut of && would jump over the 100 of the last +
+    const auto operation = [] ( pfme::AST_TYPE type, std::uint32_t lhand, std::uint32_t rhand )
+    {
+        pfme::BinaryNode node {};
+        node.m_type  = static_cast<std::uint32_t> ( type );
+        node.m_lhand = lhand;
+        node.m_rhand = rhand;
+        return node;
+    };
+    const std::vector<pfme::BinaryNode> scattered { pfme::BinaryNode::from_number ( 0LL ),
+                                                    pfme::BinaryNode::from_number ( 7LL ),
+                                                    pfme::BinaryNode::from_number ( 100LL ),
+                                                    pfme::BinaryNode::from_number ( 5LL ),
+                                                    operation ( pfme::AST_TYPE::ADDITION, 1, 3 ),
+                                                    operation ( pfme::AST_TYPE::AND, 0, 4 ),
+                                                    operation ( pfme::AST_TYPE::ADDITION, 5, 2 ) };
+    ASSERT_ANY_THROW ( pfme::validate ( wrap ( scattered ) ) );
+    const std::vector<pfme::BinaryNode> ordered { pfme::BinaryNode::from_number ( 0LL ),
+                                                  pfme::BinaryNode::from_number ( 7LL ),
+                                                  pfme::BinaryNode::from_number ( 5LL ),
+                                                  operation ( pfme::AST_TYPE::ADDITION, 1, 2 ),
+                                                  operation ( pfme::AST_TYPE::AND, 0, 3 ),
+                                                  pfme::BinaryNode::from_number ( 100LL ),
+                                                  operation ( pfme::AST_TYPE::ADDITION, 4, 5 ) };
+    ASSERT_EQ ( pfme::evaluate ( pfme::validate ( wrap ( ordered ) ) ).to_string(), "100" );
+
+    // every variable number belongs to exactly one name and the numbers start at 0 without gaps
+    const auto variables = [&operation] ( const char* lhs, std::uint32_t lhs_number, const char* rhs, std::uint32_t rhs_number )
+    {
+        return std::vector<pfme::BinaryNode> { pfme::BinaryNode::from_variable ( lhs, lhs_number ),
+                                               pfme::BinaryNode::from_variable ( rhs, rhs_number ),
+                                               operation ( pfme::AST_TYPE::ADDITION, 0, 1 ) };
+    };
+    ASSERT_NO_THROW ( pfme::validate ( wrap ( variables ( "x", 0, "y", 1 ) ) ) );
+    ASSERT_NO_THROW ( pfme::validate ( wrap ( variables ( "x", 1, "y", 0 ) ) ) );
+    ASSERT_NO_THROW ( pfme::validate ( wrap ( variables ( "x", 0, "x", 0 ) ) ) );
+    ASSERT_ANY_THROW ( pfme::validate ( wrap ( variables ( "x", 0, "y", 0 ) ) ) );
+    ASSERT_ANY_THROW ( pfme::validate ( wrap ( variables ( "x", 0, "x", 1 ) ) ) );
+    ASSERT_ANY_THROW ( pfme::validate ( wrap ( variables ( "x", 0, "y", 2 ) ) ) );
+    ASSERT_ANY_THROW ( pfme::validate ( wrap ( std::vector { pfme::BinaryNode::from_variable ( "x", 1 ) } ) ) );
+
+    std::vector<pfme::BinaryNode> fraction { pfme::BinaryNode::from_number ( pfme::Fraction ( 1, 3 ) ) };
+    ASSERT_NO_THROW ( pfme::validate ( wrap ( fraction ) ) );
+    const pfme::LLI zero = 0;
+    std::memcpy ( fraction[0].m_payload.data() + sizeof ( pfme::LLI ), &zero, sizeof ( zero ) );
+    ASSERT_ANY_THROW ( pfme::validate ( wrap ( fraction ) ) );
+
+    const auto path = temp_file ( "invalid" );
+    {
+        std::ofstream file ( path, std::ios::binary );
+        file << "not an expression, but long enough for a header";
+    }
+    ASSERT_ANY_THROW ( pfme::MappedExpression { path } );
+    std::filesystem::remove ( path );
+    ASSERT_ANY_THROW ( pfme::MappedExpression { path } );
+}
+
+TEST ( Serialization, function_names )
+{
+    // a writer that added its functions in another order has other ids, the names decide which function is called
+    pfme::Parser parser ( "max(1, sqrt(16), 3)" );
+    auto         nodes = pfme::flatten ( parser.parse().get() );
+    const auto   max   = std::ranges::find ( nodes, "max", &pfme::BinaryNode::get_name );
+    ASSERT_NE ( max, nodes.end() );
+    max->m_extra = *pfme::FunctionRegistry::global().find ( "sqrt" );
+    ASSERT_EQ ( pfme::evaluate ( pfme::validate ( wrap ( nodes ) ) ).to_string(), "4" );
+    ASSERT_EQ ( pfme::to_ast ( pfme::validate ( wrap ( nodes ) ) )->m_value, "max" );
+
+    const std::string_view unknown = "nosuchfunction";
+    max->m_payload                 = {};
+    std::memcpy ( max->m_payload.data(), unknown.data(), unknown.size() );
+    ASSERT_ANY_THROW ( pfme::validate ( wrap ( nodes ) ) );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,94 @@
+#include <atomic>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <new>
+#include <pfme/Session.hpp>
+#include <pfme/Visitor.hpp>
+#include <string>
+#include <vector>
+
+namespace
+{
+std::atomic<std::size_t> allocations { 0 }; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+} // namespace
+
+// counts every allocation of the test, so the steady state of a Session can be checked
+auto operator new ( std::size_t size ) -> void*
+{
+    ++allocations;
+    if ( void* memory = std::malloc ( size == 0 ? 1 : size ) ) { return memory; } // NOLINT(cppcoreguidelines-no-malloc)
+    throw std::bad_alloc();
+}
+
+auto operator delete ( void* memory ) noexcept -> void { std::free ( memory ); } // NOLINT(cppcoreguidelines-no-malloc)
+
+auto operator delete ( void* memory, std::size_t /*size*/ ) noexcept -> void
+{
+    std::free ( memory ); // NOLINT(cppcoreguidelines-no-malloc)
+}
+
+TEST ( Session, same_results_as_visitor )
+{
+    const std::vector<std::string> inputs { "5 * 3 * 3 + ( ( 4.3 + 3 * 5 ) + 24 ) * 3 / 7",
+                                            "1 / 3 + 2^-2",
+                                            "max(1, 2 + 3, -sqrt(16))",
+                                            "0x10 + 1.5e3",
+                                            "(((5",
+                                            "2 * 5 +" };
+    pfme::Session session;
+    for ( int round = 0; round < 2; ++round )
+    {
+        for ( const auto& input : inputs )
+        {
+            auto result = session.evaluate ( input );
+            ASSERT_TRUE ( result ) << input;
+            ASSERT_EQ ( *result, *pfme::Visitor ( input ).try_evaluate() ) << input;
+        }
+    }
+
+    pfme::basic_session<float> single;
+    ASSERT_EQ ( std::get<float> ( *single.evaluate ( "0.1 + 0.2 * 3" ) ), 0.1F + 0.2F * 3.0F );
+}
+
+TEST ( Session, errors )
+{
+    pfme::Session session ( pfme::LexerConfig::german() );
+    ASSERT_EQ ( session.evaluate ( "1 +* 2" ).error().m_code, pfme::ERROR_CODE::INVALID_TOKEN );
+    ASSERT_EQ ( session.evaluate ( "" ).error().m_code, pfme::ERROR_CODE::EMPTY_EXPRESSION );
+    ASSERT_EQ ( session.evaluate ( "5 / 0" ).error().m_code, pfme::ERROR_CODE::DIVISION_BY_ZERO );
+    ASSERT_EQ ( session.evaluate ( "1,5 * 2" ).value(), pfme::AST::num_t { 3.0L } );
+    ASSERT_EQ ( session.evaluate ( "max(1;4) ^ 2" ).value(), pfme::AST::num_t { 16LL } );
+
+    ASSERT_TRUE ( session.parse ( "2 * (3 + 4" ) );
+    ASSERT_EQ ( session.evaluate().value(), pfme::AST::num_t { 14LL } );
+}
+
+TEST ( Session, steady_state_does_not_allocate )
+{
+    const std::vector<std::string> inputs { "1 + 2 * 3", "(4.5 - 1) / 3", "2^10 - 3 / 4", "min(3, 1 + 1) * -abs(-2)" };
+    pfme::Session                  session;
+    for ( const auto& input : inputs ) { ASSERT_TRUE ( session.evaluate ( input ) ); }
+
+    const auto before = allocations.load();
+    for ( int round = 0; round < 100; ++round )
+    {
+        for ( const auto& input : inputs ) { static_cast<void> ( session.evaluate ( input ) ); }
+    }
+    ASSERT_EQ ( allocations.load() - before, 0 );
+}
+
+TEST ( Session, deep_trees )
+{
+    std::string chain;
+    for ( int i = 0; i < 200'000; ++i ) { chain += "1+"; }
+    chain += '1';
+    pfme::Session session;
+    ASSERT_EQ ( session.evaluate ( chain ).value(), pfme::AST::num_t { 200'001LL } );
+    ASSERT_EQ ( session.evaluate ( std::string ( 100'000, '(' ) + "2" ).value(), pfme::AST::num_t { 2LL } );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,182 @@
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <new>
+#include <pfme/Small.hpp>
+#include <pfme/Visitor.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+std::atomic<std::size_t> allocations { 0 }; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+// NaN is a result like any other, it only has to be NaN on both paths
+auto same ( const pfme::AST::num_t& lhs, const pfme::AST::num_t& rhs ) -> bool
+{
+    const auto* left  = std::get_if<pfme::LD> ( &lhs );
+    const auto* right = std::get_if<pfme::LD> ( &rhs );
+    if ( left && right && std::isnan ( *left ) && std::isnan ( *right ) ) { return true; }
+    return lhs == rhs;
+}
+
+auto general ( const std::string& input, const pfme::LexerConfig& config ) -> pfme::Result<pfme::AST::num_t>
+{
+    auto visitor = pfme::Visitor::try_create ( std::make_unique<pfme::Lexer> ( input, config ) );
+    if ( !visitor ) { return std::unexpected ( visitor.error() ); }
+    return visitor->try_evaluate();
+}
+
+// the fast path, if it takes the input, and evaluate_small() get what the Visitor gets
+auto expect_same ( const std::string& input, const pfme::LexerConfig& config = pfme::LexerConfig::standard() ) -> bool
+{
+    const auto expected = general ( input, config );
+    const auto fast     = pfme::try_evaluate_small ( input, config );
+    for ( const auto& result : { fast.value_or ( expected ), pfme::evaluate_small ( input, config ) } )
+    {
+        EXPECT_EQ ( result.has_value(), expected.has_value() ) << input;
+        if ( result.has_value() != expected.has_value() ) { return false; }
+        if ( result ) { EXPECT_TRUE ( same ( *result, *expected ) ) << input; }
+        else
+        {
+            EXPECT_EQ ( result.error().m_code, expected.error().m_code ) << input;
+            EXPECT_EQ ( result.error().m_position, expected.error().m_position ) << input;
+        }
+    }
+    return fast.has_value();
+}
+} // namespace
+
+// counts every allocation of the test, so the fast path can be checked
+auto operator new ( std::size_t size ) -> void*
+{
+    ++allocations;
+    if ( void* memory = std::malloc ( size == 0 ? 1 : size ) ) { return memory; } // NOLINT(cppcoreguidelines-no-malloc)
+    throw std::bad_alloc();
+}
+
+auto operator delete ( void* memory ) noexcept -> void { std::free ( memory ); } // NOLINT(cppcoreguidelines-no-malloc)
+
+auto operator delete ( void* memory, std::size_t /*size*/ ) noexcept -> void
+{
+    std::free ( memory ); // NOLINT(cppcoreguidelines-no-malloc)
+}
+
+TEST ( Small, same_results_as_visitor )
+{
+    // the quirks of the Parser are kept as well
+    for ( const std::string input : { "1 + 2 * 3",
+                                      "5 * 3 * 3 + ( ( 4.3 + 3 * 5 ) + 24 ) * 3 / 7",
+                                      "8 - 3 - 2",
+                                      "8 / 4 / 2",
+                                      "2 ^ 3 ^ 2",
+                                      "-2 ^ 2",
+                                      "2 * -3",
+                                      "2 - -3",
+                                      "+4 - +1",
+                                      "1 / 3 + 2^-2",
+                                      "(1 + 2",
+                                      "1 + 2) * 3",
+                                      "((2 + 3) * (4 - 1)) ^ 2 / 5",
+                                      "1 +",
+                                      "5 * (",
+                                      "1.5e3 * .5 - 2.",
+                                      "1e-3 + 2E+2",
+                                      "-9223372036854775808 + 1",
+                                      "9223372036854775807 * 2",
+                                      "0.1 + 0.2",
+                                      "\t7 \n" } )
+    {
+        ASSERT_TRUE ( expect_same ( input ) ) << input;
+    }
+
+    ASSERT_EQ ( *pfme::evaluate_small ( "2 ^ 3 ^ 2" ), pfme::AST::num_t { 512LL } );
+    ASSERT_EQ ( *pfme::evaluate_small ( "1 + 2) * 3" ), pfme::AST::num_t { 9LL } );
+    ASSERT_EQ ( std::get<float> ( *pfme::evaluate_small<float> ( "0.1 + 0.2 * 3" ) ), 0.1F + 0.2F * 3.0F );
+    ASSERT_EQ ( std::get<double> ( *pfme::evaluate_small<double> ( "1 / 3.0" ) ), 1 / 3.0 );
+    ASSERT_TRUE ( expect_same ( "1,5 * 2 ^ 0,5", pfme::LexerConfig::german() ) );
+}
+
+TEST ( Small, fallback )
+{
+    // everything the fast path does not know goes to the Visitor, with the same results and errors
+    for ( const std::string input : { "sqrt(16) + 1",
+                                      "2 * x",
+                                      "0x10 + 1",
+                                      "1_000 * 2",
+                                      "1'000",
+                                      "1.2.3",
+                                      "9223372036854775808",
+                                      "1e99999",
+                                      "1 +* 2",
+                                      "2 3",
+                                      "-(2 + 3)",
+                                      ")",
+                                      "",
+                                      "   ",
+                                      "(",
+                                      "2e",
+                                      "5 ; 2",
+                                      "1 + \xc3\xa4" } )
+    {
+        ASSERT_FALSE ( expect_same ( input ) ) << input;
+    }
+
+    // the limit counts tokens, not characters
+    std::string at_limit = "1";
+    while ( at_limit.size() < pfme::SMALL_TOKEN_LIMIT - 1 ) { at_limit += "+1"; }
+    ASSERT_TRUE ( expect_same ( at_limit ) );
+    ASSERT_TRUE ( expect_same ( "   " + std::string ( 1000, '1' ) + ".5   " ) );
+    ASSERT_FALSE ( expect_same ( at_limit + "+1" ) );
+    ASSERT_EQ ( *pfme::evaluate_small ( at_limit + "+1" ),
+                pfme::AST::num_t { static_cast<pfme::LLI> ( pfme::SMALL_TOKEN_LIMIT / 2 + 1 ) } );
+}
+
+TEST ( Small, errors )
+{
+    ASSERT_EQ ( pfme::try_evaluate_small ( "5 / (3 - 3)" )->error().m_code, pfme::ERROR_CODE::DIVISION_BY_ZERO );
+    ASSERT_EQ ( pfme::try_evaluate_small ( "0 ^ -1" )->error().m_code, pfme::ERROR_CODE::DIVISION_BY_ZERO );
+    ASSERT_TRUE ( expect_same ( "5 / (3 - 3)" ) );
+    ASSERT_EQ ( pfme::evaluate_small ( "1 + * 2" ).error().m_code, pfme::ERROR_CODE::INVALID_TOKEN );
+    ASSERT_EQ ( pfme::evaluate_small ( "" ).error().m_code, pfme::ERROR_CODE::EMPTY_EXPRESSION );
+}
+
+TEST ( Small, random_inputs )
+{
+    // token soup, most of it is invalid in some way
+    const std::vector<std::string> parts { "1", "2", "3", "0", "7.5", "1e2", ".5", "+", "-", "*", "/", "^", "(", ")", " " };
+    std::mt19937                   random ( 7 );
+    std::size_t                    fast = 0;
+    for ( int i = 0; i < 20000; ++i )
+    {
+        std::string input;
+        const auto  length = std::uniform_int_distribution<std::size_t> { 1, 40 }( random );
+        for ( std::size_t part = 0; part < length; ++part )
+        {
+            input += parts[std::uniform_int_distribution<std::size_t> { 0, parts.size() - 1 }( random )];
+        }
+        fast += expect_same ( input ) ? 1 : 0;
+        if ( ::testing::Test::HasFailure() ) { return; }
+    }
+    ASSERT_GT ( fast, 1000 );
+}
+
+TEST ( Small, no_allocations )
+{
+    const std::vector<std::string> inputs { "1 + 2 * 3", "((2 + 3) * (4 - 1)) ^ 2 / 5", "1.5e3 * .5 - 2.", "1 / 3 + 2^-2" };
+    for ( const auto& input : inputs )
+    {
+        const auto before = allocations.load();
+        const auto result = pfme::evaluate_small ( input );
+        ASSERT_EQ ( allocations.load(), before ) << input;
+        ASSERT_TRUE ( result ) << input;
+    }
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
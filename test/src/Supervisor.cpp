@@ -0,0 +1,114 @@
+#include <chrono>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <pfme/Functions.hpp>
+#include <pfme/Session.hpp>
+#include <pfme/Supervisor.hpp>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// functions that take the worker down, registered before any Supervisor is created so the workers know them
+auto add_failing_functions() -> bool
+{
+    pfme::Function crash;
+    crash.m_name   = "crash";
+    crash.m_scalar = [] ( std::span<const pfme::AST::num_t> /*arguments*/ ) -> std::expected<pfme::AST::num_t, pfme::ERROR_CODE>
+    {
+        std::abort();
+    };
+    crash.m_batch = [] ( std::span<const std::span<const double>> /*arguments*/, std::span<double> /*results*/ )
+    {
+        std::abort();
+    };
+    pfme::FunctionRegistry::global().add ( crash );
+
+    pfme::Function hang;
+    hang.m_name   = "hang";
+    hang.m_scalar = [] ( std::span<const pfme::AST::num_t> /*arguments*/ ) -> std::expected<pfme::AST::num_t, pfme::ERROR_CODE>
+    {
+        while ( true ) { std::this_thread::sleep_for ( std::chrono::seconds { 1 } ); }
+    };
+    hang.m_batch = [] ( std::span<const std::span<const double>> /*arguments*/, std::span<double> /*results*/ ) {};
+    pfme::FunctionRegistry::global().add ( hang );
+    return true;
+}
+
+const bool added = add_failing_functions();
+
+auto options() -> pfme::SupervisorOptions
+{
+    pfme::SupervisorOptions options;
+    options.m_workers = 2;
+    options.m_timeout = std::chrono::milliseconds { 200 };
+    return options;
+}
+} // namespace
+
+TEST ( Supervisor, same_results_as_session )
+{
+    ASSERT_TRUE ( added );
+    pfme::Supervisor supervisor ( options() );
+    ASSERT_EQ ( supervisor.get_workers(), 2 );
+
+    std::vector<std::string> inputs {
+        "1 + 2 * 3", "1 / 3", "2 ^ 0.5", "sqrt(-1)", "1 +* 2", "4 / 0", "max(1, 7, 3)", "1 < 2 ? 3 : 4" };
+    for ( int i = 0; i < 300; ++i ) { inputs.push_back ( std::to_string ( i ) + " * 3 - 1 / 7" ); }
+    std::vector<std::string_view> views ( inputs.begin(), inputs.end() );
+    const auto                    results = supervisor.evaluate ( views );
+    ASSERT_EQ ( results.size(), inputs.size() );
+
+    pfme::Session session;
+    for ( std::size_t i = 0; i < inputs.size(); ++i )
+    {
+        const auto expected = session.evaluate ( inputs[i] );
+        ASSERT_EQ ( results[i].has_value(), expected.has_value() ) << inputs[i];
+        if ( expected ) { ASSERT_EQ ( *results[i], *expected ) << inputs[i]; }
+        else
+        {
+            ASSERT_EQ ( results[i].error().m_code, expected.error().m_code ) << inputs[i];
+            ASSERT_EQ ( results[i].error().m_position, expected.error().m_position ) << inputs[i];
+        }
+    }
+    ASSERT_EQ ( supervisor.get_restarts(), 0 );
+}
+
+TEST ( Supervisor, restarts_failed_workers )
+{
+    pfme::Supervisor supervisor ( options() );
+    const std::vector<std::string_view> inputs {
+        "1 + 1", "crash(1) + 1", "2 + 2", "hang(1)", "3 + 3", "crash(2)", "4 + 4", "5 + 5" };
+    const auto results = supervisor.evaluate ( inputs );
+    for ( const auto failed : { 1, 3, 5 } )
+    {
+        ASSERT_EQ ( results[failed].error().m_code, pfme::ERROR_CODE::WORKER_FAILED ) << inputs[failed];
+    }
+    ASSERT_EQ ( results[0].value(), pfme::AST::num_t { 2LL } );
+    ASSERT_EQ ( results[2].value(), pfme::AST::num_t { 4LL } );
+    ASSERT_EQ ( results[4].value(), pfme::AST::num_t { 6LL } );
+    ASSERT_EQ ( results[6].value(), pfme::AST::num_t { 8LL } );
+    ASSERT_EQ ( results[7].value(), pfme::AST::num_t { 10LL } );
+    ASSERT_EQ ( supervisor.get_restarts(), 3 );
+
+    // the restarted workers keep working
+    ASSERT_EQ ( supervisor.evaluate ( "6 * 7" ).value(), pfme::AST::num_t { 42LL } );
+}
+
+TEST ( Supervisor, long_input )
+{
+    pfme::Supervisor supervisor ( options() );
+    std::string      input ( pfme::Supervisor::MAX_LENGTH + 1, ' ' );
+    input.front() = '1';
+    ASSERT_EQ ( supervisor.evaluate ( input ).error().m_code, pfme::ERROR_CODE::INPUT_TOO_LONG );
+    input.pop_back();
+    ASSERT_EQ ( supervisor.evaluate ( input ).value(), pfme::AST::num_t { 1LL } );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,155 @@
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <latch>
+#include <pfme/Compiled.hpp>
+#include <pfme/Trace.hpp>
+#include <pfme/Visitor.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+auto count ( const std::string& text, const std::string& part ) -> std::size_t
+{
+    std::size_t found = 0;
+    for ( auto position = text.find ( part ); position != std::string::npos; position = text.find ( part, position + 1 ) )
+    {
+        ++found;
+    }
+    return found;
+}
+
+auto export_trace() -> std::string
+{
+    std::ostringstream output;
+    pfme::trace::write_chrome_trace ( output );
+    return output.str();
+}
+
+class Trace : public ::testing::Test
+{
+protected:
+    void SetUp() override { pfme::trace::clear(); }
+    void TearDown() override { pfme::trace::set_level ( pfme::trace::TRACE_LEVEL::OFF ); }
+};
+} // namespace
+
+TEST_F ( Trace, off_by_default )
+{
+    ASSERT_EQ ( pfme::trace::get_level(), pfme::trace::TRACE_LEVEL::OFF );
+    ASSERT_EQ ( *pfme::Visitor ( "1 + 2" ).try_evaluate(), pfme::AST::num_t { 3LL } );
+    const auto trace = export_trace();
+    ASSERT_EQ ( trace.find ( "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" ), 0 );
+    ASSERT_EQ ( count ( trace, R"("ph":"X")" ), 0 );
+}
+
+TEST_F ( Trace, stages_and_nodes )
+{
+    pfme::trace::set_level ( pfme::trace::TRACE_LEVEL::STAGES );
+    ASSERT_EQ ( *pfme::Visitor ( "1 + 2 * 3" ).try_evaluate(), pfme::AST::num_t { 7LL } );
+    auto trace = export_trace();
+    ASSERT_EQ ( count ( trace, R"({"name":"parse","cat":"stage","ph":"X")" ), 1 ) << trace;
+    ASSERT_EQ ( count ( trace, R"({"name":"evaluate","cat":"stage","ph":"X")" ), 1 ) << trace;
+    ASSERT_EQ ( count ( trace, R"("cat":"node")" ), 0 ) << trace;
+
+    pfme::trace::clear();
+    pfme::trace::set_level ( pfme::trace::TRACE_LEVEL::NODES );
+    const auto compiled = pfme::CompiledExpression::compile ( "1 + 2 * sqrt(4)" );
+    ASSERT_EQ ( *compiled->evaluate(), pfme::AST::num_t { 5LL } );
+    trace = export_trace();
+    ASSERT_EQ ( count ( trace, R"({"name":"compile","cat":"stage")" ), 1 ) << trace;
+    ASSERT_EQ ( count ( trace, R"({"name":"parse","cat":"stage")" ), 1 ) << trace;
+    ASSERT_EQ ( count ( trace, R"({"name":"evaluate","cat":"stage")" ), 1 ) << trace;
+    ASSERT_EQ ( count ( trace, R"("cat":"node")" ), 3 ) << trace;
+    ASSERT_EQ ( count ( trace, R"({"name":"sqrt","cat":"node")" ), 1 ) << trace;
+    ASSERT_EQ ( count ( trace, R"({"name":"*","cat":"node")" ), 1 ) << trace;
+    ASSERT_EQ ( count ( trace, R"({"name":"+","cat":"node")" ), 1 ) << trace;
+
+    // the Visitor records the same nodes, even though they are replaced by their results
+    pfme::trace::clear();
+    ASSERT_EQ ( *pfme::Visitor ( "1 + 2 * sqrt(4)" ).try_evaluate(), pfme::AST::num_t { 5LL } );
+    trace = export_trace();
+    ASSERT_EQ ( count ( trace, R"({"name":"sqrt","cat":"node")" ), 1 ) << trace;
+    ASSERT_EQ ( count ( trace, R"("cat":"node")" ), 3 ) << trace;
+    ASSERT_EQ ( trace.substr ( trace.size() - 4 ), "\n]}\n" );
+
+    // comparisons and logical operators have names of their own
+    pfme::trace::clear();
+    ASSERT_EQ ( *pfme::CompiledExpression::compile ( "1 < 2 && 3 >= 3" )->evaluate(), pfme::AST::num_t { 1LL } );
+    trace = export_trace();
+    ASSERT_EQ ( count ( trace, R"({"name":"<","cat":"node")" ), 1 ) << trace;
+    ASSERT_EQ ( count ( trace, R"({"name":">=","cat":"node")" ), 1 ) << trace;
+    ASSERT_EQ ( count ( trace, R"({"name":"&&","cat":"node")" ), 1 ) << trace;
+    ASSERT_EQ ( count ( trace, R"({"name":"node","cat":"node")" ), 0 ) << trace;
+}
+
+TEST_F ( Trace, ring_keeps_the_newest_events )
+{
+    pfme::trace::set_level ( pfme::trace::TRACE_LEVEL::STAGES );
+    for ( std::size_t i = 0; i < pfme::trace::CAPACITY + 10; ++i )
+    {
+        pfme::trace::record ( i < 10 ? pfme::trace::STAGE::PARSE : pfme::trace::STAGE::EVALUATE, pfme::trace::now() );
+    }
+    const auto trace = export_trace();
+    ASSERT_EQ ( count ( trace, R"("ph":"X")" ), pfme::trace::CAPACITY );
+    ASSERT_EQ ( count ( trace, R"("name":"parse")" ), 0 );
+}
+
+TEST_F ( Trace, threads )
+{
+    pfme::trace::set_level ( pfme::trace::TRACE_LEVEL::NODES );
+    const auto               compiled = pfme::CompiledExpression::compile ( "1 + 2" );
+    std::vector<std::thread> threads;
+    std::latch               running ( 4 );
+    for ( int i = 0; i < 4; ++i )
+    {
+        threads.emplace_back (
+            [&compiled, &running]
+            {
+                // every thread has its buffer before any of them finishes, so none of them takes over the buffer of another
+                pfme::trace::record ( pfme::trace::STAGE::PARSE, pfme::trace::now() );
+                running.arrive_and_wait();
+                for ( int j = 0; j < 100; ++j ) { ASSERT_EQ ( *compiled->evaluate(), pfme::AST::num_t { 3LL } ); }
+            } );
+    }
+    for ( auto& thread : threads ) { thread.join(); }
+
+    // the events of finished threads are kept
+    const auto trace = export_trace();
+    ASSERT_EQ ( count ( trace, R"({"name":"evaluate","cat":"stage")" ), 400 );
+    ASSERT_EQ ( count ( trace, R"({"name":"+","cat":"node")" ), 400 );
+    ASSERT_GE ( count ( trace, R"("name":"thread_name")" ), 5 );
+
+    const auto path = std::filesystem::temp_directory_path() / "pfme_trace_test.json";
+    pfme::trace::save_chrome_trace ( path );
+    std::ifstream      file ( path );
+    std::ostringstream saved;
+    saved << file.rdbuf();
+    ASSERT_EQ ( saved.str(), trace );
+    std::filesystem::remove ( path );
+}
+
+TEST_F ( Trace, finished_threads_hand_on_their_buffer )
+{
+    pfme::trace::set_level ( pfme::trace::TRACE_LEVEL::STAGES );
+    pfme::trace::record ( pfme::trace::STAGE::PARSE, pfme::trace::now() );
+    const auto buffers = count ( export_trace(), R"("name":"thread_name")" );
+
+    // one thread after the other needs one buffer more at most, and the events of all of them are kept
+    for ( int i = 0; i < 300; ++i )
+    {
+        std::thread ( [] { pfme::trace::record ( pfme::trace::STAGE::EVALUATE, pfme::trace::now() ); } ).join();
+    }
+    const auto trace = export_trace();
+    ASSERT_LE ( count ( trace, R"("name":"thread_name")" ), buffers + 1 );
+    ASSERT_EQ ( count ( trace, R"({"name":"evaluate","cat":"stage")" ), 300 );
+}
+
+int main ( int argc, char** argv )
+{
+    ::testing::InitGoogleTest ( &argc, argv );
+    return RUN_ALL_TESTS();
+}
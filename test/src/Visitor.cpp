@@ -1,3 +1,4 @@
+#include <cmath>
 #include <gtest/gtest.h>
 #include <pfme/Visitor.hpp>
 
@@ -36,6 +37,8 @@ TEST ( Visitor, special_sequences )
     pfme::Visitor vA ( "5^0" );
     pfme::Visitor vB ( ".5^0" );
     pfme::Visitor vC ( "2+-5" );
+    pfme::Visitor vD ( "(1+3)/2+1" );
+    pfme::Visitor vE ( "5 " );
 
 
     ASSERT_EQ ( v1.visit(), std::to_string ( 5 + 0 ) );
@@ -50,6 +53,94 @@ TEST ( Visitor, special_sequences )
     ASSERT_EQ ( vA.visit(), std::to_string ( 1 ) );
     ASSERT_EQ ( vB.visit(), std::to_string ( 1 ) );
     ASSERT_EQ ( vC.visit(), std::to_string ( 2 - 5 ) );
+    ASSERT_EQ ( vD.visit(), std::to_string ( ( 1 + 3 ) / 2 + 1 ) );
+    ASSERT_EQ ( vE.visit(), std::to_string ( 5 ) );
+}
+
+TEST ( Visitor, literals )
+{
+    ASSERT_EQ ( pfme::Visitor ( "0x10 + 1" ).visit(), std::to_string ( 17 ) );
+    ASSERT_EQ ( pfme::Visitor ( "1.5e3 * 2" ).visit(), std::to_string ( 3000.0L ) );
+    ASSERT_EQ ( pfme::Visitor ( "-9223372036854775808 + 1" ).visit(), std::to_string ( -9223372036854775807LL ) );
+    ASSERT_ANY_THROW ( pfme::Visitor ( "9223372036854775808 + 1" ) );
+}
+
+TEST ( Visitor, deep_trees )
+{
+    constexpr int depth = 1'000'000;
+    std::string   chain;
+    for ( int i = 0; i < depth; ++i ) { chain += "1+"; }
+    chain += '1';
+    pfme::Visitor right ( chain );
+    ASSERT_EQ ( right.visit(), std::to_string ( depth + 1 ) );
+
+    std::string nested ( 200'000, '(' );
+    nested += '1';
+    for ( int i = 0; i < 200'000; ++i ) { nested += "+1)"; }
+    pfme::Visitor left ( nested );
+    ASSERT_EQ ( left.visit(), std::to_string ( 200'001 ) );
+
+    pfme::Visitor parenthesis ( std::string ( 200'000, '(' ) + "5" + std::string ( 200'000, ')' ) );
+    ASSERT_EQ ( parenthesis.visit(), std::to_string ( 5 ) );
+}
+
+TEST ( Visitor, numeric_policies )
+{
+    // 0.1 is rounded before every operation, like a program that uses the type throughout
+    const float  single = 0.1F + 0.2F * 3.0F;
+    const double twice  = 0.1 + 0.2 * 3.0;
+    ASSERT_EQ ( std::get<float> ( *pfme::basic_visitor<float> ( "0.1 + 0.2 * 3" ).try_evaluate() ), single );
+    ASSERT_EQ ( std::get<double> ( *pfme::basic_visitor<double> ( "0.1 + 0.2 * 3" ).try_evaluate() ), twice );
+    ASSERT_EQ ( std::get<pfme::LD> ( *pfme::Visitor ( "0.1 + 0.2 * 3" ).try_evaluate() ), 0.1L + 0.2L * 3.0L );
+    ASSERT_EQ ( std::get<double> ( *pfme::basic_visitor<double> ( "sqrt(2.) / 2" ).try_evaluate() ),
+                static_cast<double> ( std::sqrt ( 2.0L ) ) / 2 );
+
+    // integers and fractions stay exact
+    ASSERT_EQ ( std::get<pfme::LLI> ( *pfme::basic_visitor<float> ( "16777217 * 3" ).try_evaluate() ), 50331651 );
+    ASSERT_EQ ( pfme::basic_visitor<float> ( "1 / 3 + 2^-2" ).visit(), pfme::Fraction ( 7, 12 ).to_string() );
+    ASSERT_EQ ( pfme::basic_visitor<double> ( "5+ 3.8" ).visit(), std::to_string ( 5 + 3.8 ) );
+    ASSERT_EQ ( pfme::basic_visitor<double> ( "2^0.5" ).visit(), std::to_string ( std::pow ( 2.0, 0.5 ) ) );
+
+    auto error = pfme::basic_visitor<float>::try_create ( "1 / (2 - 2.)" )->try_visit();
+    ASSERT_FALSE ( error );
+    ASSERT_EQ ( error.error().m_code, pfme::ERROR_CODE::DIVISION_BY_ZERO );
+}
+
+TEST ( Visitor, conditions )
+{
+    // precedence: arithmetic, comparisons, equality, &&, ||, ?:
+    ASSERT_EQ ( pfme::Visitor ( "1 + 2 < 4 && 3 > 2 || 0" ).visit(), "1" );
+    ASSERT_EQ ( pfme::Visitor ( "2^3 > 7 == 1" ).visit(), "1" );
+    ASSERT_EQ ( pfme::Visitor ( "1 ? 2 : 3 + 4" ).visit(), "2" );
+    ASSERT_EQ ( pfme::Visitor ( "(1 ? 2 : 3) + 4" ).visit(), "6" );
+    ASSERT_EQ ( pfme::Visitor ( "max(0 ? 2 : 3, 1)" ).visit(), "3" );
+    // comparisons chain to the left like in C
+    ASSERT_EQ ( pfme::Visitor ( "1 < 2 < 3" ).visit(), "1" );
+    ASSERT_EQ ( pfme::Visitor ( "3 > 2 > 1" ).visit(), "0" );
+    ASSERT_EQ ( pfme::Visitor ( "2 == 2 != 0" ).visit(), "1" );
+    ASSERT_EQ ( pfme::Visitor ( "1 == 2 == 0" ).visit(), "1" );
+    ASSERT_EQ ( pfme::Visitor ( "1 + 1 < 3 < 2 * 1 == 1 != 0" ).visit(), "1" );
+    ASSERT_EQ ( pfme::Visitor ( "3 > (2 > 1)" ).visit(), "1" );
+    // conditions chain to the right and nest between ? and :
+    ASSERT_EQ ( pfme::Visitor ( "2 < 1 ? 5 : 1 > 0 ? 6 : 7" ).visit(), "6" );
+    ASSERT_EQ ( pfme::Visitor ( "1 ? 0 ? 5 : 6 : 7" ).visit(), "6" );
+
+    // exact numbers are compared exactly
+    ASSERT_EQ ( pfme::Visitor ( "1/3 == 2/6" ).visit(), "1" );
+    ASSERT_EQ ( pfme::Visitor ( "1.5 >= 3/2" ).visit(), "1" );
+    ASSERT_EQ ( pfme::Visitor ( "9223372036854775807 > 9223372036854775806" ).visit(), "1" );
+
+    // the side that is not needed is never evaluated
+    ASSERT_EQ ( pfme::Visitor ( "0 != 0 ? 1/0 : 9" ).visit(), "9" );
+    ASSERT_EQ ( pfme::Visitor ( "0 && 1/0" ).visit(), "0" );
+    ASSERT_EQ ( pfme::Visitor ( "2 || 1/0" ).visit(), "1" );
+    ASSERT_EQ ( pfme::Visitor ( "2 && 3" ).visit(), "1" );
+    ASSERT_EQ ( pfme::Visitor::try_create ( "1 ? 1/0 : 2" )->try_visit().error().m_code, pfme::ERROR_CODE::DIVISION_BY_ZERO );
+
+    ASSERT_EQ ( pfme::Visitor::try_create ( "1 ? 2" ).error().m_code, pfme::ERROR_CODE::UNEXPECTED_TOKEN );
+    ASSERT_EQ ( pfme::Visitor::try_create ( "(1 ? 2) : 3" ).error().m_code, pfme::ERROR_CODE::UNEXPECTED_TOKEN );
+    ASSERT_FALSE ( pfme::Visitor::try_create ( "1 : 2" ) );
+    ASSERT_FALSE ( pfme::Visitor::try_create ( "max(1 ? 2, 3)" ) );
 }
 
 int main ( int argc, char** argv )